@@ -0,0 +1,446 @@
+/*
+ * libchip8 C interface, see chip8.h
+ */
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "../src/Chip8.hpp"
+#include "../src/ThreadPool.hpp"
+
+#define CHIP8_LIB_TASKS_PER_THREAD 4
+
+namespace Chip8{
+    namespace Lib{
+
+        thread_local std::string lastError;
+
+        // Batch state shared by every generator policy, machines live in TypedBatch
+        class Batch{
+
+        protected:
+            std::size_t m_count;
+            uint64_t m_seed;
+            uint32_t m_frameInstructions;
+            std::shared_ptr<const MemoryImage> m_image;
+            std::unique_ptr<Util::ThreadPool> m_pool;
+
+            std::vector<uint8_t> m_faults;
+            std::vector<std::string> m_faultMessages;
+            std::vector<uint64_t> m_instructions;
+
+            std::vector<uint8_t> m_packedFrames;
+            std::vector<uint8_t> m_byteFrames;
+            std::vector<uint16_t> m_watchAddrs;
+            std::vector<uint8_t> m_watched;
+            chip8_reward_fn m_rewardFn;
+            void* m_rewardUser;
+            std::vector<float> m_rewards;
+
+            virtual void resetMachine(std::size_t t_index) = 0;
+            virtual void runMachine(std::size_t t_index, uint64_t t_instructions) = 0;
+
+            void refreshViews(std::size_t t_index, const chip8_batch* t_handle){
+                const uint8_t* display = framebuffer(t_index);
+                if(!m_packedFrames.empty()){
+                    std::copy(display, display + CHIP8_FB_PACKED_SIZE, m_packedFrames.begin() + t_index * CHIP8_FB_PACKED_SIZE);
+                }
+                if(!m_byteFrames.empty()){
+                    uint8_t* pixels = m_byteFrames.data() + t_index * CHIP8_FB_BYTES_SIZE;
+                    for(std::size_t byte = 0; byte < CHIP8_FB_PACKED_SIZE; ++byte){
+                        for(std::size_t bit = 0; bit < 8; ++bit){
+                            pixels[byte * 8 + bit] = (display[byte] >> (7 - bit)) & 0x01;
+                        }
+                    }
+                }
+                for(std::size_t watch = 0; watch < m_watchAddrs.size(); ++watch){
+                    m_watched[t_index * m_watchAddrs.size() + watch] = peek(t_index, m_watchAddrs[watch]);
+                }
+                if(m_rewardFn){
+                    m_rewards[t_index] = m_rewardFn(t_handle, t_index, m_rewardUser);
+                }
+            }
+
+        public:
+            Batch(const chip8_batch_config& t_config, const uint8_t* t_rom, std::size_t t_romSize) : m_count(t_config.count),
+                                                                                                       m_seed(t_config.seed),
+                                                                                                       m_frameInstructions((t_config.frame_instructions)? t_config.frame_instructions : CHIP8_DEFAULT_FRAME_INSTRUCTIONS),
+                                                                                                       m_image(PagedMemory::makeImage(t_rom, t_romSize)),
+                                                                                                       m_faults(t_config.count, 0),
+                                                                                                       m_faultMessages(t_config.count),
+                                                                                                       m_instructions(t_config.count, 0),
+                                                                                                       m_rewardFn(nullptr),
+                                                                                                       m_rewardUser(nullptr),
+                                                                                                       m_rewards(t_config.count, 0.0f){
+                if(t_config.threads > 1){
+                    m_pool.reset(new Util::ThreadPool(t_config.threads));
+                }
+            }
+
+            virtual ~Batch() = default;
+
+            std::size_t size() const{
+                return m_count;
+            }
+
+            void checkIndex(std::size_t t_index) const{
+                if(t_index >= m_count){
+                    throw std::string("libchip8: machine index " + std::to_string(t_index) + " out of range for a batch of " + std::to_string(m_count));
+                }
+            }
+
+            void reset(std::size_t t_index, const chip8_batch* t_handle){
+                std::size_t begin = t_index, end = t_index + 1;
+                if(t_index == static_cast<std::size_t>(-1)){
+                    begin = 0;
+                    end = m_count;
+                }
+                else{
+                    checkIndex(t_index);
+                }
+                for(std::size_t index = begin; index < end; ++index){
+                    resetMachine(index);
+                    m_faults[index] = 0;
+                    m_faultMessages[index].clear();
+                    m_instructions[index] = 0;
+                    refreshViews(index, t_handle);
+                }
+            }
+
+            virtual void setKeys(const uint16_t* t_keys) = 0;
+
+            long step(const uint16_t* t_keys, uint32_t t_frames, const chip8_batch* t_handle){
+                if(t_keys){
+                    setKeys(t_keys);
+                }
+
+                uint64_t instructions = static_cast<uint64_t>(t_frames) * m_frameInstructions;
+                auto runRange = [this, instructions](std::size_t t_begin, std::size_t t_end){
+                    for(std::size_t index = t_begin; index < t_end; ++index){
+                        if(!m_faults[index]){
+                            runMachine(index, instructions);
+                        }
+                    }
+                };
+
+                if(m_pool && m_count > 1){
+                    std::size_t tasks = std::min(m_count, m_pool->size() * CHIP8_LIB_TASKS_PER_THREAD);
+                    std::size_t chunk = (m_count + tasks - 1) / tasks;
+                    for(std::size_t begin = 0; begin < m_count; begin += chunk){
+                        std::size_t end = std::min(m_count, begin + chunk);
+                        m_pool->submit([runRange, begin, end]{
+                            runRange(begin, end);
+                        });
+                    }
+                    m_pool->wait();
+                }
+                else{
+                    runRange(0, m_count);
+                }
+
+                // Views and reward hooks run on the caller, callbacks need not be thread safe
+                long live = 0;
+                for(std::size_t index = 0; index < m_count; ++index){
+                    refreshViews(index, t_handle);
+                    live += !m_faults[index];
+                }
+                return live;
+            }
+
+            const uint8_t* faults() const{
+                return m_faults.data();
+            }
+
+            const std::string& faultMessage(std::size_t t_index) const{
+                checkIndex(t_index);
+                return m_faultMessages[t_index];
+            }
+
+            const uint64_t* instructions() const{
+                return m_instructions.data();
+            }
+
+            const uint8_t* framebuffers(chip8_fb_format t_format, const chip8_batch* t_handle){
+                std::vector<uint8_t>& frames = (t_format == CHIP8_FB_BYTES)? m_byteFrames : m_packedFrames;
+                if(t_format != CHIP8_FB_PACKED && t_format != CHIP8_FB_BYTES){
+                    throw std::string("libchip8: unknown frame buffer format " + std::to_string(t_format));
+                }
+                if(frames.empty()){
+                    frames.resize(m_count * ((t_format == CHIP8_FB_BYTES)? CHIP8_FB_BYTES_SIZE : CHIP8_FB_PACKED_SIZE));
+                    for(std::size_t index = 0; index < m_count; ++index){
+                        refreshViews(index, t_handle);
+                    }
+                }
+                return frames.data();
+            }
+
+            const uint8_t* watch(const uint16_t* t_addrs, std::size_t t_numAddrs, const chip8_batch* t_handle){
+                m_watchAddrs.assign(t_addrs, t_addrs + t_numAddrs);
+                m_watched.assign(m_count * t_numAddrs, 0);
+                for(std::size_t index = 0; index < m_count; ++index){
+                    refreshViews(index, t_handle);
+                }
+                return m_watched.data();
+            }
+
+            void setReward(chip8_reward_fn t_fn, void* t_user){
+                m_rewardFn = t_fn;
+                m_rewardUser = t_user;
+            }
+
+            const float* rewards() const{
+                return m_rewards.data();
+            }
+
+            virtual const uint8_t* framebuffer(std::size_t t_index) const = 0;
+            virtual uint8_t peek(std::size_t t_index, uint16_t t_addr) const = 0;
+            virtual const uint8_t* registers(std::size_t t_index) const = 0;
+        };
+
+        template<typename TChip8>
+        class TypedBatch : public Batch{
+
+        private:
+            // Instances are cache line aligned, std::allocator does not honour that before C++17
+            std::vector<std::unique_ptr<TChip8>> m_machines;
+
+        protected:
+            void resetMachine(std::size_t t_index) override{
+                m_machines[t_index]->reset(m_seed, t_index);
+                m_machines[t_index]->load(m_image);
+            }
+
+            void runMachine(std::size_t t_index, uint64_t t_instructions) override{
+                TChip8& machine = *m_machines[t_index];
+                uint64_t executed = 0;
+                try{
+                    for(; executed < t_instructions; ++executed){
+                        machine.run_tick();
+                    }
+                }
+                catch(const std::string& error){
+                    m_faults[t_index] = 1;
+                    m_faultMessages[t_index] = error;
+                }
+                m_instructions[t_index] += executed;
+            }
+
+        public:
+            TypedBatch(const chip8_batch_config& t_config, const uint8_t* t_rom, std::size_t t_romSize) : Batch(t_config, t_rom, t_romSize){
+                m_machines.reserve(m_count);
+                for(std::size_t index = 0; index < m_count; ++index){
+                    m_machines.emplace_back(new TChip8(m_seed));
+                    resetMachine(index);
+                }
+            }
+
+            void setKeys(const uint16_t* t_keys) override{
+                for(std::size_t index = 0; index < m_count; ++index){
+                    m_machines[index]->setKeystates(t_keys[index]);
+                }
+            }
+
+            const uint8_t* framebuffer(std::size_t t_index) const override{
+                checkIndex(t_index);
+                return m_machines[t_index]->getDisplayData();
+            }
+
+            uint8_t peek(std::size_t t_index, uint16_t t_addr) const override{
+                checkIndex(t_index);
+                return m_machines[t_index]->getMemory().read(t_addr);
+            }
+
+            const uint8_t* registers(std::size_t t_index) const override{
+                checkIndex(t_index);
+                return m_machines[t_index]->getRegisters().data();
+            }
+        };
+
+        // Runs t_func and turns every exception into t_error plus chip8_last_error()
+        template<typename TFunc, typename TRes>
+        TRes guard(TFunc t_func, TRes t_error){
+            try{
+                return t_func();
+            }
+            catch(const std::string& error){
+                lastError = error;
+            }
+            catch(const std::exception& exception){
+                lastError = std::string("libchip8: ") + exception.what();
+            }
+            catch(...){
+                lastError = "libchip8: unknown error";
+            }
+            return t_error;
+        }
+
+    } // namespace Lib
+} // namespace Chip8
+
+struct chip8_batch{
+    std::unique_ptr<Chip8::Lib::Batch> impl;
+};
+
+namespace Lib = Chip8::Lib;
+
+static void requireBatch(const chip8_batch* t_batch){
+    if(!t_batch){
+        throw std::string("libchip8: null batch handle");
+    }
+}
+
+extern "C" {
+
+uint32_t chip8_abi_version(void){
+    return CHIP8_ABI_VERSION;
+}
+
+const char* chip8_last_error(void){
+    return Lib::lastError.c_str();
+}
+
+chip8_batch* chip8_batch_create(const chip8_batch_config* config, const uint8_t* rom, size_t rom_size){
+    return Lib::guard([config, rom, rom_size]() -> chip8_batch*{
+        if(!config || (!rom && rom_size)){
+            throw std::string("libchip8: null config or rom");
+        }
+        std::unique_ptr<chip8_batch> batch(new chip8_batch);
+        switch(config->rng){
+            case CHIP8_RNG_MT19937:
+                batch->impl.reset(new Lib::TypedBatch<Chip8::Chip8>(*config, rom, rom_size));
+                break;
+            case CHIP8_RNG_XORSHIFT:
+                batch->impl.reset(new Lib::TypedBatch<Chip8::Chip8Xorshift>(*config, rom, rom_size));
+                break;
+            case CHIP8_RNG_PCG32:
+                batch->impl.reset(new Lib::TypedBatch<Chip8::Chip8Pcg32>(*config, rom, rom_size));
+                break;
+            default:
+                throw std::string("libchip8: unknown rng " + std::to_string(config->rng));
+        }
+        return batch.release();
+    }, static_cast<chip8_batch*>(nullptr));
+}
+
+void chip8_batch_destroy(chip8_batch* batch){
+    delete batch;
+}
+
+size_t chip8_batch_size(const chip8_batch* batch){
+    return (batch)? batch->impl->size() : 0;
+}
+
+int chip8_batch_reset(chip8_batch* batch, size_t index){
+    return Lib::guard([batch, index]{
+        requireBatch(batch);
+        batch->impl->reset(index, batch);
+        return 0;
+    }, -1);
+}
+
+int chip8_batch_set_keys(chip8_batch* batch, const uint16_t* keys){
+    return Lib::guard([batch, keys]{
+        requireBatch(batch);
+        if(!keys){
+            throw std::string("libchip8: null key array");
+        }
+        batch->impl->setKeys(keys);
+        return 0;
+    }, -1);
+}
+
+long chip8_batch_step(chip8_batch* batch, const uint16_t* keys, uint32_t frames){
+    return Lib::guard([batch, keys, frames]{
+        requireBatch(batch);
+        return batch->impl->step(keys, frames, batch);
+    }, -1L);
+}
+
+const uint8_t* chip8_batch_faults(const chip8_batch* batch){
+    return Lib::guard([batch]{
+        requireBatch(batch);
+        return batch->impl->faults();
+    }, static_cast<const uint8_t*>(nullptr));
+}
+
+const char* chip8_fault_message(const chip8_batch* batch, size_t index){
+    return Lib::guard([batch, index]{
+        requireBatch(batch);
+        return batch->impl->faultMessage(index).c_str();
+    }, static_cast<const char*>(nullptr));
+}
+
+const uint64_t* chip8_batch_instructions(const chip8_batch* batch){
+    return Lib::guard([batch]{
+        requireBatch(batch);
+        return batch->impl->instructions();
+    }, static_cast<const uint64_t*>(nullptr));
+}
+
+const uint8_t* chip8_framebuffer(const chip8_batch* batch, size_t index){
+    return Lib::guard([batch, index]{
+        requireBatch(batch);
+        return batch->impl->framebuffer(index);
+    }, static_cast<const uint8_t*>(nullptr));
+}
+
+const uint8_t* chip8_batch_framebuffers(chip8_batch* batch, chip8_fb_format format){
+    return Lib::guard([batch, format]{
+        requireBatch(batch);
+        return batch->impl->framebuffers(format, batch);
+    }, static_cast<const uint8_t*>(nullptr));
+}
+
+int chip8_peek(const chip8_batch* batch, size_t index, uint16_t addr, uint8_t* value){
+    return Lib::guard([batch, index, addr, value]{
+        requireBatch(batch);
+        if(!value){
+            throw std::string("libchip8: null peek value");
+        }
+        *value = batch->impl->peek(index, addr);
+        return 0;
+    }, -1);
+}
+
+int chip8_peek_registers(const chip8_batch* batch, size_t index, uint8_t* vregs){
+    return Lib::guard([batch, index, vregs]{
+        requireBatch(batch);
+        if(!vregs){
+            throw std::string("libchip8: null register array");
+        }
+        const uint8_t* registers = batch->impl->registers(index);
+        std::copy(registers, registers + CHIP8_NUM_V_REG, vregs);
+        return 0;
+    }, -1);
+}
+
+const uint8_t* chip8_batch_watch(chip8_batch* batch, const uint16_t* addrs, size_t num_addrs){
+    return Lib::guard([batch, addrs, num_addrs]{
+        requireBatch(batch);
+        if(!addrs && num_addrs){
+            throw std::string("libchip8: null watch address list");
+        }
+        return batch->impl->watch(addrs, num_addrs, batch);
+    }, static_cast<const uint8_t*>(nullptr));
+}
+
+int chip8_batch_set_reward(chip8_batch* batch, chip8_reward_fn fn, void* user){
+    return Lib::guard([batch, fn, user]{
+        requireBatch(batch);
+        batch->impl->setReward(fn, user);
+        return 0;
+    }, -1);
+}
+
+const float* chip8_batch_rewards(const chip8_batch* batch){
+    return Lib::guard([batch]{
+        requireBatch(batch);
+        return batch->impl->rewards();
+    }, static_cast<const float*>(nullptr));
+}
+
+} // extern "C"
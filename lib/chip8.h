@@ -0,0 +1,114 @@
+/*
+ * libchip8, C interface to the Chip8 core for external harnesses.
+ *
+ * A batch owns any number of machines running the same rom. Every call that steps or observes
+ * machines works on the whole batch, so driving N environments costs one call per step instead of N.
+ * Machine i of a batch seeded with s draws RND from stream i of s, see Chip8Rng.hpp.
+ *
+ * Functions returning int return 0 on success and -1 on error, functions returning pointers return
+ * NULL on error; chip8_last_error() then describes the failure. Handles are not thread safe, distinct
+ * batches may be used from distinct threads.
+ */
+
+#ifndef LIBCHIP8_H
+#define LIBCHIP8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_ABI_VERSION               1
+
+#define CHIP8_FB_WIDTH                  64
+#define CHIP8_FB_HEIGHT                 32
+/* Packed frame buffer, 8 pixels per byte, most significant bit leftmost, rows top to bottom */
+#define CHIP8_FB_PACKED_SIZE            ((CHIP8_FB_WIDTH / 8) * CHIP8_FB_HEIGHT)
+/* Byte frame buffer, one 0/1 byte per pixel */
+#define CHIP8_FB_BYTES_SIZE             (CHIP8_FB_WIDTH * CHIP8_FB_HEIGHT)
+
+/* One frame is one timer period of the core */
+#define CHIP8_DEFAULT_FRAME_INSTRUCTIONS 10
+
+#if defined(__GNUC__)
+#define CHIP8_API __attribute__((visibility("default")))
+#else
+#define CHIP8_API
+#endif
+
+typedef struct chip8_batch chip8_batch;
+
+typedef enum chip8_rng{
+    CHIP8_RNG_MT19937  = 0,
+    CHIP8_RNG_XORSHIFT = 1,
+    CHIP8_RNG_PCG32    = 2
+} chip8_rng;
+
+typedef enum chip8_fb_format{
+    CHIP8_FB_PACKED = 0,
+    CHIP8_FB_BYTES  = 1
+} chip8_fb_format;
+
+typedef struct chip8_batch_config{
+    size_t count;                       /* machines in the batch */
+    uint64_t seed;                      /* master seed, machine i uses stream i */
+    chip8_rng rng;
+    uint32_t frame_instructions;        /* instructions per frame, 0 selects CHIP8_DEFAULT_FRAME_INSTRUCTIONS */
+    uint32_t threads;                   /* worker threads used to step the batch, 0 or 1 steps on the caller */
+} chip8_batch_config;
+
+/* Called once per machine after every chip8_batch_step, the result lands in chip8_batch_rewards() */
+typedef float (*chip8_reward_fn)(const chip8_batch* batch, size_t index, void* user);
+
+CHIP8_API uint32_t chip8_abi_version(void);
+CHIP8_API const char* chip8_last_error(void);
+
+/* The rom image is copied once and shared copy on write by every machine of the batch */
+CHIP8_API chip8_batch* chip8_batch_create(const chip8_batch_config* config, const uint8_t* rom, size_t rom_size);
+CHIP8_API void chip8_batch_destroy(chip8_batch* batch);
+CHIP8_API size_t chip8_batch_size(const chip8_batch* batch);
+
+/* Resets machine index, or every machine when index is (size_t) -1, to the rom image and its seed stream */
+CHIP8_API int chip8_batch_reset(chip8_batch* batch, size_t index);
+
+/* keys holds one 16 bit key mask per machine, bit k set means key k is held */
+CHIP8_API int chip8_batch_set_keys(chip8_batch* batch, const uint16_t* keys);
+
+/*
+ * Runs frames frames on every live machine. keys may be NULL to keep the current key state.
+ * Returns the number of machines that are still live (not faulted) or -1 on error.
+ */
+CHIP8_API long chip8_batch_step(chip8_batch* batch, const uint16_t* keys, uint32_t frames);
+
+/* Per machine fault flags, nonzero once a machine hit an invalid opcode, cleared by reset */
+CHIP8_API const uint8_t* chip8_batch_faults(const chip8_batch* batch);
+CHIP8_API const char* chip8_fault_message(const chip8_batch* batch, size_t index);
+/* Instructions executed by each machine since its last reset */
+CHIP8_API const uint64_t* chip8_batch_instructions(const chip8_batch* batch);
+
+/* Live packed frame buffer of one machine, valid until the batch is destroyed */
+CHIP8_API const uint8_t* chip8_framebuffer(const chip8_batch* batch, size_t index);
+/*
+ * Frame buffers of every machine laid out back to back, refreshed at the end of each step and reset.
+ * The first call for a format enables it, the pointer stays valid until the batch is destroyed.
+ */
+CHIP8_API const uint8_t* chip8_batch_framebuffers(chip8_batch* batch, chip8_fb_format format);
+
+/* Reward hooks */
+CHIP8_API int chip8_peek(const chip8_batch* batch, size_t index, uint16_t addr, uint8_t* value);
+CHIP8_API int chip8_peek_registers(const chip8_batch* batch, size_t index, uint8_t* vregs);
+/*
+ * Memory bytes gathered after every step and reset, count * num_addrs bytes laid out machine major.
+ * Replaces any previous watch list.
+ */
+CHIP8_API const uint8_t* chip8_batch_watch(chip8_batch* batch, const uint16_t* addrs, size_t num_addrs);
+CHIP8_API int chip8_batch_set_reward(chip8_batch* batch, chip8_reward_fn fn, void* user);
+CHIP8_API const float* chip8_batch_rewards(const chip8_batch* batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCHIP8_H */
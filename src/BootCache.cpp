@@ -0,0 +1,145 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "BootCache.hpp"
+#include "Chip8.hpp"
+#include "Chip8Extended.hpp"
+#include "Chip8Util.hpp"
+#include "LoggerImpl.hpp"
+
+namespace Chip8{
+
+template<typename TChip8>
+BootCache<TChip8>::BootCache(const std::string& t_quirks, const std::string& t_directory, uint64_t t_maxTicks) : m_quirks(t_quirks),
+                                                                                                                  m_directory(t_directory),
+                                                                                                                  m_maxTicks(t_maxTicks){
+    if(!m_directory.empty() && mkdir(m_directory.c_str(), 0755) && errno != EEXIST){
+        throw std::string("BootCache: could not create directory '" + m_directory + "': " + std::strerror(errno));
+    }
+}
+
+template<typename TChip8>
+std::string BootCache<TChip8>::filePath(uint64_t t_romHash) const{
+    std::ostringstream path;
+    path << m_directory << '/' << std::hex << std::setw(16) << std::setfill('0') << t_romHash << '-' << m_quirks << ".boot";
+    return path.str();
+}
+
+// Bytes of machine state a boot file holds: a snapshot less its generator, the same for every generator policy
+template<typename TChip8>
+static constexpr std::size_t bootStateSize(){
+    return TChip8::stateSize - TChip8::Rng::stateSize;
+}
+
+template<typename TChip8>
+bool BootCache<TChip8>::readFile(uint64_t t_romHash, BootState<TChip8>& t_boot) const{
+    std::ifstream bootStream(filePath(t_romHash), std::ios::binary);
+    if(!bootStream.is_open()){
+        return false;
+    }
+
+    // A file from another build or layout is only a stale cache entry, boot again and replace it
+    std::string magic;
+    int version = 0;
+    std::size_t stateSize = 0;
+    bootStream >> magic >> version >> stateSize;
+    if(magic != CHIP8_BOOT_MAGIC || version != CHIP8_BOOT_VERSION || stateSize != bootStateSize<TChip8>() || bootStream.get() != '\n'){
+        return false;
+    }
+    Util::readRaw(bootStream, t_boot.ticks);
+    try{
+        t_boot.state->readState(bootStream);
+    }
+    catch(const std::string&){
+        return false;
+    }
+    return true;
+}
+
+template<typename TChip8>
+void BootCache<TChip8>::writeFile(uint64_t t_romHash, const BootState<TChip8>& t_boot) const{
+    // Written aside then renamed over, a concurrent reader never sees a torn state
+    std::string path = filePath(t_romHash);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream bootStream(tempPath, std::ios::binary | std::ios::trunc);
+        if(!bootStream.is_open()){
+            throw std::string("BootCache: could not create '" + tempPath + "'");
+        }
+        bootStream << CHIP8_BOOT_MAGIC << ' ' << CHIP8_BOOT_VERSION << ' ' << bootStateSize<TChip8>() << '\n';
+        Util::writeRaw(bootStream, t_boot.ticks);
+        t_boot.state->writeState(bootStream);
+        if(!bootStream){
+            throw std::string("BootCache: failed writing '" + tempPath + "'");
+        }
+    }
+    if(std::rename(tempPath.c_str(), path.c_str())){
+        throw std::string("BootCache: could not replace '" + path + "': " + std::strerror(errno));
+    }
+}
+
+template<typename TChip8>
+const BootState<TChip8>& BootCache<TChip8>::boot(uint64_t t_romHash, const TChip8& t_loaded){
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        entry = &m_entries[t_romHash];
+    }
+
+    // Other roms keep going while one boots, callers for the same rom wait for it
+    std::call_once(entry->booted, [this, entry, t_romHash, &t_loaded]{
+        BootState<TChip8>& boot = entry->boot;
+        boot.state.reset(new TChip8(t_loaded));
+        if(!m_directory.empty()){
+            if(readFile(t_romHash, boot)){
+                return;
+            }
+            *boot.state = t_loaded;
+        }
+
+        try{
+            boot.ticks = boot.state->runToInput(m_maxTicks);
+        }
+        catch(const std::string&){
+            boot.ticks = 0;
+        }
+        if(!boot.ticks || boot.ticks >= m_maxTicks){
+            // Faulted or never waited for input, start every run from the loaded rom instead
+            *boot.state = t_loaded;
+            boot.ticks = 0;
+        }
+
+        if(!m_directory.empty()){
+            // The state in memory is good regardless, a cache that cannot be written only costs the next process
+            try{
+                writeFile(t_romHash, boot);
+            }
+            catch(const std::string& error){
+                chip8Logger.log<Logger::LogWarning>(error, Logger::endl);
+            }
+        }
+    });
+    return entry->boot;
+}
+
+template class BootCache<Chip8>;
+template class BootCache<Chip8Xorshift>;
+template class BootCache<Chip8Pcg32>;
+template class BootCache<Chip8Vip>;
+template class BootCache<Chip8Chip48>;
+template class BootCache<Chip8SuperChip>;
+template class BootCache<SuperChip8>;
+template class BootCache<XoChip8>;
+// Debug builds boot to the same states, and share the files of their variant
+template class BootCache<Chip8Debug>;
+template class BootCache<Chip8VipDebug>;
+template class BootCache<Chip8Chip48Debug>;
+template class BootCache<SuperChip8Debug>;
+template class BootCache<XoChip8Debug>;
+
+} // namespace Chip8
@@ -0,0 +1,59 @@
+#ifndef CHIP8_BOOT_CACHE_HPP
+#define CHIP8_BOOT_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#define CHIP8_BOOT_MAGIC          "chip8-boot"
+#define CHIP8_BOOT_VERSION        2
+#define CHIP8_BOOT_MAX_TICKS      0x100000
+
+namespace Chip8{
+
+// Machine state of a rom at its first input wait. ticks is the number of ticks from load to state, 0 when the
+// rom faulted or never waited for input within the tick limit and state is the freshly loaded machine.
+template<typename TChip8>
+struct BootState{
+    std::unique_ptr<TChip8> state;
+    uint64_t ticks = 0;
+};
+
+// Boot states by rom content hash. Until its first SKP, SKNP, LD Vx, K or RND a program runs the same for
+// every seed and input, so that prefix is run once per rom and every later reset, relaunch or farm job starts
+// from a copy of its end state (see BasicChip8::restore). With a directory the states are also kept on disk as
+// '<hash>-<quirks>.boot' and survive the process; those files leave the generator out, so instantiations that only
+// differ in their generator share them. Safe to share between threads.
+template<typename TChip8>
+class BootCache{
+
+private:
+    struct Entry{
+        std::once_flag booted;
+        BootState<TChip8> boot;
+    };
+
+    std::string m_quirks;
+    std::string m_directory;
+    uint64_t m_maxTicks;
+    std::mutex m_lock;
+    std::unordered_map<uint64_t, Entry> m_entries;
+
+    std::string filePath(uint64_t t_romHash) const;
+    bool readFile(uint64_t t_romHash, BootState<TChip8>& t_boot) const;
+    void writeFile(uint64_t t_romHash, const BootState<TChip8>& t_boot) const;
+
+public:
+    // t_quirks names the interpreter variant in file names, an empty t_directory keeps states in memory only
+    BootCache(const std::string& t_quirks, const std::string& t_directory = "", uint64_t t_maxTicks = CHIP8_BOOT_MAX_TICKS);
+
+    // Boot state of the rom hashed t_romHash. On the first call for a rom it is read from the directory or
+    // else run from t_loaded, an instance that has just loaded the rom.
+    const BootState<TChip8>& boot(uint64_t t_romHash, const TChip8& t_loaded);
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_BOOT_CACHE_HPP
@@ -0,0 +1,68 @@
+#include <algorithm>
+
+#include "Breakpoints.hpp"
+
+namespace Chip8{
+
+Breakpoints::Breakpoints(std::size_t t_memorySize) : m_mask(static_cast<uint32_t>(t_memorySize - 1)),
+                                                     m_hitKind(BREAK_EXEC),
+                                                     m_hitAddr(0),
+                                                     m_hit(false){
+    if(t_memorySize < 64 || t_memorySize > (std::size_t(1) << 32) || (t_memorySize & (t_memorySize - 1))){
+        throw std::string("Breakpoints: memory size " + std::to_string(t_memorySize) + " is not a power of two of at least 64");
+    }
+    m_exec.assign(t_memorySize / 64, 0);
+    m_read.assign(t_memorySize / 64, 0);
+    m_write.assign(t_memorySize / 64, 0);
+}
+
+static void setBits(std::vector<uint64_t>& t_bits, uint32_t t_mask, uint32_t t_addr, uint32_t t_length, bool t_set){
+    for(uint32_t offset = 0; offset < t_length && offset <= t_mask; ++offset){
+        uint32_t addr = (t_addr + offset) & t_mask;
+        uint64_t bit = uint64_t(1) << (addr & 63);
+        t_bits[addr >> 6] = (t_set)? t_bits[addr >> 6] | bit : t_bits[addr >> 6] & ~bit;
+    }
+}
+
+void Breakpoints::set(BreakpointKind t_kind, uint32_t t_addr, uint32_t t_length){
+    if(t_kind == BREAK_EXEC){
+        setBits(m_exec, m_mask, t_addr, t_length, true);
+    }
+    if(t_kind == BREAK_READ || t_kind == BREAK_ACCESS){
+        setBits(m_read, m_mask, t_addr, t_length, true);
+    }
+    if(t_kind == BREAK_WRITE || t_kind == BREAK_ACCESS){
+        setBits(m_write, m_mask, t_addr, t_length, true);
+    }
+}
+
+void Breakpoints::clear(BreakpointKind t_kind, uint32_t t_addr, uint32_t t_length){
+    if(t_kind == BREAK_EXEC){
+        setBits(m_exec, m_mask, t_addr, t_length, false);
+    }
+    if(t_kind == BREAK_READ || t_kind == BREAK_ACCESS){
+        setBits(m_read, m_mask, t_addr, t_length, false);
+    }
+    if(t_kind == BREAK_WRITE || t_kind == BREAK_ACCESS){
+        setBits(m_write, m_mask, t_addr, t_length, false);
+    }
+}
+
+void Breakpoints::clearAll(){
+    std::fill(m_exec.begin(), m_exec.end(), 0);
+    std::fill(m_read.begin(), m_read.end(), 0);
+    std::fill(m_write.begin(), m_write.end(), 0);
+    m_hit = false;
+}
+
+bool Breakpoints::watched(BreakpointKind t_kind, uint32_t t_addr) const{
+    t_addr &= m_mask;
+    switch(t_kind){
+        case BREAK_EXEC:    return test(m_exec, t_addr);
+        case BREAK_READ:    return test(m_read, t_addr);
+        case BREAK_WRITE:   return test(m_write, t_addr);
+        default:            return test(m_read, t_addr) && test(m_write, t_addr);
+    }
+}
+
+} // namespace Chip8
@@ -0,0 +1,99 @@
+#ifndef CHIP8_BREAKPOINTS_HPP
+#define CHIP8_BREAKPOINTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Chip8{
+
+enum BreakpointKind{
+    BREAK_EXEC,     // before the instruction at the address runs
+    BREAK_READ,     // after an instruction read the byte as data
+    BREAK_WRITE,    // after an instruction wrote the byte
+    BREAK_ACCESS    // read or write
+};
+
+// Execution, read and write breakpoints as one bit per guest address. Execution bits are tested by Debugger
+// before each tick, read and write bits by the data accesses of the debug instantiations of the cores (see
+// Quirks::Debug), which record the first access of a tick for the debugger to stop on. Instruction fetches
+// never count as reads.
+class Breakpoints{
+
+private:
+    uint32_t m_mask;
+    std::vector<uint64_t> m_exec;
+    std::vector<uint64_t> m_read;
+    std::vector<uint64_t> m_write;
+    // Set by the first watched access since clearHit()
+    BreakpointKind m_hitKind;
+    uint32_t m_hitAddr;
+    bool m_hit;
+
+    static bool test(const std::vector<uint64_t>& t_bits, uint32_t t_addr){
+        return (t_bits[t_addr >> 6] >> (t_addr & 63)) & 1;
+    }
+
+    void record(BreakpointKind t_kind, uint32_t t_addr){
+        if(!m_hit){
+            m_hit = true;
+            m_hitKind = t_kind;
+            m_hitAddr = t_addr;
+        }
+    }
+
+public:
+    // Throws std::string unless t_memorySize is a power of two of at least 64, addresses wrap at it
+    explicit Breakpoints(std::size_t t_memorySize);
+
+    // Sets or clears t_length bytes from t_addr, BREAK_ACCESS sets both watch kinds
+    void set(BreakpointKind t_kind, uint32_t t_addr, uint32_t t_length = 1);
+    void clear(BreakpointKind t_kind, uint32_t t_addr, uint32_t t_length = 1);
+    void clearAll();
+
+    std::size_t memorySize() const{
+        return m_mask + 1;
+    }
+
+    bool exec(uint32_t t_addr) const{
+        return test(m_exec, t_addr & m_mask);
+    }
+
+    bool watched(BreakpointKind t_kind, uint32_t t_addr) const;
+
+    // Hooks of the cores, inline since debug builds call them on every data access
+    void read(uint32_t t_addr){
+        t_addr &= m_mask;
+        if(test(m_read, t_addr)){
+            record(BREAK_READ, t_addr);
+        }
+    }
+
+    void write(uint32_t t_addr){
+        t_addr &= m_mask;
+        if(test(m_write, t_addr)){
+            record(BREAK_WRITE, t_addr);
+        }
+    }
+
+    bool hit() const{
+        return m_hit;
+    }
+
+    BreakpointKind hitKind() const{
+        return m_hitKind;
+    }
+
+    uint32_t hitAddress() const{
+        return m_hitAddr;
+    }
+
+    void clearHit(){
+        m_hit = false;
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_BREAKPOINTS_HPP
@@ -10,34 +10,107 @@
 #include <endian.h>
 #include <iomanip>
 #include <climits>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <ostream>
 
 #include "Bitfield.hpp"
 #include "Chip8.hpp"
+#include "Chip8Util.hpp"
 #include "LoggerImpl.hpp"
+#include "RomCorpus.hpp"
 
 namespace Chip8{
 
-Chip8::Chip8(std::mt19937::result_type t_seed) : m_dist(0, 255), m_seed(t_seed) {
+template<typename TRng, typename TQuirks>
+BasicChip8<TRng, TQuirks>::BasicChip8(uint64_t t_seed) : m_timerPeriod(CHIP8_TIMER_PERIOD), m_seed(t_seed), m_breakpoints(nullptr) {
     reset(m_seed);
 }
 
-Chip8::Chip8(std::mt19937::result_type seed, const std::string& filePath) : m_dist(0, 255), m_seed(seed) {
+template<typename TRng, typename TQuirks>
+BasicChip8<TRng, TQuirks>::BasicChip8(uint64_t seed, const std::string& filePath) : m_timerPeriod(CHIP8_TIMER_PERIOD), m_seed(seed), m_breakpoints(nullptr) {
     reset(m_seed);
     load(filePath);
 }
 
-Chip8::Chip8(std::mt19937::result_type seed, std::istream& inStream) : m_dist(0, 255), m_seed(seed){
+template<typename TRng, typename TQuirks>
+BasicChip8<TRng, TQuirks>::BasicChip8(uint64_t seed, std::istream& inStream) : m_timerPeriod(CHIP8_TIMER_PERIOD), m_seed(seed), m_breakpoints(nullptr){
     reset(m_seed);
     load(inStream);
 }
 
-void Chip8::reset(){
+template<typename TRng, typename TQuirks>
+void* BasicChip8<TRng, TQuirks>::operator new(std::size_t t_size){
+    void* storage = nullptr;
+    if(posix_memalign(&storage, alignof(BasicChip8), t_size)){
+        throw std::bad_alloc();
+    }
+    return storage;
+}
+
+template<typename TRng, typename TQuirks>
+void* BasicChip8<TRng, TQuirks>::operator new[](std::size_t t_size){
+    return operator new(t_size);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::operator delete(void* t_ptr){
+    free(t_ptr);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::operator delete[](void* t_ptr){
+    free(t_ptr);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::layoutReport(std::ostream& t_outStream){
+    // Offsets are taken from a live instance, the register file holds a bit field so offsetof is not an option
+    std::unique_ptr<BasicChip8> inst(new BasicChip8(0));
+    const char* base = reinterpret_cast<const char*>(inst.get());
+    auto offset = [base](const void* t_member){
+        return static_cast<long>(reinterpret_cast<const char*>(t_member) - base);
+    };
+
+    t_outStream << "sizeof " << sizeof(BasicChip8) << ", alignof " << alignof(BasicChip8) << '\n'
+                << "  hot   vRegs          @" << offset(&inst->m_vRegs) << " +" << sizeof(inst->m_vRegs) << '\n'
+                << "  hot   programCounter @" << offset(&inst->m_programCounter) << " +" << sizeof(inst->m_programCounter) << '\n'
+                << "  hot   iReg           @" << offset(&inst->m_iReg) << " +" << sizeof(inst->m_iReg) << '\n'
+                << "  hot   keystates      @" << offset(&inst->m_keystates) << " +" << sizeof(inst->m_keystates) << '\n'
+                << "  hot   dtReg          @" << offset(&inst->m_dtReg) << " +" << sizeof(inst->m_dtReg) << '\n'
+                << "  hot   stReg          @" << offset(&inst->m_stReg) << " +" << sizeof(inst->m_stReg) << '\n'
+                << "  hot   tCounter       @" << offset(&inst->m_tCounter) << " +" << sizeof(inst->m_tCounter) << '\n'
+                << "  hot   timerPeriod    @" << offset(&inst->m_timerPeriod) << " +" << sizeof(inst->m_timerPeriod) << '\n'
+                << "  hot   stack          @" << offset(&inst->m_stack) << " +" << sizeof(inst->m_stack) << '\n'
+                << "  warm  memory         @" << offset(&inst->m_memory) << " +" << sizeof(inst->m_memory) << '\n'
+                << "  warm  disp           @" << offset(&inst->m_disp) << " +" << sizeof(inst->m_disp) << '\n'
+                << "  warm  counters       @" << offset(&inst->m_counters) << " +" << sizeof(inst->m_counters) << '\n'
+                << "  cold  seed           @" << offset(&inst->m_seed) << " +" << sizeof(inst->m_seed) << '\n'
+                << "  cold  generator      @" << offset(&inst->m_generator) << " +" << sizeof(inst->m_generator) << '\n'
+                << "  cold  breakpoints    @" << offset(&inst->m_breakpoints) << " +" << sizeof(inst->m_breakpoints) << '\n';
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::reset(){
     reset(m_seed);
 }
 
-void Chip8::reset(std::mt19937::result_type seed) {
-    std::copy(m_spriteTable.begin(), m_spriteTable.end(), m_memory.begin());
-    std::fill(m_memory.begin() + CHIP8_SPRITE_TABLE_SIZE, m_memory.end(), 0);
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::reset(uint64_t seed) {
+    resetMachine();
+    m_generator = TRng(seed);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::reset(uint64_t t_seed, uint64_t t_stream){
+    resetMachine();
+    m_generator = TRng::split(t_seed, t_stream);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::resetMachine(){
+    m_memory.reset(PagedMemory::blankImage());
     std::fill(m_stack.begin(), m_stack.end(), 0);
     std::fill(m_vRegs.begin(), m_vRegs.end(), 0);
     m_iReg = 0;
@@ -47,164 +120,414 @@ void Chip8::reset(std::mt19937::result_type seed) {
     std::fill(std::begin(m_disp), std::end(m_disp), 0);
     m_programCounter = CHIP8_PROG_START_OFFSET;
     m_stackPointer = 0xf;
-    m_generator = std::mt19937(seed);
+    m_keystates = 0;
+    m_counters = ExecutionCounters();
 }
 
-void Chip8::load(const std::string& file_path){
+// Current memory contents as a new image, loads overlay the rom on top of it
+template<typename TRng, typename TQuirks>
+std::shared_ptr<MemoryImage> BasicChip8<TRng, TQuirks>::snapshotMemory() const{
+    std::shared_ptr<MemoryImage> image = std::make_shared<MemoryImage>();
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        std::copy(m_memory.page(page), m_memory.page(page) + CHIP8_PAGE_SIZE, image->begin() + (page << CHIP8_PAGE_SHIFT));
+    }
+    return image;
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::load(const std::string& file_path){
     std::ifstream file_stream;
     file_stream.open(file_path);
     load(file_stream);
 }
 
-void Chip8::load(std::istream& inStream){
-    inStream.read((char*) (m_memory.begin() + CHIP8_PROG_START_OFFSET), CHIP8_MAIN_MEM_SIZE - CHIP8_PROG_START_OFFSET);
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::load(std::istream& inStream){
+    std::shared_ptr<MemoryImage> image = snapshotMemory();
+    inStream.read((char*) (image->begin() + CHIP8_PROG_START_OFFSET), CHIP8_MAIN_MEM_SIZE - CHIP8_PROG_START_OFFSET);
+    m_memory.reset(std::move(image));
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::load(const uint8_t* t_rom, std::size_t t_size){
+    std::shared_ptr<MemoryImage> image = snapshotMemory();
+    std::copy(t_rom, t_rom + std::min<std::size_t>(t_size, CHIP8_MAIN_MEM_SIZE - CHIP8_PROG_START_OFFSET), image->begin() + CHIP8_PROG_START_OFFSET);
+    m_memory.reset(std::move(image));
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::load(const RomCorpus& t_corpus, std::size_t t_index){
+    RomCorpus::Rom rom = t_corpus.rom(t_index);
+    load(rom.data, rom.size);
 }
 
-void Chip8::updateKeystate(bool press_state, bool repeat, const Chip8Key& key){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::load(std::shared_ptr<const MemoryImage> t_image){
+    m_memory.reset(std::move(t_image));
+}
+
+template<typename TRng, typename TQuirks>
+uint64_t BasicChip8<TRng, TQuirks>::runToInput(uint64_t t_maxTicks){
+    uint64_t ticks = 0;
+    while(ticks < t_maxTicks && !readsInput((m_memory.read(m_programCounter) << 8) | m_memory.read(m_programCounter + 1))){
+        run_tick();
+        ++ticks;
+    }
+    if(m_memory.privatePages()){
+        m_memory.reset(snapshotMemory());
+    }
+    return ticks;
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::restore(const BasicChip8& t_boot, uint64_t t_seed){
+    // The boot state has no private pages, so this is a register copy and a shared image
+    uint64_t seed = m_seed;
+    Breakpoints* breakpoints = m_breakpoints;
+    uint8_t timerPeriod = m_timerPeriod;
+    *this = t_boot;
+    m_seed = seed;
+    m_breakpoints = breakpoints;
+    m_timerPeriod = timerPeriod;
+    m_generator = TRng(t_seed);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::writeState(std::ostream& t_outStream) const{
+    const uint8_t stackPointer = m_stackPointer;
+    Util::writeRaw(t_outStream, m_vRegs);
+    Util::writeRaw(t_outStream, m_programCounter);
+    Util::writeRaw(t_outStream, m_iReg);
+    Util::writeRaw(t_outStream, m_keystates);
+    Util::writeRaw(t_outStream, m_dtReg);
+    Util::writeRaw(t_outStream, m_stReg);
+    Util::writeRaw(t_outStream, m_tCounter);
+    Util::writeRaw(t_outStream, stackPointer);
+    Util::writeRaw(t_outStream, m_stack);
+    Util::writeRaw(t_outStream, m_disp);
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        t_outStream.write(reinterpret_cast<const char*>(m_memory.page(page)), CHIP8_PAGE_SIZE);
+    }
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::readState(std::istream& t_inStream){
+    uint8_t stackPointer = 0;
+    std::shared_ptr<MemoryImage> image = std::make_shared<MemoryImage>();
+    Util::readRaw(t_inStream, m_vRegs);
+    Util::readRaw(t_inStream, m_programCounter);
+    Util::readRaw(t_inStream, m_iReg);
+    Util::readRaw(t_inStream, m_keystates);
+    Util::readRaw(t_inStream, m_dtReg);
+    Util::readRaw(t_inStream, m_stReg);
+    Util::readRaw(t_inStream, m_tCounter);
+    Util::readRaw(t_inStream, stackPointer);
+    Util::readRaw(t_inStream, m_stack);
+    Util::readRaw(t_inStream, m_disp);
+    Util::readRaw(t_inStream, *image);
+    if(!t_inStream){
+        throw std::string("Chip8: truncated machine state");
+    }
+    m_stackPointer = stackPointer;
+    m_memory.reset(std::move(image));
+}
+
+template<typename TRng, typename TQuirks>
+constexpr std::size_t BasicChip8<TRng, TQuirks>::stateSize;
+
+template<typename TRng, typename TQuirks>
+std::size_t BasicChip8<TRng, TQuirks>::saveState(uint8_t* t_buffer, std::size_t t_size) const{
+    if(t_size < stateSize){
+        throw std::string("Chip8: state buffer too small");
+    }
+
+    uint8_t* out = t_buffer;
+    Util::putLE<uint32_t>(out, CHIP8_STATE_MAGIC);
+    Util::putLE<uint16_t>(out, CHIP8_STATE_VERSION);
+    Util::putLE<uint16_t>(out, TRng::stateSize);
+    Util::putLE(out, m_seed);
+    out = std::copy(m_vRegs.begin(), m_vRegs.end(), out);
+    Util::putLE(out, m_programCounter);
+    Util::putLE(out, m_iReg);
+    Util::putLE(out, m_keystates);
+    Util::putLE(out, m_dtReg);
+    Util::putLE(out, m_stReg);
+    Util::putLE(out, m_tCounter);
+    Util::putLE<uint8_t>(out, m_stackPointer);
+    for(uint16_t entry : m_stack){
+        Util::putLE(out, entry);
+    }
+    out = std::copy(m_disp.begin(), m_disp.end(), out);
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        out = std::copy(m_memory.page(page), m_memory.page(page) + CHIP8_PAGE_SIZE, out);
+    }
+    m_generator.saveState(out);
+    return stateSize;
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::loadState(const uint8_t* t_buffer, std::size_t t_size){
+    if(t_size < stateSize){
+        throw std::string("Chip8: truncated machine state");
+    }
+
+    const uint8_t* in = t_buffer;
+    if(Util::getLE<uint32_t>(in) != CHIP8_STATE_MAGIC){
+        throw std::string("Chip8: not a machine state");
+    }
+    if(Util::getLE<uint16_t>(in) != CHIP8_STATE_VERSION){
+        throw std::string("Chip8: unsupported machine state version");
+    }
+    if(Util::getLE<uint16_t>(in) != TRng::stateSize){
+        throw std::string("Chip8: machine state was saved with another generator");
+    }
+    m_seed = Util::getLE<uint64_t>(in);
+    std::copy(in, in + CHIP8_NUM_V_REG, m_vRegs.begin());
+    in += CHIP8_NUM_V_REG;
+    m_programCounter = Util::getLE<uint16_t>(in);
+    m_iReg = Util::getLE<uint16_t>(in);
+    m_keystates = Util::getLE<uint16_t>(in);
+    m_dtReg = Util::getLE<uint8_t>(in);
+    m_stReg = Util::getLE<uint8_t>(in);
+    m_tCounter = Util::getLE<uint8_t>(in);
+    m_stackPointer = Util::getLE<uint8_t>(in);
+    for(uint16_t& entry : m_stack){
+        entry = Util::getLE<uint16_t>(in);
+    }
+    std::copy(in, in + CHIP8_DISP_SIZE, m_disp.begin());
+    in += CHIP8_DISP_SIZE;
+    m_memory.assign(in);
+    in += CHIP8_MAIN_MEM_SIZE;
+    m_generator.loadState(in);
+}
+
+// Hash of the full architectural state, used to compare runs
+template<typename TRng, typename TQuirks>
+uint64_t BasicChip8<TRng, TQuirks>::stateHash() const{
+    const uint8_t regs[] = {static_cast<uint8_t>(m_iReg >> 8), static_cast<uint8_t>(m_iReg),
+                            static_cast<uint8_t>(m_programCounter >> 8), static_cast<uint8_t>(m_programCounter),
+                            m_dtReg, m_stReg, static_cast<uint8_t>(m_stackPointer), m_tCounter};
+    uint64_t hash = Util::fnv1a(regs, sizeof(regs));
+    hash = Util::fnv1a(m_vRegs.data(), m_vRegs.size(), hash);
+    for(uint16_t entry : m_stack){
+        const uint8_t bytes[] = {static_cast<uint8_t>(entry >> 8), static_cast<uint8_t>(entry)};
+        hash = Util::fnv1a(bytes, sizeof(bytes), hash);
+    }
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        hash = Util::fnv1a(m_memory.page(page), CHIP8_PAGE_SIZE, hash);
+    }
+    return Util::fnv1a(m_disp.data(), m_disp.size(), hash);
+}
+
+template<typename TRng, typename TQuirks>
+uint64_t BasicChip8<TRng, TQuirks>::fullStateHash() const{
+    // Word hash rather than fnv1a, this is called for every state a search visits
+    const uint64_t regs[] = {static_cast<uint64_t>(m_iReg) | static_cast<uint64_t>(m_programCounter) << 16 | static_cast<uint64_t>(m_dtReg) << 32
+                             | static_cast<uint64_t>(m_stReg) << 40 | static_cast<uint64_t>(m_stackPointer) << 48 | static_cast<uint64_t>(m_tCounter) << 56,
+                             m_generator.fingerprint()};
+    uint64_t hash = Util::wordHash(reinterpret_cast<const uint8_t*>(regs), sizeof(regs));
+    hash = Util::wordHash(m_vRegs.data(), m_vRegs.size(), hash);
+    hash = Util::wordHash(reinterpret_cast<const uint8_t*>(m_stack.data()), m_stack.size() * sizeof(uint16_t), hash);
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        hash = Util::wordHash(m_memory.page(page), CHIP8_PAGE_SIZE, hash);
+    }
+    return Util::wordHash(m_disp.data(), m_disp.size(), hash);
+}
+
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::updateKeystate(bool press_state, bool repeat, const Chip8Key& key){
     if(key != KEY_NULL)
         m_keystates = (m_keystates & ~(0x1 << key)) | (press_state << key & (0x1 << key));
 }
 
-void Chip8::CLS(){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::CLS(){
     std::fill(m_disp.begin(), m_disp.end(), 0);
 }
 
-void Chip8::RET(){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::RET(){
     m_programCounter = m_stack[++m_stackPointer];
 }
 
-void Chip8::JMP(uint16_t t_nnn){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::JMP(uint16_t t_nnn){
     m_programCounter = t_nnn;
 }
 
-void Chip8::CALL(uint16_t t_nnn){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::CALL(uint16_t t_nnn){
     m_stack[m_stackPointer--] = m_programCounter;
     m_programCounter = t_nnn;
 }
 
-void Chip8::SE_IMM(uint8_t t_x, uint8_t t_kk){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SE_IMM(uint8_t t_x, uint8_t t_kk){
     if(m_vRegs[t_x] == t_kk){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::SNE_IMM(uint8_t t_x, uint8_t t_kk){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SNE_IMM(uint8_t t_x, uint8_t t_kk){
     if(m_vRegs[t_x] != t_kk){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::SE_REG(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SE_REG(uint8_t t_x, uint8_t t_y){
     if(m_vRegs[t_x] == m_vRegs[t_y]){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::LD_IMM(uint8_t t_x, uint8_t t_kk){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_IMM(uint8_t t_x, uint8_t t_kk){
     m_vRegs[t_x] = t_kk;
 }
 
-void Chip8::ADD_IMM(uint8_t t_x, uint8_t t_kk){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::ADD_IMM(uint8_t t_x, uint8_t t_kk){
     m_vRegs[t_x] += t_kk;
 }
 
-void Chip8::LD_REG(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_REG(uint8_t t_x, uint8_t t_y){
     m_vRegs[t_x] = m_vRegs[t_y];
 }
 
-void Chip8::OR(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::OR(uint8_t t_x, uint8_t t_y){
     m_vRegs[t_x] |= m_vRegs[t_y];
 }
 
-void Chip8::AND(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::AND(uint8_t t_x, uint8_t t_y){
     m_vRegs[t_x] &= m_vRegs[t_y];
 }
 
-void Chip8::XOR(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::XOR(uint8_t t_x, uint8_t t_y){
     m_vRegs[t_x] ^= m_vRegs[t_y];
 }
 
-void Chip8::ADD_REG(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::ADD_REG(uint8_t t_x, uint8_t t_y){
     m_vRegs[0xf] = (m_vRegs[t_x] > (UINT8_MAX - m_vRegs[t_y]))? 0x01 : 0x00;
     m_vRegs[t_x] += m_vRegs[t_y];
 }
 
-void Chip8::SUB_REG(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SUB_REG(uint8_t t_x, uint8_t t_y){
     m_vRegs[0xf] = static_cast<uint8_t>(m_vRegs[t_x] > m_vRegs[t_y]);
     m_vRegs[t_x] -= m_vRegs[t_y];
 }
 
-void Chip8::SHR(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SHR(uint8_t t_x, uint8_t t_y){
+    if(TQuirks::shiftUsesVy){
+        uint8_t value = m_vRegs[t_y];
+        m_vRegs[t_x] = value >> 1;
+        m_vRegs[0xf] = value & 0x01;
+        return;
+    }
     m_vRegs[0xf] = m_vRegs[t_x] & 0x01;
     m_vRegs[t_x] >>= 1;
 }
 
-void Chip8::SUBN(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SUBN(uint8_t t_x, uint8_t t_y){
     m_vRegs[0xf] = static_cast<uint8_t>(m_vRegs[t_y] > m_vRegs[t_x]);
     m_vRegs[t_x] = m_vRegs[t_y] - m_vRegs[t_x];
 }
 
-void Chip8::SHL(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SHL(uint8_t t_x, uint8_t t_y){
+    if(TQuirks::shiftUsesVy){
+        uint8_t value = m_vRegs[t_y];
+        m_vRegs[t_x] = value << 1;
+        m_vRegs[0xf] = (value & 0x80)? 0x01 : 0x00;
+        return;
+    }
     m_vRegs[0xf] = (m_vRegs[t_x] & 0x80)? 0x01 : 0x00;
     m_vRegs[t_x] <<= 1;
 }
 
-void Chip8::SNE_REG(uint8_t t_x, uint8_t t_y){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SNE_REG(uint8_t t_x, uint8_t t_y){
     if(m_vRegs[t_x] != m_vRegs[t_y]){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::LD_I(uint16_t t_nnn){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_I(uint16_t t_nnn){
     m_iReg = t_nnn & 0x0fff;
 }
 
-void Chip8::JMP_REG(uint16_t t_nnn){
-    m_programCounter = m_vRegs[0] + t_nnn;
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::JMP_REG(uint16_t t_nnn){
+    m_programCounter = m_vRegs[(TQuirks::jumpUsesVx)? (t_nnn >> 8) : 0] + t_nnn;
 }
 
-void Chip8::RND(uint8_t t_x, uint8_t t_kk){
-    m_vRegs[t_x] = m_dist(m_generator) & t_kk;
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::RND(uint8_t t_x, uint8_t t_kk){
+    m_vRegs[t_x] = m_generator.next() & t_kk;
 }
 
-void Chip8::DRW(uint8_t t_x, uint8_t t_y, uint8_t t_n){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::DRW(uint8_t t_x, uint8_t t_y, uint8_t t_n){
     m_vRegs[0xf] = 0x00;
+    ++m_counters.draws;
     for(uint8_t spriteLine = 0; spriteLine < t_n; ++spriteLine){
-        uint8_t spriteByte = m_memory[m_iReg + spriteLine];
-        uint8_t dispX = m_vRegs[t_x] >> 3, dispY = m_vRegs[t_y] + spriteLine;
-
-        if(dispY > 0x1f){
-            dispY -= 0x20;
+        uint8_t spriteByte = readData(m_iReg + spriteLine);
+        // The sprite origin always wraps, the sprite itself wraps around both edges or is clipped by them
+        uint8_t dispX = (m_vRegs[t_x] >> 3) & ((CHIP8_DISP_X >> 3) - 1), dispY = (m_vRegs[t_y] & (CHIP8_DISP_Y - 1)) + spriteLine;
+        if(TQuirks::clipSprites && dispY >= CHIP8_DISP_Y){
+            break;
         }
+        dispY &= CHIP8_DISP_Y - 1;
+        ++m_counters.spriteRows;
+
         m_vRegs[0xf] |= (m_disp[dispX + dispY * (CHIP8_DISP_X >> 3)] & (spriteByte >> (m_vRegs[t_x] & 0x07)))? 0x01 : 0x00;
         m_disp[dispX + dispY * (CHIP8_DISP_X >> 3)] ^= (spriteByte >> (m_vRegs[t_x] & 0x07));
-        if(m_vRegs[t_x] & 0x7){
-            if(dispX + 1 > 0x3f){
-                dispX -= 0x3f;
-            }
-            m_vRegs[0xf] |= (m_disp[dispX + 1 + dispY * (CHIP8_DISP_X >> 3)] & (spriteByte << (8 - (m_vRegs[t_x] & 0x07))))? 0x01 : 0x00;
-            m_disp[dispX + 1 + dispY * (CHIP8_DISP_X >> 3)] ^= (spriteByte << (8 - (m_vRegs[t_x] & 0x07)));
+        if((m_vRegs[t_x] & 0x7) && !(TQuirks::clipSprites && dispX == (CHIP8_DISP_X >> 3) - 1)){
+            dispX = (dispX + 1) & ((CHIP8_DISP_X >> 3) - 1);
+            m_vRegs[0xf] |= (m_disp[dispX + dispY * (CHIP8_DISP_X >> 3)] & (spriteByte << (8 - (m_vRegs[t_x] & 0x07))))? 0x01 : 0x00;
+            m_disp[dispX + dispY * (CHIP8_DISP_X >> 3)] ^= (spriteByte << (8 - (m_vRegs[t_x] & 0x07)));
         }
     }
+    m_counters.collisions += m_vRegs[0xf];
 }
 
-void Chip8::SKP(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SKP(uint8_t t_x){
     if(m_vRegs[t_x] < 0x10 && (m_keystates >> m_vRegs[t_x]) & 0x01){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::SKNP(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::SKNP(uint8_t t_x){
     if(m_vRegs[t_x] < 0x10 && !((m_keystates >> m_vRegs[t_x]) & 0x01)){
         m_programCounter += 2;
+        ++m_counters.skipsTaken;
     }
 }
 
-void Chip8::LD_VX_DT(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_VX_DT(uint8_t t_x){
     m_vRegs[t_x] = m_dtReg;
 }
 
-void Chip8::LD_KP(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_KP(uint8_t t_x){
     if(m_keystates){
         uint8_t keyIndex = 0;
         while(m_keystates >> keyIndex){
@@ -216,44 +539,57 @@ void Chip8::LD_KP(uint8_t t_x){
             ++keyIndex;
         }
     }
+    else{
+        ++m_counters.keyWaits;
+    }
 }
 
-void Chip8::LD_DT_VX(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_DT_VX(uint8_t t_x){
     m_dtReg = m_vRegs[t_x];
 }
 
-void Chip8::LD_ST(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_ST(uint8_t t_x){
     m_stReg = m_vRegs[t_x];
 }
 
-void Chip8::ADD_I(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::ADD_I(uint8_t t_x){
     m_iReg += m_vRegs[t_x];
 }
 
-void Chip8::LD_SPRT(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_SPRT(uint8_t t_x){
     m_iReg = 5 * m_vRegs[t_x];
 }
 
-void Chip8::LD_BCD(uint8_t t_x){
-    m_memory[m_iReg] = m_vRegs[t_x] / 100;
-    m_memory[m_iReg +1] = (m_vRegs[t_x] % 100) / 10;
-    m_memory[m_iReg + 2] = m_vRegs[t_x] % 10;
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_BCD(uint8_t t_x){
+    writeData(m_iReg, m_vRegs[t_x] / 100);
+    writeData(m_iReg + 1, (m_vRegs[t_x] % 100) / 10);
+    writeData(m_iReg + 2, m_vRegs[t_x] % 10);
 }
 
-void Chip8::LD_MEM(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_MEM(uint8_t t_x){
     for(uint8_t i = 0; i <= t_x; ++i){
-        m_memory[m_iReg + i] = m_vRegs[i];
+        writeData(m_iReg + i, m_vRegs[i]);
     }
+    advanceIndex(t_x);
 }
 
-void Chip8::LD_REGS(uint8_t t_x){
+template<typename TRng, typename TQuirks>
+void BasicChip8<TRng, TQuirks>::LD_REGS(uint8_t t_x){
     for(uint8_t i = 0; i <= t_x; ++i){
-        m_vRegs[i] = m_memory[m_iReg + i];
+        m_vRegs[i] = readData(m_iReg + i);
     }
+    advanceIndex(t_x);
 }
 
 
-TickResult Chip8::run_tick() {
+template<typename TRng, typename TQuirks>
+TickResult BasicChip8<TRng, TQuirks>::run_tick() {
 
 
     chip8Logger.log<Logger::LogTrace>("Chip8: key state: 0x", std::hex, std::setw(4), std::setfill('0'), m_keystates, Logger::endl);
@@ -304,7 +640,7 @@ TickResult Chip8::run_tick() {
 
     chip8Logger.log<Logger::LogTrace>("Chip8: t_counter:", static_cast<uint>(m_tCounter), Logger::endl);
 
-    if(++m_tCounter >= 10){
+    if(++m_tCounter >= m_timerPeriod){
         m_tCounter = 0;
         if(m_dtReg){
             m_dtReg--;
@@ -317,11 +653,9 @@ TickResult Chip8::run_tick() {
             tickRes.soundState = 0;
     }
 
-    #ifdef LITTLE_ENDIAN
-        uint16_t op = (m_memory[m_programCounter] << 8) |m_memory[m_programCounter + 1];
-    #else
-        uint16_t op = *((uint16_t*)  (m_memory + m_programCounter));
-    #endif
+    // Byte wise fetch, an opcode may straddle two pages
+    uint16_t op = (m_memory.read(m_programCounter) << 8) | m_memory.read(m_programCounter + 1);
+    ++m_counters.instructions;
 
     chip8Logger.log<Logger::LogDebug>("Chip8: pc: ", std::hex, std::setw(4), std::setfill('0'), m_programCounter, Logger::endl);
     chip8Logger.log<Logger::LogDebug>("Chip8: op: ", std::hex, std::setw(4), std::setfill('0'), op, Logger::endl);
@@ -419,7 +753,7 @@ TickResult Chip8::run_tick() {
                     break;
                 case 6:
                     //SHR VX, Vy
-                    SHR(OPX);
+                    SHR(OPX, OPY);
                     m_programCounter+=2;
                     break;
                 case 7:
@@ -429,7 +763,7 @@ TickResult Chip8::run_tick() {
                     break;
                 case 0xe:
                     //SHL VX, VY
-                    SHL(OPX);
+                    SHL(OPX, OPY);
                     m_programCounter+=2;
                     break;
                 default:
@@ -451,7 +785,9 @@ TickResult Chip8::run_tick() {
         case 0xb000:
             // JMP V0, NNN
             JMP_REG(NNN);
-            m_programCounter+=2;
+            if(TQuirks::legacyJumpAdvance){
+                m_programCounter+=2;
+            }
             break;
         case 0xc000:
             // RND VX, KK
@@ -549,4 +885,14 @@ TickResult Chip8::run_tick() {
     #undef NIB
 }
 
+template class BasicChip8<Rng::Mt19937>;
+template class BasicChip8<Rng::Xorshift>;
+template class BasicChip8<Rng::Pcg32>;
+template class BasicChip8<Rng::Mt19937, Quirks::CosmacVip>;
+template class BasicChip8<Rng::Mt19937, Quirks::Chip48>;
+template class BasicChip8<Rng::Mt19937, Quirks::SuperChip>;
+template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Legacy>>;
+template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::CosmacVip>>;
+template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Chip48>>;
+
 }
\ No newline at end of file
@@ -5,15 +5,19 @@
 #ifndef CHIP8_INTERPRETER_H
 #define CHIP8_INTERPRETER_H
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <random>
 
 #include "Bitfield.hpp"
+#include "Breakpoints.hpp"
+#include "Chip8Quirks.hpp"
+#include "Chip8Rng.hpp"
+#include "PagedMemory.hpp"
 
-#define CHIP8_SPRITE_TABLE_SIZE   0x0050
-#define CHIP8_MAIN_MEM_SIZE       0x1000
-#define CHIP8_PROG_START_OFFSET   0x0200
 #define CHIP8_NUM_V_REG           0x0010
 #define CHIP8_STACK_SIZE          0x0010
 #define CHIP8_DISP_SIZE           0x0100
@@ -22,9 +26,20 @@
 #define CHIP8_DISP_Y              0x0020
 
 #define CHIP8_TICK_PERIOD_USEC 2000 
+// Ticks per DT and ST decrement unless setTimerPeriod() says otherwise, the timers run at 60Hz for 10 instructions per frame
+#define CHIP8_TIMER_PERIOD        10
+#define CHIP8_MAX_TIMER_PERIOD    255
+
+#define CHIP8_CACHE_LINE_SIZE     64
+
+// Snapshot layout, bump the version whenever saveState writes anything differently
+#define CHIP8_STATE_MAGIC         0x53533843
+#define CHIP8_STATE_VERSION       1
 
 namespace Chip8{
 
+class RomCorpus;
+
 union TickResult{
     Bitfield::Bitfield<uint8_t, 0, 1> displayUpdate;
     Bitfield::Bitfield<uint8_t, 1, 1> soundState;
@@ -51,39 +66,99 @@ enum Chip8Key{
     KEY_F,
 };
 
-class Chip8 {
+// True for the instructions whose result depends on the keypad or the generator: SKP, SKNP, LD Vx, K and RND.
+// Until a program reaches one of them its run is a function of the rom alone.
+inline bool readsInput(uint16_t t_op){
+    return (t_op & 0xf000) == 0xc000 || (t_op & 0xf0ff) == 0xe09e || (t_op & 0xf0ff) == 0xe0a1 || (t_op & 0xf0ff) == 0xf00a;
+}
+
+// Programmer visible registers, read and written as a whole by debuggers
+struct Registers{
+    std::array<uint8_t, CHIP8_NUM_V_REG> v;
+    uint16_t i;
+    uint16_t pc;
+    uint8_t sp;
+    uint8_t dt;
+    uint8_t st;
+};
+
+// What an interpreter did since its last reset, kept by the instruction handlers as plain per instance
+// counters. Only instructions is bumped every tick, the others by the handlers they count.
+struct ExecutionCounters{
+    uint64_t instructions;
+    // DRW instructions, the rows of sprite data they drew (once per plane) and those that set VF
+    uint64_t draws;
+    uint64_t spriteRows;
+    uint64_t collisions;
+    // SE, SNE, SKP and SKNP that skipped
+    uint64_t skipsTaken;
+    // Ticks LD VX, K spent waiting for a key
+    uint64_t keyWaits;
+
+    ExecutionCounters& operator+=(const ExecutionCounters& t_other){
+        instructions += t_other.instructions;
+        draws += t_other.draws;
+        spriteRows += t_other.spriteRows;
+        collisions += t_other.collisions;
+        skipsTaken += t_other.skipsTaken;
+        keyWaits += t_other.keyWaits;
+        return *this;
+    }
+};
+
+// Interpreter core, TRng is one of the Rng generator policies and drives the RND instruction, TQuirks one of
+// the Quirks policies. Definitions live in Chip8.cpp which instantiates every generator with the legacy quirks
+// and every quirk policy with mt19937, plus the debug variants Machine offers.
+template<typename TRng, typename TQuirks = Quirks::Legacy>
+class BasicChip8 {
 protected:
 
-    std::mt19937 m_generator;
-    std::uniform_int_distribution<> m_dist;
-
-    const std::array<uint8_t, CHIP8_SPRITE_TABLE_SIZE>m_spriteTable = {0xF0, 0x90, 0x90, 0x90, 0xF0, /* 0 */
-                                                                       0x20, 0x60, 0x20, 0x20, 0x70, /* 1 */
-                                                                       0xF0, 0x10, 0xF0, 0x80, 0xF0, /* 2 */
-                                                                       0xF0, 0x10, 0xF0, 0x10, 0xF0, /* 3 */
-                                                                       0x90, 0x90, 0xF0, 0x10, 0x10, /* 4 */
-                                                                       0xF0, 0x80, 0xF0, 0x10, 0xF0, /* 5 */
-                                                                       0xF0, 0x80, 0xF0, 0x90, 0xF0, /* 6 */
-                                                                       0xF0, 0x10, 0x20, 0x40, 0x40, /* 7 */
-                                                                       0xF0, 0x90, 0xF0, 0x90, 0xF0, /* 8 */
-                                                                       0xF0, 0x90, 0xF0, 0x10, 0xF0, /* 9 */
-                                                                       0xF0, 0x90, 0xF0, 0x90, 0x90, /* A */
-                                                                       0xE0, 0x90, 0xE0, 0x90, 0xE0, /* B */
-                                                                       0xF0, 0x80, 0x80, 0x80, 0xF0, /* C */
-                                                                       0xE0, 0x90, 0x90, 0x90, 0xE0, /* E */
-                                                                       0xF0, 0x80, 0xF0, 0x80, 0x80, /* F */ };
-    std::mt19937::result_type m_seed;
-    std::array<uint8_t, CHIP8_MAIN_MEM_SIZE> m_memory;
-    std::array<uint8_t, CHIP8_NUM_V_REG> m_vRegs;
-    std::array<uint16_t, CHIP8_STACK_SIZE> m_stack;
-    std::array<uint8_t, CHIP8_DISP_SIZE> m_disp;
+    // Hot register file, everything an instruction other than DRW or a memory op touches shares one cache line
+    alignas(CHIP8_CACHE_LINE_SIZE) std::array<uint8_t, CHIP8_NUM_V_REG> m_vRegs;
+    uint16_t m_programCounter;
     uint16_t m_iReg;
+    uint16_t m_keystates;
     uint8_t m_dtReg;
     uint8_t m_stReg;
-    uint8_t m_stackPointer : 4;
-    uint16_t m_programCounter;
     uint8_t m_tCounter;
-    uint16_t m_keystates;
+    uint8_t m_timerPeriod;
+    uint8_t m_stackPointer : 4;
+    std::array<uint16_t, CHIP8_STACK_SIZE> m_stack;
+
+    // Page table is read by every fetch, the pages themselves are shared with every instance of the rom
+    alignas(CHIP8_CACHE_LINE_SIZE) PagedMemory m_memory;
+    std::array<uint8_t, CHIP8_DISP_SIZE> m_disp;
+    // Written every tick (instructions) but never read on the hot path, so it stays out of the register line
+    ExecutionCounters m_counters;
+
+    // Cold, only touched by reset and RND
+    uint64_t m_seed;
+    TRng m_generator;
+    // Only debug instantiations (see Quirks::Debug) look at it
+    Breakpoints* m_breakpoints;
+
+    // Data accesses of instructions, instruction fetches read m_memory directly
+    uint8_t readData(uint16_t t_addr) const{
+        if(TQuirks::debug && m_breakpoints){
+            m_breakpoints->read(t_addr);
+        }
+        return m_memory.read(t_addr);
+    }
+
+    void writeData(uint16_t t_addr, uint8_t t_value){
+        if(TQuirks::debug && m_breakpoints){
+            m_breakpoints->write(t_addr);
+        }
+        m_memory.write(t_addr, t_value);
+    }
+
+    void resetMachine();
+    void advanceIndex(uint8_t t_x){
+        if(TQuirks::loadStoreAdvance != Quirks::IndexAdvance::None){
+            m_iReg += t_x + (TQuirks::loadStoreAdvance == Quirks::IndexAdvance::ByXPlusOne);
+        }
+    }
+    std::shared_ptr<MemoryImage> snapshotMemory() const;
 
     // Opcode functions
     void CLS();
@@ -101,9 +176,9 @@ protected:
     void XOR(uint8_t t_x, uint8_t t_y);
     void ADD_REG(uint8_t t_x, uint8_t t_y);
     void SUB_REG(uint8_t t_x, uint8_t t_y);
-    void SHR(uint8_t t_x);
+    void SHR(uint8_t t_x, uint8_t t_y);
     void SUBN(uint8_t t_x, uint8_t t_y);
-    void SHL(uint8_t t_x);
+    void SHL(uint8_t t_x, uint8_t t_y);
     void SNE_REG(uint8_t t_x, uint8_t t_y);
     void LD_I(uint16_t t_nnn);
     void JMP_REG(uint16_t t_nnn);
@@ -122,23 +197,177 @@ protected:
     void LD_REGS(uint8_t t_x);
 
 public:
-    Chip8(std::mt19937::result_type t_seed);
-    Chip8(std::mt19937::result_type t_seed, const std::string& t_rom);
-    Chip8(std::mt19937::result_type t_seed, std::istream& t_inStream);
+    typedef TRng Rng;
+
+    // Instances are cache line aligned, the global operator new only guarantees 16 bytes before C++17
+    static void* operator new(std::size_t t_size);
+    static void* operator new[](std::size_t t_size);
+    static void* operator new(std::size_t t_size, void* t_ptr){
+        return t_ptr;
+    }
+    static void operator delete(void* t_ptr);
+    static void operator delete[](void* t_ptr);
+
+    // Writes sizeof and member offsets, used to check the hot register file stays within one cache line
+    static void layoutReport(std::ostream& t_outStream);
+
+    BasicChip8(uint64_t t_seed);
+    BasicChip8(uint64_t t_seed, const std::string& t_rom);
+    BasicChip8(uint64_t t_seed, std::istream& t_inStream);
 
     void reset();
-    void reset(std::mt19937::result_type t_seed);
+    void reset(uint64_t t_seed);
+    // Resets with generator stream t_stream split from master seed t_seed, for parallel runs
+    void reset(uint64_t t_seed, uint64_t t_stream);
     void load(const std::string& t_filePath);
     void load(std::istream& t_iStream);
+    void load(const uint8_t* t_rom, std::size_t t_size);
+    // Copies rom t_index straight out of the corpus mapping
+    void load(const RomCorpus& t_corpus, std::size_t t_index);
+    // Maps a prepared image, see PagedMemory::makeImage, without copying it
+    void load(std::shared_ptr<const MemoryImage> t_image);
     TickResult run_tick();
 
+    // Runs until the next instruction reads the keypad or the generator, or for at most t_maxTicks ticks, and
+    // returns the ticks run. Memory is folded into a fresh image so copies of the result share it.
+    uint64_t runToInput(uint64_t t_maxTicks);
+    // Copies t_boot, a state reached by runToInput, and reseeds the generator with t_seed. Equivalent to
+    // reset(t_seed), the same load and the ticks runToInput ran, whatever keys were pressed meanwhile.
+    void restore(const BasicChip8& t_boot, uint64_t t_seed);
+    // Architectural state without the generator, as kept by BootCache files. Host byte order, the files are
+    // a local cache. readState throws when the stream ends early.
+    void writeState(std::ostream& t_outStream) const;
+    void readState(std::istream& t_inStream);
+
+    // Complete snapshot in a fixed little endian layout, generator included:
+    //
+    //     magic u32, version u16, generator state size u16, seed u64, V0-VF, PC u16, I u16, keys u16,
+    //     DT u8, ST u8, timer counter u8, SP u8, stack 16 x u16, display, memory, generator state
+    //
+    // Both work on caller buffers of at least stateSize bytes and allocate nothing, except loadState for a
+    // memory page that differs from the rom image and never had a private buffer. Cheap enough to call
+    // every frame. saveState returns the bytes written, both throw when t_size is too small and loadState
+    // when the magic, version or generator do not match, leaving the machine untouched.
+    static constexpr std::size_t stateSize = 16 + CHIP8_NUM_V_REG + 10 + 2 * CHIP8_STACK_SIZE + CHIP8_DISP_SIZE + CHIP8_MAIN_MEM_SIZE + TRng::stateSize;
+    std::size_t saveState(uint8_t* t_buffer, std::size_t t_size) const;
+    void loadState(const uint8_t* t_buffer, std::size_t t_size);
+
+    uint64_t stateHash() const;
+    // Also covers the generator, so states with equal hashes evolve identically under the same input.
+    // Cheaper than stateHash() and not comparable with it.
+    uint64_t fullStateHash() const;
+
     void updateKeystate(bool t_pressState, bool t_repeat, const Chip8Key& t_key);
 
     std::array<uint8_t, ((CHIP8_DISP_X >> 3) * CHIP8_DISP_Y)>::const_iterator getDisplay(){
         return m_disp.begin();
     }
+
+    const uint8_t* getDisplayData() const{
+        return m_disp.data();
+    }
+
+    const std::array<uint8_t, CHIP8_NUM_V_REG>& getRegisters() const{
+        return m_vRegs;
+    }
+
+    uint16_t getProgramCounter() const{
+        return m_programCounter;
+    }
+
+    uint16_t getIndexRegister() const{
+        return m_iReg;
+    }
+
+    uint8_t getDelayTimer() const{
+        return m_dtReg;
+    }
+
+    uint8_t getSoundTimer() const{
+        return m_stReg;
+    }
+
+    // Replaces the whole key state, bit k set means key k is held
+    void setKeystates(uint16_t t_keystates){
+        m_keystates = t_keystates;
+    }
+
+    const PagedMemory& getMemory() const{
+        return m_memory;
+    }
+
+    // Addresses wrap at CHIP8_MAIN_MEM_SIZE
+    uint8_t readMemory(uint32_t t_addr) const{
+        return m_memory.read(static_cast<uint16_t>(t_addr));
+    }
+
+    void writeMemory(uint16_t t_addr, uint8_t t_value){
+        m_memory.write(t_addr, t_value);
+    }
+
+    Registers readRegisters() const{
+        return Registers{m_vRegs, m_iReg, m_programCounter, m_stackPointer, m_dtReg, m_stReg};
+    }
+
+    void writeRegisters(const Registers& t_registers){
+        m_vRegs = t_registers.v;
+        m_iReg = t_registers.i;
+        m_programCounter = t_registers.pc;
+        m_stackPointer = t_registers.sp & (CHIP8_STACK_SIZE - 1);
+        m_dtReg = t_registers.dt;
+        m_stReg = t_registers.st;
+    }
+
+    // Reports data reads and writes to t_breakpoints, nullptr detaches. Only debug instantiations check it,
+    // the others ignore it. Survives reset() and restore().
+    void attach(Breakpoints* t_breakpoints){
+        m_breakpoints = t_breakpoints;
+    }
+
+    // Ticks per DT and ST decrement, the instructions a rom runs per 60Hz frame. Part of the configuration
+    // rather than the machine state, like attach() it survives reset(), restore() and loading a snapshot.
+    void setTimerPeriod(uint8_t t_ticks){
+        m_timerPeriod = (t_ticks)? t_ticks : 1;
+    }
+
+    // Cleared by reset(), restore() takes those of the boot state and loading a snapshot keeps them, they
+    // are not part of the machine state. Ticks run and then undone by loading a snapshot taken before them
+    // stay counted unless the counters from before are put back with setCounters().
+    const ExecutionCounters& getCounters() const{
+        return m_counters;
+    }
+
+    void setCounters(const ExecutionCounters& t_counters){
+        m_counters = t_counters;
+    }
 };
 
+extern template class BasicChip8<Rng::Mt19937>;
+extern template class BasicChip8<Rng::Xorshift>;
+extern template class BasicChip8<Rng::Pcg32>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::CosmacVip>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::Chip48>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::SuperChip>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Legacy>>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::CosmacVip>>;
+extern template class BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Chip48>>;
+
+// The default interpreter, mt19937 keeps RND sequences identical to earlier releases
+class Chip8 : public BasicChip8<Rng::Mt19937>{
+public:
+    using BasicChip8::BasicChip8;
+};
+
+typedef BasicChip8<Rng::Xorshift> Chip8Xorshift;
+typedef BasicChip8<Rng::Pcg32> Chip8Pcg32;
+typedef BasicChip8<Rng::Mt19937, Quirks::CosmacVip> Chip8Vip;
+typedef BasicChip8<Rng::Mt19937, Quirks::Chip48> Chip8Chip48;
+typedef BasicChip8<Rng::Mt19937, Quirks::SuperChip> Chip8SuperChip;
+// Variants a debugger runs, with watchpoint hooks on every data access
+typedef BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Legacy>> Chip8Debug;
+typedef BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::CosmacVip>> Chip8VipDebug;
+typedef BasicChip8<Rng::Mt19937, Quirks::Debug<Quirks::Chip48>> Chip8Chip48Debug;
+
 } // namespace Chip8
 
 #endif // CHIP8_INTERPRETER_H
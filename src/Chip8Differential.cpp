@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "Chip8Differential.hpp"
+#include "Chip8Util.hpp"
+
+// Field offsets of the Chip8::saveState layout
+#define CHIP8_STATE_SEED_OFFSET     8
+#define CHIP8_STATE_V_OFFSET        16
+#define CHIP8_STATE_PC_OFFSET       (CHIP8_STATE_V_OFFSET + CHIP8_NUM_V_REG)
+#define CHIP8_STATE_STACK_OFFSET    (CHIP8_STATE_PC_OFFSET + 10)
+#define CHIP8_STATE_DISP_OFFSET     (CHIP8_STATE_STACK_OFFSET + 2 * CHIP8_STACK_SIZE)
+#define CHIP8_STATE_MEM_OFFSET      (CHIP8_STATE_DISP_OFFSET + CHIP8_DISP_SIZE)
+#define CHIP8_STATE_RNG_OFFSET      (CHIP8_STATE_MEM_OFFSET + CHIP8_MAIN_MEM_SIZE)
+
+namespace Chip8{
+
+namespace{
+
+template<typename T>
+T field(const uint8_t* t_state, std::size_t t_offset){
+    const uint8_t* in = t_state + t_offset;
+    return Util::getLE<T>(in);
+}
+
+std::string hex(unsigned t_value, int t_width){
+    std::ostringstream out;
+    out << "0x" << std::hex << std::setw(t_width) << std::setfill('0') << t_value;
+    return out.str();
+}
+
+} // namespace
+
+Differential::Differential(DifferentialEngine& t_engine, const uint8_t* t_rom, std::size_t t_size, uint64_t t_interval) : m_engine(t_engine),
+                                                                                                                         m_image(PagedMemory::makeImage(t_rom, t_size)),
+                                                                                                                         m_interval(std::max<uint64_t>(1, t_interval)),
+                                                                                                                         m_seeds(t_engine.lanes()),
+                                                                                                                         m_scripts(t_engine.lanes(), nullptr),
+                                                                                                                         m_ticks(t_engine.lanes()),
+                                                                                                                         m_scriptPositions(t_engine.lanes()),
+                                                                                                                         m_faults(t_engine.lanes()),
+                                                                                                                         m_checked(t_engine.lanes(), std::vector<uint8_t>(Chip8::stateSize)),
+                                                                                                                         m_checkedTicks(t_engine.lanes()),
+                                                                                                                         m_checkedFaults(t_engine.lanes()),
+                                                                                                                         m_checkedInstructions(0),
+                                                                                                                         m_engineState(Chip8::stateSize){
+    m_reference.resize(t_engine.lanes());
+    for(std::size_t lane = 0; lane < t_engine.lanes(); ++lane){
+        reset(lane, lane);
+    }
+}
+
+void Differential::resetReference(std::size_t t_lane){
+    // Constructed again rather than reset, the seed a snapshot records is the one the Chip8 was made with
+    m_reference[t_lane].reset(new Chip8(m_seeds[t_lane]));
+    m_reference[t_lane]->load(m_image);
+    m_ticks[t_lane] = 0;
+    m_scriptPositions[t_lane] = 0;
+    m_faults[t_lane].clear();
+}
+
+void Differential::reset(std::size_t t_lane, uint64_t t_seed, const InputScript* t_script){
+    m_seeds[t_lane] = t_seed;
+    m_scripts[t_lane] = t_script;
+    resetReference(t_lane);
+    m_engine.reset(t_lane, t_seed, t_script);
+}
+
+void Differential::runReference(std::size_t t_lane, uint64_t t_instructions){
+    Chip8& chip8 = *m_reference[t_lane];
+    try{
+        for(; m_faults[t_lane].empty() && m_ticks[t_lane] < t_instructions; ++m_ticks[t_lane]){
+            if(m_scripts[t_lane]){
+                m_scriptPositions[t_lane] = m_scripts[t_lane]->apply(chip8, m_ticks[t_lane], m_scriptPositions[t_lane]);
+            }
+            chip8.run_tick();
+        }
+    }
+    catch(const std::string& error){
+        m_faults[t_lane] = error;
+    }
+}
+
+void Differential::checkpoint(){
+    for(std::size_t lane = 0; lane < m_engine.lanes(); ++lane){
+        m_reference[lane]->saveState(m_checked[lane].data(), m_checked[lane].size());
+        m_checkedTicks[lane] = m_ticks[lane];
+        m_checkedFaults[lane] = m_faults[lane];
+    }
+}
+
+bool Differential::compare(std::size_t t_lane, uint64_t t_instructions, Divergence& t_divergence){
+    std::vector<uint8_t> reference(Chip8::stateSize);
+    m_reference[t_lane]->saveState(reference.data(), reference.size());
+    m_engine.saveState(t_lane, m_engineState.data(), m_engineState.size());
+
+    std::string diff = diffStates(reference.data(), m_engineState.data());
+    if(m_faults[t_lane] != m_engine.fault(t_lane)){
+        diff += "fault: '" + m_faults[t_lane] + "' != '" + m_engine.fault(t_lane) + "'\n";
+    }
+    if(diff.empty()){
+        return false;
+    }
+    t_divergence.found = true;
+    t_divergence.lane = t_lane;
+    t_divergence.instructions = std::min(t_instructions, m_ticks[t_lane]);
+    t_divergence.diff = diff;
+    return true;
+}
+
+void Differential::pinpoint(Divergence& t_divergence){
+    // The engine runs again from its reset to the last check, the reference lane continues from its state there
+    std::size_t lane = t_divergence.lane;
+    for(std::size_t engineLane = 0; engineLane < m_engine.lanes(); ++engineLane){
+        m_engine.reset(engineLane, m_seeds[engineLane], m_scripts[engineLane]);
+    }
+    m_engine.runTo(m_checkedInstructions);
+    resetReference(lane);
+    m_reference[lane]->loadState(m_checked[lane].data(), m_checked[lane].size());
+    m_ticks[lane] = m_checkedTicks[lane];
+    m_faults[lane] = m_checkedFaults[lane];
+
+    std::vector<uint8_t> before(Chip8::stateSize);
+    for(uint64_t instructions = m_checkedInstructions + 1; instructions <= t_divergence.instructions; ++instructions){
+        m_reference[lane]->saveState(before.data(), before.size());
+        runReference(lane, instructions);
+        m_engine.runTo(instructions);
+        if(compare(lane, instructions, t_divergence)){
+            uint16_t pc = field<uint16_t>(before.data(), CHIP8_STATE_PC_OFFSET);
+            t_divergence.pinpointed = true;
+            t_divergence.pc = pc;
+            t_divergence.opcode = (pc < CHIP8_MAIN_MEM_SIZE - 1)? (before[CHIP8_STATE_MEM_OFFSET + pc] << 8) | before[CHIP8_STATE_MEM_OFFSET + pc + 1] : 0;
+            return;
+        }
+    }
+}
+
+Differential::Divergence Differential::run(uint64_t t_instructions){
+    Divergence divergence{false, 0, 0, 0, 0, false, ""};
+    m_checkedInstructions = 0;
+    checkpoint();
+
+    while(m_checkedInstructions < t_instructions){
+        uint64_t check = std::min(t_instructions, m_checkedInstructions + m_interval);
+        m_engine.runTo(check);
+        for(std::size_t lane = 0; lane < m_engine.lanes(); ++lane){
+            runReference(lane, check);
+            if(compare(lane, check, divergence)){
+                pinpoint(divergence);
+                return divergence;
+            }
+        }
+        checkpoint();
+        m_checkedInstructions = check;
+    }
+    return divergence;
+}
+
+std::string Differential::diffStates(const uint8_t* t_reference, const uint8_t* t_engine){
+    std::ostringstream diff;
+    auto scalar = [&diff, t_reference, t_engine](const std::string& t_name, std::size_t t_offset, std::size_t t_size){
+        unsigned reference = 0, engine = 0;
+        for(std::size_t byte = 0; byte < t_size; ++byte){
+            reference |= t_reference[t_offset + byte] << (8 * byte);
+            engine |= t_engine[t_offset + byte] << (8 * byte);
+        }
+        if(reference != engine){
+            diff << t_name << ": " << hex(reference, 2 * t_size) << " != " << hex(engine, 2 * t_size) << '\n';
+        }
+    };
+
+    if(field<uint64_t>(t_reference, CHIP8_STATE_SEED_OFFSET) != field<uint64_t>(t_engine, CHIP8_STATE_SEED_OFFSET)){
+        diff << "seed: " << field<uint64_t>(t_reference, CHIP8_STATE_SEED_OFFSET) << " != " << field<uint64_t>(t_engine, CHIP8_STATE_SEED_OFFSET) << '\n';
+    }
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        std::ostringstream name;
+        name << 'V' << std::hex << std::uppercase << reg;
+        scalar(name.str(), CHIP8_STATE_V_OFFSET + reg, 1);
+    }
+    scalar("PC", CHIP8_STATE_PC_OFFSET, 2);
+    scalar("I", CHIP8_STATE_PC_OFFSET + 2, 2);
+    scalar("keys", CHIP8_STATE_PC_OFFSET + 4, 2);
+    scalar("DT", CHIP8_STATE_PC_OFFSET + 6, 1);
+    scalar("ST", CHIP8_STATE_PC_OFFSET + 7, 1);
+    scalar("timer counter", CHIP8_STATE_PC_OFFSET + 8, 1);
+    scalar("SP", CHIP8_STATE_PC_OFFSET + 9, 1);
+    for(std::size_t entry = 0; entry < CHIP8_STACK_SIZE; ++entry){
+        scalar("stack[" + std::to_string(entry) + "]", CHIP8_STATE_STACK_OFFSET + 2 * entry, 2);
+    }
+
+    std::size_t pixels = 0;
+    for(std::size_t byte = 0; byte < CHIP8_DISP_SIZE; ++byte){
+        uint8_t differing = t_reference[CHIP8_STATE_DISP_OFFSET + byte] ^ t_engine[CHIP8_STATE_DISP_OFFSET + byte];
+        for(int bit = 7; bit >= 0; --bit){
+            if((differing >> bit) & 1 && pixels++ < CHIP8_DIFFERENTIAL_MAX_LISTED){
+                std::size_t pixel = 8 * byte + 7 - bit;
+                diff << "pixel (" << pixel % CHIP8_DISP_X << ", " << pixel / CHIP8_DISP_X << "): " << ((t_reference[CHIP8_STATE_DISP_OFFSET + byte] >> bit) & 1)
+                     << " != " << ((t_engine[CHIP8_STATE_DISP_OFFSET + byte] >> bit) & 1) << '\n';
+            }
+        }
+    }
+    if(pixels > CHIP8_DIFFERENTIAL_MAX_LISTED){
+        diff << "... " << pixels - CHIP8_DIFFERENTIAL_MAX_LISTED << " more pixels\n";
+    }
+
+    std::size_t bytes = 0;
+    for(std::size_t addr = 0; addr < CHIP8_MAIN_MEM_SIZE; ++addr){
+        if(t_reference[CHIP8_STATE_MEM_OFFSET + addr] != t_engine[CHIP8_STATE_MEM_OFFSET + addr] && bytes++ < CHIP8_DIFFERENTIAL_MAX_LISTED){
+            scalar("memory[" + hex(addr, 3) + "]", CHIP8_STATE_MEM_OFFSET + addr, 1);
+        }
+    }
+    if(bytes > CHIP8_DIFFERENTIAL_MAX_LISTED){
+        diff << "... " << bytes - CHIP8_DIFFERENTIAL_MAX_LISTED << " more memory bytes\n";
+    }
+
+    if(!std::equal(t_reference + CHIP8_STATE_RNG_OFFSET, t_reference + Chip8::stateSize, t_engine + CHIP8_STATE_RNG_OFFSET)){
+        diff << "generator state differs\n";
+    }
+    return diff.str();
+}
+
+std::string Differential::report(const Divergence& t_divergence){
+    if(!t_divergence.found){
+        return "";
+    }
+    std::ostringstream report;
+    report << "lane " << t_divergence.lane << " diverged ";
+    if(t_divergence.pinpointed){
+        report << "at instruction " << t_divergence.instructions << ", " << hex(t_divergence.opcode, 4) << " at " << hex(t_divergence.pc, 3) << ":\n";
+    }
+    else{
+        report << "by instruction " << t_divergence.instructions << ", not reproduced one instruction at a time:\n";
+    }
+    return report.str() + t_divergence.diff;
+}
+
+} // namespace Chip8
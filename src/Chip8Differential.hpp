@@ -0,0 +1,132 @@
+#ifndef CHIP8_DIFFERENTIAL_HPP
+#define CHIP8_DIFFERENTIAL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Chip8.hpp"
+#include "Chip8Lockstep.hpp"
+#include "InputScript.hpp"
+
+// Differing memory bytes and pixels listed one by one in a report, the rest are counted
+#define CHIP8_DIFFERENTIAL_MAX_LISTED 8
+
+namespace Chip8{
+
+// Execution engine checked against the reference interpreter by Differential. An engine runs one or more
+// lanes of the same rom, each with its own seed and input script, and counts instructions like Chip8 counts
+// ticks, a faulting instruction not included.
+class DifferentialEngine{
+public:
+    virtual ~DifferentialEngine() = default;
+
+    virtual std::size_t lanes() const = 0;
+    // Back to the loaded rom with generator seed t_seed and keys from t_script, null for none
+    virtual void reset(std::size_t t_lane, uint64_t t_seed, const InputScript* t_script) = 0;
+    // Runs every lane until t_instructions instructions have retired since its reset, or it faulted
+    virtual void runTo(uint64_t t_instructions) = 0;
+    // Snapshot of a lane in the layout of Chip8::saveState
+    virtual void saveState(std::size_t t_lane, uint8_t* t_buffer, std::size_t t_size) const = 0;
+    // Fault message of a lane, empty while it runs
+    virtual std::string fault(std::size_t t_lane) const = 0;
+};
+
+// Lanes of a Lockstep engine
+class LockstepEngine : public DifferentialEngine{
+
+private:
+    Lockstep m_lockstep;
+
+public:
+    LockstepEngine(std::size_t t_lanes, const uint8_t* t_rom, std::size_t t_size) : m_lockstep(t_lanes, t_rom, t_size){
+    }
+
+    std::size_t lanes() const override{
+        return m_lockstep.lanes();
+    }
+
+    void reset(std::size_t t_lane, uint64_t t_seed, const InputScript* t_script) override{
+        m_lockstep.reset(t_lane, t_seed);
+        m_lockstep.setInputScript(t_lane, t_script);
+    }
+
+    void runTo(uint64_t t_instructions) override{
+        m_lockstep.run(static_cast<uint32_t>(std::min<uint64_t>(t_instructions, UINT32_MAX)));
+    }
+
+    void saveState(std::size_t t_lane, uint8_t* t_buffer, std::size_t t_size) const override{
+        m_lockstep.saveState(t_lane, t_buffer, t_size);
+    }
+
+    std::string fault(std::size_t t_lane) const override{
+        return m_lockstep.faultMessage(t_lane);
+    }
+
+    const Lockstep& lockstep() const{
+        return m_lockstep;
+    }
+};
+
+// Runs an engine alongside one Chip8 per lane, from the same rom, seeds and input, and compares the full
+// architectural state of every lane every t_interval instructions. At the first difference it stops, steps
+// the diverged lane again one instruction at a time from the last state both agreed on, and reports the
+// first instruction after which they differ together with the differing fields.
+class Differential{
+
+public:
+    struct Divergence{
+        bool found;
+        std::size_t lane;
+        // Instructions retired when the states first differed, and the instruction retired last
+        uint64_t instructions;
+        uint16_t pc;
+        uint16_t opcode;
+        // False when stepping again did not reproduce it, the engine then only differs at a check
+        bool pinpointed;
+        std::string diff;
+    };
+
+private:
+    DifferentialEngine& m_engine;
+    std::shared_ptr<const MemoryImage> m_image;
+    uint64_t m_interval;
+    std::vector<std::unique_ptr<Chip8>> m_reference;
+    std::vector<uint64_t> m_seeds;
+    std::vector<const InputScript*> m_scripts;
+    std::vector<uint64_t> m_ticks;
+    std::vector<std::size_t> m_scriptPositions;
+    std::vector<std::string> m_faults;
+    // Reference state of every lane at the last check, and when that was
+    std::vector<std::vector<uint8_t>> m_checked;
+    std::vector<uint64_t> m_checkedTicks;
+    std::vector<std::string> m_checkedFaults;
+    uint64_t m_checkedInstructions;
+    std::vector<uint8_t> m_engineState;
+
+    void resetReference(std::size_t t_lane);
+    void runReference(std::size_t t_lane, uint64_t t_instructions);
+    void checkpoint();
+    // Compares one lane, fills t_divergence if it differs
+    bool compare(std::size_t t_lane, uint64_t t_instructions, Divergence& t_divergence);
+    void pinpoint(Divergence& t_divergence);
+
+public:
+    Differential(DifferentialEngine& t_engine, const uint8_t* t_rom, std::size_t t_size, uint64_t t_interval);
+
+    // Resets a lane of both sides, see DifferentialEngine::reset
+    void reset(std::size_t t_lane, uint64_t t_seed, const InputScript* t_script = nullptr);
+    // Runs every lane t_instructions instructions from its reset, checking as it goes
+    Divergence run(uint64_t t_instructions);
+
+    // Differing fields of two snapshots in the layout of Chip8::saveState, one per line, empty if equal
+    static std::string diffStates(const uint8_t* t_reference, const uint8_t* t_engine);
+    static std::string report(const Divergence& t_divergence);
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_DIFFERENTIAL_HPP
@@ -0,0 +1,126 @@
+#ifndef CHIP8_DISPLAY_HPP
+#define CHIP8_DISPLAY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define CHIP8_HIRES_X             0x0080
+#define CHIP8_HIRES_Y             0x0040
+#define CHIP8_NUM_PLANES          2
+#define CHIP8_NUM_COLORS          (1 << CHIP8_NUM_PLANES)
+
+namespace Chip8{
+
+// One display row, pixel 0 in the most significant bit
+__extension__ typedef unsigned __int128 DisplayRow;
+
+// Bit planes of the SUPER-CHIP / XO-CHIP display, one 128 bit word per row and plane. Horizontal scrolls
+// are a shift per row and vertical ones a row move, so the compiler turns every scroll into a few vector
+// instructions per plane. Low resolution programs draw 2x2 pixels into the same 128x64 planes.
+// Functions taking a plane mask touch plane p when bit p of the mask is set.
+class PlaneDisplay{
+
+private:
+    std::array<std::array<DisplayRow, CHIP8_HIRES_Y>, CHIP8_NUM_PLANES> m_planes;
+
+public:
+    PlaneDisplay(){
+        clear(CHIP8_NUM_COLORS - 1);
+    }
+
+    void clear(uint8_t t_planeMask){
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            if((t_planeMask >> plane) & 0x01){
+                m_planes[plane].fill(0);
+            }
+        }
+    }
+
+    void scrollDown(uint8_t t_planeMask, unsigned t_rows){
+        t_rows = std::min<unsigned>(t_rows, CHIP8_HIRES_Y);
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            if((t_planeMask >> plane) & 0x01){
+                std::copy_backward(m_planes[plane].begin(), m_planes[plane].end() - t_rows, m_planes[plane].end());
+                std::fill(m_planes[plane].begin(), m_planes[plane].begin() + t_rows, 0);
+            }
+        }
+    }
+
+    void scrollUp(uint8_t t_planeMask, unsigned t_rows){
+        t_rows = std::min<unsigned>(t_rows, CHIP8_HIRES_Y);
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            if((t_planeMask >> plane) & 0x01){
+                std::copy(m_planes[plane].begin() + t_rows, m_planes[plane].end(), m_planes[plane].begin());
+                std::fill(m_planes[plane].end() - t_rows, m_planes[plane].end(), 0);
+            }
+        }
+    }
+
+    void scrollLeft(uint8_t t_planeMask, unsigned t_pixels){
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            if((t_planeMask >> plane) & 0x01){
+                for(DisplayRow& row : m_planes[plane]){
+                    row <<= t_pixels;
+                }
+            }
+        }
+    }
+
+    void scrollRight(uint8_t t_planeMask, unsigned t_pixels){
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            if((t_planeMask >> plane) & 0x01){
+                for(DisplayRow& row : m_planes[plane]){
+                    row >>= t_pixels;
+                }
+            }
+        }
+    }
+
+    // XORs t_bits into row t_y of plane t_plane, true when a lit pixel was turned off
+    bool draw(std::size_t t_plane, std::size_t t_y, DisplayRow t_bits){
+        DisplayRow& row = m_planes[t_plane][t_y];
+        bool collision = (row & t_bits) != 0;
+        row ^= t_bits;
+        return collision;
+    }
+
+    const DisplayRow& row(std::size_t t_plane, std::size_t t_y) const{
+        return m_planes[t_plane][t_y];
+    }
+
+    void setRow(std::size_t t_plane, std::size_t t_y, DisplayRow t_bits){
+        m_planes[t_plane][t_y] = t_bits;
+    }
+
+    // Palette index of pixel (t_x, t_y), bit p set when the pixel is lit in plane p
+    uint8_t pixel(std::size_t t_x, std::size_t t_y) const{
+        uint8_t index = 0;
+        for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+            index |= static_cast<uint8_t>((m_planes[plane][t_y] >> (CHIP8_HIRES_X - 1 - t_x)) & 0x01) << plane;
+        }
+        return index;
+    }
+
+    // Palette index of every pixel, row major
+    void readPixels(uint8_t* t_pixels) const{
+        for(std::size_t y = 0; y < CHIP8_HIRES_Y; ++y){
+            for(std::size_t x = 0; x < CHIP8_HIRES_X; ++x){
+                *t_pixels++ = pixel(x, y);
+            }
+        }
+    }
+
+    const uint8_t* data() const{
+        return reinterpret_cast<const uint8_t*>(m_planes.data());
+    }
+
+    static constexpr std::size_t size(){
+        return sizeof(DisplayRow) * CHIP8_HIRES_Y * CHIP8_NUM_PLANES;
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_DISPLAY_HPP
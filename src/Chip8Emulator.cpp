@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <SDL2/SDL_endian.h>
@@ -9,15 +10,10 @@
 #include "LoggerImpl.hpp"
 #include "Chip8Emulator.hpp"
 #include "Chip8Util.hpp"
+#include "RomLibrary.hpp"
 
 namespace Chip8{
 
-        template<uint32_t>
-        uint32_t mapColorFormat(const SDL_Color& color);
-
-        template<uint32_t>
-        uint32_t mapColorFormat(uint32_t r, uint32_t g, uint32_t b, uint32_t a);
-
         template<>
         uint32_t mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(uint32_t r, uint32_t g, uint32_t b, uint32_t a){
             #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -50,12 +46,27 @@ namespace Chip8{
 
         namespace arg = std::placeholders;
 
-        Emulator::Emulator(const std::pair<int, int>& t_resolution, const std::pair<SDL_Color, SDL_Color>& t_palette, std::string& t_romPath, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds, bool t_chip8Seed) : m_run(true), 
+        Emulator::Emulator(const std::pair<int, int>& t_resolution, const std::array<SDL_Color, CHIP8_NUM_COLORS>& t_palette, std::string& t_romPath, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds, bool t_chip8Seed, long t_tickPeriodUsec, const std::string& t_quirks) : m_run(true), 
                                                                                                                                                                                                                 m_chip8Run(true), 
                                                                                                                                                                                                                 m_chip8Paused(false), 
+                                                                                                                                                                                                                m_ticks(0), 
+                                                                                                                                                                                                                m_tickPeriodUsec(std::max(1L, t_tickPeriodUsec)), 
                                                                                                                                                                                                                 m_romPath(t_romPath), 
-                                                                                                                                                                                                                m_chip8Instance((t_chip8Seed)? std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()) : 0, t_romPath), 
-                                                                                                                                                                                                                m_inputHandler(t_keyBinds){
+                                                                                                                                                                                                                m_chip8Instance(makeMachine(t_quirks, (t_chip8Seed)? std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()) : 0)), 
+                                                                                                                                                                                                                m_inputHandler(t_keyBinds),
+                                                                                                                                                                                                                m_rewinding(false),
+                                                                                                                                                                                                                m_ticksPerFrame(std::max(1L, 1000000 / (CHIP8_FRAME_RATE * m_tickPeriodUsec))),
+                                                                                                                                                                                                                m_frameTicks(0),
+                                                                                                                                                                                                                m_cycle(0),
+                                                                                                                                                                                                                m_captureCycle(0),
+                                                                                                                                                                                                                m_keys(0),
+                                                                                                                                                                                                                m_appliedKeys(0),
+                                                                                                                                                                                                                m_keysApplied(false),
+                                                                                                                                                                                                                m_runAheadFrames(0),
+                                                                                                                                                                                                                m_runAheadUsec(0),
+                                                                                                                                                                                                                m_runAheadCount(0){
+
+            m_chip8Instance->load(t_romPath);
 
             this->m_window = SDL_CreateWindow("Chip8 Emu", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, t_resolution.first, t_resolution.second, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
             chip8Logger.log<Logger::LogTrace>("Emulator: m_window created", Logger::endl);
@@ -68,11 +79,16 @@ namespace Chip8{
 
             m_windowTexture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, render_target_w, render_target_h);
 
-            m_frameFgColor =    mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(t_palette.first);
+            for(std::size_t color = 0; color < CHIP8_NUM_COLORS; ++color){
+                m_framePalette[color] = mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(t_palette[color]);
+            }
+
+            m_frameFgColor =    m_framePalette[1];
 
-            m_frameBgColor =    mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(t_palette.second);
+            m_frameBgColor =    m_framePalette[0];
 
-            m_frameTexture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, 64, 32);
+            m_framePixels.resize(m_chip8Instance->displayWidth() * m_chip8Instance->displayHeight());
+            m_frameTexture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, m_chip8Instance->displayWidth(), m_chip8Instance->displayHeight());
 
             int bpp;
             uint32_t r_mask, g_mask, b_mask, a_mask;
@@ -122,24 +138,26 @@ namespace Chip8{
                 m_pauseRenderBoundary.y = 0;
             }
 
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_0, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_0));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_1, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_1));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_2, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_2));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_3, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_3));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_4, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_4));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_5, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_5));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_6, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_6));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_7, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_7));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_8, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_8));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_9, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_9));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_A, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_A));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_B, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_B));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_C, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_C));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_D, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_D));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_E, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_E));
-            m_inputHandler.bindAction(KeyHandler::KEY_CH8_F, std::bind(&Chip8::updateKeystate, &m_chip8Instance, arg::_1, arg::_2, KEY_F));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_0, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_0));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_1, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_1));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_2, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_2));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_3, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_3));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_4, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_4));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_5, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_5));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_6, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_6));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_7, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_7));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_8, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_8));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_9, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_9));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_A, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_A));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_B, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_B));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_C, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_C));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_D, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_D));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_E, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_E));
+            m_inputHandler.bindAction(KeyHandler::KEY_CH8_F, std::bind(&Emulator::handleKeyInput, this, arg::_1, arg::_2, KEY_F));
             m_inputHandler.bindAction(KeyHandler::KEY_EMU_RESET, std::bind(&Emulator::handleResetInput, this, arg::_1, arg::_2));
             m_inputHandler.bindAction(KeyHandler::KEY_EMU_PAUSE, std::bind(&Emulator::handlePauseInput, this, arg::_1, arg::_2));
+            m_inputHandler.bindAction(KeyHandler::KEY_EMU_REWIND, std::bind(&Emulator::handleRewindInput, this, arg::_1, arg::_2));
+            m_inputHandler.bindAction(KeyHandler::KEY_EMU_PROFILE, std::bind(&Emulator::handleProfileInput, this, arg::_1, arg::_2));
         }
 
         void Emulator::handlePauseInput(bool t_pressState, bool t_repeat){
@@ -157,11 +175,154 @@ namespace Chip8{
         }
 
         void Emulator::handleResetInput(bool t_pressState, bool t_repeat){
-            if(t_pressState && !t_repeat){
-                m_chip8Instance.reset();
-                m_chip8Instance.load(m_romPath);
+            // A netplay peer cannot follow a restart
+            if(t_pressState && !t_repeat && !m_netplay){
+                restartSession();
                 m_chip8Run = true;
+                renderFrame();
+            }
+        }
+
+        void Emulator::handleKeyInput(bool t_pressState, bool t_repeat, Chip8Key t_key){
+            // Applied before the next tick, see applyKeys
+            m_keys = (m_keys & ~(0x1 << t_key)) | (t_pressState << t_key);
+        }
+
+        void Emulator::applyKeys(){
+            if(m_keysApplied && m_keys == m_appliedKeys){
+                return;
             }
+            m_chip8Instance->setKeystates(m_keys);
+            m_appliedKeys = m_keys;
+            m_keysApplied = true;
+            if(m_replay){
+                m_replay->addEvent(m_cycle, m_keys);
+            }
+        }
+
+        void Emulator::restartSession(){
+            m_chip8Instance->restart();
+            m_cycle = m_chip8Instance->bootTicks();
+            m_keysApplied = false;
+            if(m_replay){
+                m_replay->clear();
+            }
+            if(m_profiler){
+                m_profiler->clear();
+            }
+            if(m_rewind){
+                m_rewind->clear();
+                captureFrame();
+            }
+        }
+
+        void Emulator::handleRewindInput(bool t_pressState, bool t_repeat){
+            if(!m_rewind || t_repeat){
+                return;
+            }
+            m_rewinding = t_pressState;
+            m_frameTicks = 0;
+        }
+
+        void Emulator::handleProfileInput(bool t_pressState, bool t_repeat){
+            if(m_profiler && t_pressState && !t_repeat){
+                saveProfile();
+            }
+        }
+
+        void Emulator::enableRewind(std::size_t t_seconds, std::size_t t_bufferBytes){
+            m_rewindState.resize(m_chip8Instance->stateSize());
+            m_rewind.reset(new RewindBuffer(m_rewindState.size(), t_seconds * CHIP8_FRAME_RATE, t_bufferBytes));
+            captureFrame();
+            chip8Logger.log<Logger::LogTrace>("Emulator: rewind of ", t_seconds, "s in ", m_rewind->capacityBytes(), " bytes", Logger::endl);
+        }
+
+        void Emulator::startRecording(const std::string& t_filePath, uint64_t t_romHash){
+            m_replay.reset(new Replay(t_romHash, m_chip8Instance->quirks(), m_chip8Instance->seed()));
+            m_replayPath = t_filePath;
+            m_keysApplied = false;
+        }
+
+        void Emulator::enableRunAhead(long t_frames){
+            m_runAheadFrames = std::max(0L, t_frames);
+            m_runAheadState.resize(m_chip8Instance->stateSize());
+        }
+
+        void Emulator::enableNetplay(uint16_t t_localPort, const std::string& t_peerHost, uint16_t t_peerPort, long t_latencyMsec, unsigned t_lossPercent){
+            m_netplayLink.reset(new UdpLink(t_localPort, t_peerHost, t_peerPort, t_latencyMsec, t_lossPercent));
+            m_netplay.reset(new NetplaySession(*m_chip8Instance, *m_netplayLink, m_ticksPerFrame));
+            m_frameTicks = 0;
+            chip8Logger.log<Logger::LogTrace>("Emulator: netplay on port ", m_netplayLink->localPort(), " with ", t_peerHost, ":", t_peerPort, Logger::endl);
+        }
+
+        void Emulator::runAhead(){
+            auto start = std::chrono::steady_clock::now();
+            m_chip8Instance->saveState(m_runAheadState.data(), m_runAheadState.size());
+            // The frames ahead are only shown, the ticks that count are the ones that run them for real
+            ExecutionCounters counters = m_chip8Instance->counters();
+            try{
+                for(long tick = 0; tick < m_runAheadFrames * m_ticksPerFrame; ++tick){
+                    m_chip8Instance->run_tick();
+                }
+            }
+            catch(const std::string&){
+                // The machine itself reports the fault once it gets there, until then show the frames before it
+            }
+            renderFrame();
+            m_chip8Instance->loadState(m_runAheadState.data(), m_runAheadState.size());
+            m_chip8Instance->setCounters(counters);
+            m_runAheadUsec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            ++m_runAheadCount;
+        }
+
+        void Emulator::setPins(const MemoryPins& t_pins){
+            m_pins = t_pins;
+            for(const MemoryPins::Pin& pin : m_pins.pins()){
+                chip8Logger.log<Logger::LogTrace>("Emulator: pinned 0x", std::hex, pin.addr, " to ", std::dec, static_cast<unsigned>(pin.value), Logger::endl);
+            }
+        }
+
+        void Emulator::setTriggers(const TriggerProgram& t_triggers){
+            m_triggers = t_triggers;
+            m_triggerCounters = TriggerCounters(m_triggers.size());
+        }
+
+        void Emulator::enableGdb(const std::string& t_address){
+            m_chip8Instance = makeMachine(m_chip8Instance->quirks(), m_chip8Instance->seed(), true);
+            m_chip8Instance->load(m_romPath);
+            m_debugger.reset(new Debugger(*m_chip8Instance));
+            m_gdb.reset(new GdbStub(*m_debugger, t_address));
+            std::cout << "Emulator: waiting for gdb on " << t_address << std::endl;
+            m_gdb->accept();
+            chip8Logger.log<Logger::LogInfo>("Emulator: gdb connected", Logger::endl);
+        }
+
+        void Emulator::enableProfile(const std::string& t_filePath, uint64_t t_samplePeriod){
+            m_profiler.reset(new Profiler(t_samplePeriod));
+            m_profilePath = t_filePath;
+        }
+
+        void Emulator::saveProfile(){
+            try{
+                m_profiler->save(m_profilePath, m_chip8Instance->counters());
+                chip8Logger.log<Logger::LogInfo>("Emulator: profile of ", m_chip8Instance->counters().instructions, " instructions written to ", m_profilePath, Logger::endl);
+            }
+            catch(const std::string& error){
+                chip8Logger.log<Logger::LogError>(error, Logger::endl);
+            }
+        }
+
+        void Emulator::captureFrame(){
+            m_chip8Instance->saveState(m_rewindState.data(), m_rewindState.size());
+            m_rewind->push(m_rewindState.data());
+            m_captureCycle = m_cycle;
+        }
+
+        void Emulator::boot(uint64_t t_romHash, const std::string& t_bootDirectory){
+            m_chip8Instance->boot(t_romHash, t_bootDirectory);
+            m_cycle = m_chip8Instance->bootTicks();
+            // The boot state may already show a title screen and only wait for a key
+            renderFrame();
         }
 
         void Emulator::run(){
@@ -171,15 +332,83 @@ namespace Chip8{
             std::chrono::high_resolution_clock::time_point beg, end;
             while(m_run){
                 beg = std::chrono::high_resolution_clock::now();
-                if(m_run && m_chip8Run && !m_chip8Paused){
+                if(m_rewinding && !m_chip8Paused){
+                    // One state back per frame, so the history plays in reverse at its own speed
+                    if(++m_frameTicks >= m_ticksPerFrame){
+                        m_frameTicks = 0;
+                        if(m_rewind->pop(m_rewindState.data())){
+                            m_chip8Instance->loadState(m_rewindState.data(), m_rewindState.size());
+                            m_captureCycle -= m_ticksPerFrame;
+                            m_cycle = m_captureCycle;
+                            // The recorded future is undone with it, and the keys held now take over from the
+                            // ones held in the state rewound to
+                            if(m_replay){
+                                m_replay->truncate(m_cycle);
+                            }
+                            m_keysApplied = false;
+                            m_chip8Run = true;
+                            renderFrame();
+                        }
+                    }
+                }
+                else if(m_netplay && m_chip8Run && !m_chip8Paused){
+                    // The peers exchange one key state per frame, so the session runs a frame at a time
+                    if(++m_frameTicks >= m_ticksPerFrame){
+                        m_frameTicks = 0;
+                        if(m_netplay->advanceFrame(m_keys)){
+                            renderFrame();
+                        }
+                        std::string fault = m_netplay->fault();
+                        if(!fault.empty()){
+                            chip8Logger.log<Logger::LogError>(fault, Logger::endl);
+                            m_chip8Run = false;
+                        }
+                    }
+                }
+                else if(m_gdb && m_chip8Run && !m_chip8Paused){
+                    // One tick per period while the client has the machine resumed, the frame is shown whenever it stops
+                    if(!m_gdb->poll()){
+                        chip8Logger.log<Logger::LogInfo>("Emulator: gdb disconnected", Logger::endl);
+                        m_gdb.reset();
+                        renderFrame();
+                    }
+                    else if(m_gdb->resumed()){
+                        applyKeys();
+                        m_cycle += m_gdb->advance(1);
+                        if(!m_gdb->resumed() || !(m_cycle % m_ticksPerFrame)){
+                            renderFrame();
+                        }
+                    }
+                }
+                else if(m_run && m_chip8Run && !m_chip8Paused){
+                    applyKeys();
                     try{
-                        TickResult res = m_chip8Instance.run_tick();
-                        if(res.displayUpdate){
+                        TickResult res = (m_profiler)? m_profiler->tick(*m_chip8Instance) : m_chip8Instance->run_tick();
+                        ++m_cycle;
+                        if(res.displayUpdate && !m_runAheadFrames){
                             renderFrame();
                         }
                         updateSoundState(res.soundState);
+                        if(!m_pins.empty() && !(m_cycle % m_ticksPerFrame)){
+                            m_pins.apply(*m_chip8Instance);
+                        }
+                        if(!m_triggers.empty() && !(m_cycle % m_ticksPerFrame)){
+                            uint64_t frame = m_cycle / m_ticksPerFrame;
+                            for(uint64_t fired = m_triggerCounters.update(m_chip8Instance->evaluate(m_triggers), frame); fired; fired &= fired - 1){
+                                chip8Logger.log<Logger::LogInfo>("Trigger '", m_triggers.name(__builtin_ctzll(fired)), "' at frame ", frame, Logger::endl);
+                            }
+                        }
+                        // A snapshot and its delta take a few microseconds, well inside one tick period
+                        if(m_rewind && m_cycle - m_captureCycle >= static_cast<uint64_t>(m_ticksPerFrame)){
+                            captureFrame();
+                        }
+                        if(m_runAheadFrames && !(m_cycle % m_ticksPerFrame)){
+                            runAhead();
+                        }
                     }
                     catch(std::string error_msg){
+                        // The faulting tick counts, a replay runs it too and stops on the same fault
+                        ++m_cycle;
                         chip8Logger.log<Logger::LogError>(error_msg, Logger::endl);
                         m_chip8Run = false;
                     }
@@ -215,11 +444,41 @@ namespace Chip8{
                 }
                 end = std::chrono::high_resolution_clock::now();
                 m_ticks++;
-                auto sleep_duration = CHIP8_TICK_PERIOD_USEC - std::chrono::duration_cast<std::chrono::microseconds>(end - beg).count();
+                auto sleep_duration = m_tickPeriodUsec - std::chrono::duration_cast<std::chrono::microseconds>(end - beg).count();
                 if(sleep_duration > 0){
                     usleep(sleep_duration);
                 }
             }
+
+            if(m_replay){
+                m_replay->finish(m_cycle, m_chip8Instance->stateHash());
+                m_replay->save(m_replayPath);
+                chip8Logger.log<Logger::LogTrace>("Emulator: recorded ", m_cycle, " cycles and ", m_replay->events().size(), " key changes to ", m_replayPath, Logger::endl);
+            }
+            if(m_profiler){
+                saveProfile();
+            }
+            if(m_netplay){
+                const NetplaySession::Stats& stats = m_netplay->stats();
+                std::cout << "Netplay: " << stats.frames << " frames, " << stats.stalls << " waiting for the peer, " << stats.rollbacks << " rollbacks re-running "
+                          << stats.resimulatedFrames << " frames in " << stats.resimulationUsec << " usec (longest " << stats.maxResimulationUsec << " usec), "
+                          << stats.datagramsSent << " datagrams sent, " << stats.datagramsReceived << " received" << std::endl;
+            }
+            for(std::size_t trigger = 0; trigger < m_triggers.size(); ++trigger){
+                const TriggerCounters::Counter& counter = m_triggerCounters.counters()[trigger];
+                std::cout << "Trigger '" << m_triggers.name(trigger) << "': fired " << counter.fired << " times";
+                if(counter.fired){
+                    std::cout << ", first at frame " << counter.firstFrame;
+                }
+                std::cout << ", held for " << counter.frames << " frames" << std::endl;
+            }
+            if(m_runAheadCount){
+                double usecPerFrame = static_cast<double>(m_runAheadUsec) / m_runAheadCount;
+                std::cout << "Run ahead " << m_runAheadFrames << " frames: " << std::fixed << std::setprecision(1) << usecPerFrame << " usec per frame, "
+                          << 100.0 * usecPerFrame * CHIP8_FRAME_RATE / 1000000 << "% of the frame time, "
+                          << m_runAheadFrames * m_ticksPerFrame << " extra ticks per " << m_ticksPerFrame << ", "
+                          << 1000.0 * m_runAheadFrames / CHIP8_FRAME_RATE << " ms of input latency hidden" << std::endl;
+            }
         }
 
         void Emulator::renderFrame(){
@@ -227,13 +486,10 @@ namespace Chip8{
             int frame_tex_pitch = 0;
 
             if(!SDL_LockTexture(m_frameTexture, NULL, (void**)&frame_tex_pixels, &frame_tex_pitch)){
-                auto ch8_display = m_chip8Instance.getDisplay();
-                for(uint ind = 0; ind < CHIP8_DISP_SIZE; ind++){
-                    uint8_t disp_byte = ch8_display[ind];
-                    for(uint bit_ind = 0; bit_ind < 8; bit_ind++){
-                        frame_tex_pixels[ind * 8 + (7 - bit_ind)] = (disp_byte & 0x01)? m_frameFgColor : m_frameBgColor;
-                        disp_byte >>= 1;
-                    }
+                m_chip8Instance->readPixels(m_framePixels.data());
+                const std::size_t width = m_chip8Instance->displayWidth();
+                for(std::size_t ind = 0; ind < m_framePixels.size(); ind++){
+                    frame_tex_pixels[(ind / width) * (frame_tex_pitch / sizeof(uint32_t)) + ind % width] = m_framePalette[m_framePixels[ind]];
                 }
 
             }
@@ -2,17 +2,43 @@
 #define EMU_SDL_H
 
 #include <SDL2/SDL.h>
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "KeyHandler.hpp"
 #include "Chip8.hpp"
+#include "Chip8Display.hpp"
+#include "Chip8Machine.hpp"
+#include "Debugger.hpp"
+#include "GdbStub.hpp"
+#include "MemorySearch.hpp"
+#include "Netplay.hpp"
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include "RewindBuffer.hpp"
+#include "Trigger.hpp"
 
 #define PAUSE_BLINK_INTERVAL 375
 
 namespace Chip8{
 
+        // Pixel value of a colour in texture format TFormat, specialized for SDL_PIXELFORMAT_RGBA8888
+        template<uint32_t TFormat>
+        uint32_t mapColorFormat(const SDL_Color& color);
+
+        template<uint32_t TFormat>
+        uint32_t mapColorFormat(uint32_t r, uint32_t g, uint32_t b, uint32_t a);
+
+        template<>
+        uint32_t mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(const SDL_Color& color);
+
+        template<>
+        uint32_t mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(uint32_t r, uint32_t g, uint32_t b, uint32_t a);
+
         enum chip8_run_state{
             RUNNING = 0,
             NOT_RUNNING,
@@ -27,6 +53,9 @@ namespace Chip8{
 
             SDL_Texture* m_frameTexture = nullptr;
             uint32_t m_frameBgColor, m_frameFgColor;
+            // Texture colour of each palette index, and the indices of the last frame
+            std::array<uint32_t, CHIP8_NUM_COLORS> m_framePalette;
+            std::vector<uint8_t> m_framePixels;
 
             SDL_Texture* m_pauseTexture = nullptr;
             SDL_Rect m_pauseRenderBoundary;
@@ -41,20 +70,93 @@ namespace Chip8{
             bool m_chip8Paused;
 
             long m_ticks;
+            long m_tickPeriodUsec;
 
             const std::string& m_romPath;
-            Chip8 m_chip8Instance;
+            std::unique_ptr<Machine> m_chip8Instance;
             KeyHandler::KeyHandler m_inputHandler;
 
+            // One snapshot per frame while running, played back a frame at a time while key_emu_rewind is held
+            std::unique_ptr<RewindBuffer> m_rewind;
+            std::vector<uint8_t> m_rewindState;
+            bool m_rewinding;
+            long m_ticksPerFrame;
+            long m_frameTicks;
+
+            // Ticks since a cold load of the rom, input reaches the machine only between ticks so a session is
+            // its seed and the key state at every cycle it changed
+            uint64_t m_cycle;
+            // Cycle of the newest rewind snapshot, snapshots are m_ticksPerFrame cycles apart
+            uint64_t m_captureCycle;
+            uint16_t m_keys;
+            uint16_t m_appliedKeys;
+            bool m_keysApplied;
+            std::unique_ptr<Replay> m_replay;
+            std::string m_replayPath;
+
+            // Frames shown ahead of the machine, see enableRunAhead, and what running them ahead cost
+            long m_runAheadFrames;
+            std::vector<uint8_t> m_runAheadState;
+            uint64_t m_runAheadUsec;
+            uint64_t m_runAheadCount;
+
+            std::unique_ptr<UdpLink> m_netplayLink;
+            std::unique_ptr<NetplaySession> m_netplay;
+
+            MemoryPins m_pins;
+            TriggerProgram m_triggers;
+            TriggerCounters m_triggerCounters;
+
+            std::unique_ptr<Debugger> m_debugger;
+            std::unique_ptr<GdbStub> m_gdb;
+
+            std::unique_ptr<Profiler> m_profiler;
+            std::string m_profilePath;
+
             void renderFrame();
             void renderPause(bool t_forceUpdate);
             void updateSoundState(bool t_state); 
             void updateTargetSize();
             void handlePauseInput(bool t_state, bool t_repeat);
             void handleResetInput(bool t_state, bool t_repeat);
+            void handleRewindInput(bool t_state, bool t_repeat);
+            void handleProfileInput(bool t_state, bool t_repeat);
+            void handleKeyInput(bool t_state, bool t_repeat, Chip8Key t_key);
+            void captureFrame();
+            void runAhead();
+            void saveProfile();
+            void restartSession();
+            void applyKeys();
 
         public:
-            Emulator(const std::pair<int, int>& t_resolution, const std::pair<SDL_Color, SDL_Color>& t_palette, std::string& t_romPath, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds, bool t_chip8Seed);
+            Emulator(const std::pair<int, int>& t_resolution, const std::array<SDL_Color, CHIP8_NUM_COLORS>& t_palette, std::string& t_romPath, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds, bool t_chip8Seed, long t_tickPeriodUsec = CHIP8_TICK_PERIOD_USEC, const std::string& t_quirks = "");
+            // Starts the rom from its boot state, see Machine::boot; resets then restore it without reading the rom again
+            void boot(uint64_t t_romHash, const std::string& t_bootDirectory);
+            // Keeps t_seconds of history for key_emu_rewind in at most t_bufferBytes of deltas
+            void enableRewind(std::size_t t_seconds, std::size_t t_bufferBytes);
+            // Records the session from its current state on into t_filePath, see Replay. Written when run() returns,
+            // a restart starts the recording over.
+            void startRecording(const std::string& t_filePath, uint64_t t_romHash);
+            // Shows every frame as it will be t_frames frames later with the keys held now: the machine is saved,
+            // run ahead, drawn and restored, hiding frames of input lag the rom itself adds. Costs t_frames
+            // frames of emulation per frame, run() reports it when it returns.
+            void enableRunAhead(long t_frames);
+            // Plays the session with a peer at t_peerHost:t_peerPort, see NetplaySession. Both sides need the same
+            // rom, variant and seed; restarts are disabled. t_latencyMsec and t_lossPercent are injected into the link.
+            void enableNetplay(uint16_t t_localPort, const std::string& t_peerHost, uint16_t t_peerPort, long t_latencyMsec, unsigned t_lossPercent);
+            // Forces the pinned addresses to their values at the end of every frame, see MemoryPins
+            void setPins(const MemoryPins& t_pins);
+            // Evaluates t_triggers at the end of every frame and logs each firing, run() prints the counts when it returns
+            void setTriggers(const TriggerProgram& t_triggers);
+            // Swaps in the debug build of the machine, reloads the rom and blocks until a gdb client connects on
+            // t_address, see GdbStub. The machine then only runs while the client has it resumed, at the usual
+            // tick rate, and runs on freely once the client leaves. Call it before anything else that uses the machine.
+            void enableGdb(const std::string& t_address);
+            // Runs every tick through a Profiler timing one in t_samplePeriod, see Profiler. The profile and the
+            // machine's ExecutionCounters cover the session since its last restart and are written to t_filePath
+            // when run() returns and whenever key_emu_profile is pressed, as JSON for a .json path, CSV otherwise.
+            // Both count the ticks that were shown: run-ahead ticks are left out, rewound ones stay counted.
+            void enableProfile(const std::string& t_filePath, uint64_t t_samplePeriod);
             void run();
             ~Emulator();
         };
@@ -0,0 +1,678 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include "Chip8Extended.hpp"
+#include "Chip8Util.hpp"
+#include "PagedMemory.hpp"
+
+namespace Chip8{
+
+// 8x10 digits 0-F loaded by FX30, SUPER-CHIP only defines 0-9
+static const uint8_t bigSpriteTable[] = {0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, /* 0 */
+                                         0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, /* 1 */
+                                         0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, /* 2 */
+                                         0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, /* 3 */
+                                         0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, /* 4 */
+                                         0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, /* 5 */
+                                         0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, /* 6 */
+                                         0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, /* 7 */
+                                         0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, /* 8 */
+                                         0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, /* 9 */
+                                         0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, /* A */
+                                         0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, /* B */
+                                         0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, /* C */
+                                         0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, /* D */
+                                         0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, /* E */
+                                         0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  /* F */};
+
+// Doubles every bit of a sprite row, low resolution pixels are 2x2 display pixels
+static uint32_t spreadBits(uint32_t t_bits){
+    uint32_t spread = 0;
+    for(unsigned bit = 0; bit < 16; ++bit){
+        spread |= ((t_bits >> bit) & 0x01) * (0x3u << (2 * bit));
+    }
+    return spread;
+}
+
+template<typename TRng, typename TMode>
+ExtendedChip8<TRng, TMode>::ExtendedChip8(uint64_t t_seed) : m_timerPeriod(CHIP8_TIMER_PERIOD), m_seed(t_seed), m_breakpoints(nullptr){
+    reset(m_seed);
+}
+
+template<typename TRng, typename TMode>
+ExtendedChip8<TRng, TMode>::ExtendedChip8(uint64_t t_seed, const std::string& t_rom) : m_timerPeriod(CHIP8_TIMER_PERIOD), m_seed(t_seed), m_breakpoints(nullptr){
+    reset(m_seed);
+    load(t_rom);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::reset(){
+    reset(m_seed);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::reset(uint64_t t_seed){
+    resetMachine();
+    m_generator = TRng(t_seed);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::resetMachine(){
+    m_memory.fill(0);
+    const MemoryImage& blank = *PagedMemory::blankImage();
+    std::copy(blank.begin(), blank.begin() + CHIP8_SPRITE_TABLE_SIZE, m_memory.begin());
+    std::copy(std::begin(bigSpriteTable), std::end(bigSpriteTable), m_memory.begin() + CHIP8_BIG_SPRITE_OFFSET);
+
+    m_vRegs.fill(0);
+    m_stack.fill(0);
+    m_flagRegs.fill(0);
+    m_audioPattern.fill(0);
+    m_display.clear(CHIP8_NUM_COLORS - 1);
+    m_programCounter = CHIP8_PROG_START_OFFSET;
+    m_iReg = 0;
+    m_keystates = 0;
+    m_dtReg = 0;
+    m_stReg = 0;
+    m_tCounter = 0;
+    m_stackPointer = 0;
+    m_hiRes = false;
+    m_halted = false;
+    m_planeMask = 0x01;
+    m_pitch = 64;
+    m_counters = ExecutionCounters();
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::load(const std::string& t_filePath){
+    std::ifstream romStream(t_filePath, std::ios::binary);
+    if(!romStream.is_open()){
+        throw std::string("Chip8: could not open rom '" + t_filePath + "'");
+    }
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(romStream)), std::istreambuf_iterator<char>());
+    load(rom.data(), rom.size());
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::load(const uint8_t* t_rom, std::size_t t_size){
+    std::copy(t_rom, t_rom + std::min<std::size_t>(t_size, TMode::memorySize - CHIP8_PROG_START_OFFSET), m_memory.begin() + CHIP8_PROG_START_OFFSET);
+}
+
+template<typename TRng, typename TMode>
+uint64_t ExtendedChip8<TRng, TMode>::runToInput(uint64_t t_maxTicks){
+    uint64_t ticks = 0;
+    while(ticks < t_maxTicks && !m_halted && !readsInput((read(m_programCounter) << 8) | read(m_programCounter + 1))){
+        run_tick();
+        ++ticks;
+    }
+    return ticks;
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::restore(const ExtendedChip8& t_boot, uint64_t t_seed){
+    uint64_t seed = m_seed;
+    Breakpoints* breakpoints = m_breakpoints;
+    uint8_t timerPeriod = m_timerPeriod;
+    *this = t_boot;
+    m_seed = seed;
+    m_breakpoints = breakpoints;
+    m_timerPeriod = timerPeriod;
+    m_generator = TRng(t_seed);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::writeState(std::ostream& t_outStream) const{
+    const uint8_t flags[] = {m_dtReg, m_stReg, m_tCounter, m_stackPointer, m_hiRes, m_halted, m_planeMask, m_pitch};
+    Util::writeRaw(t_outStream, m_vRegs);
+    Util::writeRaw(t_outStream, m_programCounter);
+    Util::writeRaw(t_outStream, m_iReg);
+    Util::writeRaw(t_outStream, m_keystates);
+    Util::writeRaw(t_outStream, flags);
+    Util::writeRaw(t_outStream, m_stack);
+    Util::writeRaw(t_outStream, m_flagRegs);
+    Util::writeRaw(t_outStream, m_audioPattern);
+    Util::writeRaw(t_outStream, m_display);
+    Util::writeRaw(t_outStream, m_memory);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::readState(std::istream& t_inStream){
+    uint8_t flags[8];
+    Util::readRaw(t_inStream, m_vRegs);
+    Util::readRaw(t_inStream, m_programCounter);
+    Util::readRaw(t_inStream, m_iReg);
+    Util::readRaw(t_inStream, m_keystates);
+    Util::readRaw(t_inStream, flags);
+    Util::readRaw(t_inStream, m_stack);
+    Util::readRaw(t_inStream, m_flagRegs);
+    Util::readRaw(t_inStream, m_audioPattern);
+    Util::readRaw(t_inStream, m_display);
+    Util::readRaw(t_inStream, m_memory);
+    if(!t_inStream){
+        throw std::string("Chip8: truncated machine state");
+    }
+    m_dtReg = flags[0];
+    m_stReg = flags[1];
+    m_tCounter = flags[2];
+    m_stackPointer = flags[3] & (CHIP8_STACK_SIZE - 1);
+    m_hiRes = flags[4];
+    m_halted = flags[5];
+    m_planeMask = flags[6];
+    m_pitch = flags[7];
+}
+
+template<typename TRng, typename TMode>
+constexpr std::size_t ExtendedChip8<TRng, TMode>::stateSize;
+
+template<typename TRng, typename TMode>
+std::size_t ExtendedChip8<TRng, TMode>::saveState(uint8_t* t_buffer, std::size_t t_size) const{
+    if(t_size < stateSize){
+        throw std::string("Chip8: state buffer too small");
+    }
+
+    uint8_t* out = t_buffer;
+    Util::putLE<uint32_t>(out, CHIP8_EXT_STATE_MAGIC);
+    Util::putLE<uint16_t>(out, CHIP8_STATE_VERSION);
+    Util::putLE<uint16_t>(out, TRng::stateSize);
+    Util::putLE(out, m_seed);
+    Util::putLE<uint32_t>(out, TMode::memorySize);
+    out = std::copy(m_vRegs.begin(), m_vRegs.end(), out);
+    Util::putLE(out, m_programCounter);
+    Util::putLE(out, m_iReg);
+    Util::putLE(out, m_keystates);
+    const uint8_t flags[] = {m_dtReg, m_stReg, m_tCounter, m_stackPointer, m_hiRes, m_halted, m_planeMask, m_pitch};
+    out = std::copy(std::begin(flags), std::end(flags), out);
+    for(uint16_t entry : m_stack){
+        Util::putLE(out, entry);
+    }
+    out = std::copy(m_flagRegs.begin(), m_flagRegs.end(), out);
+    out = std::copy(m_audioPattern.begin(), m_audioPattern.end(), out);
+    for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+        for(std::size_t y = 0; y < CHIP8_HIRES_Y; ++y){
+            Util::putLE(out, m_display.row(plane, y));
+        }
+    }
+    out = std::copy(m_memory.begin(), m_memory.end(), out);
+    m_generator.saveState(out);
+    return stateSize;
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::loadState(const uint8_t* t_buffer, std::size_t t_size){
+    if(t_size < stateSize){
+        throw std::string("Chip8: truncated machine state");
+    }
+
+    const uint8_t* in = t_buffer;
+    if(Util::getLE<uint32_t>(in) != CHIP8_EXT_STATE_MAGIC){
+        throw std::string("Chip8: not a machine state");
+    }
+    if(Util::getLE<uint16_t>(in) != CHIP8_STATE_VERSION){
+        throw std::string("Chip8: unsupported machine state version");
+    }
+    if(Util::getLE<uint16_t>(in) != TRng::stateSize){
+        throw std::string("Chip8: machine state was saved with another generator");
+    }
+    uint64_t seed = Util::getLE<uint64_t>(in);
+    if(Util::getLE<uint32_t>(in) != TMode::memorySize){
+        throw std::string("Chip8: machine state was saved by another machine model");
+    }
+    m_seed = seed;
+    std::copy(in, in + CHIP8_NUM_V_REG, m_vRegs.begin());
+    in += CHIP8_NUM_V_REG;
+    m_programCounter = Util::getLE<uint16_t>(in);
+    m_iReg = Util::getLE<uint16_t>(in);
+    m_keystates = Util::getLE<uint16_t>(in);
+    m_dtReg = *in++;
+    m_stReg = *in++;
+    m_tCounter = *in++;
+    m_stackPointer = *in++ & (CHIP8_STACK_SIZE - 1);
+    m_hiRes = *in++;
+    m_halted = *in++;
+    m_planeMask = *in++;
+    m_pitch = *in++;
+    for(uint16_t& entry : m_stack){
+        entry = Util::getLE<uint16_t>(in);
+    }
+    std::copy(in, in + CHIP8_NUM_FLAG_REGS, m_flagRegs.begin());
+    in += CHIP8_NUM_FLAG_REGS;
+    std::copy(in, in + CHIP8_AUDIO_PATTERN_SIZE, m_audioPattern.begin());
+    in += CHIP8_AUDIO_PATTERN_SIZE;
+    for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+        for(std::size_t y = 0; y < CHIP8_HIRES_Y; ++y){
+            m_display.setRow(plane, y, Util::getLE<DisplayRow>(in));
+        }
+    }
+    std::copy(in, in + TMode::memorySize, m_memory.begin());
+    in += TMode::memorySize;
+    m_generator.loadState(in);
+}
+
+template<typename TRng, typename TMode>
+uint64_t ExtendedChip8<TRng, TMode>::stateHash() const{
+    const uint8_t regs[] = {static_cast<uint8_t>(m_iReg >> 8), static_cast<uint8_t>(m_iReg),
+                            static_cast<uint8_t>(m_programCounter >> 8), static_cast<uint8_t>(m_programCounter),
+                            m_dtReg, m_stReg, m_stackPointer, m_tCounter, m_hiRes, m_halted, m_planeMask, m_pitch};
+    uint64_t hash = Util::fnv1a(regs, sizeof(regs));
+    hash = Util::fnv1a(m_vRegs.data(), m_vRegs.size(), hash);
+    hash = Util::fnv1a(reinterpret_cast<const uint8_t*>(m_stack.data()), m_stack.size() * sizeof(uint16_t), hash);
+    hash = Util::fnv1a(m_flagRegs.data(), m_flagRegs.size(), hash);
+    hash = Util::fnv1a(m_audioPattern.data(), m_audioPattern.size(), hash);
+    hash = Util::wordHash(m_memory.data(), m_memory.size(), hash);
+    return Util::wordHash(m_display.data(), m_display.size(), hash);
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::updateKeystate(bool t_pressState, bool t_repeat, const Chip8Key& t_key){
+    if(t_key != KEY_NULL)
+        m_keystates = (m_keystates & ~(0x1 << t_key)) | (t_pressState << t_key & (0x1 << t_key));
+}
+
+// The program counter already points past the instruction, XO-CHIP skips F000 NNNN as a whole
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::skip(){
+    ++m_counters.skipsTaken;
+    m_programCounter += (TMode::xoChip && read(m_programCounter) == 0xf0 && read(m_programCounter + 1) == 0x00)? 4 : 2;
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::advanceIndex(uint8_t t_x){
+    if(TMode::loadStoreAdvance != Quirks::IndexAdvance::None){
+        m_iReg += t_x + (TMode::loadStoreAdvance == Quirks::IndexAdvance::ByXPlusOne);
+    }
+}
+
+// Draws an 8xN sprite, or 16x16 for N = 0, into every selected plane. Plane data follows one another from I.
+template<typename TRng, typename TMode>
+uint8_t ExtendedChip8<TRng, TMode>::draw(uint8_t t_x, uint8_t t_y, uint8_t t_n){
+    const unsigned scale = (m_hiRes)? 1 : 2;
+    const unsigned width = (t_n)? 8 : 16, height = (t_n)? t_n : 16;
+    const unsigned originX = (m_vRegs[t_x] * scale) & (CHIP8_HIRES_X - 1), originY = (m_vRegs[t_y] * scale) & (CHIP8_HIRES_Y - 1);
+    // Rows drawn per plane, those starting below the bottom edge are clipped
+    const unsigned rows = (TMode::clipSprites)? std::min(height, (CHIP8_HIRES_Y - originY + scale - 1) / scale) : height;
+
+    uint8_t collision = 0;
+    uint32_t addr = m_iReg;
+    for(std::size_t plane = 0; plane < CHIP8_NUM_PLANES; ++plane){
+        if(!((m_planeMask >> plane) & 0x01)){
+            continue;
+        }
+        m_counters.spriteRows += rows;
+        for(unsigned spriteLine = 0; spriteLine < height; ++spriteLine){
+            uint32_t bits = (width == 16)? (readData(addr) << 8) | readData(addr + 1) : readData(addr);
+            addr += width >> 3;
+            if(scale == 2){
+                bits = spreadBits(bits);
+            }
+
+            // Sprite row at the left edge, then moved to its column with one shift per half
+            DisplayRow sprite = static_cast<DisplayRow>(bits) << (CHIP8_HIRES_X - width * scale);
+            DisplayRow placed = sprite >> originX;
+            if(!TMode::clipSprites && originX){
+                placed |= sprite << (CHIP8_HIRES_X - originX);
+            }
+
+            for(unsigned repeat = 0; repeat < scale; ++repeat){
+                unsigned dispY = originY + spriteLine * scale + repeat;
+                if(dispY >= CHIP8_HIRES_Y){
+                    if(TMode::clipSprites){
+                        break;
+                    }
+                    dispY &= CHIP8_HIRES_Y - 1;
+                }
+                collision |= m_display.draw(plane, dispY, placed);
+            }
+        }
+    }
+    return collision;
+}
+
+template<typename TRng, typename TMode>
+void ExtendedChip8<TRng, TMode>::unknownOpcode(uint16_t t_op) const{
+    std::stringstream err_msg_stream;
+    err_msg_stream << "Chip8: Unknown opcode <0x" << std::hex << std::setfill('0') << std::setw(4) << t_op << "> at address <0x" << std::hex << std::setfill('0') << std::setw(4) << static_cast<uint16_t>(m_programCounter - 2) << ">.";
+    throw err_msg_stream.str();
+}
+
+template<typename TRng, typename TMode>
+TickResult ExtendedChip8<TRng, TMode>::run_tick(){
+    TickResult tickRes = {};
+    if(m_halted){
+        return tickRes;
+    }
+
+    if(++m_tCounter >= m_timerPeriod){
+        m_tCounter = 0;
+        if(m_dtReg){
+            m_dtReg--;
+        }
+        if(m_stReg){
+            m_stReg--;
+            tickRes.soundState = 1;
+        }
+    }
+
+    const uint16_t op = (read(m_programCounter) << 8) | read(m_programCounter + 1);
+    m_programCounter += 2;
+    ++m_counters.instructions;
+
+    const uint8_t x = (op >> 8) & 0x0f, y = (op >> 4) & 0x0f, kk = op & 0x00ff, n = op & 0x000f;
+    const uint16_t nnn = op & 0x0fff;
+    // Scroll distances are in pixels of the current resolution
+    const unsigned scale = (m_hiRes)? 1 : 2;
+
+    switch(op >> 12){
+        case 0x0:
+            if((op & 0xfff0) == 0x00c0){
+                // SCD N
+                m_display.scrollDown(m_planeMask, n * scale);
+                tickRes.displayUpdate = 1;
+                break;
+            }
+            if(TMode::xoChip && (op & 0xfff0) == 0x00d0){
+                // SCU N
+                m_display.scrollUp(m_planeMask, n * scale);
+                tickRes.displayUpdate = 1;
+                break;
+            }
+            switch(op){
+                case 0x00e0:
+                    // CLS
+                    m_display.clear(m_planeMask);
+                    tickRes.displayUpdate = 1;
+                    break;
+                case 0x00ee:
+                    // RET
+                    // The pointer itself wraps, like in saveState, so a restored machine hashes the same
+                    m_stackPointer = (m_stackPointer - 1) & (CHIP8_STACK_SIZE - 1);
+                    m_programCounter = m_stack[m_stackPointer];
+                    break;
+                case 0x00fb:
+                    // SCR
+                    m_display.scrollRight(m_planeMask, 4 * scale);
+                    tickRes.displayUpdate = 1;
+                    break;
+                case 0x00fc:
+                    // SCL
+                    m_display.scrollLeft(m_planeMask, 4 * scale);
+                    tickRes.displayUpdate = 1;
+                    break;
+                case 0x00fd:
+                    // EXIT
+                    m_programCounter -= 2;
+                    m_halted = true;
+                    break;
+                case 0x00fe:
+                case 0x00ff:
+                    // LOW, HIGH; XO-CHIP clears the display on a resolution change
+                    m_hiRes = (op == 0x00ff);
+                    if(TMode::xoChip){
+                        m_display.clear(CHIP8_NUM_COLORS - 1);
+                    }
+                    tickRes.displayUpdate = 1;
+                    break;
+                default:
+                    unknownOpcode(op);
+            }
+            break;
+        case 0x1:
+            // JMP NNN
+            m_programCounter = nnn;
+            break;
+        case 0x2:
+            // CALL NNN
+            m_stack[m_stackPointer] = m_programCounter;
+            m_stackPointer = (m_stackPointer + 1) & (CHIP8_STACK_SIZE - 1);
+            m_programCounter = nnn;
+            break;
+        case 0x3:
+            // SE VX, KK
+            if(m_vRegs[x] == kk){
+                skip();
+            }
+            break;
+        case 0x4:
+            // SNE VX, KK
+            if(m_vRegs[x] != kk){
+                skip();
+            }
+            break;
+        case 0x5:
+            if(n == 0){
+                // SE VX, VY
+                if(m_vRegs[x] == m_vRegs[y]){
+                    skip();
+                }
+            }
+            else if(TMode::xoChip && (n == 2 || n == 3)){
+                // SAVE VX - VY, LOAD VX - VY; either order, I is left alone
+                const int step = (x <= y)? 1 : -1;
+                for(int reg = x, offset = 0; ; reg += step, ++offset){
+                    if(n == 2){
+                        writeData(m_iReg + offset, m_vRegs[reg]);
+                    }
+                    else{
+                        m_vRegs[reg] = readData(m_iReg + offset);
+                    }
+                    if(reg == y){
+                        break;
+                    }
+                }
+            }
+            else{
+                unknownOpcode(op);
+            }
+            break;
+        case 0x6:
+            // LD VX, KK
+            m_vRegs[x] = kk;
+            break;
+        case 0x7:
+            // ADD VX, KK
+            m_vRegs[x] += kk;
+            break;
+        case 0x8:{
+            // VF is written last so VF as an operand sees its old value
+            uint8_t flag;
+            switch(n){
+                case 0x0:
+                    m_vRegs[x] = m_vRegs[y];
+                    break;
+                case 0x1:
+                    m_vRegs[x] |= m_vRegs[y];
+                    break;
+                case 0x2:
+                    m_vRegs[x] &= m_vRegs[y];
+                    break;
+                case 0x3:
+                    m_vRegs[x] ^= m_vRegs[y];
+                    break;
+                case 0x4:
+                    flag = (m_vRegs[x] + m_vRegs[y]) > UINT8_MAX;
+                    m_vRegs[x] += m_vRegs[y];
+                    m_vRegs[0xf] = flag;
+                    break;
+                case 0x5:
+                    flag = m_vRegs[x] >= m_vRegs[y];
+                    m_vRegs[x] -= m_vRegs[y];
+                    m_vRegs[0xf] = flag;
+                    break;
+                case 0x6:{
+                    uint8_t value = m_vRegs[(TMode::shiftUsesVy)? y : x];
+                    m_vRegs[x] = value >> 1;
+                    m_vRegs[0xf] = value & 0x01;
+                    break;
+                }
+                case 0x7:
+                    flag = m_vRegs[y] >= m_vRegs[x];
+                    m_vRegs[x] = m_vRegs[y] - m_vRegs[x];
+                    m_vRegs[0xf] = flag;
+                    break;
+                case 0xe:{
+                    uint8_t value = m_vRegs[(TMode::shiftUsesVy)? y : x];
+                    m_vRegs[x] = value << 1;
+                    m_vRegs[0xf] = value >> 7;
+                    break;
+                }
+                default:
+                    unknownOpcode(op);
+            }
+            break;
+        }
+        case 0x9:
+            // SNE VX, VY
+            if(m_vRegs[x] != m_vRegs[y]){
+                skip();
+            }
+            break;
+        case 0xa:
+            // LD I, NNN
+            m_iReg = nnn;
+            break;
+        case 0xb:
+            // JMP V0, NNN or JMP VX, XNN
+            m_programCounter = m_vRegs[(TMode::jumpUsesVx)? x : 0] + nnn;
+            break;
+        case 0xc:
+            // RND VX, KK
+            m_vRegs[x] = m_generator.next() & kk;
+            break;
+        case 0xd:
+            // DRW VX, VY, N
+            m_vRegs[0xf] = draw(x, y, n);
+            ++m_counters.draws;
+            m_counters.collisions += m_vRegs[0xf];
+            tickRes.displayUpdate = 1;
+            break;
+        case 0xe:
+            if(kk == 0x9e){
+                // SKP VX
+                if(m_vRegs[x] < 0x10 && (m_keystates >> m_vRegs[x]) & 0x01){
+                    skip();
+                }
+            }
+            else if(kk == 0xa1){
+                // SKNP VX
+                if(!(m_vRegs[x] < 0x10 && (m_keystates >> m_vRegs[x]) & 0x01)){
+                    skip();
+                }
+            }
+            else{
+                unknownOpcode(op);
+            }
+            break;
+        case 0xf:
+            if(TMode::xoChip && op == 0xf000){
+                // LD I, NNNN
+                m_iReg = (read(m_programCounter) << 8) | read(m_programCounter + 1);
+                m_programCounter += 2;
+                break;
+            }
+            if(TMode::xoChip && kk == 0x01){
+                // PLANE N
+                m_planeMask = x & (CHIP8_NUM_COLORS - 1);
+                break;
+            }
+            if(TMode::xoChip && op == 0xf002){
+                // AUDIO
+                for(std::size_t i = 0; i < m_audioPattern.size(); ++i){
+                    m_audioPattern[i] = readData(m_iReg + i);
+                }
+                break;
+            }
+            switch(kk){
+                case 0x07:
+                    // LD VX, DT
+                    m_vRegs[x] = m_dtReg;
+                    break;
+                case 0x0a:
+                    // LD VX, KP; waits on this instruction until a key is held
+                    if(m_keystates){
+                        uint8_t keyIndex = 0;
+                        while(!((m_keystates >> keyIndex) & 0x01)){
+                            ++keyIndex;
+                        }
+                        m_vRegs[x] = keyIndex;
+                    }
+                    else{
+                        m_programCounter -= 2;
+                        ++m_counters.keyWaits;
+                    }
+                    break;
+                case 0x15:
+                    // LD DT, VX
+                    m_dtReg = m_vRegs[x];
+                    break;
+                case 0x18:
+                    // LD ST, VX
+                    m_stReg = m_vRegs[x];
+                    break;
+                case 0x1e:
+                    // ADD I, VX
+                    m_iReg += m_vRegs[x];
+                    break;
+                case 0x29:
+                    // LD I, Sprt(VX)
+                    m_iReg = 5 * (m_vRegs[x] & 0x0f);
+                    break;
+                case 0x30:
+                    // LD I, BigSprt(VX)
+                    m_iReg = CHIP8_BIG_SPRITE_OFFSET + CHIP8_BIG_SPRITE_SIZE * (m_vRegs[x] & 0x0f);
+                    break;
+                case 0x33:
+                    // LD I, BCD(VX)
+                    writeData(m_iReg, m_vRegs[x] / 100);
+                    writeData(m_iReg + 1, (m_vRegs[x] % 100) / 10);
+                    writeData(m_iReg + 2, m_vRegs[x] % 10);
+                    break;
+                case 0x3a:
+                    // PITCH VX
+                    if(!TMode::xoChip){
+                        unknownOpcode(op);
+                    }
+                    m_pitch = m_vRegs[x];
+                    break;
+                case 0x55:
+                    // LD [I], VX
+                    for(uint8_t i = 0; i <= x; ++i){
+                        writeData(m_iReg + i, m_vRegs[i]);
+                    }
+                    advanceIndex(x);
+                    break;
+                case 0x65:
+                    // LD VX, [I]
+                    for(uint8_t i = 0; i <= x; ++i){
+                        m_vRegs[i] = readData(m_iReg + i);
+                    }
+                    advanceIndex(x);
+                    break;
+                case 0x75:
+                    // LD R, VX
+                    for(uint8_t i = 0; i <= (x & (TMode::flagRegisters - 1)); ++i){
+                        m_flagRegs[i] = m_vRegs[i];
+                    }
+                    break;
+                case 0x85:
+                    // LD VX, R
+                    for(uint8_t i = 0; i <= (x & (TMode::flagRegisters - 1)); ++i){
+                        m_vRegs[i] = m_flagRegs[i];
+                    }
+                    break;
+                default:
+                    unknownOpcode(op);
+            }
+            break;
+    }
+
+    return tickRes;
+}
+
+template class ExtendedChip8<Rng::Mt19937, Modes::SuperChip>;
+template class ExtendedChip8<Rng::Mt19937, Modes::XoChip>;
+template class ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::SuperChip>>;
+template class ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::XoChip>>;
+
+} // namespace Chip8
@@ -0,0 +1,232 @@
+#ifndef CHIP8_EXTENDED_HPP
+#define CHIP8_EXTENDED_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "Chip8.hpp"
+#include "Chip8Display.hpp"
+#include "Chip8Quirks.hpp"
+#include "Chip8Rng.hpp"
+
+#define CHIP8_NUM_FLAG_REGS       0x0010
+#define CHIP8_BIG_SPRITE_OFFSET   CHIP8_SPRITE_TABLE_SIZE
+#define CHIP8_BIG_SPRITE_SIZE     0x000a
+#define CHIP8_AUDIO_PATTERN_SIZE  0x0010
+
+#define CHIP8_EXT_STATE_MAGIC     0x58533843
+
+namespace Chip8{
+    namespace Modes{
+
+    // Machine models for ExtendedChip8, a quirk policy plus what the model adds to CHIP-8:
+    //
+    //     xoChip          XO-CHIP opcodes: bit planes, F000 NNNN, 5XY2/5XY3, 00DN, audio
+    //     memorySize      bytes of guest memory, addresses wrap at it
+    //     flagRegisters   number of FX75/FX85 flag registers
+
+    struct SuperChip : Quirks::SuperChip{
+        static constexpr bool xoChip = false;
+        static constexpr uint32_t memorySize = 0x1000;
+        static constexpr uint8_t flagRegisters = 8;
+    };
+
+    struct XoChip : Quirks::XoChip{
+        static constexpr bool xoChip = true;
+        static constexpr uint32_t memorySize = 0x10000;
+        static constexpr uint8_t flagRegisters = 16;
+    };
+
+    } // namespace Modes
+
+// SUPER-CHIP and XO-CHIP interpreter: 128x64 high resolution, scrolling, 16x16 sprites, big font digits and
+// for XO-CHIP 64 KiB of memory and two bit planes giving four colours. Kept apart from BasicChip8 so the
+// CHIP-8 core keeps its 4 KiB paged memory and 64x32 display, and with them its state hashes.
+template<typename TRng, typename TMode>
+class ExtendedChip8{
+protected:
+    std::array<uint8_t, CHIP8_NUM_V_REG> m_vRegs;
+    uint16_t m_programCounter;
+    uint16_t m_iReg;
+    uint16_t m_keystates;
+    uint8_t m_dtReg;
+    uint8_t m_stReg;
+    uint8_t m_tCounter;
+    uint8_t m_timerPeriod;
+    uint8_t m_stackPointer;
+    bool m_hiRes;
+    bool m_halted;
+    uint8_t m_planeMask;
+    uint8_t m_pitch;
+    std::array<uint16_t, CHIP8_STACK_SIZE> m_stack;
+    std::array<uint8_t, CHIP8_NUM_FLAG_REGS> m_flagRegs;
+    std::array<uint8_t, CHIP8_AUDIO_PATTERN_SIZE> m_audioPattern;
+
+    PlaneDisplay m_display;
+    std::array<uint8_t, TMode::memorySize> m_memory;
+
+    uint64_t m_seed;
+    TRng m_generator;
+    // Only debug instantiations (see Quirks::Debug) look at it
+    Breakpoints* m_breakpoints;
+    ExecutionCounters m_counters;
+
+    uint8_t read(uint32_t t_addr) const{
+        return m_memory[t_addr & (TMode::memorySize - 1)];
+    }
+
+    void write(uint32_t t_addr, uint8_t t_value){
+        m_memory[t_addr & (TMode::memorySize - 1)] = t_value;
+    }
+
+    // Data accesses of instructions, report to m_breakpoints in debug instantiations. Fetches use read().
+    uint8_t readData(uint32_t t_addr) const{
+        if(TMode::debug && m_breakpoints){
+            m_breakpoints->read(t_addr);
+        }
+        return read(t_addr);
+    }
+
+    void writeData(uint32_t t_addr, uint8_t t_value){
+        if(TMode::debug && m_breakpoints){
+            m_breakpoints->write(t_addr);
+        }
+        write(t_addr, t_value);
+    }
+
+    void resetMachine();
+    void skip();
+    void advanceIndex(uint8_t t_x);
+    uint8_t draw(uint8_t t_x, uint8_t t_y, uint8_t t_n);
+    void unknownOpcode(uint16_t t_op) const;
+
+public:
+    typedef TRng Rng;
+
+    ExtendedChip8(uint64_t t_seed);
+    ExtendedChip8(uint64_t t_seed, const std::string& t_rom);
+
+    void reset();
+    void reset(uint64_t t_seed);
+    void load(const std::string& t_filePath);
+    void load(const uint8_t* t_rom, std::size_t t_size);
+    TickResult run_tick();
+
+    // See BasicChip8, runToInput also stops once the program has exited
+    uint64_t runToInput(uint64_t t_maxTicks);
+    void restore(const ExtendedChip8& t_boot, uint64_t t_seed);
+    void writeState(std::ostream& t_outStream) const;
+    void readState(std::istream& t_inStream);
+
+    // Snapshots as BasicChip8::saveState, with their own magic and layout:
+    //
+    //     magic u32, version u16, generator state size u16, seed u64, memory size u32, V0-VF, PC u16, I u16,
+    //     keys u16, DT, ST, timer counter, SP, hires, halted, plane mask, pitch u8, stack 16 x u16, flag
+    //     registers, audio pattern, display rows plane by plane as 16 byte words, memory, generator state
+    static constexpr std::size_t stateSize = 20 + CHIP8_NUM_V_REG + 14 + 2 * CHIP8_STACK_SIZE + CHIP8_NUM_FLAG_REGS + CHIP8_AUDIO_PATTERN_SIZE
+                                             + PlaneDisplay::size() + TMode::memorySize + TRng::stateSize;
+    std::size_t saveState(uint8_t* t_buffer, std::size_t t_size) const;
+    void loadState(const uint8_t* t_buffer, std::size_t t_size);
+
+    uint64_t stateHash() const;
+
+    void updateKeystate(bool t_pressState, bool t_repeat, const Chip8Key& t_key);
+
+    void setKeystates(uint16_t t_keystates){
+        m_keystates = t_keystates;
+    }
+
+    const PlaneDisplay& getDisplay() const{
+        return m_display;
+    }
+
+    const std::array<uint8_t, CHIP8_NUM_V_REG>& getRegisters() const{
+        return m_vRegs;
+    }
+
+    uint16_t getProgramCounter() const{
+        return m_programCounter;
+    }
+
+    uint16_t getIndexRegister() const{
+        return m_iReg;
+    }
+
+    uint8_t getDelayTimer() const{
+        return m_dtReg;
+    }
+
+    uint8_t getSoundTimer() const{
+        return m_stReg;
+    }
+
+    const std::array<uint8_t, TMode::memorySize>& getMemory() const{
+        return m_memory;
+    }
+
+    uint8_t readMemory(uint32_t t_addr) const{
+        return read(t_addr);
+    }
+
+    void writeMemory(uint32_t t_addr, uint8_t t_value){
+        write(t_addr, t_value);
+    }
+
+    bool hiRes() const{
+        return m_hiRes;
+    }
+
+    // Set once the program executed 00FD, ticks do nothing afterwards
+    bool halted() const{
+        return m_halted;
+    }
+
+    Registers readRegisters() const{
+        return Registers{m_vRegs, m_iReg, m_programCounter, m_stackPointer, m_dtReg, m_stReg};
+    }
+
+    void writeRegisters(const Registers& t_registers){
+        m_vRegs = t_registers.v;
+        m_iReg = t_registers.i;
+        m_programCounter = t_registers.pc;
+        m_stackPointer = t_registers.sp & (CHIP8_STACK_SIZE - 1);
+        m_dtReg = t_registers.dt;
+        m_stReg = t_registers.st;
+    }
+
+    // See BasicChip8::attach
+    void attach(Breakpoints* t_breakpoints){
+        m_breakpoints = t_breakpoints;
+    }
+
+    // See BasicChip8::setTimerPeriod
+    void setTimerPeriod(uint8_t t_ticks){
+        m_timerPeriod = (t_ticks)? t_ticks : 1;
+    }
+
+    // See BasicChip8::getCounters
+    const ExecutionCounters& getCounters() const{
+        return m_counters;
+    }
+
+    void setCounters(const ExecutionCounters& t_counters){
+        m_counters = t_counters;
+    }
+};
+
+extern template class ExtendedChip8<Rng::Mt19937, Modes::SuperChip>;
+extern template class ExtendedChip8<Rng::Mt19937, Modes::XoChip>;
+extern template class ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::SuperChip>>;
+extern template class ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::XoChip>>;
+
+typedef ExtendedChip8<Rng::Mt19937, Modes::SuperChip> SuperChip8;
+typedef ExtendedChip8<Rng::Mt19937, Modes::XoChip> XoChip8;
+typedef ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::SuperChip>> SuperChip8Debug;
+typedef ExtendedChip8<Rng::Mt19937, Quirks::Debug<Modes::XoChip>> XoChip8Debug;
+
+} // namespace Chip8
+
+#endif // CHIP8_EXTENDED_HPP
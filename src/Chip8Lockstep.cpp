@@ -0,0 +1,522 @@
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#include "Chip8Lockstep.hpp"
+#include "Chip8Util.hpp"
+
+// Kernel helpers never leave this file, passing 256 bit vectors without AVX only costs a spill
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace Chip8{
+
+namespace{
+
+typedef uint8_t  U8x16  __attribute__((vector_size(16), may_alias));
+typedef uint8_t  U8x32  __attribute__((vector_size(32), may_alias));
+typedef int8_t   M8x8   __attribute__((vector_size(8),  may_alias));
+typedef int8_t   M8x16  __attribute__((vector_size(16), may_alias));
+typedef int8_t   M8x32  __attribute__((vector_size(32), may_alias));
+typedef uint16_t U16x8  __attribute__((vector_size(16), may_alias));
+typedef uint16_t U16x16 __attribute__((vector_size(32), may_alias));
+typedef int16_t  M16x16 __attribute__((vector_size(32), may_alias));
+typedef uint32_t U32x8  __attribute__((vector_size(32), may_alias));
+typedef int32_t  M32x8  __attribute__((vector_size(32), may_alias));
+
+namespace Avx2{
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#include "Chip8LockstepKernel.inl"
+#pragma GCC pop_options
+} // namespace Avx2
+
+namespace Generic{
+#include "Chip8LockstepKernel.inl"
+} // namespace Generic
+
+const LockstepKernel& selectKernel(){
+    return (Lockstep::hasAvx2())? Avx2::kernel : Generic::kernel;
+}
+
+} // namespace
+
+bool Lockstep::hasAvx2(){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+template<typename T>
+Lockstep::AlignedArray<T> Lockstep::allocLanes(std::size_t t_slots){
+    void* storage = nullptr;
+    if(posix_memalign(&storage, CHIP8_LOCKSTEP_CHUNK, t_slots * sizeof(T))){
+        throw std::bad_alloc();
+    }
+    std::fill(static_cast<T*>(storage), static_cast<T*>(storage) + t_slots, 0);
+    return AlignedArray<T>(static_cast<T*>(storage));
+}
+
+Lockstep::Lockstep(std::size_t t_lanes, const uint8_t* t_rom, std::size_t t_size) : m_kernel(selectKernel()),
+                                                                                      m_numLanes(t_lanes),
+                                                                                      m_hasScripts(false),
+                                                                                      m_written({0}),
+                                                                                      m_budget(UINT32_MAX),
+                                                                                      m_steps(0){
+    std::size_t slots = std::max<std::size_t>(CHIP8_LOCKSTEP_CHUNK, (t_lanes + CHIP8_LOCKSTEP_CHUNK - 1) & ~(CHIP8_LOCKSTEP_CHUNK - 1));
+
+    m_lanes.slots = slots;
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        m_vRegStorage.push_back(allocLanes<uint8_t>(slots));
+        m_lanes.vRegs[reg] = m_vRegStorage.back().get();
+    }
+    m_iReg = allocLanes<uint16_t>(slots);
+    m_programCounter = allocLanes<uint16_t>(slots);
+    m_dtReg = allocLanes<uint8_t>(slots);
+    m_stReg = allocLanes<uint8_t>(slots);
+    m_tCounter = allocLanes<uint8_t>(slots);
+    m_count = allocLanes<uint32_t>(slots);
+    m_order = allocLanes<uint32_t>(slots);
+    m_mask = allocLanes<int8_t>(slots);
+    m_cond = allocLanes<int8_t>(slots);
+    m_chunkActive.assign(slots / CHIP8_LOCKSTEP_CHUNK, 0);
+
+    m_lanes.iReg = m_iReg.get();
+    m_lanes.programCounter = m_programCounter.get();
+    m_lanes.dtReg = m_dtReg.get();
+    m_lanes.stReg = m_stReg.get();
+    m_lanes.tCounter = m_tCounter.get();
+    m_lanes.count = m_count.get();
+    m_lanes.order = m_order.get();
+    m_lanes.mask = m_mask.get();
+    m_lanes.cond = m_cond.get();
+    m_lanes.chunkActive = m_chunkActive.data();
+
+    m_laneOfSlot.resize(slots);
+    m_slotOfLane.resize(slots);
+    std::iota(m_laneOfSlot.begin(), m_laneOfSlot.end(), 0);
+    std::iota(m_slotOfLane.begin(), m_slotOfLane.end(), 0);
+
+    // Same boot image the interpreter builds, shared by every lane until a lane writes to it
+    m_image = PagedMemory::makeImage(t_rom, t_size);
+
+    m_memory.resize(slots);
+    m_disp.resize(slots);
+    m_stack.resize(slots);
+    m_stackPointer.resize(slots);
+    m_keystates.resize(slots);
+    m_generator.resize(slots);
+    m_seeds.resize(slots);
+    m_scripts.assign(slots, nullptr);
+    m_scriptPosition.assign(slots, 0);
+    m_faults.resize(slots);
+
+    for(std::size_t lane = 0; lane < slots; ++lane){
+        reset(lane, lane);
+        if(lane >= m_numLanes){
+            // Padding slots never run
+            m_order[m_slotOfLane[lane]] = UINT32_MAX;
+        }
+    }
+}
+
+void Lockstep::reset(std::size_t t_lane, uint64_t t_seed){
+    std::size_t slot = m_slotOfLane[t_lane];
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        m_lanes.vRegs[reg][slot] = 0;
+    }
+    m_iReg[slot] = 0;
+    m_programCounter[slot] = CHIP8_PROG_START_OFFSET;
+    m_dtReg[slot] = 0;
+    m_stReg[slot] = 0;
+    m_tCounter[slot] = 0;
+    m_count[slot] = 0;
+    m_order[slot] = 0;
+
+    m_memory[t_lane].reset(m_image);
+    m_disp[t_lane].fill(0);
+    m_stack[t_lane].fill(0);
+    m_stackPointer[t_lane] = 0xf;
+    m_keystates[t_lane] = 0;
+    m_generator[t_lane] = Rng::Mt19937(t_seed);
+    m_seeds[t_lane] = t_seed;
+    m_scriptPosition[t_lane] = 0;
+    m_faults[t_lane].clear();
+}
+
+void Lockstep::setInputScript(std::size_t t_lane, const InputScript* t_script){
+    m_scripts[t_lane] = t_script;
+    m_scriptPosition[t_lane] = 0;
+    m_hasScripts = m_hasScripts || t_script;
+}
+
+void Lockstep::updateKeystate(std::size_t t_lane, bool t_pressState, const Chip8Key& t_key){
+    if(t_key != KEY_NULL)
+        m_keystates[t_lane] = (m_keystates[t_lane] & ~(0x1 << t_key)) | (t_pressState << t_key & (0x1 << t_key));
+}
+
+uint32_t Lockstep::instructions(std::size_t t_lane) const{
+    return m_count[m_slotOfLane[t_lane]];
+}
+
+bool Lockstep::faulted(std::size_t t_lane) const{
+    return !m_faults[t_lane].empty();
+}
+
+const std::string& Lockstep::faultMessage(std::size_t t_lane) const{
+    return m_faults[t_lane];
+}
+
+// Same byte order as Chip8::stateHash so lanes can be checked against the reference interpreter
+uint64_t Lockstep::stateHash(std::size_t t_lane) const{
+    std::size_t slot = m_slotOfLane[t_lane];
+    const uint8_t regs[] = {static_cast<uint8_t>(m_iReg[slot] >> 8), static_cast<uint8_t>(m_iReg[slot]),
+                            static_cast<uint8_t>(m_programCounter[slot] >> 8), static_cast<uint8_t>(m_programCounter[slot]),
+                            m_dtReg[slot], m_stReg[slot], m_stackPointer[t_lane], m_tCounter[slot]};
+    uint64_t hash = Util::fnv1a(regs, sizeof(regs));
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        hash = Util::fnv1a(m_lanes.vRegs[reg] + slot, 1, hash);
+    }
+    for(uint16_t entry : m_stack[t_lane]){
+        const uint8_t bytes[] = {static_cast<uint8_t>(entry >> 8), static_cast<uint8_t>(entry)};
+        hash = Util::fnv1a(bytes, sizeof(bytes), hash);
+    }
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        hash = Util::fnv1a(m_memory[t_lane].page(page), CHIP8_PAGE_SIZE, hash);
+    }
+    return Util::fnv1a(m_disp[t_lane].data(), m_disp[t_lane].size(), hash);
+}
+
+std::size_t Lockstep::saveState(std::size_t t_lane, uint8_t* t_buffer, std::size_t t_size) const{
+    if(t_size < Chip8::stateSize){
+        throw std::string("Lockstep: state buffer too small");
+    }
+
+    std::size_t slot = m_slotOfLane[t_lane];
+    uint8_t* out = t_buffer;
+    Util::putLE<uint32_t>(out, CHIP8_STATE_MAGIC);
+    Util::putLE<uint16_t>(out, CHIP8_STATE_VERSION);
+    Util::putLE<uint16_t>(out, Rng::Mt19937::stateSize);
+    Util::putLE(out, m_seeds[t_lane]);
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        *out++ = m_lanes.vRegs[reg][slot];
+    }
+    Util::putLE(out, m_programCounter[slot]);
+    Util::putLE(out, m_iReg[slot]);
+    Util::putLE(out, m_keystates[t_lane]);
+    Util::putLE(out, m_dtReg[slot]);
+    Util::putLE(out, m_stReg[slot]);
+    Util::putLE(out, m_tCounter[slot]);
+    Util::putLE(out, m_stackPointer[t_lane]);
+    for(uint16_t entry : m_stack[t_lane]){
+        Util::putLE(out, entry);
+    }
+    out = std::copy(m_disp[t_lane].begin(), m_disp[t_lane].end(), out);
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        out = std::copy(m_memory[t_lane].page(page), m_memory[t_lane].page(page) + CHIP8_PAGE_SIZE, out);
+    }
+    m_generator[t_lane].saveState(out);
+    return Chip8::stateSize;
+}
+
+void Lockstep::markWritten(uint16_t t_addr){
+    m_written[t_addr >> 6] |= uint64_t(1) << (t_addr & 0x3f);
+}
+
+void Lockstep::fault(std::size_t t_slot, uint16_t t_pc, uint16_t t_op){
+    std::stringstream err_msg_stream;
+    err_msg_stream << "Chip8: Unknown opcode <0x" << std::hex << std::setfill('0') << std::setw(4) << t_op << "> at address <0x" << std::hex << std::setfill('0') << std::setw(4) << t_pc << ">.";
+    m_faults[m_laneOfSlot[t_slot]] = err_msg_stream.str();
+    m_order[t_slot] = UINT32_MAX;
+    m_mask[t_slot] = 0;
+}
+
+template<typename TFunc>
+void Lockstep::forEachSelected(TFunc t_func){
+    for(std::size_t chunk = 0; chunk < m_chunkActive.size(); ++chunk){
+        if(!m_chunkActive[chunk]){
+            continue;
+        }
+        for(std::size_t slot = chunk * CHIP8_LOCKSTEP_CHUNK; slot < (chunk + 1) * CHIP8_LOCKSTEP_CHUNK; ++slot){
+            if(m_mask[slot]){
+                t_func(slot, m_laneOfSlot[slot]);
+            }
+        }
+    }
+}
+
+void Lockstep::execute(uint16_t t_pc, uint16_t t_op){
+    uint8_t x = (t_op >> 8) & 0x0f, y = (t_op >> 4) & 0x0f, kk = t_op & 0x00ff, nib = t_op & 0x000f;
+    uint16_t nnn = t_op & 0x0fff;
+    bool known = true;
+
+    switch(t_op & 0xf000){
+        case 0x0000:
+            if(nnn == 0x0e0){
+                // CLS
+                forEachSelected([this](std::size_t t_slot, std::size_t t_lane){
+                    m_disp[t_lane].fill(0);
+                });
+                m_kernel.advance(m_lanes);
+            }
+            else if(nnn == 0x0ee){
+                // RET
+                forEachSelected([this](std::size_t t_slot, std::size_t t_lane){
+                    m_stackPointer[t_lane] = (m_stackPointer[t_lane] + 1) & 0xf;
+                    m_programCounter[t_slot] = m_stack[t_lane][m_stackPointer[t_lane]] + 2;
+                });
+            }
+            else{
+                known = false;
+            }
+            break;
+        case 0x1000:
+            m_kernel.jump(m_lanes, nnn);
+            break;
+        case 0x2000:
+            // CALL
+            forEachSelected([this, nnn](std::size_t t_slot, std::size_t t_lane){
+                m_stack[t_lane][m_stackPointer[t_lane]] = m_programCounter[t_slot];
+                m_stackPointer[t_lane] = (m_stackPointer[t_lane] - 1) & 0xf;
+                m_programCounter[t_slot] = nnn;
+            });
+            break;
+        case 0x3000:
+            m_kernel.skipImm(m_lanes, x, kk, true);
+            break;
+        case 0x4000:
+            m_kernel.skipImm(m_lanes, x, kk, false);
+            break;
+        case 0x5000:
+            m_kernel.skipReg(m_lanes, x, y, true);
+            break;
+        case 0x6000:
+            m_kernel.ldImm(m_lanes, x, kk);
+            m_kernel.advance(m_lanes);
+            break;
+        case 0x7000:
+            m_kernel.addImm(m_lanes, x, kk);
+            m_kernel.advance(m_lanes);
+            break;
+        case 0x8000:
+            known = m_kernel.alu(m_lanes, x, y, nib);
+            if(known){
+                m_kernel.advance(m_lanes);
+            }
+            break;
+        case 0x9000:
+            m_kernel.skipReg(m_lanes, x, y, false);
+            break;
+        case 0xa000:
+            m_kernel.ldI(m_lanes, nnn);
+            m_kernel.advance(m_lanes);
+            break;
+        case 0xb000:
+            m_kernel.jumpReg(m_lanes, nnn);
+            break;
+        case 0xc000:
+            // RND
+            forEachSelected([this, x, kk](std::size_t t_slot, std::size_t t_lane){
+                m_lanes.vRegs[x][t_slot] = m_generator[t_lane].next() & kk;
+            });
+            m_kernel.advance(m_lanes);
+            break;
+        case 0xd000:
+            // DRW
+            forEachSelected([this, x, y, nib](std::size_t t_slot, std::size_t t_lane){
+                uint8_t vx = m_lanes.vRegs[x][t_slot], vy = m_lanes.vRegs[y][t_slot];
+                uint8_t flag = 0x00;
+                for(uint8_t spriteLine = 0; spriteLine < nib; ++spriteLine){
+                    uint8_t spriteByte = m_memory[t_lane].read(m_iReg[t_slot] + spriteLine);
+                    uint8_t dispX = (vx >> 3) & ((CHIP8_DISP_X >> 3) - 1), dispY = (vy + spriteLine) & (CHIP8_DISP_Y - 1);
+                    uint8_t& left = m_disp[t_lane][dispX + dispY * (CHIP8_DISP_X >> 3)];
+                    flag |= (left & (spriteByte >> (vx & 0x07)))? 0x01 : 0x00;
+                    left ^= (spriteByte >> (vx & 0x07));
+                    if(vx & 0x7){
+                        uint8_t& right = m_disp[t_lane][((dispX + 1) & ((CHIP8_DISP_X >> 3) - 1)) + dispY * (CHIP8_DISP_X >> 3)];
+                        flag |= (right & (spriteByte << (8 - (vx & 0x07))))? 0x01 : 0x00;
+                        right ^= (spriteByte << (8 - (vx & 0x07)));
+                    }
+                }
+                m_lanes.vRegs[0xf][t_slot] = flag;
+            });
+            m_kernel.advance(m_lanes);
+            break;
+        case 0xe000:
+            if(kk == 0x9e || kk == 0xa1){
+                // SKP / SKNP
+                bool pressed = (kk == 0x9e);
+                forEachSelected([this, x, pressed](std::size_t t_slot, std::size_t t_lane){
+                    uint8_t key = m_lanes.vRegs[x][t_slot];
+                    m_cond[t_slot] = (key < 0x10 && ((m_keystates[t_lane] >> key) & 0x01) == pressed)? -1 : 0;
+                });
+                m_kernel.skip(m_lanes);
+            }
+            else{
+                known = false;
+            }
+            break;
+        case 0xf000:
+            switch(kk){
+                case 0x07:
+                    m_kernel.ldVxDt(m_lanes, x);
+                    break;
+                case 0x0a:
+                    // LD VX, KP, only lanes with a key down move on
+                    forEachSelected([this, x](std::size_t t_slot, std::size_t t_lane){
+                        if(m_keystates[t_lane]){
+                            m_lanes.vRegs[x][t_slot] = __builtin_ctz(m_keystates[t_lane]);
+                            m_programCounter[t_slot] += 2;
+                        }
+                    });
+                    return;
+                case 0x15:
+                    m_kernel.ldDt(m_lanes, x);
+                    break;
+                case 0x18:
+                    m_kernel.ldSt(m_lanes, x);
+                    break;
+                case 0x1e:
+                    m_kernel.addI(m_lanes, x);
+                    break;
+                case 0x29:
+                    m_kernel.spriteI(m_lanes, x);
+                    break;
+                case 0x33:
+                    // LD BCD
+                    forEachSelected([this, x](std::size_t t_slot, std::size_t t_lane){
+                        uint8_t value = m_lanes.vRegs[x][t_slot];
+                        for(uint16_t digit = 0; digit < 3; ++digit){
+                            uint16_t addr = (m_iReg[t_slot] + digit) & (CHIP8_MAIN_MEM_SIZE - 1);
+                            m_memory[t_lane].write(addr, (digit == 0)? value / 100 : (digit == 1)? (value % 100) / 10 : value % 10);
+                            markWritten(addr);
+                        }
+                    });
+                    break;
+                case 0x55:
+                    // LD [I], VX
+                    forEachSelected([this, x](std::size_t t_slot, std::size_t t_lane){
+                        for(uint8_t reg = 0; reg <= x; ++reg){
+                            uint16_t addr = (m_iReg[t_slot] + reg) & (CHIP8_MAIN_MEM_SIZE - 1);
+                            m_memory[t_lane].write(addr, m_lanes.vRegs[reg][t_slot]);
+                            markWritten(addr);
+                        }
+                    });
+                    break;
+                case 0x65:
+                    // LD VX, [I]
+                    forEachSelected([this, x](std::size_t t_slot, std::size_t t_lane){
+                        for(uint8_t reg = 0; reg <= x; ++reg){
+                            m_lanes.vRegs[reg][t_slot] = m_memory[t_lane].read(m_iReg[t_slot] + reg);
+                        }
+                    });
+                    break;
+                default:
+                    known = false;
+            }
+            if(known){
+                m_kernel.advance(m_lanes);
+            }
+            break;
+    }
+
+    if(!known){
+        forEachSelected([this, t_pc, t_op](std::size_t t_slot, std::size_t t_lane){
+            fault(t_slot, t_pc, t_op);
+        });
+    }
+}
+
+bool Lockstep::step(){
+    if(m_steps && !(m_steps % CHIP8_LOCKSTEP_REGROUP_PERIOD)){
+        regroup();
+    }
+
+    long leader = m_kernel.leader(m_lanes, CHIP8_LOCKSTEP_MAX_SKEW);
+    if(leader < 0){
+        return false;
+    }
+    uint16_t pc = m_programCounter[leader];
+    const PagedMemory& code = m_memory[m_laneOfSlot[leader]];
+    uint16_t op = (pc < CHIP8_MAIN_MEM_SIZE - 1)? (code.read(pc) << 8) | code.read(pc + 1) : 0x0000;
+
+    m_kernel.select(m_lanes, pc);
+
+    // Lanes that rewrote the instruction at pc run it on their own turn
+    if(pc < CHIP8_MAIN_MEM_SIZE - 1 && ((m_written[pc >> 6] >> (pc & 0x3f)) & 1 || (m_written[(pc + 1) >> 6] >> ((pc + 1) & 0x3f)) & 1)){
+        forEachSelected([this, pc, op](std::size_t t_slot, std::size_t t_lane){
+            if(((m_memory[t_lane].read(pc) << 8) | m_memory[t_lane].read(pc + 1)) != op){
+                m_mask[t_slot] = 0;
+            }
+        });
+    }
+
+    if(m_hasScripts){
+        forEachSelected([this](std::size_t t_slot, std::size_t t_lane){
+            if(m_scripts[t_lane]){
+                const std::vector<InputScript::Event>& events = m_scripts[t_lane]->events();
+                std::size_t& position = m_scriptPosition[t_lane];
+                while(position < events.size() && events[position].cycle <= m_count[t_slot]){
+                    updateKeystate(t_lane, events[position].pressed, events[position].key);
+                    ++position;
+                }
+            }
+        });
+    }
+
+    m_kernel.tickTimers(m_lanes);
+    execute(pc, op);
+    m_kernel.retire(m_lanes, m_budget);
+    ++m_steps;
+    return true;
+}
+
+uint64_t Lockstep::run(uint32_t t_budget){
+    m_budget = t_budget;
+    for(std::size_t slot = 0; slot < m_lanes.slots; ++slot){
+        std::size_t lane = m_laneOfSlot[slot];
+        m_order[slot] = (lane >= m_numLanes || !m_faults[lane].empty() || m_count[slot] >= t_budget)? UINT32_MAX : m_count[slot];
+    }
+
+    while(step());
+
+    uint64_t total = 0;
+    for(std::size_t lane = 0; lane < m_numLanes; ++lane){
+        total += m_count[m_slotOfLane[lane]];
+    }
+    return total;
+}
+
+void Lockstep::regroup(){
+    // Stable sort of slots by PC, finished lanes last, so each PC group fills as few chunks as possible
+    std::vector<std::size_t> order(m_lanes.slots);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t t_lhs, std::size_t t_rhs){
+        uint32_t lhs = (m_order[t_lhs] == UINT32_MAX)? 0x10000 : m_programCounter[t_lhs];
+        uint32_t rhs = (m_order[t_rhs] == UINT32_MAX)? 0x10000 : m_programCounter[t_rhs];
+        return lhs < rhs;
+    });
+
+    auto permute = [this, &order](auto* t_row){
+        std::vector<typename std::remove_pointer<decltype(t_row)>::type> scratch(t_row, t_row + m_lanes.slots);
+        for(std::size_t slot = 0; slot < m_lanes.slots; ++slot){
+            t_row[slot] = scratch[order[slot]];
+        }
+    };
+    for(std::size_t reg = 0; reg < CHIP8_NUM_V_REG; ++reg){
+        permute(m_lanes.vRegs[reg]);
+    }
+    permute(m_lanes.iReg);
+    permute(m_lanes.programCounter);
+    permute(m_lanes.dtReg);
+    permute(m_lanes.stReg);
+    permute(m_lanes.tCounter);
+    permute(m_lanes.count);
+    permute(m_lanes.order);
+    permute(m_laneOfSlot.data());
+
+    for(std::size_t slot = 0; slot < m_lanes.slots; ++slot){
+        m_slotOfLane[m_laneOfSlot[slot]] = slot;
+    }
+}
+
+} // namespace Chip8
@@ -0,0 +1,162 @@
+#ifndef CHIP8_LOCKSTEP_HPP
+#define CHIP8_LOCKSTEP_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Chip8.hpp"
+#include "InputScript.hpp"
+
+// Lanes handled per vector chunk, the widest register file row (uint8_t) fills one 256 bit vector
+#define CHIP8_LOCKSTEP_CHUNK          32
+#define CHIP8_LOCKSTEP_MAX_SKEW       256
+#define CHIP8_LOCKSTEP_REGROUP_PERIOD 4096
+
+namespace Chip8{
+
+// Structure of arrays view of the vectorized lane state, one entry per lane slot
+struct LockstepLanes{
+    std::size_t slots;
+    uint8_t* vRegs[CHIP8_NUM_V_REG];
+    uint16_t* iReg;
+    uint16_t* programCounter;
+    uint8_t* dtReg;
+    uint8_t* stReg;
+    uint8_t* tCounter;
+    uint32_t* count;
+    uint32_t* order;
+    int8_t* mask;
+    int8_t* cond;
+    uint8_t* chunkActive;
+};
+
+// Vector kernels, built once for AVX2 and once for the baseline ISA and selected at run time
+struct LockstepKernel{
+    long (*leader)(const LockstepLanes& t_lanes, uint32_t t_maxSkew);
+    std::size_t (*select)(const LockstepLanes& t_lanes, uint16_t t_pc);
+    void (*retire)(const LockstepLanes& t_lanes, uint32_t t_budget);
+    void (*tickTimers)(const LockstepLanes& t_lanes);
+    void (*advance)(const LockstepLanes& t_lanes);
+    void (*skip)(const LockstepLanes& t_lanes);
+    void (*skipImm)(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk, bool t_equal);
+    void (*skipReg)(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_y, bool t_equal);
+    void (*jump)(const LockstepLanes& t_lanes, uint16_t t_nnn);
+    void (*jumpReg)(const LockstepLanes& t_lanes, uint16_t t_nnn);
+    void (*ldImm)(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk);
+    void (*addImm)(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk);
+    bool (*alu)(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_y, uint8_t t_nib);
+    void (*ldI)(const LockstepLanes& t_lanes, uint16_t t_nnn);
+    void (*addI)(const LockstepLanes& t_lanes, uint8_t t_x);
+    void (*spriteI)(const LockstepLanes& t_lanes, uint8_t t_x);
+    void (*ldVxDt)(const LockstepLanes& t_lanes, uint8_t t_x);
+    void (*ldDt)(const LockstepLanes& t_lanes, uint8_t t_x);
+    void (*ldSt)(const LockstepLanes& t_lanes, uint8_t t_x);
+};
+
+// Runs many instances of one rom in lockstep. Registers, I, PC and timers are stored as lanes so one
+// decoded instruction is applied to every lane sitting at the same PC with masked vector operations.
+// Lanes are scheduled lowest PC first so diverged lanes reconverge, a lane that falls more than
+// CHIP8_LOCKSTEP_MAX_SKEW instructions behind is scheduled first, and every
+// CHIP8_LOCKSTEP_REGROUP_PERIOD steps lanes are sorted by PC so groups occupy as few chunks as possible.
+// Results match the Chip8 interpreter bit for bit, Chip8 stays the reference.
+class Lockstep{
+
+private:
+    template<typename T>
+    struct AlignedDeleter{
+        void operator()(T* t_ptr) const{
+            free(t_ptr);
+        }
+    };
+
+    template<typename T>
+    using AlignedArray = std::unique_ptr<T[], AlignedDeleter<T>>;
+
+    template<typename T>
+    static AlignedArray<T> allocLanes(std::size_t t_slots);
+
+    const LockstepKernel& m_kernel;
+    std::size_t m_numLanes;
+    LockstepLanes m_lanes;
+
+    std::vector<AlignedArray<uint8_t>> m_vRegStorage;
+    AlignedArray<uint16_t> m_iReg;
+    AlignedArray<uint16_t> m_programCounter;
+    AlignedArray<uint8_t> m_dtReg;
+    AlignedArray<uint8_t> m_stReg;
+    AlignedArray<uint8_t> m_tCounter;
+    AlignedArray<uint32_t> m_count;
+    AlignedArray<uint32_t> m_order;
+    AlignedArray<int8_t> m_mask;
+    AlignedArray<int8_t> m_cond;
+    std::vector<uint8_t> m_chunkActive;
+
+    // Slot <-> lane mapping, slots get permuted by regroup() lanes keep their index
+    std::vector<std::size_t> m_laneOfSlot;
+    std::vector<std::size_t> m_slotOfLane;
+
+    // Per lane state only touched by scalar code
+    std::shared_ptr<const MemoryImage> m_image;
+    std::vector<PagedMemory> m_memory;
+    std::vector<std::array<uint8_t, CHIP8_DISP_SIZE>> m_disp;
+    std::vector<std::array<uint16_t, CHIP8_STACK_SIZE>> m_stack;
+    std::vector<uint8_t> m_stackPointer;
+    std::vector<uint16_t> m_keystates;
+    std::vector<Rng::Mt19937> m_generator;
+    std::vector<uint64_t> m_seeds;
+    std::vector<const InputScript*> m_scripts;
+    std::vector<std::size_t> m_scriptPosition;
+    std::vector<std::string> m_faults;
+    bool m_hasScripts;
+
+    // Addresses written by any lane, code at an unwritten address is identical in every lane
+    std::array<uint64_t, CHIP8_MAIN_MEM_SIZE / 64> m_written;
+
+    uint32_t m_budget;
+    uint64_t m_steps;
+
+    void markWritten(uint16_t t_addr);
+    void fault(std::size_t t_slot, uint16_t t_pc, uint16_t t_op);
+    void execute(uint16_t t_pc, uint16_t t_op);
+
+    template<typename TFunc>
+    void forEachSelected(TFunc t_func);
+
+public:
+    Lockstep(std::size_t t_lanes, const uint8_t* t_rom, std::size_t t_size);
+
+    void reset(std::size_t t_lane, uint64_t t_seed);
+    void setInputScript(std::size_t t_lane, const InputScript* t_script);
+    void updateKeystate(std::size_t t_lane, bool t_pressState, const Chip8Key& t_key);
+
+    bool step();
+    uint64_t run(uint32_t t_budget);
+    void regroup();
+
+    std::size_t lanes() const{
+        return m_numLanes;
+    }
+
+    uint64_t steps() const{
+        return m_steps;
+    }
+
+    uint32_t instructions(std::size_t t_lane) const;
+    bool faulted(std::size_t t_lane) const;
+    const std::string& faultMessage(std::size_t t_lane) const;
+    uint64_t stateHash(std::size_t t_lane) const;
+    // Snapshot of a lane in the layout of Chip8::saveState, Chip8::stateSize bytes, for checking lanes
+    // against the interpreter field by field
+    std::size_t saveState(std::size_t t_lane, uint8_t* t_buffer, std::size_t t_size) const;
+
+    static bool hasAvx2();
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_LOCKSTEP_HPP
@@ -0,0 +1,333 @@
+// Vector kernels for Chip8::Lockstep. This file is included twice by Chip8Lockstep.cpp, once inside
+// a '#pragma GCC target("avx2")' region and once for the baseline ISA, so it must not include anything
+// and must only use the lane vector types declared there. Every kernel only touches chunks marked
+// active by select() and only modifies lanes whose mask byte is set.
+
+static inline M8x8 laneMask8(const LockstepLanes& t_lanes, std::size_t t_slot){
+    return *reinterpret_cast<const M8x8*>(t_lanes.mask + t_slot);
+}
+
+static inline M16x16 laneMask16(const LockstepLanes& t_lanes, std::size_t t_slot){
+    return __builtin_convertvector(*reinterpret_cast<const M8x16*>(t_lanes.mask + t_slot), M16x16);
+}
+
+static inline M8x32 laneMask32(const LockstepLanes& t_lanes, std::size_t t_slot){
+    return *reinterpret_cast<const M8x32*>(t_lanes.mask + t_slot);
+}
+
+static inline U8x32& row8(uint8_t* t_row, std::size_t t_slot){
+    return *reinterpret_cast<U8x32*>(t_row + t_slot);
+}
+
+static inline U16x16& row16(uint16_t* t_row, std::size_t t_slot){
+    return *reinterpret_cast<U16x16*>(t_row + t_slot);
+}
+
+static inline U32x8& row32(uint32_t* t_row, std::size_t t_slot){
+    return *reinterpret_cast<U32x8*>(t_row + t_slot);
+}
+
+static inline U16x16 widen8(const uint8_t* t_row, std::size_t t_slot){
+    return __builtin_convertvector(*reinterpret_cast<const U8x16*>(t_row + t_slot), U16x16);
+}
+
+static long leader(const LockstepLanes& t_lanes, uint32_t t_maxSkew){
+    U32x8 minCount = ~U32x8{};
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += 8){
+        U32x8 order = row32(t_lanes.order, slot);
+        minCount = (order < minCount)? order : minCount;
+    }
+    uint32_t lowest = UINT32_MAX;
+    for(int i = 0; i < 8; ++i){
+        lowest = (minCount[i] < lowest)? minCount[i] : lowest;
+    }
+    if(lowest == UINT32_MAX){
+        return -1;
+    }
+
+    // Lowest PC first lets lanes that took a longer path catch up with the rest of their group
+    U32x8 minPc = ~U32x8{};
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += 8){
+        U32x8 pc = __builtin_convertvector(*reinterpret_cast<const U16x8*>(t_lanes.programCounter + slot), U32x8);
+        pc = (row32(t_lanes.order, slot) != UINT32_MAX)? pc : ~U32x8{};
+        minPc = (pc < minPc)? pc : minPc;
+    }
+    uint32_t lowestPc = UINT32_MAX;
+    for(int i = 0; i < 8; ++i){
+        lowestPc = (minPc[i] < lowestPc)? minPc[i] : lowestPc;
+    }
+
+    long slot = 0;
+    while(t_lanes.order[slot] == UINT32_MAX || t_lanes.programCounter[slot] != lowestPc){
+        ++slot;
+    }
+    if(t_lanes.order[slot] - lowest > t_maxSkew){
+        // Never starve lanes stuck in a loop at a higher PC
+        slot = 0;
+        while(t_lanes.order[slot] != lowest){
+            ++slot;
+        }
+    }
+    return slot;
+}
+
+static std::size_t select(const LockstepLanes& t_lanes, uint16_t t_pc){
+    std::size_t selected = 0;
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            M16x16 atPc = row16(t_lanes.programCounter, half) == t_pc;
+            *reinterpret_cast<M8x16*>(t_lanes.mask + half) = __builtin_convertvector(atPc, M8x16);
+        }
+        for(std::size_t quarter = slot; quarter < slot + CHIP8_LOCKSTEP_CHUNK; quarter += 8){
+            M32x8 runnable = row32(t_lanes.order, quarter) != UINT32_MAX;
+            *reinterpret_cast<M8x8*>(t_lanes.mask + quarter) = laneMask8(t_lanes, quarter) & __builtin_convertvector(runnable, M8x8);
+        }
+
+        std::size_t chunkLanes = 0;
+        for(std::size_t lane = slot; lane < slot + CHIP8_LOCKSTEP_CHUNK; lane += 8){
+            uint64_t bits;
+            __builtin_memcpy(&bits, t_lanes.mask + lane, sizeof(bits));
+            chunkLanes += __builtin_popcountll(bits) / 8;
+        }
+        t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK] = (chunkLanes != 0);
+        selected += chunkLanes;
+    }
+    return selected;
+}
+
+static void retire(const LockstepLanes& t_lanes, uint32_t t_budget){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t quarter = slot; quarter < slot + CHIP8_LOCKSTEP_CHUNK; quarter += 8){
+            M32x8 mask = __builtin_convertvector(laneMask8(t_lanes, quarter), M32x8);
+            U32x8 count = row32(t_lanes.count, quarter) + 1;
+            row32(t_lanes.count, quarter) = (mask)? count : row32(t_lanes.count, quarter);
+            U32x8 order = (count >= t_budget)? ~U32x8{} : count;
+            row32(t_lanes.order, quarter) = (mask)? order : row32(t_lanes.order, quarter);
+        }
+    }
+}
+
+static void tickTimers(const LockstepLanes& t_lanes){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        M8x32 mask = laneMask32(t_lanes, slot);
+        U8x32 tCounter = row8(t_lanes.tCounter, slot) + 1;
+        M8x32 wrap = mask & (tCounter >= 10);
+        row8(t_lanes.tCounter, slot) = (mask)? ((wrap)? U8x32{} : tCounter) : row8(t_lanes.tCounter, slot);
+        U8x32 dt = row8(t_lanes.dtReg, slot);
+        row8(t_lanes.dtReg, slot) = (wrap & (dt != 0))? dt - 1 : dt;
+        U8x32 st = row8(t_lanes.stReg, slot);
+        row8(t_lanes.stReg, slot) = (wrap & (st != 0))? st - 1 : st;
+    }
+}
+
+static void advance(const LockstepLanes& t_lanes){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 pc = row16(t_lanes.programCounter, half);
+            row16(t_lanes.programCounter, half) = (laneMask16(t_lanes, half))? pc + 2 : pc;
+        }
+    }
+}
+
+static inline void skipChunk(const LockstepLanes& t_lanes, std::size_t t_slot){
+    for(std::size_t half = t_slot; half < t_slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+        U16x16 cond = __builtin_convertvector(*reinterpret_cast<const M8x16*>(t_lanes.cond + half), U16x16);
+        U16x16 pc = row16(t_lanes.programCounter, half);
+        row16(t_lanes.programCounter, half) = (laneMask16(t_lanes, half))? pc + 2 + (cond & 2) : pc;
+    }
+}
+
+static void skip(const LockstepLanes& t_lanes){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            skipChunk(t_lanes, slot);
+        }
+    }
+}
+
+static void skipImm(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk, bool t_equal){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        M8x32 equal = row8(t_lanes.vRegs[t_x], slot) == t_kk;
+        *reinterpret_cast<M8x32*>(t_lanes.cond + slot) = (t_equal)? equal : ~equal;
+        skipChunk(t_lanes, slot);
+    }
+}
+
+static void skipReg(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_y, bool t_equal){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        M8x32 equal = row8(t_lanes.vRegs[t_x], slot) == row8(t_lanes.vRegs[t_y], slot);
+        *reinterpret_cast<M8x32*>(t_lanes.cond + slot) = (t_equal)? equal : ~equal;
+        skipChunk(t_lanes, slot);
+    }
+}
+
+static void jump(const LockstepLanes& t_lanes, uint16_t t_nnn){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 pc = row16(t_lanes.programCounter, half);
+            row16(t_lanes.programCounter, half) = (laneMask16(t_lanes, half))? U16x16{} + t_nnn : pc;
+        }
+    }
+}
+
+static void jumpReg(const LockstepLanes& t_lanes, uint16_t t_nnn){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 pc = row16(t_lanes.programCounter, half);
+            row16(t_lanes.programCounter, half) = (laneMask16(t_lanes, half))? widen8(t_lanes.vRegs[0], half) + static_cast<uint16_t>(t_nnn + 2) : pc;
+        }
+    }
+}
+
+static void ldImm(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            U8x32 vx = row8(t_lanes.vRegs[t_x], slot);
+            row8(t_lanes.vRegs[t_x], slot) = (laneMask32(t_lanes, slot))? U8x32{} + t_kk : vx;
+        }
+    }
+}
+
+static void addImm(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_kk){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            U8x32 vx = row8(t_lanes.vRegs[t_x], slot);
+            row8(t_lanes.vRegs[t_x], slot) = (laneMask32(t_lanes, slot))? vx + t_kk : vx;
+        }
+    }
+}
+
+// 8xy_ instructions, the flag is written before the result exactly like the interpreter so x or y == 0xf
+// behave the same. Returns false for an unknown instruction.
+static bool alu(const LockstepLanes& t_lanes, uint8_t t_x, uint8_t t_y, uint8_t t_nib){
+    if(t_nib > 7 && t_nib != 0xe){
+        return false;
+    }
+    uint8_t* vx = t_lanes.vRegs[t_x];
+    uint8_t* vy = t_lanes.vRegs[t_y];
+    uint8_t* vf = t_lanes.vRegs[0xf];
+    const U8x32 one = U8x32{} + 1;
+
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        M8x32 mask = laneMask32(t_lanes, slot);
+        U8x32 x = row8(vx, slot), y = row8(vy, slot), flag = row8(vf, slot), res = x;
+        switch(t_nib){
+            case 0x0: res = y; break;
+            case 0x1: res = x | y; break;
+            case 0x2: res = x & y; break;
+            case 0x3: res = x ^ y; break;
+            case 0x4: flag = (x > (0xff - y))? one : U8x32{}; break;
+            case 0x5: flag = (x > y)? one : U8x32{}; break;
+            case 0x6: flag = x & 1; break;
+            case 0x7: flag = (y > x)? one : U8x32{}; break;
+            case 0xe: flag = x >> 7; break;
+        }
+        if(t_nib < 4){
+            row8(vx, slot) = (mask)? res : x;
+            continue;
+        }
+
+        row8(vf, slot) = (mask)? flag : row8(vf, slot);
+        x = row8(vx, slot);
+        y = row8(vy, slot);
+        switch(t_nib){
+            case 0x4: res = x + y; break;
+            case 0x5: res = x - y; break;
+            case 0x6: res = x >> 1; break;
+            case 0x7: res = y - x; break;
+            case 0xe: res = x << 1; break;
+        }
+        row8(vx, slot) = (mask)? res : x;
+    }
+    return true;
+}
+
+static void ldI(const LockstepLanes& t_lanes, uint16_t t_nnn){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 iReg = row16(t_lanes.iReg, half);
+            row16(t_lanes.iReg, half) = (laneMask16(t_lanes, half))? U16x16{} + static_cast<uint16_t>(t_nnn & 0x0fff) : iReg;
+        }
+    }
+}
+
+static void addI(const LockstepLanes& t_lanes, uint8_t t_x){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 iReg = row16(t_lanes.iReg, half);
+            row16(t_lanes.iReg, half) = (laneMask16(t_lanes, half))? iReg + widen8(t_lanes.vRegs[t_x], half) : iReg;
+        }
+    }
+}
+
+static void spriteI(const LockstepLanes& t_lanes, uint8_t t_x){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(!t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            continue;
+        }
+        for(std::size_t half = slot; half < slot + CHIP8_LOCKSTEP_CHUNK; half += 16){
+            U16x16 iReg = row16(t_lanes.iReg, half);
+            row16(t_lanes.iReg, half) = (laneMask16(t_lanes, half))? widen8(t_lanes.vRegs[t_x], half) * 5 : iReg;
+        }
+    }
+}
+
+static void ldVxDt(const LockstepLanes& t_lanes, uint8_t t_x){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            U8x32 vx = row8(t_lanes.vRegs[t_x], slot);
+            row8(t_lanes.vRegs[t_x], slot) = (laneMask32(t_lanes, slot))? row8(t_lanes.dtReg, slot) : vx;
+        }
+    }
+}
+
+static void ldDt(const LockstepLanes& t_lanes, uint8_t t_x){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            U8x32 dt = row8(t_lanes.dtReg, slot);
+            row8(t_lanes.dtReg, slot) = (laneMask32(t_lanes, slot))? row8(t_lanes.vRegs[t_x], slot) : dt;
+        }
+    }
+}
+
+static void ldSt(const LockstepLanes& t_lanes, uint8_t t_x){
+    for(std::size_t slot = 0; slot < t_lanes.slots; slot += CHIP8_LOCKSTEP_CHUNK){
+        if(t_lanes.chunkActive[slot / CHIP8_LOCKSTEP_CHUNK]){
+            U8x32 st = row8(t_lanes.stReg, slot);
+            row8(t_lanes.stReg, slot) = (laneMask32(t_lanes, slot))? row8(t_lanes.vRegs[t_x], slot) : st;
+        }
+    }
+}
+
+const LockstepKernel kernel = {&leader, &select, &retire, &tickTimers, &advance, &skip, &skipImm, &skipReg,
+                               &jump, &jumpReg, &ldImm, &addImm, &alu, &ldI, &addI, &spriteI, &ldVxDt, &ldDt, &ldSt};
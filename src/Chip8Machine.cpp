@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+#include "Chip8Machine.hpp"
+#include "BootCache.hpp"
+#include "Chip8Extended.hpp"
+
+namespace Chip8{
+
+// Frame size of t_chip8 and, unless t_pixels is null, its palette indices
+template<typename TRng, typename TQuirks>
+static void readFrame(const BasicChip8<TRng, TQuirks>& t_chip8, uint8_t* t_pixels, std::size_t& t_width, std::size_t& t_height){
+    t_width = CHIP8_DISP_X;
+    t_height = CHIP8_DISP_Y;
+    if(!t_pixels){
+        return;
+    }
+    const uint8_t* display = t_chip8.getDisplayData();
+    for(std::size_t ind = 0; ind < CHIP8_DISP_SIZE; ++ind){
+        for(std::size_t bit = 0; bit < 8; ++bit){
+            *t_pixels++ = (display[ind] >> (7 - bit)) & 0x01;
+        }
+    }
+}
+
+template<typename TRng, typename TMode>
+static void readFrame(const ExtendedChip8<TRng, TMode>& t_chip8, uint8_t* t_pixels, std::size_t& t_width, std::size_t& t_height){
+    t_width = CHIP8_HIRES_X;
+    t_height = CHIP8_HIRES_Y;
+    if(t_pixels){
+        t_chip8.getDisplay().readPixels(t_pixels);
+    }
+}
+
+template<typename TRng, typename TQuirks>
+static std::size_t copyMemory(const BasicChip8<TRng, TQuirks>& t_chip8, uint8_t* t_buffer){
+    // Page by page, pages still reading through to the rom image are copied from there
+    if(t_buffer){
+        for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+            std::copy(t_chip8.getMemory().page(page), t_chip8.getMemory().page(page) + CHIP8_PAGE_SIZE, t_buffer + page * CHIP8_PAGE_SIZE);
+        }
+    }
+    return CHIP8_MAIN_MEM_SIZE;
+}
+
+template<typename TRng, typename TMode>
+static std::size_t copyMemory(const ExtendedChip8<TRng, TMode>& t_chip8, uint8_t* t_buffer){
+    if(t_buffer){
+        std::copy(t_chip8.getMemory().begin(), t_chip8.getMemory().end(), t_buffer);
+    }
+    return TMode::memorySize;
+}
+
+// Whether the instantiation has the watchpoint hooks of Quirks::Debug, and whether its program has exited
+template<typename TRng, typename TQuirks>
+static bool hasDebugHooks(const BasicChip8<TRng, TQuirks>&){
+    return TQuirks::debug;
+}
+
+template<typename TRng, typename TMode>
+static bool hasDebugHooks(const ExtendedChip8<TRng, TMode>&){
+    return TMode::debug;
+}
+
+template<typename TRng, typename TQuirks>
+static bool halted(const BasicChip8<TRng, TQuirks>&){
+    return false;
+}
+
+template<typename TRng, typename TMode>
+static bool halted(const ExtendedChip8<TRng, TMode>& t_chip8){
+    return t_chip8.halted();
+}
+
+template<typename TChip8>
+class BasicMachine : public Machine{
+
+private:
+    // Held by pointer, TChip8's own operator new provides the cache line alignment
+    std::unique_ptr<TChip8> m_chip8;
+    std::string m_quirks;
+    std::size_t m_width;
+    std::size_t m_height;
+    uint64_t m_seed;
+    std::string m_romPath;
+    // Rom loaded from memory, when m_romPath is empty
+    std::vector<uint8_t> m_rom;
+    std::unique_ptr<BootCache<TChip8>> m_bootCache;
+    const BootState<TChip8>* m_boot;
+
+public:
+    BasicMachine(uint64_t t_seed, const std::string& t_quirks, uint8_t t_timerPeriod) : m_chip8(new TChip8(t_seed)), m_quirks(t_quirks), m_seed(t_seed), m_boot(nullptr){
+        m_chip8->setTimerPeriod(t_timerPeriod);
+        readFrame(*m_chip8, nullptr, m_width, m_height);
+    }
+
+    void reset() override{
+        m_chip8->reset();
+    }
+
+    void load(const std::string& t_filePath) override{
+        m_chip8->load(t_filePath);
+        m_romPath = t_filePath;
+        m_rom.clear();
+        m_boot = nullptr;
+    }
+
+    void load(const uint8_t* t_rom, std::size_t t_size) override{
+        m_chip8->load(t_rom, t_size);
+        m_romPath.clear();
+        m_rom.assign(t_rom, t_rom + t_size);
+        m_boot = nullptr;
+    }
+
+    void boot(uint64_t t_romHash, const std::string& t_bootDirectory) override{
+        m_bootCache.reset(new BootCache<TChip8>(m_quirks, t_bootDirectory));
+        m_boot = &m_bootCache->boot(t_romHash, *m_chip8);
+        restart();
+    }
+
+    void restart() override{
+        if(m_boot){
+            m_chip8->restore(*m_boot->state, m_seed);
+        }
+        else{
+            m_chip8->reset();
+            if(m_romPath.empty()){
+                m_chip8->load(m_rom.data(), m_rom.size());
+            }
+            else{
+                m_chip8->load(m_romPath);
+            }
+        }
+    }
+
+    uint64_t bootTicks() const override{
+        return (m_boot)? m_boot->ticks : 0;
+    }
+
+    uint64_t seed() const override{
+        return m_seed;
+    }
+
+    TickResult run_tick() override{
+        return m_chip8->run_tick();
+    }
+
+    void updateKeystate(bool t_pressState, bool t_repeat, const Chip8Key& t_key) override{
+        m_chip8->updateKeystate(t_pressState, t_repeat, t_key);
+    }
+
+    std::size_t displayWidth() const override{
+        return m_width;
+    }
+
+    std::size_t displayHeight() const override{
+        return m_height;
+    }
+
+    void readPixels(uint8_t* t_pixels) const override{
+        std::size_t width, height;
+        readFrame(*m_chip8, t_pixels, width, height);
+    }
+
+    uint64_t stateHash() const override{
+        return m_chip8->stateHash();
+    }
+
+    uint16_t programCounter() const override{
+        return m_chip8->getProgramCounter();
+    }
+
+    uint8_t readMemory(uint32_t t_addr) const override{
+        return m_chip8->readMemory(t_addr);
+    }
+
+    void writeMemory(uint32_t t_addr, uint8_t t_value) override{
+        m_chip8->writeMemory(t_addr, t_value);
+    }
+
+    std::size_t memorySize() const override{
+        return ::Chip8::copyMemory(*m_chip8, nullptr);
+    }
+
+    void copyMemory(uint8_t* t_buffer) const override{
+        ::Chip8::copyMemory(*m_chip8, t_buffer);
+    }
+
+    uint64_t evaluate(const TriggerProgram& t_triggers) const override{
+        return t_triggers.evaluate(*m_chip8);
+    }
+
+    Registers readRegisters() const override{
+        return m_chip8->readRegisters();
+    }
+
+    void writeRegisters(const Registers& t_registers) override{
+        m_chip8->writeRegisters(t_registers);
+    }
+
+    ExecutionCounters counters() const override{
+        return m_chip8->getCounters();
+    }
+
+    void setCounters(const ExecutionCounters& t_counters) override{
+        m_chip8->setCounters(t_counters);
+    }
+
+    bool halted() const override{
+        return ::Chip8::halted(*m_chip8);
+    }
+
+    bool debuggable() const override{
+        return hasDebugHooks(*m_chip8);
+    }
+
+    void attach(Breakpoints* t_breakpoints) override{
+        if(t_breakpoints && !debuggable()){
+            throw std::string("Chip8: '") + m_quirks + "' machine built without debugging, see makeMachine";
+        }
+        m_chip8->attach(t_breakpoints);
+    }
+
+    std::size_t stateSize() const override{
+        return TChip8::stateSize;
+    }
+
+    std::size_t saveState(uint8_t* t_buffer, std::size_t t_size) const override{
+        return m_chip8->saveState(t_buffer, t_size);
+    }
+
+    void loadState(const uint8_t* t_buffer, std::size_t t_size) override{
+        m_chip8->loadState(t_buffer, t_size);
+    }
+
+    void setKeystates(uint16_t t_keystates) override{
+        m_chip8->setKeystates(t_keystates);
+    }
+
+    const char* quirks() const override{
+        return m_quirks.c_str();
+    }
+};
+
+template<typename TChip8>
+static std::unique_ptr<Machine> createMachine(uint64_t t_seed, const std::string& t_quirks, uint8_t t_timerPeriod){
+    return std::unique_ptr<Machine>(new BasicMachine<TChip8>(t_seed, t_quirks, t_timerPeriod));
+}
+
+static const struct{
+    const char* name;
+    std::unique_ptr<Machine> (*create)(uint64_t, const std::string&, uint8_t);
+    std::unique_ptr<Machine> (*createDebug)(uint64_t, const std::string&, uint8_t);
+} machineTypes[] = {{"legacy", createMachine<Chip8>,       createMachine<Chip8Debug>},
+                    {"vip",    createMachine<Chip8Vip>,    createMachine<Chip8VipDebug>},
+                    {"chip48", createMachine<Chip8Chip48>, createMachine<Chip8Chip48Debug>},
+                    {"schip",  createMachine<SuperChip8>,  createMachine<SuperChip8Debug>},
+                    {"xochip", createMachine<XoChip8>,     createMachine<XoChip8Debug>}};
+
+std::unique_ptr<Machine> makeMachine(const std::string& t_quirks, uint64_t t_seed, bool t_debug){
+    const std::size_t colon = t_quirks.find(':');
+    std::string name = t_quirks.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if(name.empty()){
+        name = machineTypes[0].name;
+    }
+    unsigned long timerPeriod = CHIP8_TIMER_PERIOD;
+    if(colon != std::string::npos){
+        const char* ipf = t_quirks.c_str() + colon + 1;
+        char* end;
+        timerPeriod = std::strtoul(ipf, &end, 10);
+        if(!std::isdigit(static_cast<unsigned char>(*ipf)) || *end || !timerPeriod || timerPeriod > CHIP8_MAX_TIMER_PERIOD){
+            throw std::string("Chip8: instructions per frame in '" + t_quirks + "' are not a number from 1 to " + std::to_string(CHIP8_MAX_TIMER_PERIOD));
+        }
+    }
+    for(const auto& machineType : machineTypes){
+        if(name == machineType.name){
+            // The default period is left out of the name, so machines that only spell it out share boot files
+            std::string quirks = (timerPeriod == CHIP8_TIMER_PERIOD)? name : name + ':' + std::to_string(timerPeriod);
+            return (t_debug)? machineType.createDebug(t_seed, quirks, timerPeriod) : machineType.create(t_seed, quirks, timerPeriod);
+        }
+    }
+    throw std::string("Chip8: unknown quirks '" + t_quirks + "', expected 'legacy', 'vip', 'chip48', 'schip' or 'xochip'");
+}
+
+} // namespace Chip8
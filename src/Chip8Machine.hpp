@@ -0,0 +1,80 @@
+#ifndef CHIP8_MACHINE_HPP
+#define CHIP8_MACHINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Chip8.hpp"
+#include "Trigger.hpp"
+
+namespace Chip8{
+
+// Run time handle over one BasicChip8 instantiation, for front ends that only learn which interpreter
+// variant a rom expects when it is loaded. Costs one virtual call per tick, the instruction handlers
+// behind it stay specialized for their quirk policy.
+class Machine{
+public:
+    virtual ~Machine() = default;
+
+    virtual void reset() = 0;
+    virtual void load(const std::string& t_filePath) = 0;
+    // Loads rom bytes already in memory, restart() loads them again
+    virtual void load(const uint8_t* t_rom, std::size_t t_size) = 0;
+    // Runs the loaded rom to its first input wait, or takes that state from t_bootDirectory (see BootCache),
+    // and continues from there. Later restarts copy the state instead of booting again.
+    virtual void boot(uint64_t t_romHash, const std::string& t_bootDirectory) = 0;
+    // Back to the start of the loaded rom: the boot state after boot(), otherwise reset() and a fresh load
+    virtual void restart() = 0;
+    // Ticks a cold load needs to reach the state restart() returns to, 0 without a boot state
+    virtual uint64_t bootTicks() const = 0;
+    virtual uint64_t seed() const = 0;
+    virtual TickResult run_tick() = 0;
+    virtual void updateKeystate(bool t_pressState, bool t_repeat, const Chip8Key& t_key) = 0;
+    // Frame size in pixels, 64x32 for CHIP-8 variants and 128x64 for SUPER-CHIP and XO-CHIP
+    virtual std::size_t displayWidth() const = 0;
+    virtual std::size_t displayHeight() const = 0;
+    // Writes the palette index, 0 to CHIP8_NUM_COLORS - 1, of every pixel in row major order
+    virtual void readPixels(uint8_t* t_pixels) const = 0;
+    virtual uint64_t stateHash() const = 0;
+    virtual uint16_t programCounter() const = 0;
+    // Guest memory byte at t_addr, addresses wrap at the memory size of the variant
+    virtual uint8_t readMemory(uint32_t t_addr) const = 0;
+    virtual void writeMemory(uint32_t t_addr, uint8_t t_value) = 0;
+    // Bytes of guest memory, 4 KiB or 64 KiB for XO-CHIP, and a copy of all of them into t_buffer
+    virtual std::size_t memorySize() const = 0;
+    virtual void copyMemory(uint8_t* t_buffer) const = 0;
+    // Results of every trigger in t_triggers, one virtual call with the program running on the concrete interpreter
+    virtual uint64_t evaluate(const TriggerProgram& t_triggers) const = 0;
+    virtual Registers readRegisters() const = 0;
+    virtual void writeRegisters(const Registers& t_registers) = 0;
+    // What the interpreter did since its last reset, see ExecutionCounters
+    virtual ExecutionCounters counters() const = 0;
+    virtual void setCounters(const ExecutionCounters& t_counters) = 0;
+    // Set once a SUPER-CHIP or XO-CHIP program executed 00FD
+    virtual bool halted() const = 0;
+    // Whether data accesses can be watched, true for machines made with t_debug set. attach() throws
+    // std::string otherwise, see Breakpoints.
+    virtual bool debuggable() const = 0;
+    virtual void attach(Breakpoints* t_breakpoints) = 0;
+    // Snapshots of the whole machine, see BasicChip8::saveState. stateSize() bytes per snapshot.
+    virtual std::size_t stateSize() const = 0;
+    virtual std::size_t saveState(uint8_t* t_buffer, std::size_t t_size) const = 0;
+    virtual void loadState(const uint8_t* t_buffer, std::size_t t_size) = 0;
+    // Replaces the whole key state, bit k set means key k is held
+    virtual void setKeystates(uint16_t t_keystates) = 0;
+    // Name of the quirk policy and timer period, as accepted by makeMachine
+    virtual const char* quirks() const = 0;
+};
+
+// Machine running the interpreter variant named t_quirks: 'legacy' (also the empty name), 'vip', 'chip48',
+// 'schip' or 'xochip', optionally followed by ':IPF' for a rom that runs IPF instructions per 60Hz frame
+// (see BasicChip8::setTimerPeriod, CHIP8_TIMER_PERIOD when left out). Throws on any other name. With t_debug
+// the interpreter reports data accesses to an attached Breakpoints, at a small cost per memory instruction
+// that the other variants do not pay.
+std::unique_ptr<Machine> makeMachine(const std::string& t_quirks, uint64_t t_seed, bool t_debug = false);
+
+} // namespace Chip8
+
+#endif // CHIP8_MACHINE_HPP
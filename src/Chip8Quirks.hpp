@@ -0,0 +1,83 @@
+#ifndef CHIP8_QUIRKS_HPP
+#define CHIP8_QUIRKS_HPP
+
+namespace Chip8{
+    namespace Quirks{
+
+    // Behaviour policies for the instructions interpreters disagree on. Every member is a compile time
+    // constant, so each instantiation of BasicChip8 folds its quirk checks away and runs branch free.
+    //
+    //     shiftUsesVy        8XY6/8XYE shift VY into VX instead of shifting VX in place
+    //     loadStoreAdvance   how FX55/FX65 leave I: untouched, I += X or I += X + 1
+    //     jumpUsesVx         BXNN jumps to XNN + VX instead of BNNN jumping to NNN + V0
+    //     clipSprites        DRW drops sprite pixels past the display edges instead of wrapping them
+    //     legacyJumpAdvance  BNNN lands 2 bytes past its target, as this interpreter always has
+    //     debug              data reads and writes report to an attached Breakpoints, see Debug below
+
+    enum class IndexAdvance{
+        None,
+        ByX,
+        ByXPlusOne
+    };
+
+    // The behaviour of earlier releases, results and state hashes match older builds
+    struct Legacy{
+        static constexpr bool shiftUsesVy = false;
+        static constexpr IndexAdvance loadStoreAdvance = IndexAdvance::None;
+        static constexpr bool jumpUsesVx = false;
+        static constexpr bool clipSprites = false;
+        static constexpr bool legacyJumpAdvance = true;
+        static constexpr bool debug = false;
+    };
+
+    // The original COSMAC VIP interpreter
+    struct CosmacVip{
+        static constexpr bool shiftUsesVy = true;
+        static constexpr IndexAdvance loadStoreAdvance = IndexAdvance::ByXPlusOne;
+        static constexpr bool jumpUsesVx = false;
+        static constexpr bool clipSprites = true;
+        static constexpr bool legacyJumpAdvance = false;
+        static constexpr bool debug = false;
+    };
+
+    // CHIP-48 on the HP48
+    struct Chip48{
+        static constexpr bool shiftUsesVy = false;
+        static constexpr IndexAdvance loadStoreAdvance = IndexAdvance::ByX;
+        static constexpr bool jumpUsesVx = true;
+        static constexpr bool clipSprites = true;
+        static constexpr bool legacyJumpAdvance = false;
+        static constexpr bool debug = false;
+    };
+
+    // SUPER-CHIP 1.1
+    struct SuperChip{
+        static constexpr bool shiftUsesVy = false;
+        static constexpr IndexAdvance loadStoreAdvance = IndexAdvance::None;
+        static constexpr bool jumpUsesVx = true;
+        static constexpr bool clipSprites = true;
+        static constexpr bool legacyJumpAdvance = false;
+        static constexpr bool debug = false;
+    };
+
+    // XO-CHIP as specified by Octo
+    struct XoChip{
+        static constexpr bool shiftUsesVy = true;
+        static constexpr IndexAdvance loadStoreAdvance = IndexAdvance::ByXPlusOne;
+        static constexpr bool jumpUsesVx = false;
+        static constexpr bool clipSprites = false;
+        static constexpr bool legacyJumpAdvance = false;
+        static constexpr bool debug = false;
+    };
+
+    // Any policy with watchpoint hooks compiled in. Only the instantiations a debugger runs pay for them,
+    // every other one has no trace of the checks.
+    template<typename TPolicy>
+    struct Debug : TPolicy{
+        static constexpr bool debug = true;
+    };
+
+    } // namespace Quirks
+} // namespace Chip8
+
+#endif // CHIP8_QUIRKS_HPP
@@ -0,0 +1,259 @@
+#ifndef CHIP8_RNG_HPP
+#define CHIP8_RNG_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "Chip8Util.hpp"
+
+#define CHIP8_RNG_GOLDEN_GAMMA 0x9e3779b97f4a7c15
+
+#define CHIP8_RNG_MT_WORDS     624
+#define CHIP8_RNG_MT_SHIFT     397
+
+namespace Chip8{
+    namespace Rng{
+
+    // Generator policies for the RND instruction. A policy is constructible from a seed, reseedable with
+    // seed(), yields one byte per RND from next() and provides split(seed, stream) which derives a
+    // deterministic, independent generator per stream so parallel runs can share one master seed.
+    // fingerprint() identifies the generator state, two generators with equal fingerprints yield the same sequence.
+    // saveState()/loadState() copy the whole generator state to and from stateSize little endian bytes.
+
+    inline uint64_t splitmix64(uint64_t& t_state){
+        uint64_t z = (t_state += CHIP8_RNG_GOLDEN_GAMMA);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    // Seed for stream t_stream of master seed t_seed
+    inline uint64_t splitSeed(uint64_t t_seed, uint64_t t_stream){
+        uint64_t state = t_seed;
+        state = splitmix64(state) ^ t_stream;
+        return splitmix64(state);
+    }
+
+    // The std::mt19937 engine with its state in reach, so it can be saved without going through a stream.
+    // Yields exactly the std::mt19937 sequence for a seed.
+    class Mt19937Engine{
+
+    private:
+        std::array<uint32_t, CHIP8_RNG_MT_WORDS> m_state;
+        uint16_t m_index;
+
+        void twist(){
+            for(std::size_t i = 0; i < CHIP8_RNG_MT_WORDS; ++i){
+                uint32_t y = (m_state[i] & 0x80000000) | (m_state[(i + 1) % CHIP8_RNG_MT_WORDS] & 0x7fffffff);
+                m_state[i] = m_state[(i + CHIP8_RNG_MT_SHIFT) % CHIP8_RNG_MT_WORDS] ^ (y >> 1) ^ ((y & 0x01)? 0x9908b0df : 0);
+            }
+            m_index = 0;
+        }
+
+    public:
+        typedef std::mt19937::result_type result_type;
+
+        static constexpr std::size_t stateSize = CHIP8_RNG_MT_WORDS * sizeof(uint32_t) + sizeof(uint16_t);
+
+        explicit Mt19937Engine(uint64_t t_seed = std::mt19937::default_seed){
+            seed(t_seed);
+        }
+
+        static constexpr result_type min(){
+            return 0;
+        }
+
+        static constexpr result_type max(){
+            return 0xffffffff;
+        }
+
+        void seed(uint64_t t_seed){
+            m_state[0] = static_cast<uint32_t>(t_seed);
+            for(uint32_t i = 1; i < CHIP8_RNG_MT_WORDS; ++i){
+                m_state[i] = 1812433253 * (m_state[i - 1] ^ (m_state[i - 1] >> 30)) + i;
+            }
+            m_index = CHIP8_RNG_MT_WORDS;
+        }
+
+        result_type operator()(){
+            if(m_index >= CHIP8_RNG_MT_WORDS){
+                twist();
+            }
+            uint32_t y = m_state[m_index++];
+            y ^= y >> 11;
+            y ^= (y << 7) & 0x9d2c5680;
+            y ^= (y << 15) & 0xefc60000;
+            return y ^ (y >> 18);
+        }
+
+        void saveState(uint8_t* t_buffer) const{
+            for(uint32_t word : m_state){
+                Util::putLE(t_buffer, word);
+            }
+            Util::putLE(t_buffer, m_index);
+        }
+
+        void loadState(const uint8_t* t_buffer){
+            for(uint32_t& word : m_state){
+                word = Util::getLE<uint32_t>(t_buffer);
+            }
+            m_index = std::min<uint16_t>(Util::getLE<uint16_t>(t_buffer), CHIP8_RNG_MT_WORDS);
+        }
+    };
+
+    // mt19937 behind the distribution Chip8 has always used, results match older builds for a given seed
+    class Mt19937{
+
+    private:
+        Mt19937Engine m_generator;
+        std::uniform_int_distribution<> m_dist;
+        // Identify the 2.5 KiB engine state for fingerprint(), it is fully determined by them
+        uint64_t m_seed;
+        uint64_t m_draws;
+
+    public:
+        static constexpr std::size_t stateSize = Mt19937Engine::stateSize + 2 * sizeof(uint64_t);
+
+        explicit Mt19937(uint64_t t_seed = std::mt19937::default_seed) : m_generator(t_seed), m_dist(0, 255), m_seed(t_seed), m_draws(0){}
+
+        void seed(uint64_t t_seed){
+            m_generator.seed(t_seed);
+            m_dist.reset();
+            m_seed = t_seed;
+            m_draws = 0;
+        }
+
+        uint8_t next(){
+            ++m_draws;
+            return m_dist(m_generator);
+        }
+
+        uint64_t fingerprint() const{
+            uint64_t state = m_seed;
+            return splitmix64(state) ^ m_draws;
+        }
+
+        void saveState(uint8_t* t_buffer) const{
+            Util::putLE(t_buffer, m_seed);
+            Util::putLE(t_buffer, m_draws);
+            m_generator.saveState(t_buffer);
+        }
+
+        void loadState(const uint8_t* t_buffer){
+            // The distribution keeps no state between draws, only the engine has to be restored
+            m_seed = Util::getLE<uint64_t>(t_buffer);
+            m_draws = Util::getLE<uint64_t>(t_buffer);
+            m_generator.loadState(t_buffer);
+        }
+
+        static Mt19937 split(uint64_t t_seed, uint64_t t_stream){
+            return Mt19937(splitSeed(t_seed, t_stream));
+        }
+    };
+
+    // xorshift64*, 8 bytes of state
+    class Xorshift{
+
+    private:
+        uint64_t m_state;
+
+    public:
+        static constexpr std::size_t stateSize = sizeof(uint64_t);
+
+        explicit Xorshift(uint64_t t_seed = 0){
+            seed(t_seed);
+        }
+
+        void seed(uint64_t t_seed){
+            // Scramble so nearby seeds diverge immediately, the all zero state is a fixed point
+            m_state = splitmix64(t_seed);
+            if(!m_state){
+                m_state = CHIP8_RNG_GOLDEN_GAMMA;
+            }
+        }
+
+        uint8_t next(){
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return (m_state * 0x2545f4914f6cdd1d) >> 56;
+        }
+
+        uint64_t fingerprint() const{
+            return m_state;
+        }
+
+        void saveState(uint8_t* t_buffer) const{
+            Util::putLE(t_buffer, m_state);
+        }
+
+        void loadState(const uint8_t* t_buffer){
+            m_state = Util::getLE<uint64_t>(t_buffer);
+        }
+
+        static Xorshift split(uint64_t t_seed, uint64_t t_stream){
+            return Xorshift(splitSeed(t_seed, t_stream));
+        }
+    };
+
+    // PCG32 (XSH RR), 16 bytes of state, streams map onto the native increment
+    class Pcg32{
+
+    private:
+        uint64_t m_state;
+        uint64_t m_inc;
+
+        uint32_t next32(){
+            uint64_t old = m_state;
+            m_state = old * 6364136223846793005 + m_inc;
+            uint32_t xorShifted = ((old >> 18) ^ old) >> 27;
+            uint32_t rot = old >> 59;
+            return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+        }
+
+    public:
+        static constexpr std::size_t stateSize = 2 * sizeof(uint64_t);
+
+        explicit Pcg32(uint64_t t_seed = 0, uint64_t t_stream = 0){
+            seed(t_seed, t_stream);
+        }
+
+        void seed(uint64_t t_seed, uint64_t t_stream = 0){
+            m_state = 0;
+            m_inc = (t_stream << 1) | 1;
+            next32();
+            m_state += t_seed;
+            next32();
+        }
+
+        uint8_t next(){
+            return next32() >> 24;
+        }
+
+        uint64_t fingerprint() const{
+            uint64_t inc = m_inc;
+            return m_state ^ splitmix64(inc);
+        }
+
+        void saveState(uint8_t* t_buffer) const{
+            Util::putLE(t_buffer, m_state);
+            Util::putLE(t_buffer, m_inc);
+        }
+
+        void loadState(const uint8_t* t_buffer){
+            m_state = Util::getLE<uint64_t>(t_buffer);
+            m_inc = Util::getLE<uint64_t>(t_buffer);
+        }
+
+        static Pcg32 split(uint64_t t_seed, uint64_t t_stream){
+            return Pcg32(t_seed, t_stream);
+        }
+    };
+
+    } // namespace Rng
+} // namespace Chip8
+
+#endif // CHIP8_RNG_HPP
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+#include "LoggerImpl.hpp"
+#include "Chip8Emulator.hpp"
+#include "Chip8TiledEmulator.hpp"
+
+namespace Chip8{
+
+        namespace arg = std::placeholders;
+
+        namespace{
+
+        const std::pair<KeyHandler::KeyAction, Chip8Key> chip8KeyActions[] = {{KeyHandler::KEY_CH8_0, KEY_0}, {KeyHandler::KEY_CH8_1, KEY_1},
+                                                                              {KeyHandler::KEY_CH8_2, KEY_2}, {KeyHandler::KEY_CH8_3, KEY_3},
+                                                                              {KeyHandler::KEY_CH8_4, KEY_4}, {KeyHandler::KEY_CH8_5, KEY_5},
+                                                                              {KeyHandler::KEY_CH8_6, KEY_6}, {KeyHandler::KEY_CH8_7, KEY_7},
+                                                                              {KeyHandler::KEY_CH8_8, KEY_8}, {KeyHandler::KEY_CH8_9, KEY_9},
+                                                                              {KeyHandler::KEY_CH8_A, KEY_A}, {KeyHandler::KEY_CH8_B, KEY_B},
+                                                                              {KeyHandler::KEY_CH8_C, KEY_C}, {KeyHandler::KEY_CH8_D, KEY_D},
+                                                                              {KeyHandler::KEY_CH8_E, KEY_E}, {KeyHandler::KEY_CH8_F, KEY_F}};
+
+        } // namespace
+
+        TiledEmulator::TiledEmulator(const std::pair<int, int>& t_resolution, const std::vector<TileConfig>& t_tiles, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds,
+                                     bool t_boot, const std::string& t_bootDirectory) : m_window(nullptr),
+                                                                                        m_renderer(nullptr),
+                                                                                        m_gridTexture(nullptr),
+                                                                                        m_tileWidth(0),
+                                                                                        m_tileHeight(0),
+                                                                                        m_run(true),
+                                                                                        m_paused(false),
+                                                                                        m_focus(0),
+                                                                                        m_inputHandler(t_keyBinds){
+            if(t_tiles.empty()){
+                throw std::string("TiledEmulator: no sessions to run");
+            }
+
+            for(const TileConfig& config : t_tiles){
+                std::unique_ptr<Tile> tile(new Tile);
+                tile->machine = makeMachine(config.quirks, config.seed);
+                tile->machine->load(config.romPath);
+                if(t_boot){
+                    tile->machine->boot(config.romHash, t_bootDirectory);
+                }
+                tile->tickPeriodUsec = std::max(1L, config.tickPeriodUsec);
+                for(std::size_t color = 0; color < CHIP8_NUM_COLORS; ++color){
+                    tile->palette[color] = mapColorFormat<SDL_PIXELFORMAT_RGBA8888>(config.palette[color]);
+                }
+                tile->width = tile->machine->displayWidth();
+                tile->height = tile->machine->displayHeight();
+                tile->keys = 0;
+                tile->restart = false;
+                tile->faulted = false;
+                tile->frame.resize(tile->width * tile->height);
+                tile->machine->readPixels(tile->frame.data());
+                tile->frameDirty = true;
+
+                m_tileWidth = std::max(m_tileWidth, tile->width);
+                m_tileHeight = std::max(m_tileHeight, tile->height);
+                m_tiles.push_back(std::move(tile));
+            }
+
+            // Near square grid, every cell as large as the largest display; smaller displays are scaled up to fill it
+            m_columns = 1;
+            while(m_columns * m_columns < m_tiles.size()){
+                ++m_columns;
+            }
+            m_rows = (m_tiles.size() + m_columns - 1) / m_columns;
+            m_gridPixels.assign(m_columns * m_tileWidth * m_rows * m_tileHeight, 0);
+            m_tileFrame.resize(m_tileWidth * m_tileHeight);
+
+            m_window = SDL_CreateWindow("Chip8 Emu", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, t_resolution.first, t_resolution.second, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+            m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            m_gridTexture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, m_columns * m_tileWidth, m_rows * m_tileHeight);
+            if(!m_window || !m_renderer || !m_gridTexture){
+                throw std::string("TiledEmulator: could not create the window: ") + SDL_GetError();
+            }
+            chip8Logger.log<Logger::LogTrace>("TiledEmulator: ", m_tiles.size(), " tiles in a ", m_columns, "x", m_rows, " grid", Logger::endl);
+
+            for(const auto& keyAction : chip8KeyActions){
+                m_inputHandler.bindAction(keyAction.first, std::bind(&TiledEmulator::handleKeyInput, this, keyAction.second, arg::_1));
+            }
+            m_inputHandler.bindAction(KeyHandler::KEY_EMU_RESET, [this](bool t_pressState, bool t_repeat){
+                if(t_pressState && !t_repeat){
+                    m_tiles[m_focus]->restart = true;
+                }
+            });
+            m_inputHandler.bindAction(KeyHandler::KEY_EMU_PAUSE, [this](bool t_pressState, bool t_repeat){
+                if(t_pressState && !t_repeat){
+                    m_paused = !m_paused;
+                }
+            });
+            m_inputHandler.bindAction(KeyHandler::KEY_EMU_NEXT_TILE, [this](bool t_pressState, bool t_repeat){
+                if(t_pressState && !t_repeat){
+                    setFocus((m_focus + 1) % m_tiles.size());
+                }
+            });
+        }
+
+        void TiledEmulator::runTile(Tile& t_tile){
+            std::vector<uint8_t> frame(t_tile.frame.size());
+            uint16_t keys = 0;
+            auto next = std::chrono::steady_clock::now();
+
+            while(m_run){
+                bool frameReady = false;
+                if(t_tile.restart.exchange(false)){
+                    t_tile.machine->restart();
+                    t_tile.faulted = false;
+                    keys = 0;
+                    frameReady = true;
+                }
+
+                if(m_paused || t_tile.faulted){
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    next = std::chrono::steady_clock::now();
+                }
+                else{
+                    uint16_t held = t_tile.keys;
+                    for(unsigned key = 0; key < 16; ++key){
+                        if(((held ^ keys) >> key) & 0x01){
+                            t_tile.machine->updateKeystate((held >> key) & 0x01, false, static_cast<Chip8Key>(key));
+                        }
+                    }
+                    keys = held;
+
+                    // Every tick that is due, a tile that fell far behind (a stalled thread) resumes at the current time
+                    auto now = std::chrono::steady_clock::now();
+                    if(now - next > std::chrono::microseconds(CHIP8_TILE_MAX_LAG_USEC)){
+                        next = now;
+                    }
+                    try{
+                        while(next <= now){
+                            if(t_tile.machine->run_tick().displayUpdate){
+                                frameReady = true;
+                            }
+                            next += std::chrono::microseconds(t_tile.tickPeriodUsec);
+                        }
+                    }
+                    catch(const std::string& error){
+                        std::lock_guard<std::mutex> lock(t_tile.frameLock);
+                        t_tile.fault = error;
+                        t_tile.faulted = true;
+                    }
+                }
+
+                if(frameReady){
+                    // Read outside the lock, the window thread only ever waits for the swap
+                    t_tile.machine->readPixels(frame.data());
+                    std::lock_guard<std::mutex> lock(t_tile.frameLock);
+                    t_tile.frame.swap(frame);
+                    t_tile.frameDirty = true;
+                }
+                std::this_thread::sleep_until(next);
+            }
+        }
+
+        bool TiledEmulator::paintTile(std::size_t t_index, bool t_force){
+            Tile& tile = *m_tiles[t_index];
+            std::string fault;
+            bool dirty;
+            {
+                std::lock_guard<std::mutex> lock(tile.frameLock);
+                fault.swap(tile.fault);
+                dirty = tile.frameDirty || t_force;
+                if(dirty){
+                    std::copy(tile.frame.begin(), tile.frame.end(), m_tileFrame.begin());
+                    tile.frameDirty = false;
+                }
+            }
+            if(!fault.empty()){
+                chip8Logger.log<Logger::LogError>(fault, Logger::endl);
+            }
+            if(!dirty){
+                return false;
+            }
+
+            const std::size_t gridWidth = m_columns * m_tileWidth;
+            const std::size_t scaleX = m_tileWidth / tile.width;
+            const std::size_t scaleY = m_tileHeight / tile.height;
+            uint32_t* cell = m_gridPixels.data() + (t_index / m_columns) * m_tileHeight * gridWidth + (t_index % m_columns) * m_tileWidth;
+            for(std::size_t y = 0; y < m_tileHeight; ++y){
+                const uint8_t* source = m_tileFrame.data() + (y / scaleY) * tile.width;
+                for(std::size_t x = 0; x < m_tileWidth; ++x){
+                    cell[y * gridWidth + x] = tile.palette[source[x / scaleX]];
+                }
+            }
+            return true;
+        }
+
+        void TiledEmulator::present(){
+            bool changed = false;
+            for(std::size_t index = 0; index < m_tiles.size(); ++index){
+                changed |= paintTile(index, false);
+            }
+            // One upload for the whole grid, however many tiles changed
+            if(changed){
+                SDL_UpdateTexture(m_gridTexture, NULL, m_gridPixels.data(), m_columns * m_tileWidth * sizeof(uint32_t));
+            }
+
+            SDL_SetRenderDrawColor(m_renderer, 0x00, 0x00, 0x00, 0xFF);
+            SDL_RenderClear(m_renderer);
+            SDL_RenderCopy(m_renderer, m_gridTexture, NULL, NULL);
+
+            if(m_tiles.size() > 1){
+                int outputW, outputH;
+                SDL_GetRendererOutputSize(m_renderer, &outputW, &outputH);
+                int column = m_focus % m_columns;
+                int row = m_focus / m_columns;
+                SDL_Rect focus;
+                focus.x = column * outputW / m_columns;
+                focus.y = row * outputH / m_rows;
+                focus.w = (column + 1) * outputW / m_columns - focus.x;
+                focus.h = (row + 1) * outputH / m_rows - focus.y;
+                SDL_SetRenderDrawColor(m_renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+                SDL_RenderDrawRect(m_renderer, &focus);
+            }
+            SDL_RenderPresent(m_renderer);
+        }
+
+        void TiledEmulator::setFocus(std::size_t t_index){
+            // Keys held on the old tile would otherwise stay down there
+            m_tiles[m_focus]->keys = 0;
+            m_focus = t_index;
+        }
+
+        void TiledEmulator::handleKeyInput(Chip8Key t_key, bool t_pressState){
+            if(t_pressState){
+                m_tiles[m_focus]->keys |= 0x1 << t_key;
+            }
+            else{
+                m_tiles[m_focus]->keys &= ~(0x1 << t_key);
+            }
+        }
+
+        void TiledEmulator::handleClick(int t_x, int t_y){
+            int windowW, windowH;
+            SDL_GetWindowSize(m_window, &windowW, &windowH);
+            if(windowW <= 0 || windowH <= 0){
+                return;
+            }
+            std::size_t index = std::min<std::size_t>(t_y * m_rows / windowH, m_rows - 1) * m_columns + std::min<std::size_t>(t_x * m_columns / windowW, m_columns - 1);
+            if(index < m_tiles.size()){
+                setFocus(index);
+            }
+        }
+
+        void TiledEmulator::run(){
+            for(std::unique_ptr<Tile>& tile : m_tiles){
+                tile->worker = std::thread(&TiledEmulator::runTile, this, std::ref(*tile));
+            }
+
+            // Presenting waits for the display refresh, so this loop runs once per refresh
+            SDL_Event e;
+            while(m_run){
+                while(SDL_PollEvent(&e)){
+                    switch(e.type){
+                        case SDL_QUIT:
+                            m_run = false;
+                            break;
+                        case SDL_KEYDOWN:
+                        case SDL_KEYUP:
+                            m_inputHandler.dispatch(e.key.keysym.sym, e.type == SDL_KEYDOWN, e.key.repeat);
+                            break;
+                        case SDL_MOUSEBUTTONDOWN:
+                            if(e.button.button == SDL_BUTTON_LEFT){
+                                handleClick(e.button.x, e.button.y);
+                            }
+                            break;
+                    }
+                }
+                present();
+            }
+
+            for(std::unique_ptr<Tile>& tile : m_tiles){
+                tile->worker.join();
+            }
+        }
+
+        TiledEmulator::~TiledEmulator(){
+            m_run = false;
+            for(std::unique_ptr<Tile>& tile : m_tiles){
+                if(tile->worker.joinable()){
+                    tile->worker.join();
+                }
+            }
+
+            SDL_DestroyTexture(m_gridTexture);
+            SDL_DestroyRenderer(m_renderer);
+            SDL_DestroyWindow(m_window);
+        }
+
+} // namespace Chip8
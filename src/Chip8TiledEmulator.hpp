@@ -0,0 +1,94 @@
+#ifndef CHIP8_TILED_EMULATOR_HPP
+#define CHIP8_TILED_EMULATOR_HPP
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "KeyHandler.hpp"
+#include "Chip8Display.hpp"
+#include "Chip8Machine.hpp"
+
+#define CHIP8_TILE_MAX_LAG_USEC   100000
+
+namespace Chip8{
+
+        // One session of a tiled window: the rom, its interpreter variant, speed and seed and its palette
+        struct TileConfig{
+            std::string romPath;
+            uint64_t romHash;
+            std::string quirks;
+            long tickPeriodUsec;
+            uint64_t seed;
+            std::array<SDL_Color, CHIP8_NUM_COLORS> palette;
+        };
+
+        // Runs several sessions side by side in one window. Every session ticks on its own worker thread at its
+        // own speed and hands finished frames to the window thread, which paints changed tiles into one grid
+        // buffer and uploads it as a single texture per display refresh. Keys go to the focused tile, chosen
+        // with key_emu_next_tile or a mouse click; key_emu_reset restarts it and key_emu_pause pauses all tiles.
+        class TiledEmulator{
+
+        private:
+            struct Tile{
+                std::unique_ptr<Machine> machine;
+                long tickPeriodUsec;
+                std::array<uint32_t, CHIP8_NUM_COLORS> palette;
+                std::size_t width;
+                std::size_t height;
+                std::thread worker;
+                // Written by the window thread, picked up by the worker before its next tick
+                std::atomic<uint16_t> keys;
+                std::atomic<bool> restart;
+                std::atomic<bool> faulted;
+                // Palette indices of the last finished frame, guarded by frameLock
+                std::mutex frameLock;
+                std::vector<uint8_t> frame;
+                bool frameDirty;
+                // What the machine threw, also guarded by frameLock. Logged by the window thread, Logger is not
+                // safe to call from the workers.
+                std::string fault;
+            };
+
+            SDL_Window* m_window;
+            SDL_Renderer* m_renderer;
+            SDL_Texture* m_gridTexture;
+
+            std::vector<std::unique_ptr<Tile>> m_tiles;
+            std::size_t m_columns;
+            std::size_t m_rows;
+            std::size_t m_tileWidth;
+            std::size_t m_tileHeight;
+            std::vector<uint32_t> m_gridPixels;
+            std::vector<uint8_t> m_tileFrame;
+
+            std::atomic<bool> m_run;
+            std::atomic<bool> m_paused;
+            std::size_t m_focus;
+            KeyHandler::KeyHandler m_inputHandler;
+
+            void runTile(Tile& t_tile);
+            bool paintTile(std::size_t t_index, bool t_force);
+            void present();
+            void setFocus(std::size_t t_index);
+            void handleKeyInput(Chip8Key t_key, bool t_pressState);
+            void handleClick(int t_x, int t_y);
+
+        public:
+            TiledEmulator(const std::pair<int, int>& t_resolution, const std::vector<TileConfig>& t_tiles, std::unordered_map<KeyHandler::KeyPair, KeyHandler::KeyAction> t_keyBinds,
+                          bool t_boot = false, const std::string& t_bootDirectory = "");
+            void run();
+            ~TiledEmulator();
+        };
+
+} // namespace Chip8
+
+#endif // CHIP8_TILED_EMULATOR_HPP
@@ -32,6 +32,73 @@ namespace Chip8{
             int exists = stat(t_filePath, &buff);
             return (exists != -1)? fileType(buff.st_mode) : 0;
         }
+
+        static const uint64_t xxhPrime1 = 0x9e3779b185ebca87;
+        static const uint64_t xxhPrime2 = 0xc2b2ae3d27d4eb4f;
+        static const uint64_t xxhPrime3 = 0x165667b19e3779f9;
+        static const uint64_t xxhPrime4 = 0x85ebca77c2b2ae63;
+        static const uint64_t xxhPrime5 = 0x27d4eb2f165667c5;
+
+        static inline uint64_t rotl64(uint64_t t_value, int t_shift){
+            return (t_value << t_shift) | (t_value >> (64 - t_shift));
+        }
+
+        static inline uint64_t read64(const uint8_t* t_data){
+            uint64_t value;
+            std::memcpy(&value, t_data, sizeof(value));
+            return value;
+        }
+
+        static inline uint64_t xxhRound(uint64_t t_acc, uint64_t t_input){
+            return rotl64(t_acc + t_input * xxhPrime2, 31) * xxhPrime1;
+        }
+
+        static inline uint64_t xxhMerge(uint64_t t_acc, uint64_t t_value){
+            return (t_acc ^ xxhRound(0, t_value)) * xxhPrime1 + xxhPrime4;
+        }
+
+        uint64_t xxh64(const uint8_t* t_data, std::size_t t_size, uint64_t t_seed){
+            const uint8_t* end = t_data + t_size;
+            uint64_t hash;
+            if(t_size >= 32){
+                // Four independent lanes keep the multiplier busy
+                uint64_t lane1 = t_seed + xxhPrime1 + xxhPrime2, lane2 = t_seed + xxhPrime2, lane3 = t_seed, lane4 = t_seed - xxhPrime1;
+                for(; t_data + 32 <= end; t_data += 32){
+                    lane1 = xxhRound(lane1, read64(t_data));
+                    lane2 = xxhRound(lane2, read64(t_data + 8));
+                    lane3 = xxhRound(lane3, read64(t_data + 16));
+                    lane4 = xxhRound(lane4, read64(t_data + 24));
+                }
+                hash = rotl64(lane1, 1) + rotl64(lane2, 7) + rotl64(lane3, 12) + rotl64(lane4, 18);
+                hash = xxhMerge(hash, lane1);
+                hash = xxhMerge(hash, lane2);
+                hash = xxhMerge(hash, lane3);
+                hash = xxhMerge(hash, lane4);
+            }
+            else{
+                hash = t_seed + xxhPrime5;
+            }
+            hash += t_size;
+
+            for(; t_data + 8 <= end; t_data += 8){
+                hash = rotl64(hash ^ xxhRound(0, read64(t_data)), 27) * xxhPrime1 + xxhPrime4;
+            }
+            if(t_data + 4 <= end){
+                uint32_t word;
+                std::memcpy(&word, t_data, sizeof(word));
+                hash = rotl64(hash ^ (word * xxhPrime1), 23) * xxhPrime2 + xxhPrime3;
+                t_data += 4;
+            }
+            for(; t_data < end; ++t_data){
+                hash = rotl64(hash ^ (*t_data * xxhPrime5), 11) * xxhPrime1;
+            }
+
+            hash ^= hash >> 33;
+            hash *= xxhPrime2;
+            hash ^= hash >> 29;
+            hash *= xxhPrime3;
+            return hash ^ (hash >> 32);
+        }
         
     } //  namespace Util
 } // namespace Chip8
\ No newline at end of file
@@ -5,16 +5,79 @@
 #ifndef CHIP8_UTIL_HPP
 #define CHIP8_UTIL_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
 #include <sys/stat.h>
 
 #define CHIP8_UTIL_BIT_WIDTH(type) (8 * sizeof(type))
 
+#define CHIP8_UTIL_FNV_OFFSET 0xcbf29ce484222325
+#define CHIP8_UTIL_FNV_PRIME  0x100000001b3
+#define CHIP8_UTIL_MIX_PRIME  0x9fb21c651e98df25
+
 namespace Chip8{
     namespace Util{
 
     extern const char* regFile;
     const char* fileExists(const char* t_filePath);
 
+    // 64 bit FNV-1a, chain calls by passing the previous result as t_hash
+    inline uint64_t fnv1a(const uint8_t* t_data, std::size_t t_size, uint64_t t_hash = CHIP8_UTIL_FNV_OFFSET){
+        for(std::size_t i = 0; i < t_size; ++i){
+            t_hash = (t_hash ^ t_data[i]) * CHIP8_UTIL_FNV_PRIME;
+        }
+        return t_hash;
+    }
+
+    // Eight bytes per step, for hashing kilobytes of state where fnv1a is too slow. Values differ from fnv1a.
+    inline uint64_t wordHash(const uint8_t* t_data, std::size_t t_size, uint64_t t_hash = CHIP8_UTIL_FNV_OFFSET){
+        std::size_t i = 0;
+        for(; i + sizeof(uint64_t) <= t_size; i += sizeof(uint64_t)){
+            uint64_t word;
+            std::memcpy(&word, t_data + i, sizeof(word));
+            t_hash = (t_hash ^ word) * CHIP8_UTIL_MIX_PRIME;
+            t_hash ^= t_hash >> 32;
+        }
+        for(; i < t_size; ++i){
+            t_hash = (t_hash ^ t_data[i]) * CHIP8_UTIL_FNV_PRIME;
+        }
+        return t_hash;
+    }
+
+    // XXH64, reads 32 bytes per round so whole rom libraries hash at memory speed. Values match the reference xxHash.
+    uint64_t xxh64(const uint8_t* t_data, std::size_t t_size, uint64_t t_seed = 0);
+
+    // Raw host order copy of a trivially copyable value, for caches that never leave the machine
+    template<typename T>
+    inline void writeRaw(std::ostream& t_outStream, const T& t_value){
+        t_outStream.write(reinterpret_cast<const char*>(&t_value), sizeof(T));
+    }
+
+    template<typename T>
+    inline void readRaw(std::istream& t_inStream, T& t_value){
+        t_inStream.read(reinterpret_cast<char*>(&t_value), sizeof(T));
+    }
+
+    // Little endian fields of fixed layout formats, t_buffer is advanced past the field
+    template<typename T>
+    inline void putLE(uint8_t*& t_buffer, T t_value){
+        for(std::size_t i = 0; i < sizeof(T); ++i){
+            *t_buffer++ = static_cast<uint8_t>(t_value >> (8 * i));
+        }
+    }
+
+    template<typename T>
+    inline T getLE(const uint8_t*& t_buffer){
+        T value = 0;
+        for(std::size_t i = 0; i < sizeof(T); ++i){
+            value |= static_cast<T>(static_cast<T>(*t_buffer++) << (8 * i));
+        }
+        return value;
+    }
+
     } // namesapce Util
 } // namespace Chip8
 
@@ -0,0 +1,78 @@
+#include "Debugger.hpp"
+
+namespace Chip8{
+
+Debugger::Debugger(Machine& t_machine) : m_machine(t_machine), m_breakpoints(t_machine.memorySize()), m_interrupt(false){
+    if(m_machine.debuggable()){
+        m_machine.attach(&m_breakpoints);
+    }
+}
+
+Debugger::~Debugger(){
+    if(m_machine.debuggable()){
+        m_machine.attach(nullptr);
+    }
+}
+
+Stop Debugger::step(){
+    Stop stop = run(1);
+    if(stop.reason == STOP_BUDGET){
+        stop.reason = STOP_STEP;
+    }
+    return stop;
+}
+
+Stop Debugger::run(uint64_t t_maxTicks, bool t_resuming){
+    Stop stop{STOP_BUDGET, 0, BREAK_EXEC, 0, std::string()};
+    m_breakpoints.clearHit();
+    while(stop.ticks < t_maxTicks){
+        uint16_t pc = m_machine.programCounter();
+        if((stop.ticks || !t_resuming) && m_breakpoints.exec(pc)){
+            stop.reason = STOP_BREAKPOINT;
+            break;
+        }
+        if(m_interrupt.exchange(false, std::memory_order_relaxed)){
+            stop.reason = STOP_INTERRUPT;
+            break;
+        }
+        if(m_machine.halted()){
+            stop.reason = STOP_HALTED;
+            break;
+        }
+        try{
+            m_machine.run_tick();
+        }
+        catch(const std::string& t_error){
+            ++stop.ticks;
+            stop.reason = STOP_FAULT;
+            stop.fault = t_error;
+            break;
+        }
+        ++stop.ticks;
+        if(m_breakpoints.hit()){
+            stop.reason = STOP_WATCH;
+            stop.addr = m_breakpoints.hitAddress();
+            stop.kind = m_breakpoints.hitKind();
+            m_breakpoints.clearHit();
+            return stop;
+        }
+    }
+    stop.addr = m_machine.programCounter();
+    return stop;
+}
+
+Stop Debugger::runTo(uint32_t t_addr, uint64_t t_maxTicks){
+    // A breakpoint the caller set stays in place afterwards
+    bool set = m_breakpoints.watched(BREAK_EXEC, t_addr);
+    m_breakpoints.set(BREAK_EXEC, t_addr);
+    Stop stop = run(t_maxTicks);
+    if(!set){
+        m_breakpoints.clear(BREAK_EXEC, t_addr);
+    }
+    if(stop.reason == STOP_BREAKPOINT && stop.addr == (t_addr & (m_breakpoints.memorySize() - 1)) && !set){
+        stop.reason = STOP_STEP;
+    }
+    return stop;
+}
+
+} // namespace Chip8
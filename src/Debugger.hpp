@@ -0,0 +1,78 @@
+#ifndef CHIP8_DEBUGGER_HPP
+#define CHIP8_DEBUGGER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Breakpoints.hpp"
+#include "Chip8Machine.hpp"
+
+namespace Chip8{
+
+enum StopReason{
+    STOP_STEP,          // step() ran its instruction, or runTo() reached its address
+    STOP_BREAKPOINT,    // the next instruction has an execution breakpoint
+    STOP_WATCH,         // the last instruction touched a watched byte
+    STOP_INTERRUPT,     // interrupt() was called
+    STOP_BUDGET,        // the tick budget ran out
+    STOP_HALTED,        // the program exited with 00FD
+    STOP_FAULT          // the interpreter threw, e.g. on an unknown opcode
+};
+
+struct Stop{
+    StopReason reason;
+    // Program counter for execution stops, the byte touched for STOP_WATCH
+    uint32_t addr;
+    // BREAK_READ or BREAK_WRITE for STOP_WATCH
+    BreakpointKind kind;
+    // Ticks run before the stop
+    uint64_t ticks;
+    // What the interpreter threw, for STOP_FAULT
+    std::string fault;
+};
+
+// Runs a Machine under control: single steps, runs to an address and stops on execution breakpoints and
+// watchpoints. Execution breakpoints are one bit test per tick in this loop, watchpoints need a machine made
+// with makeMachine(..., true) since only those interpreters report their data accesses; on any other machine
+// watchpoints never fire. Machine::run_tick() itself is untouched, so the emulator pays nothing while no
+// debugger is attached.
+class Debugger{
+
+private:
+    Machine& m_machine;
+    Breakpoints m_breakpoints;
+    std::atomic<bool> m_interrupt;
+
+public:
+    explicit Debugger(Machine& t_machine);
+    ~Debugger();
+
+    Debugger(const Debugger&) = delete;
+    Debugger& operator=(const Debugger&) = delete;
+
+    Machine& machine(){
+        return m_machine;
+    }
+
+    Breakpoints& breakpoints(){
+        return m_breakpoints;
+    }
+
+    // Runs one instruction
+    Stop step();
+    // Runs until a breakpoint, watchpoint, interrupt, exit or fault, or for at most t_maxTicks ticks. With
+    // t_resuming set the instruction at the program counter runs even with a breakpoint on it, so a stopped
+    // run resumes; a run that continues one cut short by its budget passes false and stops there at once.
+    Stop run(uint64_t t_maxTicks, bool t_resuming = true);
+    // Runs as run() with a temporary breakpoint at t_addr
+    Stop runTo(uint32_t t_addr, uint64_t t_maxTicks);
+    // Stops a run() in progress at its next tick, safe from other threads and signal handlers
+    void interrupt(){
+        m_interrupt.store(true, std::memory_order_relaxed);
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_DEBUGGER_HPP
@@ -0,0 +1,546 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "GdbStub.hpp"
+#include "LoggerImpl.hpp"
+
+namespace Chip8{
+
+namespace{
+
+// Bytes of register n in the g packet: V0-VF, I, PC, SP, DT, ST
+const std::size_t registerSizes[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 1, 1, 1};
+const std::size_t numRegisters = sizeof(registerSizes) / sizeof(registerSizes[0]);
+
+uint32_t getRegister(const Registers& t_registers, std::size_t t_reg){
+    switch(t_reg){
+        case 16:    return t_registers.i;
+        case 17:    return t_registers.pc;
+        case 18:    return t_registers.sp;
+        case 19:    return t_registers.dt;
+        case 20:    return t_registers.st;
+        default:    return t_registers.v[t_reg];
+    }
+}
+
+void setRegister(Registers& t_registers, std::size_t t_reg, uint32_t t_value){
+    switch(t_reg){
+        case 16:    t_registers.i = static_cast<uint16_t>(t_value); break;
+        case 17:    t_registers.pc = static_cast<uint16_t>(t_value); break;
+        case 18:    t_registers.sp = static_cast<uint8_t>(t_value); break;
+        case 19:    t_registers.dt = static_cast<uint8_t>(t_value); break;
+        case 20:    t_registers.st = static_cast<uint8_t>(t_value); break;
+        default:    t_registers.v[t_reg] = static_cast<uint8_t>(t_value); break;
+    }
+}
+
+const char hexDigits[] = "0123456789abcdef";
+
+int hexValue(char t_digit){
+    if(t_digit >= '0' && t_digit <= '9'){
+        return t_digit - '0';
+    }
+    if(t_digit >= 'a' && t_digit <= 'f'){
+        return t_digit - 'a' + 10;
+    }
+    if(t_digit >= 'A' && t_digit <= 'F'){
+        return t_digit - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendHex(std::string& t_out, uint8_t t_byte){
+    t_out += hexDigits[t_byte >> 4];
+    t_out += hexDigits[t_byte & 0x0f];
+}
+
+// Little endian, as the target description declares
+void appendRegister(std::string& t_out, uint32_t t_value, std::size_t t_size){
+    for(std::size_t byte = 0; byte < t_size; ++byte){
+        appendHex(t_out, static_cast<uint8_t>(t_value >> (8 * byte)));
+    }
+}
+
+bool parseRegister(const std::string& t_hex, std::size_t& t_pos, std::size_t t_size, uint32_t& t_value){
+    t_value = 0;
+    for(std::size_t byte = 0; byte < t_size; ++byte, t_pos += 2){
+        if(t_pos + 2 > t_hex.size() || hexValue(t_hex[t_pos]) < 0 || hexValue(t_hex[t_pos + 1]) < 0){
+            return false;
+        }
+        t_value |= static_cast<uint32_t>(hexValue(t_hex[t_pos]) << 4 | hexValue(t_hex[t_pos + 1])) << (8 * byte);
+    }
+    return true;
+}
+
+// Big endian hex number from t_pos up to the first non hex digit, false when there is none
+bool parseNumber(const std::string& t_text, std::size_t& t_pos, uint32_t& t_value){
+    std::size_t start = t_pos;
+    t_value = 0;
+    while(t_pos < t_text.size() && hexValue(t_text[t_pos]) >= 0){
+        t_value = (t_value << 4) | hexValue(t_text[t_pos++]);
+    }
+    return t_pos > start;
+}
+
+bool expect(const std::string& t_text, std::size_t& t_pos, char t_char){
+    if(t_pos < t_text.size() && t_text[t_pos] == t_char){
+        ++t_pos;
+        return true;
+    }
+    return false;
+}
+
+std::string targetDescription(){
+    static const char* names[] = {"v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9", "va", "vb", "vc", "vd", "ve", "vf", "i", "pc", "sp", "dt", "st"};
+    std::string xml = "<?xml version=\"1.0\"?>\n<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n<target version=\"1.0\">\n  <feature name=\"org.chip8.core\">\n";
+    for(std::size_t reg = 0; reg < numRegisters; ++reg){
+        const char* type = (reg == 17)? "code_ptr" : (reg == 16)? "data_ptr" : "uint8";
+        xml += "    <reg name=\"" + std::string(names[reg]) + "\" bitsize=\"" + std::to_string(8 * registerSizes[reg]) + "\" type=\"" + type + "\"/>\n";
+    }
+    return xml + "  </feature>\n</target>\n";
+}
+
+} // namespace
+
+GdbStub::GdbStub(Debugger& t_debugger, const std::string& t_address) : m_debugger(t_debugger),
+                                                                      m_listenSocket(-1),
+                                                                      m_socket(-1),
+                                                                      m_lastStop("S05"),
+                                                                      m_noAck(false),
+                                                                      m_resumed(false),
+                                                                      m_resuming(false),
+                                                                      m_stepping(false),
+                                                                      m_connected(false){
+    if(t_address.compare(0, 5, "unix:") == 0){
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::string path = t_address.substr(5);
+        if(path.empty() || path.size() >= sizeof(address.sun_path)){
+            throw std::string("GdbStub: bad socket path '" + path + "'");
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        m_listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(m_listenSocket < 0){
+            throw std::string("GdbStub: could not create socket: ") + std::strerror(errno);
+        }
+        ::unlink(path.c_str());
+        if(::bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) || ::listen(m_listenSocket, 1)){
+            std::string error = std::strerror(errno);
+            ::close(m_listenSocket);
+            throw std::string("GdbStub: could not listen on '" + path + "': " + error);
+        }
+        m_unixPath = path;
+        return;
+    }
+
+    std::size_t separator = t_address.rfind(':');
+    std::string host = (separator == std::string::npos || !separator)? "127.0.0.1" : t_address.substr(0, separator);
+    std::string port = (separator == std::string::npos)? t_address : t_address.substr(separator + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* local = nullptr;
+    int error = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &local);
+    if(error){
+        throw std::string("GdbStub: could not resolve '" + t_address + "': " + ::gai_strerror(error));
+    }
+    m_listenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(m_listenSocket < 0){
+        ::freeaddrinfo(local);
+        throw std::string("GdbStub: could not create socket: ") + std::strerror(errno);
+    }
+    // Restarting the emulator must not wait for the old connection to time out
+    int reuse = 1;
+    ::setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int bound = ::bind(m_listenSocket, local->ai_addr, local->ai_addrlen);
+    ::freeaddrinfo(local);
+    if(bound || ::listen(m_listenSocket, 1)){
+        std::string reason = std::strerror(errno);
+        ::close(m_listenSocket);
+        throw std::string("GdbStub: could not listen on '" + t_address + "': " + reason);
+    }
+}
+
+GdbStub::GdbStub(Debugger& t_debugger, int t_socket) : m_debugger(t_debugger),
+                                                       m_listenSocket(-1),
+                                                       m_socket(t_socket),
+                                                       m_lastStop("S05"),
+                                                       m_noAck(false),
+                                                       m_resumed(false),
+                                                       m_resuming(false),
+                                                       m_stepping(false),
+                                                       m_connected(true){
+}
+
+GdbStub::~GdbStub(){
+    close();
+    if(m_listenSocket >= 0){
+        ::close(m_listenSocket);
+    }
+    if(!m_unixPath.empty()){
+        ::unlink(m_unixPath.c_str());
+    }
+}
+
+void GdbStub::close(){
+    if(m_socket >= 0){
+        ::close(m_socket);
+    }
+    m_socket = -1;
+    m_connected = false;
+    m_resumed = false;
+}
+
+void GdbStub::accept(){
+    if(m_listenSocket < 0){
+        throw std::string("GdbStub: not listening");
+    }
+    close();
+    int client;
+    while((client = ::accept(m_listenSocket, nullptr, nullptr)) < 0){
+        if(errno != EINTR){
+            throw std::string("GdbStub: accept failed: ") + std::strerror(errno);
+        }
+    }
+    m_socket = client;
+    m_connected = true;
+    m_noAck = false;
+    m_input.clear();
+    m_lastStop = "S05";
+}
+
+void GdbStub::sendRaw(const std::string& t_bytes){
+    std::size_t sent = 0;
+    while(m_connected && sent < t_bytes.size()){
+        ssize_t written = ::send(m_socket, t_bytes.data() + sent, t_bytes.size() - sent, MSG_NOSIGNAL);
+        if(written < 0 && errno == EINTR){
+            continue;
+        }
+        if(written <= 0){
+            close();
+            return;
+        }
+        sent += written;
+    }
+}
+
+void GdbStub::send(const std::string& t_payload){
+    uint8_t checksum = 0;
+    for(char c : t_payload){
+        checksum += static_cast<uint8_t>(c);
+    }
+    std::string packet = "$" + t_payload + "#";
+    appendHex(packet, checksum);
+    sendRaw(packet);
+}
+
+bool GdbStub::poll(){
+    char buffer[4096];
+    while(m_connected){
+        ssize_t received = ::recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if(received > 0){
+            m_input.append(buffer, received);
+            continue;
+        }
+        if(received < 0 && errno == EINTR){
+            continue;
+        }
+        if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)){
+            close();
+        }
+        break;
+    }
+    // Packets that arrived before a hang up still count, a detach may come with it
+    return handleInput() && m_connected;
+}
+
+bool GdbStub::handleInput(){
+    std::size_t pos = 0;
+    while(pos < m_input.size()){
+        char c = m_input[pos];
+        if(c == 0x03){
+            // Interrupt, the next advance() stops
+            if(m_resumed){
+                m_debugger.interrupt();
+            }
+            ++pos;
+            continue;
+        }
+        if(c != '$'){
+            // Acknowledgements, and noise between packets
+            ++pos;
+            continue;
+        }
+        std::size_t end = m_input.find('#', pos);
+        if(end == std::string::npos || end + 3 > m_input.size()){
+            break;
+        }
+        std::string payload;
+        uint8_t checksum = 0;
+        for(std::size_t ind = pos + 1; ind < end; ++ind){
+            checksum += static_cast<uint8_t>(m_input[ind]);
+            if(m_input[ind] == '}' && ind + 1 < end){
+                checksum += static_cast<uint8_t>(m_input[++ind]);
+                payload += static_cast<char>(m_input[ind] ^ 0x20);
+            }
+            else{
+                payload += m_input[ind];
+            }
+        }
+        int high = hexValue(m_input[end + 1]), low = hexValue(m_input[end + 2]);
+        pos = end + 3;
+        if(!m_noAck && (high < 0 || low < 0 || checksum != (high << 4 | low))){
+            sendRaw("-");
+            continue;
+        }
+        if(!m_noAck){
+            sendRaw("+");
+        }
+        handlePacket(payload);
+        if(!m_connected){
+            break;
+        }
+    }
+    m_input.erase(0, pos);
+    return m_connected;
+}
+
+std::string GdbStub::readRegisters() const{
+    Registers registers = m_debugger.machine().readRegisters();
+    std::string hex;
+    for(std::size_t reg = 0; reg < numRegisters; ++reg){
+        appendRegister(hex, getRegister(registers, reg), registerSizes[reg]);
+    }
+    return hex;
+}
+
+void GdbStub::handlePacket(const std::string& t_packet){
+    Machine& machine = m_debugger.machine();
+    std::size_t pos = 1;
+    uint32_t addr, length, reg, value;
+    switch(t_packet.empty()? 0 : t_packet[0]){
+        case '?':
+            send(m_lastStop);
+            break;
+        case 'g':
+            send(readRegisters());
+            break;
+        case 'G':{
+            Registers registers = machine.readRegisters();
+            for(reg = 0; reg < numRegisters; ++reg){
+                if(!parseRegister(t_packet, pos, registerSizes[reg], value)){
+                    send("E01");
+                    return;
+                }
+                setRegister(registers, reg, value);
+            }
+            machine.writeRegisters(registers);
+            send("OK");
+            break;
+        }
+        case 'p':
+            if(!parseNumber(t_packet, pos, reg) || reg >= numRegisters){
+                send("E01");
+                break;
+            }
+            {
+                std::string hex;
+                appendRegister(hex, getRegister(machine.readRegisters(), reg), registerSizes[reg]);
+                send(hex);
+            }
+            break;
+        case 'P':
+            if(!parseNumber(t_packet, pos, reg) || reg >= numRegisters || !expect(t_packet, pos, '=') || !parseRegister(t_packet, pos, registerSizes[reg], value)){
+                send("E01");
+                break;
+            }
+            {
+                Registers registers = machine.readRegisters();
+                setRegister(registers, reg, value);
+                machine.writeRegisters(registers);
+            }
+            send("OK");
+            break;
+        case 'm':
+            if(!parseNumber(t_packet, pos, addr) || !expect(t_packet, pos, ',') || !parseNumber(t_packet, pos, length)){
+                send("E01");
+                break;
+            }
+            {
+                std::string hex;
+                for(uint32_t offset = 0; offset < length && offset < machine.memorySize(); ++offset){
+                    appendHex(hex, machine.readMemory(addr + offset));
+                }
+                send(hex);
+            }
+            break;
+        case 'M':
+            if(!parseNumber(t_packet, pos, addr) || !expect(t_packet, pos, ',') || !parseNumber(t_packet, pos, length) || !expect(t_packet, pos, ':')
+               || t_packet.size() - pos != 2 * static_cast<std::size_t>(length)){
+                send("E01");
+                break;
+            }
+            for(uint32_t offset = 0; offset < length; ++offset){
+                if(!parseRegister(t_packet, pos, 1, value)){
+                    send("E01");
+                    return;
+                }
+                machine.writeMemory(addr + offset, static_cast<uint8_t>(value));
+            }
+            send("OK");
+            break;
+        case 'c':
+        case 's':
+            // An address resumes from there
+            if(parseNumber(t_packet, pos, addr)){
+                Registers registers = machine.readRegisters();
+                registers.pc = static_cast<uint16_t>(addr);
+                machine.writeRegisters(registers);
+            }
+            m_resumed = true;
+            m_resuming = true;
+            m_stepping = t_packet[0] == 's';
+            break;
+        case 'Z':
+        case 'z':{
+            uint32_t type;
+            if(!parseNumber(t_packet, pos, type) || type > 4 || !expect(t_packet, pos, ',') || !parseNumber(t_packet, pos, addr)
+               || !expect(t_packet, pos, ',') || !parseNumber(t_packet, pos, length)){
+                send("E01");
+                break;
+            }
+            // Z0 and Z1 take the instruction size, watchpoints the bytes watched
+            static const BreakpointKind kinds[] = {BREAK_EXEC, BREAK_EXEC, BREAK_WRITE, BREAK_READ, BREAK_ACCESS};
+            if(type >= 2 && !machine.debuggable()){
+                send("");
+                break;
+            }
+            if(t_packet[0] == 'Z'){
+                m_debugger.breakpoints().set(kinds[type], addr, (type >= 2)? length : 1);
+            }
+            else{
+                m_debugger.breakpoints().clear(kinds[type], addr, (type >= 2)? length : 1);
+            }
+            send("OK");
+            break;
+        }
+        case 'k':
+            close();
+            break;
+        case 'D':
+            // The target runs on without the client
+            send("OK");
+            m_debugger.breakpoints().clearAll();
+            close();
+            break;
+        case 'H':
+        case 'T':
+            send("OK");
+            break;
+        case 'q':
+            if(t_packet.compare(0, 10, "qSupported") == 0){
+                send("PacketSize=4000;qXfer:features:read+;QStartNoAckMode+");
+            }
+            else if(t_packet == "qAttached"){
+                send("1");
+            }
+            else if(t_packet == "qC"){
+                send("QC1");
+            }
+            else if(t_packet == "qfThreadInfo"){
+                send("m1");
+            }
+            else if(t_packet == "qsThreadInfo"){
+                send("l");
+            }
+            else if(t_packet.compare(0, 31, "qXfer:features:read:target.xml:") == 0){
+                pos = 31;
+                if(!parseNumber(t_packet, pos, addr) || !expect(t_packet, pos, ',') || !parseNumber(t_packet, pos, length)){
+                    send("E01");
+                    break;
+                }
+                static const std::string xml = targetDescription();
+                std::string chunk = (addr < xml.size())? xml.substr(addr, length) : std::string();
+                send(((addr + chunk.size() < xml.size())? "m" : "l") + chunk);
+            }
+            else{
+                send("");
+            }
+            break;
+        case 'Q':
+            if(t_packet == "QStartNoAckMode"){
+                send("OK");
+                m_noAck = true;
+            }
+            else{
+                send("");
+            }
+            break;
+        default:
+            send("");
+            break;
+    }
+}
+
+void GdbStub::reportStop(const Stop& t_stop){
+    char reply[32];
+    switch(t_stop.reason){
+        case STOP_WATCH:
+            std::snprintf(reply, sizeof(reply), "T05%s:%x;", (t_stop.kind == BREAK_WRITE)? "watch" : "rwatch", t_stop.addr);
+            break;
+        case STOP_INTERRUPT:
+            std::snprintf(reply, sizeof(reply), "S02");
+            break;
+        case STOP_HALTED:
+            std::snprintf(reply, sizeof(reply), "W00");
+            break;
+        case STOP_FAULT:
+            chip8Logger.log<Logger::LogError>(t_stop.fault, Logger::endl);
+            std::snprintf(reply, sizeof(reply), "S04");
+            break;
+        default:
+            std::snprintf(reply, sizeof(reply), "S05");
+            break;
+    }
+    m_lastStop = reply;
+    m_resumed = false;
+    send(m_lastStop);
+}
+
+uint64_t GdbStub::advance(uint64_t t_maxTicks){
+    if(!m_resumed || !t_maxTicks){
+        return 0;
+    }
+    Stop stop = (m_stepping)? m_debugger.step() : m_debugger.run(t_maxTicks, m_resuming);
+    m_resuming = false;
+    if(stop.reason != STOP_BUDGET){
+        reportStop(stop);
+    }
+    return stop.ticks;
+}
+
+void GdbStub::serve(){
+    while(m_connected){
+        if(m_resumed){
+            advance(CHIP8_GDB_RUN_SLICE);
+        }
+        else{
+            pollfd readable{m_socket, POLLIN, 0};
+            if(::poll(&readable, 1, -1) < 0 && errno != EINTR){
+                close();
+                break;
+            }
+        }
+        poll();
+    }
+}
+
+} // namespace Chip8
@@ -0,0 +1,80 @@
+#ifndef CHIP8_GDB_STUB_HPP
+#define CHIP8_GDB_STUB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Debugger.hpp"
+
+// Ticks a resumed target runs between checks for an interrupt from the client
+#define CHIP8_GDB_RUN_SLICE 4096
+
+namespace Chip8{
+
+// GDB remote serial protocol server for one client, on a local TCP port or a Unix socket. Registers are
+// V0-VF, I, PC, SP, DT and ST in that order, little endian, as described by the target.xml it serves;
+// memory reads and writes wrap at the memory size. Supports ?, g, G, p, P, m, M, c, s, Z0-Z4, z0-z4, k, D,
+// the interrupt character and the queries gdb sends on connecting, anything else gets the empty reply.
+//
+// The stub is driven by its owner: poll() handles whatever the client sent without blocking, and while the
+// client has the target running advance() runs it through the Debugger and reports the stop. serve() does
+// both until the client leaves, for owners with nothing else to do.
+class GdbStub{
+
+private:
+    Debugger& m_debugger;
+    int m_listenSocket;
+    int m_socket;
+    std::string m_unixPath;
+    std::string m_input;
+    std::string m_lastStop;
+    bool m_noAck;
+    bool m_resumed;
+    // Set by c and s until the first advance(), only that one runs over a breakpoint at the program counter
+    bool m_resuming;
+    bool m_stepping;
+    bool m_connected;
+
+    void send(const std::string& t_payload);
+    void sendRaw(const std::string& t_bytes);
+    // Parses complete packets out of m_input, returns false once the client left
+    bool handleInput();
+    void handlePacket(const std::string& t_packet);
+    void reportStop(const Stop& t_stop);
+    std::string readRegisters() const;
+    void close();
+
+public:
+    // Listens on t_address: 'PORT' or 'HOST:PORT' for TCP, HOST defaulting to 127.0.0.1, or 'unix:PATH'.
+    // Throws std::string when the socket cannot be set up.
+    GdbStub(Debugger& t_debugger, const std::string& t_address);
+    // Serves an already connected stream socket, which the stub then owns
+    GdbStub(Debugger& t_debugger, int t_socket);
+    ~GdbStub();
+
+    GdbStub(const GdbStub&) = delete;
+    GdbStub& operator=(const GdbStub&) = delete;
+
+    // Blocks until a client connects, the target stays stopped until it resumes it
+    void accept();
+    // Handles pending packets, returns false once the client detached, killed the target or hung up
+    bool poll();
+    // Whether the client resumed the target and waits for a stop
+    bool resumed() const{
+        return m_resumed;
+    }
+    // Runs a resumed target for at most t_maxTicks ticks and sends the stop reply if it stopped. Returns the
+    // ticks run.
+    uint64_t advance(uint64_t t_maxTicks);
+    // Serves the client until it leaves, running the target flat out while it is resumed
+    void serve();
+
+    bool connected() const{
+        return m_connected;
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_GDB_STUB_HPP
@@ -39,9 +39,14 @@ IniReader::IniReader(const std::string& t_iniFile){
 
     std::size_t currentLine = 0;
     std::string currentHeader = "";
-    char read_buffer[INI_READER_READ_BUFFER_SIZE];
-    for(iniStream.getline(read_buffer, INI_READER_READ_BUFFER_SIZE), currentLine++; iniStream.gcount() > 0; iniStream.getline(read_buffer, INI_READER_READ_BUFFER_SIZE), ++currentLine){
-        char* lineStart = eatWhitespace(read_buffer);
+    // Lines of any length, a list like [Triggers] triggers easily runs past a fixed buffer
+    std::string line;
+    std::vector<char> read_buffer;
+    while(std::getline(iniStream, line)){
+        ++currentLine;
+        read_buffer.assign(line.begin(), line.end());
+        read_buffer.push_back('\0');
+        char* lineStart = eatWhitespace(read_buffer.data());
         int lineLen = strlen(lineStart);
 
         if(*lineStart == ';' || *lineStart == '#')
@@ -118,7 +123,7 @@ bool IniReader::getBool(const std::string& t_header, const std::string& t_key, b
         if(value_it != header_it->second.end()){
             std::string value = value_it->second;
             transform(value.begin(), value.end(), value.begin(), ::tolower);
-            return value.compare("true") || value.compare("1") || value.compare("yes");
+            return !value.compare("true") || !value.compare("1") || !value.compare("yes");
         }
     }
     return t_defaultValue;
@@ -10,10 +10,6 @@
 #define INI_READER_DEFAULT_INI_FILE "conf.ini"
 #endif
 
-#ifndef INI_READER_READ_BUFFER_SIZE
-#define INI_READER_READ_BUFFER_SIZE 256
-#endif
-
 class IniReaderException : public std::exception{
 public:
     enum ExceptionCode{
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "InputScript.hpp"
+
+namespace Chip8{
+
+InputScript::InputScript(const std::string& t_filePath){
+    std::ifstream inStream(t_filePath);
+    if(!inStream.is_open()){
+        throw std::string("InputScript: could not open '" + t_filePath + "'");
+    }
+    parse(inStream);
+}
+
+InputScript::InputScript(std::istream& t_inStream){
+    parse(t_inStream);
+}
+
+void InputScript::parse(std::istream& t_inStream){
+    std::string line;
+    std::size_t lineNumber = 0;
+    while(std::getline(t_inStream, line)){
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        if(line.find_first_not_of(" \t\r") == std::string::npos){
+            continue;
+        }
+
+        std::istringstream lineStream(line);
+        uint64_t cycle;
+        unsigned key;
+        std::string state;
+        if(!(lineStream >> cycle >> std::hex >> key >> state) || key > 0xf || (state != "down" && state != "up")){
+            throw std::string("InputScript: malformed event '" + line + "' on line " + std::to_string(lineNumber));
+        }
+        addEvent(cycle, static_cast<Chip8Key>(key), state == "down");
+    }
+}
+
+void InputScript::addEvent(uint64_t t_cycle, Chip8Key t_key, bool t_pressed){
+    Event event{t_cycle, t_key, t_pressed};
+    auto pos = std::upper_bound(m_events.begin(), m_events.end(), event, [](const Event& t_lhs, const Event& t_rhs){
+        return t_lhs.cycle < t_rhs.cycle;
+    });
+    m_events.insert(pos, event);
+}
+
+} // namespace Chip8
@@ -0,0 +1,59 @@
+#ifndef CHIP8_INPUT_SCRIPT_HPP
+#define CHIP8_INPUT_SCRIPT_HPP
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "Chip8.hpp"
+
+namespace Chip8{
+
+// Scripted key input for headless runs. Text format, one event per line:
+//
+//     <cycle> <key 0-f> <down|up>
+//
+// '#' starts a comment, events are applied before the instruction at <cycle> executes.
+class InputScript{
+
+public:
+    struct Event{
+        uint64_t cycle;
+        Chip8Key key;
+        bool pressed;
+    };
+
+private:
+    std::vector<Event> m_events;
+
+public:
+    InputScript() = default;
+    InputScript(const std::string& t_filePath);
+    InputScript(std::istream& t_inStream);
+
+    void parse(std::istream& t_inStream);
+    void addEvent(uint64_t t_cycle, Chip8Key t_key, bool t_pressed);
+
+    // Applies every event due at or before t_cycle starting from t_position, returns the new position
+    template<typename TChip8>
+    std::size_t apply(TChip8& t_chip8, uint64_t t_cycle, std::size_t t_position) const{
+        while(t_position < m_events.size() && m_events[t_position].cycle <= t_cycle){
+            t_chip8.updateKeystate(m_events[t_position].pressed, false, m_events[t_position].key);
+            ++t_position;
+        }
+        return t_position;
+    }
+
+    const std::vector<Event>& events() const{
+        return m_events;
+    }
+
+    bool empty() const{
+        return m_events.empty();
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_INPUT_SCRIPT_HPP
@@ -58,7 +58,7 @@ namespace Chip8{
         }
 
         std::string getNameFromAction(KeyAction t_keyAction){
-            const std::array<std::string, KEY_EMU_RESET + 1> chip8Actions({"key_ch8_1",
+            const std::array<std::string, KEY_EMU_PROFILE + 1> chip8Actions({"key_ch8_1",
                                                                         "key_ch8_2",
                                                                         "key_ch8_3",
                                                                         "key_ch8_c",
@@ -75,7 +75,10 @@ namespace Chip8{
                                                                         "key_ch8_b",
                                                                         "key_ch8_f",
                                                                         "key_emu_pause",
-                                                                        "key_emu_reset",});
+                                                                        "key_emu_reset",
+                                                                        "key_emu_next_tile",
+                                                                        "key_emu_rewind",
+                                                                        "key_emu_profile",});
             return chip8Actions[t_keyAction];
         }
 
@@ -97,7 +100,10 @@ namespace Chip8{
                                                                             {"key_ch8_e",       KEY_CH8_E},
                                                                             {"key_ch8_f",       KEY_CH8_F},
                                                                             {"key_emu_pause",   KEY_EMU_PAUSE},
-                                                                            {"key_emu_reset",   KEY_EMU_RESET},});
+                                                                            {"key_emu_reset",   KEY_EMU_RESET},
+                                                                            {"key_emu_next_tile", KEY_EMU_NEXT_TILE},
+                                                                            {"key_emu_rewind",  KEY_EMU_REWIND},
+                                                                            {"key_emu_profile", KEY_EMU_PROFILE},});
 
             std::string t_actionNameLower(t_actionName);
             std::transform(t_actionNameLower.begin(), t_actionNameLower.end(), t_actionNameLower.begin(), ::tolower);
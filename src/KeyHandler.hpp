@@ -1,6 +1,7 @@
 #ifndef CHIP8_KEY_HANDLER_HPP
 #define CHIP8_KEY_HANDLER_HPP
 
+#include <array>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -58,6 +59,9 @@ namespace Chip8{
             KEY_CH8_F,
             KEY_EMU_PAUSE,
             KEY_EMU_RESET,
+            KEY_EMU_NEXT_TILE,
+            KEY_EMU_REWIND,
+            KEY_EMU_PROFILE,
         };
 
         std::string getNameFromKmod(uint16_t t_modifiers);
@@ -69,7 +73,7 @@ namespace Chip8{
 
         protected:
             std::unordered_map<KeyPair, KeyAction> m_bindMap;
-            std::array<std::function<void(bool ,bool)>, KEY_EMU_RESET + 1> m_handlerContext;
+            std::array<std::function<void(bool ,bool)>, KEY_EMU_PROFILE + 1> m_handlerContext;
 
         public:
             KeyHandler() : m_bindMap(), m_handlerContext({nullptr}) {};
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "MemorySearch.hpp"
+
+// Kernel helpers never leave this file, passing 256 bit vectors without AVX only costs a spill
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace Chip8{
+
+namespace{
+
+typedef uint8_t U8x32 __attribute__((vector_size(32), may_alias));
+typedef int8_t  M8x32 __attribute__((vector_size(32), may_alias));
+
+namespace Avx2{
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#include "MemorySearchKernel.inl"
+#pragma GCC pop_options
+} // namespace Avx2
+
+namespace Generic{
+#include "MemorySearchKernel.inl"
+} // namespace Generic
+
+const MemorySearchKernel& selectKernel(){
+    return (MemorySearch::hasAvx2())? Avx2::kernel : Generic::kernel;
+}
+
+const struct{
+    const char* name;
+    SearchPredicate predicate;
+} predicateNames[] = {{"equal",         SEARCH_EQUAL},
+                      {"not-equal",     SEARCH_NOT_EQUAL},
+                      {"changed",       SEARCH_CHANGED},
+                      {"unchanged",     SEARCH_UNCHANGED},
+                      {"increased",     SEARCH_INCREASED},
+                      {"decreased",     SEARCH_DECREASED},
+                      {"increased-by",  SEARCH_INCREASED_BY},
+                      {"decreased-by",  SEARCH_DECREASED_BY}};
+
+} // namespace
+
+SearchPredicate getSearchPredicateFromName(const std::string& t_name){
+    for(const auto& predicateName : predicateNames){
+        if(t_name == predicateName.name){
+            return predicateName.predicate;
+        }
+    }
+    throw std::string("MemorySearch: unknown predicate '" + t_name + "'");
+}
+
+bool MemorySearch::hasAvx2(){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+MemorySearch::MemorySearch(std::size_t t_instances, std::size_t t_memorySize) : m_kernel(selectKernel()),
+                                                                                 m_instances(t_instances),
+                                                                                 m_memorySize(t_memorySize){
+    if(!t_memorySize || t_memorySize % CHIP8_SEARCH_BLOCK){
+        throw std::string("MemorySearch: memory size " + std::to_string(t_memorySize) + " is not a multiple of " + std::to_string(CHIP8_SEARCH_BLOCK));
+    }
+    m_snapshots.resize(t_instances * t_memorySize);
+    m_candidates.resize(t_instances * (t_memorySize / CHIP8_SEARCH_BLOCK));
+    m_memory.resize(t_memorySize);
+}
+
+void MemorySearch::start(std::size_t t_instance, const uint8_t* t_memory){
+    std::memcpy(m_snapshots.data() + t_instance * m_memorySize, t_memory, m_memorySize);
+    uint64_t* words = candidateWords(t_instance);
+    std::fill(words, words + m_memorySize / CHIP8_SEARCH_BLOCK, ~uint64_t(0));
+}
+
+void MemorySearch::start(std::size_t t_instance, const Machine& t_machine){
+    t_machine.copyMemory(m_memory.data());
+    start(t_instance, m_memory.data());
+}
+
+std::size_t MemorySearch::narrow(std::size_t t_instance, const uint8_t* t_memory, SearchPredicate t_predicate, uint8_t t_value){
+    return m_kernel.narrow(candidateWords(t_instance), m_snapshots.data() + t_instance * m_memorySize, t_memory, m_memorySize, t_predicate, t_value);
+}
+
+std::size_t MemorySearch::narrow(std::size_t t_instance, const Machine& t_machine, SearchPredicate t_predicate, uint8_t t_value){
+    t_machine.copyMemory(m_memory.data());
+    return narrow(t_instance, m_memory.data(), t_predicate, t_value);
+}
+
+std::size_t MemorySearch::candidates(std::size_t t_instance) const{
+    const uint64_t* words = candidateWords(t_instance);
+    std::size_t count = 0;
+    for(std::size_t word = 0; word < m_memorySize / CHIP8_SEARCH_BLOCK; ++word){
+        count += __builtin_popcountll(words[word]);
+    }
+    return count;
+}
+
+bool MemorySearch::isCandidate(std::size_t t_instance, uint32_t t_addr) const{
+    return t_addr < m_memorySize && (candidateWords(t_instance)[t_addr / CHIP8_SEARCH_BLOCK] >> (t_addr % CHIP8_SEARCH_BLOCK)) & 1;
+}
+
+static void appendAddresses(std::vector<uint32_t>& t_addresses, const uint64_t* t_words, std::size_t t_numWords){
+    for(std::size_t word = 0; word < t_numWords; ++word){
+        for(uint64_t bits = t_words[word]; bits; bits &= bits - 1){
+            t_addresses.push_back(word * CHIP8_SEARCH_BLOCK + __builtin_ctzll(bits));
+        }
+    }
+}
+
+std::vector<uint32_t> MemorySearch::addresses(std::size_t t_instance) const{
+    std::vector<uint32_t> found;
+    appendAddresses(found, candidateWords(t_instance), m_memorySize / CHIP8_SEARCH_BLOCK);
+    return found;
+}
+
+std::vector<uint32_t> MemorySearch::common() const{
+    std::size_t numWords = m_memorySize / CHIP8_SEARCH_BLOCK;
+    std::vector<uint64_t> words(numWords, (m_instances)? ~uint64_t(0) : 0);
+    for(std::size_t instance = 0; instance < m_instances; ++instance){
+        const uint64_t* instanceWords = candidateWords(instance);
+        for(std::size_t word = 0; word < numWords; ++word){
+            words[word] &= instanceWords[word];
+        }
+    }
+    std::vector<uint32_t> found;
+    appendAddresses(found, words.data(), numWords);
+    return found;
+}
+
+uint8_t MemorySearch::value(std::size_t t_instance, uint32_t t_addr) const{
+    return m_snapshots[t_instance * m_memorySize + t_addr % m_memorySize];
+}
+
+void MemoryPins::pin(uint32_t t_addr, uint8_t t_value){
+    auto pinned = std::find_if(m_pins.begin(), m_pins.end(), [t_addr](const Pin& t_pin){ return t_pin.addr == t_addr; });
+    if(pinned != m_pins.end()){
+        pinned->value = t_value;
+    }
+    else{
+        m_pins.push_back(Pin{t_addr, t_value});
+    }
+}
+
+void MemoryPins::unpin(uint32_t t_addr){
+    m_pins.erase(std::remove_if(m_pins.begin(), m_pins.end(), [t_addr](const Pin& t_pin){ return t_pin.addr == t_addr; }), m_pins.end());
+}
+
+// Decimal, or hex after a 0x prefix; a leading zero is no octal prefix
+static unsigned long parseNumber(const char* t_text, char** t_end){
+    bool hex = t_text[0] == '0' && (t_text[1] == 'x' || t_text[1] == 'X');
+    return std::strtoul(t_text, t_end, (hex)? 16 : 10);
+}
+
+void MemoryPins::parse(const std::string& t_pins){
+    std::size_t pos = 0;
+    while((pos = t_pins.find_first_not_of(" \t,", pos)) != std::string::npos){
+        std::size_t end = t_pins.find_first_of(" \t,", pos);
+        std::string pin = t_pins.substr(pos, end - pos);
+        pos = end;
+
+        std::size_t separator = pin.find('=');
+        char* addrEnd = nullptr;
+        char* valueEnd = nullptr;
+        unsigned long addr = (separator == std::string::npos)? 0 : parseNumber(pin.c_str(), &addrEnd);
+        unsigned long value = (separator == std::string::npos)? 0 : parseNumber(pin.c_str() + separator + 1, &valueEnd);
+        if(separator == std::string::npos || addrEnd != pin.c_str() + separator || !separator || valueEnd == pin.c_str() + separator + 1 || *valueEnd
+           || addr > UINT32_MAX || value > 0xff){
+            throw std::string("MemoryPins: expected '<addr>=<value>', got '" + pin + "'");
+        }
+        this->pin(static_cast<uint32_t>(addr), static_cast<uint8_t>(value));
+    }
+}
+
+void MemoryPins::apply(Machine& t_machine) const{
+    for(const Pin& pin : m_pins){
+        t_machine.writeMemory(pin.addr, pin.value);
+    }
+}
+
+} // namespace Chip8
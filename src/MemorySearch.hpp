@@ -0,0 +1,129 @@
+#ifndef CHIP8_MEMORY_SEARCH_HPP
+#define CHIP8_MEMORY_SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Chip8Machine.hpp"
+
+// Addresses per candidate word, memory sizes must be a multiple of it
+#define CHIP8_SEARCH_BLOCK 64
+
+namespace Chip8{
+
+// Test of every candidate address against its value in the last snapshot, t_value is the N of the
+// comparisons taking one
+enum SearchPredicate{
+    SEARCH_EQUAL,           // new == N
+    SEARCH_NOT_EQUAL,       // new != N
+    SEARCH_CHANGED,         // new != old
+    SEARCH_UNCHANGED,       // new == old
+    SEARCH_INCREASED,       // new > old
+    SEARCH_DECREASED,       // new < old
+    SEARCH_INCREASED_BY,    // new == old + N, wrapping at 256
+    SEARCH_DECREASED_BY     // new == old - N, wrapping at 256
+};
+
+// 'equal', 'not-equal', 'changed', 'unchanged', 'increased', 'decreased', 'increased-by', 'decreased-by'
+SearchPredicate getSearchPredicateFromName(const std::string& t_name);
+
+// Vector kernel, built once for AVX2 and once for the baseline ISA and selected at run time
+struct MemorySearchKernel{
+    // Drops the candidates of t_memory failing t_predicate against t_snapshot and copies the blocks of
+    // t_memory that held candidates into t_snapshot. Returns the candidates left.
+    std::size_t (*narrow)(uint64_t* t_candidates, uint8_t* t_snapshot, const uint8_t* t_memory, std::size_t t_size, SearchPredicate t_predicate,
+                          uint8_t t_value);
+};
+
+// Cheat finder over the guest memory of many instances at once. Each instance starts from a snapshot in
+// which every address is a candidate, every narrow() then compares its memory with the previous snapshot
+// and keeps the candidates passing the predicate, e.g. 'decreased by 1' after losing a life. Candidates are
+// bitsets, a word per 64 addresses, and the comparisons run 32 bytes at a time, so a step over 4 KiB costs
+// under a microsecond and a farm sized fleet can be narrowed every frame. common() gives the addresses
+// that are still candidates in every instance.
+class MemorySearch{
+
+private:
+    const MemorySearchKernel& m_kernel;
+    std::size_t m_instances;
+    std::size_t m_memorySize;
+    std::vector<uint8_t> m_snapshots;
+    std::vector<uint64_t> m_candidates;
+    std::vector<uint8_t> m_memory;
+
+    uint64_t* candidateWords(std::size_t t_instance){
+        return m_candidates.data() + t_instance * (m_memorySize / CHIP8_SEARCH_BLOCK);
+    }
+
+    const uint64_t* candidateWords(std::size_t t_instance) const{
+        return m_candidates.data() + t_instance * (m_memorySize / CHIP8_SEARCH_BLOCK);
+    }
+
+public:
+    // Throws std::string unless t_memorySize is a nonzero multiple of CHIP8_SEARCH_BLOCK
+    MemorySearch(std::size_t t_instances, std::size_t t_memorySize);
+
+    std::size_t instances() const{
+        return m_instances;
+    }
+
+    std::size_t memorySize() const{
+        return m_memorySize;
+    }
+
+    // Takes the first snapshot of an instance, every address becomes a candidate
+    void start(std::size_t t_instance, const uint8_t* t_memory);
+    void start(std::size_t t_instance, const Machine& t_machine);
+    // Keeps the candidates passing t_predicate, the memory becomes the snapshot the next step compares
+    // against. Returns the candidates left.
+    std::size_t narrow(std::size_t t_instance, const uint8_t* t_memory, SearchPredicate t_predicate, uint8_t t_value = 0);
+    std::size_t narrow(std::size_t t_instance, const Machine& t_machine, SearchPredicate t_predicate, uint8_t t_value = 0);
+
+    std::size_t candidates(std::size_t t_instance) const;
+    bool isCandidate(std::size_t t_instance, uint32_t t_addr) const;
+    // Candidate addresses in ascending order
+    std::vector<uint32_t> addresses(std::size_t t_instance) const;
+    // Addresses that are candidates in every instance
+    std::vector<uint32_t> common() const;
+    // Value of a candidate address in the last snapshot of an instance, blocks without candidates are no
+    // longer copied
+    uint8_t value(std::size_t t_instance, uint32_t t_addr) const;
+
+    static bool hasAvx2();
+};
+
+// Addresses forced to a value, written into the machine every frame by apply()
+class MemoryPins{
+
+public:
+    struct Pin{
+        uint32_t addr;
+        uint8_t value;
+    };
+
+private:
+    std::vector<Pin> m_pins;
+
+public:
+    // Pins a found address, pinning it again replaces its value
+    void pin(uint32_t t_addr, uint8_t t_value);
+    void unpin(uint32_t t_addr);
+    // Adds pins from a list of '<addr>=<value>' separated by spaces or commas, numbers decimal or 0x
+    // prefixed hex. Throws std::string on anything else.
+    void parse(const std::string& t_pins);
+    void apply(Machine& t_machine) const;
+
+    const std::vector<Pin>& pins() const{
+        return m_pins;
+    }
+
+    bool empty() const{
+        return m_pins.empty();
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_MEMORY_SEARCH_HPP
@@ -0,0 +1,64 @@
+// Vector kernel for Chip8::MemorySearch. This file is included twice by MemorySearch.cpp, once inside a
+// '#pragma GCC target("avx2")' region and once for the baseline ISA, so it must not include anything and
+// must only use the vector types declared there.
+
+static inline U8x32 load32(const uint8_t* t_bytes){
+    U8x32 vector;
+    __builtin_memcpy(&vector, t_bytes, sizeof(vector));
+    return vector;
+}
+
+// Bit i set for every byte i that is all ones, each group of 8 mask bytes is packed by one multiply
+static inline uint64_t packMask(const M8x32& t_mask){
+    U8x32 bits = reinterpret_cast<U8x32>(t_mask) & 1;
+    uint64_t words[4];
+    __builtin_memcpy(words, &bits, sizeof(words));
+    uint64_t packed = 0;
+    for(int word = 0; word < 4; ++word){
+        packed |= ((words[word] * 0x0102040810204080ull) >> 56) << (8 * word);
+    }
+    return packed;
+}
+
+static inline M8x32 test32(const U8x32& t_old, const U8x32& t_new, SearchPredicate t_predicate, uint8_t t_value){
+    switch(t_predicate){
+        case SEARCH_EQUAL:
+            return t_new == t_value;
+        case SEARCH_NOT_EQUAL:
+            return t_new != t_value;
+        case SEARCH_CHANGED:
+            return t_new != t_old;
+        case SEARCH_UNCHANGED:
+            return t_new == t_old;
+        case SEARCH_INCREASED:
+            return t_new > t_old;
+        case SEARCH_DECREASED:
+            return t_new < t_old;
+        case SEARCH_INCREASED_BY:
+            return t_new == static_cast<U8x32>(t_old + t_value);
+        case SEARCH_DECREASED_BY:
+        default:
+            return t_new == static_cast<U8x32>(t_old - t_value);
+    }
+}
+
+static std::size_t narrow(uint64_t* t_candidates, uint8_t* t_snapshot, const uint8_t* t_memory, std::size_t t_size, SearchPredicate t_predicate,
+                          uint8_t t_value){
+    std::size_t left = 0;
+    for(std::size_t block = 0; block < t_size / CHIP8_SEARCH_BLOCK; ++block){
+        uint64_t& candidates = t_candidates[block];
+        // Most blocks run out of candidates after a few steps, their snapshot is not read again
+        if(candidates){
+            const uint8_t* oldBytes = t_snapshot + block * CHIP8_SEARCH_BLOCK;
+            const uint8_t* newBytes = t_memory + block * CHIP8_SEARCH_BLOCK;
+            uint64_t passed = packMask(test32(load32(oldBytes), load32(newBytes), t_predicate, t_value))
+                              | packMask(test32(load32(oldBytes + 32), load32(newBytes + 32), t_predicate, t_value)) << 32;
+            candidates &= passed;
+            left += __builtin_popcountll(candidates);
+            __builtin_memcpy(t_snapshot + block * CHIP8_SEARCH_BLOCK, newBytes, CHIP8_SEARCH_BLOCK);
+        }
+    }
+    return left;
+}
+
+static const MemorySearchKernel kernel = {narrow};
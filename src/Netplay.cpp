@@ -0,0 +1,249 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Chip8Util.hpp"
+#include "Netplay.hpp"
+
+// magic, acknowledged frames, first frame, key state count
+#define CHIP8_NETPLAY_HEADER_SIZE   (4 + 4 + 4 + 1)
+
+namespace Chip8{
+
+UdpLink::UdpLink(uint16_t t_localPort, const std::string& t_peerHost, uint16_t t_peerPort, long t_latencyMsec, unsigned t_lossPercent) : m_socket(-1),
+                                                                                                                                         m_latencyMsec(t_latencyMsec),
+                                                                                                                                         m_lossPercent(t_lossPercent),
+                                                                                                                                         m_loss(t_localPort + 1){
+    m_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if(m_socket < 0){
+        throw std::string("UdpLink: could not create socket: ") + std::strerror(errno);
+    }
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(t_localPort);
+    if(::bind(m_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) || ::fcntl(m_socket, F_SETFL, O_NONBLOCK)){
+        std::string error = std::strerror(errno);
+        ::close(m_socket);
+        throw std::string("UdpLink: could not bind port " + std::to_string(t_localPort) + ": " + error);
+    }
+    if(!t_peerHost.empty()){
+        try{
+            connect(t_peerHost, t_peerPort);
+        }
+        catch(const std::string&){
+            ::close(m_socket);
+            throw;
+        }
+    }
+}
+
+UdpLink::~UdpLink(){
+    ::close(m_socket);
+}
+
+void UdpLink::connect(const std::string& t_peerHost, uint16_t t_peerPort){
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* peer = nullptr;
+    int error = ::getaddrinfo(t_peerHost.c_str(), std::to_string(t_peerPort).c_str(), &hints, &peer);
+    if(error){
+        throw std::string("UdpLink: could not resolve '" + t_peerHost + "': " + ::gai_strerror(error));
+    }
+    // Connected, the socket only takes datagrams from the peer
+    int connected = ::connect(m_socket, peer->ai_addr, peer->ai_addrlen);
+    ::freeaddrinfo(peer);
+    if(connected){
+        throw std::string("UdpLink: could not connect to '" + t_peerHost + "': " + std::strerror(errno));
+    }
+}
+
+void UdpLink::transmit(const std::vector<uint8_t>& t_datagram){
+    // Like the network itself, a refused or full send is a lost datagram
+    if(m_lossPercent && m_loss() % 100 < m_lossPercent){
+        return;
+    }
+    ::send(m_socket, t_datagram.data(), t_datagram.size(), 0);
+}
+
+void UdpLink::send(const std::vector<uint8_t>& t_datagram){
+    if(m_latencyMsec > 0){
+        m_pending.push_back(Pending{std::chrono::steady_clock::now() + std::chrono::milliseconds(m_latencyMsec), t_datagram});
+    }
+    else{
+        transmit(t_datagram);
+    }
+}
+
+bool UdpLink::receive(std::vector<uint8_t>& t_datagram){
+    auto now = std::chrono::steady_clock::now();
+    while(!m_pending.empty() && m_pending.front().due <= now){
+        transmit(m_pending.front().datagram);
+        m_pending.pop_front();
+    }
+
+    t_datagram.resize(CHIP8_NETPLAY_MAX_PACKET);
+    ssize_t size = ::recv(m_socket, t_datagram.data(), t_datagram.size(), 0);
+    if(size < 0){
+        t_datagram.clear();
+        return false;
+    }
+    t_datagram.resize(size);
+    return true;
+}
+
+uint16_t UdpLink::localPort() const{
+    sockaddr_in local{};
+    socklen_t size = sizeof(local);
+    ::getsockname(m_socket, reinterpret_cast<sockaddr*>(&local), &size);
+    return ntohs(local.sin_port);
+}
+
+NetplaySession::NetplaySession(Machine& t_machine, UdpLink& t_link, long t_ticksPerFrame) : m_machine(t_machine),
+                                                                                             m_link(t_link),
+                                                                                             m_ticksPerFrame(t_ticksPerFrame),
+                                                                                             m_frame(0),
+                                                                                             m_remoteAck(0),
+                                                                                             m_predicted(CHIP8_NETPLAY_MAX_ROLLBACK + 1),
+                                                                                             m_states(CHIP8_NETPLAY_MAX_ROLLBACK + 1, std::vector<uint8_t>(t_machine.stateSize())),
+                                                                                             m_faultFrame(0),
+                                                                                             m_stats(){
+}
+
+uint16_t NetplaySession::remoteInput(uint64_t t_frame) const{
+    // Players mostly hold a key for many frames, the last known state is the best guess
+    if(t_frame < m_remoteInputs.size()){
+        return m_remoteInputs[t_frame];
+    }
+    return (m_remoteInputs.empty())? 0 : m_remoteInputs.back();
+}
+
+void NetplaySession::runFrame(uint64_t t_frame){
+    uint16_t remote = remoteInput(t_frame);
+    m_predicted[t_frame % m_predicted.size()] = remote;
+    if(!m_fault.empty()){
+        return;
+    }
+    m_machine.setKeystates(m_localInputs[t_frame] | remote);
+    try{
+        for(long tick = 0; tick < m_ticksPerFrame; ++tick){
+            m_machine.run_tick();
+        }
+    }
+    catch(const std::string& error){
+        m_fault = error;
+        m_faultFrame = t_frame;
+    }
+}
+
+void NetplaySession::sendInputs(){
+    uint64_t first = std::min<uint64_t>(m_remoteAck, m_localInputs.size());
+    std::size_t count = std::min<std::size_t>({m_localInputs.size() - first, 0xff, (CHIP8_NETPLAY_MAX_PACKET - CHIP8_NETPLAY_HEADER_SIZE) / 2});
+    m_datagram.resize(CHIP8_NETPLAY_HEADER_SIZE + 2 * count);
+    uint8_t* out = m_datagram.data();
+    Util::putLE<uint32_t>(out, CHIP8_NETPLAY_MAGIC);
+    Util::putLE<uint32_t>(out, m_remoteInputs.size());
+    Util::putLE<uint32_t>(out, first);
+    Util::putLE<uint8_t>(out, count);
+    for(std::size_t index = 0; index < count; ++index){
+        Util::putLE<uint16_t>(out, m_localInputs[first + index]);
+    }
+    m_link.send(m_datagram);
+    ++m_stats.datagramsSent;
+}
+
+uint64_t NetplaySession::receiveInputs(){
+    uint64_t confirmed = m_remoteInputs.size();
+    while(m_link.receive(m_datagram)){
+        const uint8_t* in = m_datagram.data();
+        if(m_datagram.size() < CHIP8_NETPLAY_HEADER_SIZE || Util::getLE<uint32_t>(in) != CHIP8_NETPLAY_MAGIC){
+            continue;
+        }
+        uint64_t ack = Util::getLE<uint32_t>(in);
+        uint64_t first = Util::getLE<uint32_t>(in);
+        std::size_t count = Util::getLE<uint8_t>(in);
+        if(m_datagram.size() != CHIP8_NETPLAY_HEADER_SIZE + 2 * count){
+            continue;
+        }
+        ++m_stats.datagramsReceived;
+        m_remoteAck = std::max(m_remoteAck, std::min<uint64_t>(ack, m_localInputs.size()));
+
+        // Datagrams arrive out of order or twice, only the part continuing the known inputs is new
+        in += 2 * std::min<uint64_t>(count, m_remoteInputs.size() - std::min<uint64_t>(first, m_remoteInputs.size()));
+        for(uint64_t frame = m_remoteInputs.size(); first <= frame && frame < first + count; ++frame){
+            m_remoteInputs.push_back(Util::getLE<uint16_t>(in));
+        }
+    }
+
+    for(uint64_t frame = confirmed; frame < std::min<uint64_t>(m_frame, m_remoteInputs.size()); ++frame){
+        if(m_predicted[frame % m_predicted.size()] != m_remoteInputs[frame]){
+            return frame;
+        }
+    }
+    return m_frame;
+}
+
+void NetplaySession::rollback(uint64_t t_frame){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t>& saved = m_states[t_frame % m_states.size()];
+    m_machine.loadState(saved.data(), saved.size());
+    if(!m_fault.empty() && m_faultFrame >= t_frame){
+        m_fault.clear();
+    }
+    for(uint64_t frame = t_frame; frame < m_frame; ++frame){
+        if(frame != t_frame){
+            std::vector<uint8_t>& state = m_states[frame % m_states.size()];
+            m_machine.saveState(state.data(), state.size());
+        }
+        runFrame(frame);
+    }
+
+    uint64_t usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    ++m_stats.rollbacks;
+    m_stats.resimulatedFrames += m_frame - t_frame;
+    m_stats.resimulationUsec += usec;
+    m_stats.maxResimulationUsec = std::max(m_stats.maxResimulationUsec, usec);
+}
+
+bool NetplaySession::advanceFrame(uint16_t t_keystates){
+    uint64_t mispredicted = receiveInputs();
+    if(mispredicted < m_frame){
+        rollback(mispredicted);
+    }
+    // Further ahead, the frame to roll back to would no longer be kept
+    if(m_frame >= m_remoteInputs.size() + CHIP8_NETPLAY_MAX_ROLLBACK){
+        ++m_stats.stalls;
+        sendInputs();
+        return false;
+    }
+
+    m_localInputs.push_back(t_keystates);
+    std::vector<uint8_t>& state = m_states[m_frame % m_states.size()];
+    m_machine.saveState(state.data(), state.size());
+    runFrame(m_frame);
+    ++m_frame;
+    ++m_stats.frames;
+    sendInputs();
+    return true;
+}
+
+void NetplaySession::poll(){
+    uint64_t mispredicted = receiveInputs();
+    if(mispredicted < m_frame){
+        rollback(mispredicted);
+    }
+    sendInputs();
+}
+
+std::string NetplaySession::fault() const{
+    return (!m_fault.empty() && m_faultFrame < confirmedFrames())? m_fault : "";
+}
+
+} // namespace Chip8
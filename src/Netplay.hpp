@@ -0,0 +1,134 @@
+#ifndef CHIP8_NETPLAY_HPP
+#define CHIP8_NETPLAY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Chip8Machine.hpp"
+
+#define CHIP8_NETPLAY_MAGIC         0x504e3843
+// Frames a peer runs ahead of the last input it has from the other one, 200 ms at 60 Hz
+#define CHIP8_NETPLAY_MAX_ROLLBACK  12
+#define CHIP8_NETPLAY_MAX_PACKET    512
+
+namespace Chip8{
+
+// Non-blocking UDP socket talking to one peer. Outgoing datagrams can be delayed by t_latencyMsec and dropped
+// with probability t_lossPercent, to try a session over 127.0.0.1 under the conditions of a real link.
+// Throws std::string when the socket cannot be set up.
+class UdpLink{
+
+private:
+    struct Pending{
+        std::chrono::steady_clock::time_point due;
+        std::vector<uint8_t> datagram;
+    };
+
+    int m_socket;
+    long m_latencyMsec;
+    unsigned m_lossPercent;
+    std::minstd_rand m_loss;
+    std::deque<Pending> m_pending;
+
+    void transmit(const std::vector<uint8_t>& t_datagram);
+
+public:
+    // Binds t_localPort on every interface, 0 picks a free port, and sends to t_peerHost:t_peerPort
+    UdpLink(uint16_t t_localPort, const std::string& t_peerHost, uint16_t t_peerPort, long t_latencyMsec = 0, unsigned t_lossPercent = 0);
+    UdpLink(const UdpLink&) = delete;
+    UdpLink& operator=(const UdpLink&) = delete;
+    ~UdpLink();
+
+    // Reaims the link, for peers that only learn each other's port once both are bound
+    void connect(const std::string& t_peerHost, uint16_t t_peerPort);
+    void send(const std::vector<uint8_t>& t_datagram);
+    // Next datagram from the peer into t_datagram, false when none is waiting. Also sends delayed datagrams that are due.
+    bool receive(std::vector<uint8_t>& t_datagram);
+    uint16_t localPort() const;
+};
+
+// Two player session over a UdpLink. Each peer runs its own machine, loaded with the same rom, variant and
+// seed, and the peers only exchange their key state once per frame; the machine sees the two key states
+// ORed, so each player keeps to their own keys. Frames run at once with the last key state known from the
+// other peer. When its real key state for a frame arrives and differs, the session loads the state saved
+// before that frame and runs the frames since again, all within the frame it arrived in.
+//
+// Each datagram repeats every key state the other peer has not acknowledged yet, so lost datagrams cost
+// nothing but a later correction. A peer more than CHIP8_NETPLAY_MAX_ROLLBACK frames ahead of the inputs it
+// has waits for the other one.
+class NetplaySession{
+
+public:
+    struct Stats{
+        uint64_t frames;
+        // Frames that waited for the other peer
+        uint64_t stalls;
+        uint64_t rollbacks;
+        uint64_t resimulatedFrames;
+        uint64_t resimulationUsec;
+        uint64_t maxResimulationUsec;
+        uint64_t datagramsSent;
+        uint64_t datagramsReceived;
+    };
+
+private:
+    Machine& m_machine;
+    UdpLink& m_link;
+    long m_ticksPerFrame;
+
+    // Next frame to run, key states per frame from either peer
+    uint64_t m_frame;
+    std::vector<uint16_t> m_localInputs;
+    std::vector<uint16_t> m_remoteInputs;
+    // Frames of local input the other peer has
+    uint64_t m_remoteAck;
+    // Remote key state each unconfirmed frame ran with, and the machine before each of the last frames
+    std::vector<uint16_t> m_predicted;
+    std::vector<std::vector<uint8_t>> m_states;
+    std::string m_fault;
+    uint64_t m_faultFrame;
+    Stats m_stats;
+    std::vector<uint8_t> m_datagram;
+
+    uint16_t remoteInput(uint64_t t_frame) const;
+    void runFrame(uint64_t t_frame);
+    void sendInputs();
+    // Takes in waiting datagrams, returns the first frame that ran with a wrong guess or m_frame if none did
+    uint64_t receiveInputs();
+    void rollback(uint64_t t_frame);
+
+public:
+    // t_machine is loaded, and booted if at all, the same way as the other peer's
+    NetplaySession(Machine& t_machine, UdpLink& t_link, long t_ticksPerFrame);
+
+    // Runs one frame with t_keystates held locally. False when it waited for the other peer instead.
+    bool advanceFrame(uint16_t t_keystates);
+    // Exchanges inputs and corrects past frames without running a new one
+    void poll();
+
+    uint64_t frame() const{
+        return m_frame;
+    }
+
+    // Frames whose inputs from both peers are known, the timeline up to there is final
+    uint64_t confirmedFrames() const{
+        return std::min<uint64_t>(m_frame, m_remoteInputs.size());
+    }
+
+    // Fault of a confirmed frame, empty if none. Faults in frames that ran on a guess may still go away.
+    std::string fault() const;
+
+    const Stats& stats() const{
+        return m_stats;
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_NETPLAY_HPP
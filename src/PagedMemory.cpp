@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "PagedMemory.hpp"
+
+namespace Chip8{
+
+namespace{
+
+// Font sprites, read only and shared by every instance
+const std::array<uint8_t, CHIP8_SPRITE_TABLE_SIZE> spriteTable = {0xF0, 0x90, 0x90, 0x90, 0xF0, /* 0 */
+                                                                  0x20, 0x60, 0x20, 0x20, 0x70, /* 1 */
+                                                                  0xF0, 0x10, 0xF0, 0x80, 0xF0, /* 2 */
+                                                                  0xF0, 0x10, 0xF0, 0x10, 0xF0, /* 3 */
+                                                                  0x90, 0x90, 0xF0, 0x10, 0x10, /* 4 */
+                                                                  0xF0, 0x80, 0xF0, 0x10, 0xF0, /* 5 */
+                                                                  0xF0, 0x80, 0xF0, 0x90, 0xF0, /* 6 */
+                                                                  0xF0, 0x10, 0x20, 0x40, 0x40, /* 7 */
+                                                                  0xF0, 0x90, 0xF0, 0x90, 0xF0, /* 8 */
+                                                                  0xF0, 0x90, 0xF0, 0x10, 0xF0, /* 9 */
+                                                                  0xF0, 0x90, 0xF0, 0x90, 0x90, /* A */
+                                                                  0xE0, 0x90, 0xE0, 0x90, 0xE0, /* B */
+                                                                  0xF0, 0x80, 0x80, 0x80, 0xF0, /* C */
+                                                                  0xE0, 0x90, 0x90, 0x90, 0xE0, /* E */
+                                                                  0xF0, 0x80, 0xF0, 0x80, 0x80, /* F */ };
+
+} // namespace
+
+PagedMemory::PagedMemory() : PagedMemory(blankImage()){
+}
+
+PagedMemory::PagedMemory(std::shared_ptr<const MemoryImage> t_image) : m_dirty(0){
+    reset(std::move(t_image));
+}
+
+PagedMemory::PagedMemory(const PagedMemory& t_other) : m_image(t_other.m_image), m_dirty(0){
+    *this = t_other;
+}
+
+PagedMemory& PagedMemory::operator=(const PagedMemory& t_other){
+    if(this == &t_other){
+        return *this;
+    }
+
+    // Only diverged pages are copied, the image stays shared
+    m_image = t_other.m_image;
+    m_dirty = t_other.m_dirty;
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        if((m_dirty >> page) & 0x01){
+            if(!m_private[page]){
+                m_private[page].reset(new MemoryPage);
+            }
+            *m_private[page] = *t_other.m_private[page];
+            m_pages[page] = m_private[page]->data();
+        }
+        else{
+            m_pages[page] = m_image->data() + (page << CHIP8_PAGE_SHIFT);
+        }
+    }
+    return *this;
+}
+
+void PagedMemory::reset(){
+    m_dirty = 0;
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        m_pages[page] = m_image->data() + (page << CHIP8_PAGE_SHIFT);
+    }
+}
+
+void PagedMemory::reset(std::shared_ptr<const MemoryImage> t_image){
+    m_image = std::move(t_image);
+    reset();
+}
+
+void PagedMemory::assign(const uint8_t* t_data){
+    for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+        const uint8_t* source = t_data + (page << CHIP8_PAGE_SHIFT);
+        const uint8_t* shared = m_image->data() + (page << CHIP8_PAGE_SHIFT);
+        if(std::equal(source, source + CHIP8_PAGE_SIZE, shared)){
+            m_pages[page] = shared;
+            m_dirty &= ~(0x01 << page);
+        }
+        else{
+            if(!m_private[page]){
+                m_private[page].reset(new MemoryPage);
+            }
+            std::copy(source, source + CHIP8_PAGE_SIZE, m_private[page]->begin());
+            m_pages[page] = m_private[page]->data();
+            m_dirty |= 0x01 << page;
+        }
+    }
+}
+
+uint8_t* PagedMemory::writablePage(std::size_t t_page){
+    if(!((m_dirty >> t_page) & 0x01)){
+        if(!m_private[t_page]){
+            m_private[t_page].reset(new MemoryPage);
+        }
+        std::copy(m_pages[t_page], m_pages[t_page] + CHIP8_PAGE_SIZE, m_private[t_page]->begin());
+        m_pages[t_page] = m_private[t_page]->data();
+        m_dirty |= 0x01 << t_page;
+    }
+    return m_private[t_page]->data();
+}
+
+std::size_t PagedMemory::privatePages() const{
+    return __builtin_popcount(m_dirty);
+}
+
+std::size_t PagedMemory::privateBytes() const{
+    return CHIP8_PAGE_SIZE * std::count_if(m_private.begin(), m_private.end(), [](const std::unique_ptr<MemoryPage>& t_page){
+        return static_cast<bool>(t_page);
+    });
+}
+
+const std::shared_ptr<const MemoryImage>& PagedMemory::blankImage(){
+    static const std::shared_ptr<const MemoryImage> blank = makeImage(nullptr, 0);
+    return blank;
+}
+
+std::shared_ptr<const MemoryImage> PagedMemory::makeImage(const uint8_t* t_rom, std::size_t t_size){
+    std::shared_ptr<MemoryImage> image = std::make_shared<MemoryImage>();
+    std::copy(spriteTable.begin(), spriteTable.end(), image->begin());
+    std::fill(image->begin() + CHIP8_SPRITE_TABLE_SIZE, image->end(), 0);
+    std::copy(t_rom, t_rom + std::min<std::size_t>(t_size, CHIP8_MAIN_MEM_SIZE - CHIP8_PROG_START_OFFSET), image->begin() + CHIP8_PROG_START_OFFSET);
+    return image;
+}
+
+} // namespace Chip8
@@ -0,0 +1,217 @@
+#ifndef CHIP8_PAGED_MEMORY_HPP
+#define CHIP8_PAGED_MEMORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+
+#define CHIP8_SPRITE_TABLE_SIZE   0x0050
+#define CHIP8_MAIN_MEM_SIZE       0x1000
+#define CHIP8_PROG_START_OFFSET   0x0200
+
+#define CHIP8_PAGE_SHIFT          8
+#define CHIP8_PAGE_SIZE           (1 << CHIP8_PAGE_SHIFT)
+#define CHIP8_NUM_PAGES           (CHIP8_MAIN_MEM_SIZE >> CHIP8_PAGE_SHIFT)
+
+namespace Chip8{
+
+typedef std::array<uint8_t, CHIP8_MAIN_MEM_SIZE> MemoryImage;
+typedef std::array<uint8_t, CHIP8_PAGE_SIZE> MemoryPage;
+
+// Guest memory as CHIP8_NUM_PAGES pages that read through to a shared, read only image until first
+// written, only then is the page copied into a private buffer. Buffers are kept across resets so a
+// reused instance does not allocate again. Addresses wrap at CHIP8_MAIN_MEM_SIZE.
+class PagedMemory{
+
+private:
+    template<typename TMemory, typename TRef>
+    class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t, std::ptrdiff_t, void, TRef>{
+
+    private:
+        TMemory* m_memory;
+        std::ptrdiff_t m_index;
+
+    public:
+        Iterator(TMemory* t_memory = nullptr, std::ptrdiff_t t_index = 0) : m_memory(t_memory), m_index(t_index){}
+
+        TRef operator*() const{
+            return (*m_memory)[m_index];
+        }
+
+        TRef operator[](std::ptrdiff_t t_offset) const{
+            return (*m_memory)[m_index + t_offset];
+        }
+
+        Iterator& operator++(){
+            ++m_index;
+            return *this;
+        }
+
+        Iterator operator++(int){
+            Iterator prev(*this);
+            ++m_index;
+            return prev;
+        }
+
+        Iterator& operator--(){
+            --m_index;
+            return *this;
+        }
+
+        Iterator operator--(int){
+            Iterator prev(*this);
+            --m_index;
+            return prev;
+        }
+
+        Iterator& operator+=(std::ptrdiff_t t_offset){
+            m_index += t_offset;
+            return *this;
+        }
+
+        Iterator& operator-=(std::ptrdiff_t t_offset){
+            m_index -= t_offset;
+            return *this;
+        }
+
+        Iterator operator+(std::ptrdiff_t t_offset) const{
+            return Iterator(m_memory, m_index + t_offset);
+        }
+
+        friend Iterator operator+(std::ptrdiff_t t_offset, const Iterator& t_it){
+            return t_it + t_offset;
+        }
+
+        Iterator operator-(std::ptrdiff_t t_offset) const{
+            return Iterator(m_memory, m_index - t_offset);
+        }
+
+        std::ptrdiff_t operator-(const Iterator& t_other) const{
+            return m_index - t_other.m_index;
+        }
+
+        bool operator==(const Iterator& t_other) const{
+            return m_index == t_other.m_index;
+        }
+
+        bool operator!=(const Iterator& t_other) const{
+            return m_index != t_other.m_index;
+        }
+
+        bool operator<(const Iterator& t_other) const{
+            return m_index < t_other.m_index;
+        }
+
+        bool operator>(const Iterator& t_other) const{
+            return m_index > t_other.m_index;
+        }
+
+        bool operator<=(const Iterator& t_other) const{
+            return m_index <= t_other.m_index;
+        }
+
+        bool operator>=(const Iterator& t_other) const{
+            return m_index >= t_other.m_index;
+        }
+    };
+
+    std::array<const uint8_t*, CHIP8_NUM_PAGES> m_pages;
+    std::shared_ptr<const MemoryImage> m_image;
+    std::array<std::unique_ptr<MemoryPage>, CHIP8_NUM_PAGES> m_private;
+    // Bit per page, set while the page reads from its private buffer
+    uint16_t m_dirty;
+
+    uint8_t* writablePage(std::size_t t_page);
+
+public:
+    typedef Iterator<PagedMemory, uint8_t&> iterator;
+    typedef Iterator<const PagedMemory, const uint8_t&> const_iterator;
+
+    PagedMemory();
+    explicit PagedMemory(std::shared_ptr<const MemoryImage> t_image);
+    PagedMemory(const PagedMemory& t_other);
+    PagedMemory(PagedMemory&& t_other) = default;
+
+    PagedMemory& operator=(const PagedMemory& t_other);
+    PagedMemory& operator=(PagedMemory&& t_other) = default;
+
+    // Drops every private page, memory reads the image again
+    void reset();
+    void reset(std::shared_ptr<const MemoryImage> t_image);
+    // Overwrites all memory with CHIP8_MAIN_MEM_SIZE bytes from t_data. Pages equal to the image read through to it
+    // again, the rest go to private buffers, so only a page that never had a buffer allocates.
+    void assign(const uint8_t* t_data);
+
+    uint8_t read(uint16_t t_addr) const{
+        t_addr &= CHIP8_MAIN_MEM_SIZE - 1;
+        return m_pages[t_addr >> CHIP8_PAGE_SHIFT][t_addr & (CHIP8_PAGE_SIZE - 1)];
+    }
+
+    void write(uint16_t t_addr, uint8_t t_value){
+        t_addr &= CHIP8_MAIN_MEM_SIZE - 1;
+        writablePage(t_addr >> CHIP8_PAGE_SHIFT)[t_addr & (CHIP8_PAGE_SIZE - 1)] = t_value;
+    }
+
+    const uint8_t& operator[](std::size_t t_addr) const{
+        t_addr &= CHIP8_MAIN_MEM_SIZE - 1;
+        return m_pages[t_addr >> CHIP8_PAGE_SHIFT][t_addr & (CHIP8_PAGE_SIZE - 1)];
+    }
+
+    // Non const access has to assume a write and copies the page
+    uint8_t& operator[](std::size_t t_addr){
+        t_addr &= CHIP8_MAIN_MEM_SIZE - 1;
+        return writablePage(t_addr >> CHIP8_PAGE_SHIFT)[t_addr & (CHIP8_PAGE_SIZE - 1)];
+    }
+
+    const uint8_t* page(std::size_t t_page) const{
+        return m_pages[t_page];
+    }
+
+    const std::shared_ptr<const MemoryImage>& image() const{
+        return m_image;
+    }
+
+    // Pages currently diverged from the image
+    std::size_t privatePages() const;
+    // Bytes held by private page buffers, including buffers kept for reuse
+    std::size_t privateBytes() const;
+
+    iterator begin(){
+        return iterator(this, 0);
+    }
+
+    iterator end(){
+        return iterator(this, CHIP8_MAIN_MEM_SIZE);
+    }
+
+    const_iterator begin() const{
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const{
+        return const_iterator(this, CHIP8_MAIN_MEM_SIZE);
+    }
+
+    const_iterator cbegin() const{
+        return begin();
+    }
+
+    const_iterator cend() const{
+        return end();
+    }
+
+    constexpr std::size_t size() const{
+        return CHIP8_MAIN_MEM_SIZE;
+    }
+
+    // Font sprites followed by zeroed memory, shared by every instance
+    static const std::shared_ptr<const MemoryImage>& blankImage();
+    // Blank image with t_rom copied to CHIP8_PROG_START_OFFSET, build once per rom and share it
+    static std::shared_ptr<const MemoryImage> makeImage(const uint8_t* t_rom, std::size_t t_size);
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_PAGED_MEMORY_HPP
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Profiler.hpp"
+
+// Timer reads back to back when measuring what reading the timer costs
+#define CHIP8_PROFILE_CALIBRATION_ROUNDS 256
+
+namespace Chip8{
+
+static const char* const opcodeClassNames[OP_NUM_CLASSES] = {
+    "SYS", "CLS", "RET", "SCD", "SCU", "SCR", "SCL", "EXIT", "LOW", "HIGH", "JP", "CALL", "SE_IMM", "SNE_IMM",
+    "SE_REG", "SAVE_RANGE", "LOAD_RANGE", "LD_IMM", "ADD_IMM", "LD_REG", "OR", "AND", "XOR", "ADD_REG", "SUB",
+    "SHR", "SUBN", "SHL", "SNE_REG", "LD_I", "JP_V0", "RND", "DRW", "SKP", "SKNP", "LD_I_LONG", "PLANE", "AUDIO",
+    "LD_VX_DT", "LD_KEY", "LD_DT", "LD_ST", "ADD_I", "LD_FONT", "LD_HIFONT", "LD_BCD", "PITCH", "LD_MEM",
+    "LD_REGS", "SAVE_FLAGS", "LOAD_FLAGS", "UNKNOWN"
+};
+
+OpcodeClass opcodeClass(uint16_t t_op){
+    const uint8_t n = t_op & 0x000f;
+    const uint8_t kk = t_op & 0x00ff;
+    switch(t_op >> 12){
+        case 0x0:
+            if((t_op & 0xfff0) == 0x00c0){
+                return OP_SCD;
+            }
+            if((t_op & 0xfff0) == 0x00d0){
+                return OP_SCU;
+            }
+            switch(t_op){
+                case 0x00e0:
+                    return OP_CLS;
+                case 0x00ee:
+                    return OP_RET;
+                case 0x00fb:
+                    return OP_SCR;
+                case 0x00fc:
+                    return OP_SCL;
+                case 0x00fd:
+                    return OP_EXIT;
+                case 0x00fe:
+                    return OP_LOW;
+                case 0x00ff:
+                    return OP_HIGH;
+                default:
+                    return OP_SYS;
+            }
+        case 0x1:
+            return OP_JP;
+        case 0x2:
+            return OP_CALL;
+        case 0x3:
+            return OP_SE_IMM;
+        case 0x4:
+            return OP_SNE_IMM;
+        case 0x5:
+            return (n == 0)? OP_SE_REG : (n == 2)? OP_SAVE_RANGE : (n == 3)? OP_LOAD_RANGE : OP_UNKNOWN;
+        case 0x6:
+            return OP_LD_IMM;
+        case 0x7:
+            return OP_ADD_IMM;
+        case 0x8:
+            switch(n){
+                case 0x0:
+                    return OP_LD_REG;
+                case 0x1:
+                    return OP_OR;
+                case 0x2:
+                    return OP_AND;
+                case 0x3:
+                    return OP_XOR;
+                case 0x4:
+                    return OP_ADD_REG;
+                case 0x5:
+                    return OP_SUB;
+                case 0x6:
+                    return OP_SHR;
+                case 0x7:
+                    return OP_SUBN;
+                case 0xe:
+                    return OP_SHL;
+                default:
+                    return OP_UNKNOWN;
+            }
+        case 0x9:
+            return (n == 0)? OP_SNE_REG : OP_UNKNOWN;
+        case 0xa:
+            return OP_LD_I;
+        case 0xb:
+            return OP_JP_V0;
+        case 0xc:
+            return OP_RND;
+        case 0xd:
+            return OP_DRW;
+        case 0xe:
+            return (kk == 0x9e)? OP_SKP : (kk == 0xa1)? OP_SKNP : OP_UNKNOWN;
+        default:
+            if(t_op == 0xf000){
+                return OP_LD_I_LONG;
+            }
+            if(t_op == 0xf002){
+                return OP_AUDIO;
+            }
+            switch(kk){
+                case 0x01:
+                    return OP_PLANE;
+                case 0x07:
+                    return OP_LD_VX_DT;
+                case 0x0a:
+                    return OP_LD_KEY;
+                case 0x15:
+                    return OP_LD_DT;
+                case 0x18:
+                    return OP_LD_ST;
+                case 0x1e:
+                    return OP_ADD_I;
+                case 0x29:
+                    return OP_LD_FONT;
+                case 0x30:
+                    return OP_LD_HIFONT;
+                case 0x33:
+                    return OP_LD_BCD;
+                case 0x3a:
+                    return OP_PITCH;
+                case 0x55:
+                    return OP_LD_MEM;
+                case 0x65:
+                    return OP_LD_REGS;
+                case 0x75:
+                    return OP_SAVE_FLAGS;
+                case 0x85:
+                    return OP_LOAD_FLAGS;
+                default:
+                    return OP_UNKNOWN;
+            }
+    }
+}
+
+const char* opcodeClassName(OpcodeClass t_class){
+    return (t_class < OP_NUM_CLASSES)? opcodeClassNames[t_class] : "?";
+}
+
+uint64_t Profiler::timestamp(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+Profiler::Profiler(uint64_t t_samplePeriod) : m_samplePeriod(t_samplePeriod), m_jitter(0x9e3779b97f4a7c15), m_overhead(0){
+    clear();
+    if(m_samplePeriod){
+        // The cheapest of a few back to back reads, slower ones were interrupted
+        m_overhead = UINT64_MAX;
+        for(int round = 0; round < CHIP8_PROFILE_CALIBRATION_ROUNDS; ++round){
+            uint64_t start = timestamp();
+            m_overhead = std::min(m_overhead, timestamp() - start);
+        }
+    }
+}
+
+void Profiler::clear(){
+    m_countdown = m_samplePeriod;
+    m_counts.fill(0);
+    m_samples.fill(0);
+    m_cycles.fill(0);
+    for(auto& histogram : m_histograms){
+        histogram.fill(0);
+    }
+}
+
+void Profiler::sample(OpcodeClass t_class, uint64_t t_cycles){
+    t_cycles = (t_cycles > m_overhead)? t_cycles - m_overhead : 0;
+    std::size_t bucket = 0;
+    while(bucket < CHIP8_PROFILE_BUCKETS - 1 && (t_cycles >> bucket)){
+        ++bucket;
+    }
+    ++m_samples[t_class];
+    m_cycles[t_class] += t_cycles;
+    ++m_histograms[t_class][bucket];
+}
+
+void Profiler::merge(const Profiler& t_other){
+    for(std::size_t opClass = 0; opClass < OP_NUM_CLASSES; ++opClass){
+        m_counts[opClass] += t_other.m_counts[opClass];
+        m_samples[opClass] += t_other.m_samples[opClass];
+        m_cycles[opClass] += t_other.m_cycles[opClass];
+        for(std::size_t bucket = 0; bucket < CHIP8_PROFILE_BUCKETS; ++bucket){
+            m_histograms[opClass][bucket] += t_other.m_histograms[opClass][bucket];
+        }
+    }
+}
+
+// Buckets up to the last nonempty one
+static std::size_t usedBuckets(const std::array<uint64_t, CHIP8_PROFILE_BUCKETS>& t_histogram){
+    std::size_t used = CHIP8_PROFILE_BUCKETS;
+    while(used && !t_histogram[used - 1]){
+        --used;
+    }
+    return used;
+}
+
+void Profiler::writeJson(std::ostream& t_outStream, const ExecutionCounters& t_counters) const{
+    t_outStream << "{\n  \"counters\": {\"instructions\": " << t_counters.instructions << ", \"draws\": " << t_counters.draws
+                << ", \"sprite_rows\": " << t_counters.spriteRows << ", \"collisions\": " << t_counters.collisions
+                << ", \"skips_taken\": " << t_counters.skipsTaken << ", \"key_waits\": " << t_counters.keyWaits << "},\n"
+                << "  \"sample_period\": " << m_samplePeriod << ",\n  \"timer_overhead\": " << m_overhead << ",\n  \"opcodes\": [";
+    const char* separator = "\n";
+    for(std::size_t opClass = 0; opClass < OP_NUM_CLASSES; ++opClass){
+        if(!m_counts[opClass]){
+            continue;
+        }
+        t_outStream << separator << "    {\"name\": \"" << opcodeClassNames[opClass] << "\", \"count\": " << m_counts[opClass]
+                    << ", \"samples\": " << m_samples[opClass] << ", \"mean_cycles\": "
+                    << ((m_samples[opClass])? static_cast<double>(m_cycles[opClass]) / m_samples[opClass] : 0.0) << ", \"histogram\": [";
+        for(std::size_t bucket = 0, used = usedBuckets(m_histograms[opClass]); bucket < used; ++bucket){
+            t_outStream << ((bucket)? ", " : "") << m_histograms[opClass][bucket];
+        }
+        t_outStream << "]}";
+        separator = ",\n";
+    }
+    t_outStream << "\n  ]\n}\n";
+}
+
+void Profiler::writeCsv(std::ostream& t_outStream, const ExecutionCounters& t_counters) const{
+    const std::pair<const char*, uint64_t> counters[] = {
+        {"instructions", t_counters.instructions}, {"draws", t_counters.draws}, {"sprite_rows", t_counters.spriteRows},
+        {"collisions", t_counters.collisions}, {"skips_taken", t_counters.skipsTaken}, {"key_waits", t_counters.keyWaits}
+    };
+    t_outStream << "kind,name,count,samples,mean_cycles,histogram\n";
+    for(const auto& counter : counters){
+        t_outStream << "counter," << counter.first << ',' << counter.second << ",,,\n";
+    }
+    for(std::size_t opClass = 0; opClass < OP_NUM_CLASSES; ++opClass){
+        if(!m_counts[opClass]){
+            continue;
+        }
+        t_outStream << "opcode," << opcodeClassNames[opClass] << ',' << m_counts[opClass] << ',' << m_samples[opClass] << ','
+                    << ((m_samples[opClass])? static_cast<double>(m_cycles[opClass]) / m_samples[opClass] : 0.0) << ',';
+        for(std::size_t bucket = 0, used = usedBuckets(m_histograms[opClass]); bucket < used; ++bucket){
+            t_outStream << ((bucket)? ";" : "") << m_histograms[opClass][bucket];
+        }
+        t_outStream << '\n';
+    }
+}
+
+void Profiler::save(const std::string& t_filePath, const ExecutionCounters& t_counters) const{
+    std::ofstream outStream(t_filePath);
+    if(!outStream.is_open()){
+        throw std::string("Profiler: could not open '" + t_filePath + "' for writing");
+    }
+    bool json = t_filePath.size() >= 5 && !t_filePath.compare(t_filePath.size() - 5, 5, ".json");
+    outStream << std::fixed << std::setprecision(1);
+    if(json){
+        writeJson(outStream, t_counters);
+    }
+    else{
+        writeCsv(outStream, t_counters);
+    }
+    if(!outStream){
+        throw std::string("Profiler: could not write '" + t_filePath + "'");
+    }
+}
+
+} // namespace Chip8
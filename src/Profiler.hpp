@@ -0,0 +1,170 @@
+#ifndef CHIP8_PROFILER_HPP
+#define CHIP8_PROFILER_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Chip8.hpp"
+#include "Chip8Machine.hpp"
+
+// Ticks between two timed ticks by default, and the log2 buckets of a cost histogram
+#define CHIP8_PROFILE_DEFAULT_PERIOD 64
+#define CHIP8_PROFILE_BUCKETS        32
+
+namespace Chip8{
+
+// One class per instruction handler of any variant, decoded from the encoding alone: 5XY2 is SAVE_RANGE
+// whether or not the variant that ran it knows XO-CHIP
+enum OpcodeClass{
+    OP_SYS,             // 0NNN
+    OP_CLS,
+    OP_RET,
+    OP_SCD,
+    OP_SCU,
+    OP_SCR,
+    OP_SCL,
+    OP_EXIT,
+    OP_LOW,
+    OP_HIGH,
+    OP_JP,
+    OP_CALL,
+    OP_SE_IMM,
+    OP_SNE_IMM,
+    OP_SE_REG,
+    OP_SAVE_RANGE,
+    OP_LOAD_RANGE,
+    OP_LD_IMM,
+    OP_ADD_IMM,
+    OP_LD_REG,
+    OP_OR,
+    OP_AND,
+    OP_XOR,
+    OP_ADD_REG,
+    OP_SUB,
+    OP_SHR,
+    OP_SUBN,
+    OP_SHL,
+    OP_SNE_REG,
+    OP_LD_I,
+    OP_JP_V0,
+    OP_RND,
+    OP_DRW,
+    OP_SKP,
+    OP_SKNP,
+    OP_LD_I_LONG,       // F000 NNNN
+    OP_PLANE,
+    OP_AUDIO,
+    OP_LD_VX_DT,
+    OP_LD_KEY,
+    OP_LD_DT,
+    OP_LD_ST,
+    OP_ADD_I,
+    OP_LD_FONT,
+    OP_LD_HIFONT,
+    OP_LD_BCD,
+    OP_PITCH,
+    OP_LD_MEM,          // FX55
+    OP_LD_REGS,         // FX65
+    OP_SAVE_FLAGS,
+    OP_LOAD_FLAGS,
+    OP_UNKNOWN,
+    OP_NUM_CLASSES
+};
+
+OpcodeClass opcodeClass(uint16_t t_op);
+const char* opcodeClassName(OpcodeClass t_class);
+
+// Per opcode class instruction counts and sampled cycle costs of a run. Counting is exact, one increment
+// per tick; one in t_samplePeriod ticks on average is also timed with the time stamp counter (steady clock
+// nanoseconds off x86) and lands in a log2 histogram of its class, bucket b holding costs below 2^b. The
+// cost of reading the timer itself is measured once and taken off every sample.
+//
+// The interpreters themselves only keep their ExecutionCounters, the profiler wraps run_tick() from the
+// outside so nothing on the hot path of an unprofiled run changes.
+class Profiler{
+
+private:
+    uint64_t m_samplePeriod;
+    uint64_t m_countdown;
+    uint64_t m_jitter;
+    uint64_t m_overhead;
+    std::array<uint64_t, OP_NUM_CLASSES> m_counts;
+    std::array<uint64_t, OP_NUM_CLASSES> m_samples;
+    std::array<uint64_t, OP_NUM_CLASSES> m_cycles;
+    std::array<std::array<uint64_t, CHIP8_PROFILE_BUCKETS>, OP_NUM_CLASSES> m_histograms;
+
+    static uint64_t timestamp();
+    void sample(OpcodeClass t_class, uint64_t t_cycles);
+
+    // Ticks to the next timed one, uniform over 1 to 2 * m_samplePeriod - 1. A fixed period would keep timing
+    // the same instruction of any loop whose length divides it.
+    uint64_t nextCountdown(){
+        m_jitter ^= m_jitter << 13;
+        m_jitter ^= m_jitter >> 7;
+        m_jitter ^= m_jitter << 17;
+        return 1 + m_jitter % (2 * m_samplePeriod - 1);
+    }
+
+    // Counts the instruction at the program counter and runs it, timed when the sample period is up
+    template<typename TTick>
+    TickResult tick(uint16_t t_op, TTick t_tick){
+        OpcodeClass opClass = opcodeClass(t_op);
+        ++m_counts[opClass];
+        if(!m_samplePeriod || --m_countdown){
+            return t_tick();
+        }
+        m_countdown = nextCountdown();
+        uint64_t start = timestamp();
+        TickResult result = t_tick();
+        sample(opClass, timestamp() - start);
+        return result;
+    }
+
+public:
+    // A t_samplePeriod of 0 only counts
+    explicit Profiler(uint64_t t_samplePeriod = CHIP8_PROFILE_DEFAULT_PERIOD);
+
+    TickResult tick(Machine& t_machine){
+        uint16_t pc = t_machine.programCounter();
+        return tick(static_cast<uint16_t>((t_machine.readMemory(pc) << 8) | t_machine.readMemory(pc + 1)), [&t_machine](){ return t_machine.run_tick(); });
+    }
+
+    // For the interpreters themselves, BasicChip8 and ExtendedChip8
+    template<typename TChip8>
+    TickResult tick(TChip8& t_chip8){
+        uint16_t pc = t_chip8.getProgramCounter();
+        return tick(static_cast<uint16_t>((t_chip8.readMemory(pc) << 8) | t_chip8.readMemory(pc + 1)), [&t_chip8](){ return t_chip8.run_tick(); });
+    }
+
+    uint64_t count(OpcodeClass t_class) const{
+        return m_counts[t_class];
+    }
+
+    uint64_t samples(OpcodeClass t_class) const{
+        return m_samples[t_class];
+    }
+
+    const std::array<uint64_t, CHIP8_PROFILE_BUCKETS>& histogram(OpcodeClass t_class) const{
+        return m_histograms[t_class];
+    }
+
+    // Adds the counts and samples of another profiler, e.g. one per worker thread
+    void merge(const Profiler& t_other);
+    void clear();
+
+    // The run's ExecutionCounters and every class that ran. CSV has one line per counter and per class:
+    //
+    //     kind,name,count,samples,mean_cycles,histogram
+    //
+    // with kind 'counter' or 'opcode' and the histogram buckets separated by ';' up to the last nonempty one.
+    void writeJson(std::ostream& t_outStream, const ExecutionCounters& t_counters) const;
+    void writeCsv(std::ostream& t_outStream, const ExecutionCounters& t_counters) const;
+    // JSON for a path ending in .json, CSV otherwise. Throws std::string if the file cannot be written.
+    void save(const std::string& t_filePath, const ExecutionCounters& t_counters) const;
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_PROFILER_HPP
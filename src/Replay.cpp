@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "Chip8Util.hpp"
+#include "Replay.hpp"
+
+// magic, version, quirks length; rom hash, seed, cycles, final hash; event count
+#define CHIP8_REPLAY_HEADER_SIZE  (4 + 2 + 1 + 4 * 8 + 4)
+#define CHIP8_REPLAY_MAX_VARINT   10
+
+namespace Chip8{
+
+namespace{
+
+void putVarint(std::vector<uint8_t>& t_out, uint64_t t_value){
+    while(t_value >= 0x80){
+        t_out.push_back(static_cast<uint8_t>(t_value) | 0x80);
+        t_value >>= 7;
+    }
+    t_out.push_back(static_cast<uint8_t>(t_value));
+}
+
+bool getVarint(const uint8_t*& t_in, const uint8_t* t_end, uint64_t& t_value){
+    t_value = 0;
+    for(unsigned shift = 0; t_in < t_end && shift < 7 * CHIP8_REPLAY_MAX_VARINT; shift += 7){
+        uint8_t byte = *t_in++;
+        t_value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Replay::Replay(uint64_t t_romHash, const std::string& t_quirks, uint64_t t_seed) : m_romHash(t_romHash),
+                                                                                   m_quirks(t_quirks),
+                                                                                   m_seed(t_seed),
+                                                                                   m_cycles(0),
+                                                                                   m_finalHash(0){
+}
+
+Replay::Replay(const std::string& t_filePath){
+    std::ifstream inStream(t_filePath, std::ios::binary);
+    if(!inStream.is_open()){
+        throw std::string("Replay: could not open '" + t_filePath + "'");
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(inStream)), std::istreambuf_iterator<char>());
+    const std::string malformed = "Replay: '" + t_filePath + "' is not a replay of this version or is truncated";
+
+    const uint8_t* in = file.data();
+    const uint8_t* end = in + file.size();
+    if(file.size() < CHIP8_REPLAY_HEADER_SIZE || Util::getLE<uint32_t>(in) != CHIP8_REPLAY_MAGIC || Util::getLE<uint16_t>(in) != CHIP8_REPLAY_VERSION){
+        throw malformed;
+    }
+    std::size_t quirksLength = Util::getLE<uint8_t>(in);
+    if(file.size() < CHIP8_REPLAY_HEADER_SIZE + quirksLength){
+        throw malformed;
+    }
+    m_quirks.assign(in, in + quirksLength);
+    in += quirksLength;
+    m_romHash = Util::getLE<uint64_t>(in);
+    m_seed = Util::getLE<uint64_t>(in);
+    m_cycles = Util::getLE<uint64_t>(in);
+    m_finalHash = Util::getLE<uint64_t>(in);
+
+    uint32_t count = Util::getLE<uint32_t>(in);
+    // Every event takes at least three bytes, a count past the end of the file is not allocated
+    if(count > static_cast<std::size_t>(end - in) / 3){
+        throw malformed;
+    }
+    m_events.reserve(count);
+    uint64_t cycle = 0;
+    for(uint32_t event = 0; event < count; ++event){
+        uint64_t delta;
+        if(!getVarint(in, end, delta) || end - in < 2){
+            throw malformed;
+        }
+        cycle += delta;
+        m_events.push_back(Event{cycle, Util::getLE<uint16_t>(in)});
+    }
+}
+
+void Replay::addEvent(uint64_t t_cycle, uint16_t t_keystates){
+    // Two changes in one cycle leave only the later one in effect
+    if(!m_events.empty() && m_events.back().cycle == t_cycle){
+        m_events.back().keystates = t_keystates;
+    }
+    else{
+        m_events.push_back(Event{t_cycle, t_keystates});
+    }
+}
+
+void Replay::truncate(uint64_t t_cycle){
+    auto pos = std::lower_bound(m_events.begin(), m_events.end(), t_cycle, [](const Event& t_event, uint64_t t_value){
+        return t_event.cycle < t_value;
+    });
+    m_events.erase(pos, m_events.end());
+}
+
+void Replay::clear(){
+    m_events.clear();
+    m_cycles = 0;
+    m_finalHash = 0;
+}
+
+void Replay::finish(uint64_t t_cycles, uint64_t t_finalHash){
+    m_cycles = t_cycles;
+    m_finalHash = t_finalHash;
+}
+
+void Replay::save(const std::string& t_filePath) const{
+    if(m_quirks.size() > 0xff){
+        throw std::string("Replay: quirks name '" + m_quirks + "' is too long");
+    }
+    std::vector<uint8_t> file(CHIP8_REPLAY_HEADER_SIZE + m_quirks.size());
+    uint8_t* out = file.data();
+    Util::putLE<uint32_t>(out, CHIP8_REPLAY_MAGIC);
+    Util::putLE<uint16_t>(out, CHIP8_REPLAY_VERSION);
+    Util::putLE<uint8_t>(out, m_quirks.size());
+    out = std::copy(m_quirks.begin(), m_quirks.end(), out);
+    Util::putLE<uint64_t>(out, m_romHash);
+    Util::putLE<uint64_t>(out, m_seed);
+    Util::putLE<uint64_t>(out, m_cycles);
+    Util::putLE<uint64_t>(out, m_finalHash);
+    Util::putLE<uint32_t>(out, m_events.size());
+
+    uint64_t cycle = 0;
+    for(const Event& event : m_events){
+        putVarint(file, event.cycle - cycle);
+        file.push_back(static_cast<uint8_t>(event.keystates));
+        file.push_back(static_cast<uint8_t>(event.keystates >> 8));
+        cycle = event.cycle;
+    }
+
+    std::ofstream outStream(t_filePath, std::ios::binary | std::ios::trunc);
+    if(!outStream.is_open()){
+        throw std::string("Replay: could not create '" + t_filePath + "'");
+    }
+    outStream.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if(!outStream){
+        throw std::string("Replay: failed writing '" + t_filePath + "'");
+    }
+}
+
+std::string Replay::play(Machine& t_machine, uint64_t t_startCycle, Profiler* t_profiler) const{
+    // Events before the start only set keys, the first one applied below catches up on them
+    auto next = m_events.begin();
+    for(uint64_t cycle = t_startCycle; cycle < m_cycles; ++cycle){
+        if(next != m_events.end() && next->cycle <= cycle){
+            while(next + 1 != m_events.end() && (next + 1)->cycle <= cycle){
+                ++next;
+            }
+            t_machine.setKeystates(next->keystates);
+            ++next;
+        }
+        try{
+            if(t_profiler){
+                t_profiler->tick(t_machine);
+            }
+            else{
+                t_machine.run_tick();
+            }
+        }
+        catch(const std::string& error){
+            return error;
+        }
+    }
+    return "";
+}
+
+} // namespace Chip8
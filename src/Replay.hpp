@@ -0,0 +1,88 @@
+#ifndef CHIP8_REPLAY_HPP
+#define CHIP8_REPLAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Chip8Machine.hpp"
+#include "Profiler.hpp"
+
+#define CHIP8_REPLAY_MAGIC    0x50523843
+#define CHIP8_REPLAY_VERSION  1
+
+namespace Chip8{
+
+// A recorded session: rom, interpreter variant and seed, and the key state at every cycle it changed. Cycles
+// count ticks from a cold load of the rom, whether or not the session started from its boot state, and
+// the key state of an event is in effect from the instruction at its cycle on. Replaying the events into
+// the same machine reproduces the session exactly, the final state hash recorded with it tells.
+//
+// Files are little endian:
+//
+//     magic u32, version u16, quirks length u8, quirks, rom hash u64, seed u64, cycles u64, final state
+//     hash u64, event count u32, then per event the cycles since the previous event as a varint and
+//     the key state u16
+class Replay{
+
+public:
+    struct Event{
+        uint64_t cycle;
+        uint16_t keystates;
+    };
+
+private:
+    uint64_t m_romHash;
+    std::string m_quirks;
+    uint64_t m_seed;
+    uint64_t m_cycles;
+    uint64_t m_finalHash;
+    std::vector<Event> m_events;
+
+public:
+    Replay(uint64_t t_romHash, const std::string& t_quirks, uint64_t t_seed);
+    explicit Replay(const std::string& t_filePath);
+
+    // Key state t_keystates from t_cycle on, events arrive in cycle order
+    void addEvent(uint64_t t_cycle, uint16_t t_keystates);
+    // Drops the events at or after t_cycle, for sessions stepped back to t_cycle
+    void truncate(uint64_t t_cycle);
+    void clear();
+    // Session length and the state hash it ended with
+    void finish(uint64_t t_cycles, uint64_t t_finalHash);
+    void save(const std::string& t_filePath) const;
+
+    // Runs t_machine, loaded with the rom and variant of the replay and seeded with its seed, from t_startCycle
+    // (see Machine::bootTicks) to the end of the session. Returns the fault message of a session that ended
+    // in a fault, empty otherwise. Every tick goes through t_profiler when one is given.
+    std::string play(Machine& t_machine, uint64_t t_startCycle, Profiler* t_profiler = nullptr) const;
+
+    uint64_t romHash() const{
+        return m_romHash;
+    }
+
+    const std::string& quirks() const{
+        return m_quirks;
+    }
+
+    uint64_t seed() const{
+        return m_seed;
+    }
+
+    uint64_t cycles() const{
+        return m_cycles;
+    }
+
+    uint64_t finalHash() const{
+        return m_finalHash;
+    }
+
+    const std::vector<Event>& events() const{
+        return m_events;
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_REPLAY_HPP
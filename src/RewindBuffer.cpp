@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cstring>
+
+#include "RewindBuffer.hpp"
+
+namespace Chip8{
+
+namespace{
+
+// The ring codes every entry as pairs of varints, bytes unchanged then bytes changed, followed by the changed
+// bytes. Unchanged bytes at the end are implied.
+void putVarint(uint8_t*& t_out, std::size_t t_value){
+    while(t_value >= 0x80){
+        *t_out++ = static_cast<uint8_t>(t_value) | 0x80;
+        t_value >>= 7;
+    }
+    *t_out++ = static_cast<uint8_t>(t_value);
+}
+
+std::size_t getVarint(const uint8_t*& t_in){
+    std::size_t value = 0;
+    for(unsigned shift = 0; ; shift += 7){
+        uint8_t byte = *t_in++;
+        value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)){
+            return value;
+        }
+    }
+}
+
+} // namespace
+
+RewindBuffer::RewindBuffer(std::size_t t_stateSize, std::size_t t_frames, std::size_t t_bytes, std::size_t t_keyframeInterval) : m_stateSize(t_stateSize),
+                                                                                                                                 m_keyframeInterval(t_keyframeInterval),
+                                                                                                                                 m_head(t_stateSize),
+                                                                                                                                 m_hasHead(false),
+                                                                                                                                 // Coding never grows a state by more than the first pair of varints
+                                                                                                                                 m_scratch(t_stateSize + 2 * CHIP8_REWIND_MAX_VARINT),
+                                                                                                                                 m_ring(t_bytes),
+                                                                                                                                 m_writeOffset(0),
+                                                                                                                                 m_entries(t_frames),
+                                                                                                                                 m_first(0),
+                                                                                                                                 m_count(0),
+                                                                                                                                 m_pushed(0){
+}
+
+std::size_t RewindBuffer::encode(const uint8_t* t_state, const uint8_t* t_reference){
+    auto changed = [t_state, t_reference](std::size_t t_index) -> uint8_t{
+        return (t_reference)? t_state[t_index] ^ t_reference[t_index] : t_state[t_index];
+    };
+
+    uint8_t* out = m_scratch.data();
+    std::size_t index = 0;
+    while(index < m_stateSize){
+        // Unchanged bytes a word at a time, most of a state does not change between frames
+        std::size_t start = index;
+        for(; index + sizeof(uint64_t) <= m_stateSize; index += sizeof(uint64_t)){
+            uint64_t word, reference = 0;
+            std::memcpy(&word, t_state + index, sizeof(word));
+            if(t_reference){
+                std::memcpy(&reference, t_reference + index, sizeof(reference));
+            }
+            if(word ^ reference){
+                break;
+            }
+        }
+        while(index < m_stateSize && !changed(index)){
+            ++index;
+        }
+        if(index == m_stateSize){
+            break;
+        }
+
+        // Changed bytes up to the next run of CHIP8_REWIND_MIN_ZERO_RUN unchanged ones
+        std::size_t literals = index, zeroRun = 0;
+        for(; index < m_stateSize && zeroRun < CHIP8_REWIND_MIN_ZERO_RUN; ++index){
+            zeroRun = (changed(index))? 0 : zeroRun + 1;
+        }
+        index -= zeroRun;
+
+        putVarint(out, literals - start);
+        putVarint(out, index - literals);
+        for(; literals < index; ++literals){
+            *out++ = changed(literals);
+        }
+    }
+    return out - m_scratch.data();
+}
+
+void RewindBuffer::decode(const Entry& t_entry){
+    const uint8_t* in = m_ring.data() + t_entry.offset;
+    const uint8_t* end = in + t_entry.size;
+    uint8_t* head = m_head.data();
+    std::size_t position = 0;
+    while(in < end){
+        std::size_t unchanged = getVarint(in);
+        std::size_t literals = getVarint(in);
+        if(t_entry.keyframe){
+            std::fill(head + position, head + position + unchanged, 0);
+            std::copy(in, in + literals, head + position + unchanged);
+        }
+        else{
+            for(std::size_t index = 0; index < literals; ++index){
+                head[position + unchanged + index] ^= in[index];
+            }
+        }
+        in += literals;
+        position += unchanged + literals;
+    }
+    if(t_entry.keyframe){
+        std::fill(head + position, head + m_stateSize, 0);
+    }
+}
+
+void RewindBuffer::dropOldest(){
+    m_first = (m_first + 1) % m_entries.size();
+    --m_count;
+}
+
+void RewindBuffer::push(const uint8_t* t_state){
+    if(m_hasHead && !m_entries.empty()){
+        // The old newest state becomes an entry coded against the new one
+        bool keyframe = m_keyframeInterval && !(m_pushed % m_keyframeInterval);
+        std::size_t size = encode(m_head.data(), (keyframe)? nullptr : t_state);
+        ++m_pushed;
+
+        if(size <= m_ring.size()){
+            if(m_writeOffset + size > m_ring.size()){
+                // Entries past the write position are the oldest ones, the ring tail is skipped so they go first
+                while(m_count && entry(0).offset >= m_writeOffset){
+                    dropOldest();
+                }
+                m_writeOffset = 0;
+            }
+            while(m_count && (m_count == m_entries.size() || (entry(0).offset < m_writeOffset + size && m_writeOffset < entry(0).offset + entry(0).size))){
+                dropOldest();
+            }
+
+            Entry& newest = entry(m_count++);
+            newest.offset = m_writeOffset;
+            newest.size = size;
+            newest.keyframe = keyframe;
+            std::copy(m_scratch.begin(), m_scratch.begin() + size, m_ring.begin() + m_writeOffset);
+            m_writeOffset += size;
+        }
+        else{
+            // Too big for the whole ring, the history before it is lost
+            m_count = 0;
+            m_writeOffset = 0;
+        }
+    }
+    std::copy(t_state, t_state + m_stateSize, m_head.begin());
+    m_hasHead = true;
+}
+
+bool RewindBuffer::pop(uint8_t* t_state, std::size_t t_frames){
+    if(!m_count || !t_frames){
+        return false;
+    }
+
+    // Decode down from the nearest keyframe at or above the target, or from the newest entry
+    std::size_t target = m_count - std::min(t_frames, m_count);
+    std::size_t index = m_count;
+    for(std::size_t keyframe = target; keyframe < m_count; ++keyframe){
+        if(entry(keyframe).keyframe){
+            index = keyframe + 1;
+            break;
+        }
+    }
+    while(index > target){
+        decode(entry(--index));
+    }
+
+    m_count = target;
+    m_writeOffset = (m_count)? entry(m_count - 1).offset + entry(m_count - 1).size : 0;
+    std::copy(m_head.begin(), m_head.end(), t_state);
+    return true;
+}
+
+void RewindBuffer::clear(){
+    m_hasHead = false;
+    m_first = 0;
+    m_count = 0;
+    m_writeOffset = 0;
+    m_pushed = 0;
+}
+
+std::size_t RewindBuffer::usedBytes() const{
+    if(!m_count){
+        return 0;
+    }
+    const Entry& oldest = m_entries[m_first];
+    const Entry& newest = m_entries[(m_first + m_count - 1) % m_entries.size()];
+    std::size_t end = newest.offset + newest.size;
+    return (end >= oldest.offset)? end - oldest.offset : m_ring.size() - oldest.offset + end;
+}
+
+} // namespace Chip8
@@ -0,0 +1,80 @@
+#ifndef CHIP8_REWIND_BUFFER_HPP
+#define CHIP8_REWIND_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define CHIP8_REWIND_KEYFRAME_INTERVAL  120
+// Shorter runs of unchanged bytes cost more to code than to copy
+#define CHIP8_REWIND_MIN_ZERO_RUN       4
+#define CHIP8_REWIND_MAX_VARINT         10
+
+namespace Chip8{
+
+// History of machine snapshots (see Machine::saveState) for stepping a session back one frame at a time.
+// The newest state is kept whole, every older one as the run length coded XOR against the state after it,
+// which is mostly zeros from one frame to the next. Every CHIP8_REWIND_KEYFRAME_INTERVAL entries a keyframe
+// is coded whole instead, so popping several states at once decodes at most one interval of entries.
+//
+// Entries are packed into one byte ring allocated up front together with the scratch buffers, the oldest
+// entries give way when it or the entry count runs out, so push and pop never allocate.
+class RewindBuffer{
+
+private:
+    struct Entry{
+        std::size_t offset;
+        std::size_t size;
+        bool keyframe;
+    };
+
+    std::size_t m_stateSize;
+    std::size_t m_keyframeInterval;
+    std::vector<uint8_t> m_head;
+    bool m_hasHead;
+    std::vector<uint8_t> m_scratch;
+    std::vector<uint8_t> m_ring;
+    std::size_t m_writeOffset;
+    std::vector<Entry> m_entries;
+    std::size_t m_first;
+    std::size_t m_count;
+    uint64_t m_pushed;
+
+    Entry& entry(std::size_t t_index){
+        return m_entries[(m_first + t_index) % m_entries.size()];
+    }
+
+    // Codes t_state, XORed with t_reference unless it is null, into m_scratch and returns the coded size
+    std::size_t encode(const uint8_t* t_state, const uint8_t* t_reference);
+    // Applies an entry to m_head, turning the state after it into the state it holds
+    void decode(const Entry& t_entry);
+    void dropOldest();
+
+public:
+    // Room for t_frames states behind the newest one in t_bytes of coded entries
+    RewindBuffer(std::size_t t_stateSize, std::size_t t_frames, std::size_t t_bytes, std::size_t t_keyframeInterval = CHIP8_REWIND_KEYFRAME_INTERVAL);
+
+    // Appends t_state, stateSize bytes, as the newest state
+    void push(const uint8_t* t_state);
+    // Steps t_frames states back, or as far as the history goes, and writes the state reached to t_state. It
+    // becomes the newest state, later pushes continue from it. False when there is no older state.
+    bool pop(uint8_t* t_state, std::size_t t_frames = 1);
+    void clear();
+
+    // States that can be popped
+    std::size_t frames() const{
+        return m_count;
+    }
+
+    // Bytes of the ring holding coded entries
+    std::size_t usedBytes() const;
+
+    // Everything held, fixed at construction
+    std::size_t capacityBytes() const{
+        return m_head.size() + m_scratch.size() + m_ring.size() + m_entries.size() * sizeof(Entry);
+    }
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_REWIND_BUFFER_HPP
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "RomCorpus.hpp"
+#include "Chip8Util.hpp"
+
+namespace Chip8{
+
+RomCorpus::RomCorpus(const std::string& t_corpusPath) : m_mapping(nullptr), m_mappingSize(0){
+    int fd = open(t_corpusPath.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::string("RomCorpus: could not open '" + t_corpusPath + "': " + std::strerror(errno));
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) || static_cast<std::size_t>(fileStat.st_size) < sizeof(Header)){
+        close(fd);
+        throw std::string("RomCorpus: '" + t_corpusPath + "' is not a rom corpus");
+    }
+
+    m_mappingSize = fileStat.st_size;
+    void* mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+        throw std::string("RomCorpus: could not map '" + t_corpusPath + "': " + std::strerror(errno));
+    }
+    m_mapping = static_cast<const uint8_t*>(mapping);
+
+    // Everything is checked once here, lookups trust the offsets
+    m_header = reinterpret_cast<const Header*>(m_mapping);
+    const uint64_t count = m_header->count;
+    if(std::memcmp(m_header->magic, CHIP8_CORPUS_MAGIC, sizeof(m_header->magic)) || m_header->version != CHIP8_CORPUS_VERSION
+       || m_header->fileSize != m_mappingSize
+       || m_header->entriesOffset % alignof(Entry) || m_header->entriesOffset + count * sizeof(Entry) > m_mappingSize
+       || m_header->hashIndexOffset % alignof(uint32_t) || m_header->hashIndexOffset + count * sizeof(uint32_t) > m_mappingSize
+       || m_header->namesOffset > m_mappingSize || m_header->dataOffset > m_mappingSize){
+        munmap(const_cast<uint8_t*>(m_mapping), m_mappingSize);
+        throw std::string("RomCorpus: '" + t_corpusPath + "' is not a version " + std::to_string(CHIP8_CORPUS_VERSION) + " rom corpus");
+    }
+    m_entries = reinterpret_cast<const Entry*>(m_mapping + m_header->entriesOffset);
+    m_hashIndex = reinterpret_cast<const uint32_t*>(m_mapping + m_header->hashIndexOffset);
+    m_names = reinterpret_cast<const char*>(m_mapping + m_header->namesOffset);
+    m_data = m_mapping + m_header->dataOffset;
+
+    for(std::size_t i = 0; i < count; ++i){
+        const Entry& entry = m_entries[i];
+        if(m_header->namesOffset + entry.nameOffset + entry.nameSize > m_header->dataOffset
+           || m_header->dataOffset + entry.dataOffset + entry.dataSize > m_mappingSize || m_hashIndex[i] >= count){
+            munmap(const_cast<uint8_t*>(m_mapping), m_mappingSize);
+            throw std::string("RomCorpus: entry " + std::to_string(i) + " of '" + t_corpusPath + "' is out of bounds");
+        }
+    }
+}
+
+RomCorpus::~RomCorpus(){
+    munmap(const_cast<uint8_t*>(m_mapping), m_mappingSize);
+}
+
+RomCorpus::Rom RomCorpus::rom(std::size_t t_index) const{
+    if(t_index >= size()){
+        throw std::string("RomCorpus: rom index " + std::to_string(t_index) + " out of range for " + std::to_string(size()) + " roms");
+    }
+    const Entry& entry = m_entries[t_index];
+    return Rom{m_names + entry.nameOffset, entry.nameSize, entry.hash, m_data + entry.dataOffset, entry.dataSize};
+}
+
+int RomCorpus::compareName(std::size_t t_index, const std::string& t_name) const{
+    const Entry& entry = m_entries[t_index];
+    int order = std::memcmp(m_names + entry.nameOffset, t_name.data(), std::min<std::size_t>(entry.nameSize, t_name.size()));
+    if(order){
+        return order;
+    }
+    return (entry.nameSize < t_name.size())? -1 : (entry.nameSize > t_name.size());
+}
+
+long RomCorpus::find(const std::string& t_name) const{
+    std::size_t low = 0, high = size();
+    while(low < high){
+        std::size_t mid = low + (high - low) / 2;
+        int order = compareName(mid, t_name);
+        if(!order){
+            return mid;
+        }
+        if(order < 0){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    return -1;
+}
+
+long RomCorpus::find(uint64_t t_hash) const{
+    const uint32_t* match = std::lower_bound(m_hashIndex, m_hashIndex + size(), t_hash, [this](uint32_t t_index, uint64_t t_value){
+        return m_entries[t_index].hash < t_value;
+    });
+    if(match == m_hashIndex + size() || m_entries[*match].hash != t_hash){
+        return -1;
+    }
+    return *match;
+}
+
+uint64_t RomCorpus::hash(const uint8_t* t_data, std::size_t t_size){
+    return Util::xxh64(t_data, t_size);
+}
+
+void RomCorpus::pack(const std::string& t_corpusPath, const std::vector<std::string>& t_romPaths, const std::vector<std::string>& t_names){
+    if(t_romPaths.size() != t_names.size()){
+        throw std::string("RomCorpus: every rom needs a name");
+    }
+
+    std::vector<std::size_t> order(t_names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&t_names](std::size_t t_lhs, std::size_t t_rhs){
+        return t_names[t_lhs] < t_names[t_rhs];
+    });
+
+    std::vector<Entry> entries;
+    std::string names;
+    std::vector<uint8_t> data;
+    for(std::size_t index : order){
+        if(!entries.empty() && t_names[index] == std::string(names, entries.back().nameOffset, entries.back().nameSize)){
+            throw std::string("RomCorpus: duplicate rom name '" + t_names[index] + "'");
+        }
+        std::ifstream romStream(t_romPaths[index], std::ios::binary);
+        if(!romStream.is_open()){
+            throw std::string("RomCorpus: could not open rom '" + t_romPaths[index] + "'");
+        }
+        std::vector<uint8_t> rom((std::istreambuf_iterator<char>(romStream)), std::istreambuf_iterator<char>());
+
+        Entry entry;
+        entry.hash = hash(rom.data(), rom.size());
+        entry.dataOffset = data.size();
+        entry.dataSize = rom.size();
+        entry.nameOffset = names.size();
+        entry.nameSize = t_names[index].size();
+        entry.reserved = 0;
+        entries.push_back(entry);
+        names += t_names[index];
+        data.insert(data.end(), rom.begin(), rom.end());
+    }
+
+    std::vector<uint32_t> hashIndex(entries.size());
+    std::iota(hashIndex.begin(), hashIndex.end(), 0);
+    std::stable_sort(hashIndex.begin(), hashIndex.end(), [&entries](uint32_t t_lhs, uint32_t t_rhs){
+        return entries[t_lhs].hash < entries[t_rhs].hash;
+    });
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHIP8_CORPUS_MAGIC, sizeof(header.magic));
+    header.version = CHIP8_CORPUS_VERSION;
+    header.count = entries.size();
+    header.entriesOffset = sizeof(Header);
+    header.hashIndexOffset = header.entriesOffset + entries.size() * sizeof(Entry);
+    header.namesOffset = header.hashIndexOffset + hashIndex.size() * sizeof(uint32_t);
+    header.dataOffset = header.namesOffset + names.size();
+    header.fileSize = header.dataOffset + data.size();
+
+    std::ofstream corpus(t_corpusPath, std::ios::binary | std::ios::trunc);
+    if(!corpus.is_open()){
+        throw std::string("RomCorpus: could not create '" + t_corpusPath + "'");
+    }
+    corpus.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    corpus.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+    corpus.write(reinterpret_cast<const char*>(hashIndex.data()), hashIndex.size() * sizeof(uint32_t));
+    corpus.write(names.data(), names.size());
+    corpus.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if(!corpus){
+        throw std::string("RomCorpus: failed writing '" + t_corpusPath + "'");
+    }
+}
+
+} // namespace Chip8
@@ -0,0 +1,91 @@
+#ifndef CHIP8_ROM_CORPUS_HPP
+#define CHIP8_ROM_CORPUS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CHIP8_CORPUS_MAGIC        "C8CORPUS"
+#define CHIP8_CORPUS_VERSION      2
+
+namespace Chip8{
+
+// Read only view of a packed rom corpus, one file holding many roms. Layout, all integers in host byte order:
+//
+//     Header     magic, version, rom count, offsets of the sections below
+//     Entry[]    one per rom sorted by name: content hash, name and data location
+//     uint32_t[] entry indices sorted by content hash
+//     names      concatenated rom names
+//     data       concatenated rom images
+//
+// The file is mapped once, lookups by name or hash are binary searches over the mapping and rom
+// bytes are read straight out of it, so opening thousands of roms costs no syscalls past the open.
+class RomCorpus{
+
+public:
+    // Points into the mapping, valid while the corpus is open. name is not null terminated.
+    struct Rom{
+        const char* name;
+        std::size_t nameSize;
+        uint64_t hash;
+        const uint8_t* data;
+        std::size_t size;
+    };
+
+private:
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        uint64_t entriesOffset;
+        uint64_t hashIndexOffset;
+        uint64_t namesOffset;
+        uint64_t dataOffset;
+        uint64_t fileSize;
+    };
+
+    struct Entry{
+        uint64_t hash;
+        uint64_t dataOffset;
+        uint32_t dataSize;
+        uint32_t nameOffset;
+        uint32_t nameSize;
+        uint32_t reserved;
+    };
+
+    const uint8_t* m_mapping;
+    std::size_t m_mappingSize;
+    const Header* m_header;
+    const Entry* m_entries;
+    const uint32_t* m_hashIndex;
+    const char* m_names;
+    const uint8_t* m_data;
+
+    int compareName(std::size_t t_index, const std::string& t_name) const;
+
+public:
+    explicit RomCorpus(const std::string& t_corpusPath);
+    RomCorpus(const RomCorpus&) = delete;
+    RomCorpus& operator=(const RomCorpus&) = delete;
+    ~RomCorpus();
+
+    std::size_t size() const{
+        return m_header->count;
+    }
+
+    // Roms are indexed in name order
+    Rom rom(std::size_t t_index) const;
+    // Index of the rom named t_name or of a rom with content hash t_hash, -1 when there is none
+    long find(const std::string& t_name) const;
+    long find(uint64_t t_hash) const;
+
+    // Content hash stored in the index, the XXH64 RomLibrary keys roms by and chip8 --scan prints
+    static uint64_t hash(const uint8_t* t_data, std::size_t t_size);
+    // Packs t_romPaths into a corpus at t_corpusPath, rom t_romPaths[i] is stored under t_names[i]
+    static void pack(const std::string& t_corpusPath, const std::vector<std::string>& t_romPaths, const std::vector<std::string>& t_names);
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_ROM_CORPUS_HPP
@@ -0,0 +1,202 @@
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <unordered_set>
+
+#include "RomLibrary.hpp"
+#include "Chip8Util.hpp"
+#include "IniReader.hpp"
+
+namespace Chip8{
+
+// The index is keyed by absolute path so './roms/pong.ch8' and 'roms/pong.ch8' share an entry
+static std::string canonicalPath(const std::string& t_path){
+    char resolved[PATH_MAX];
+    return (realpath(t_path.c_str(), resolved))? std::string(resolved) : t_path;
+}
+
+RomLibrary::RomLibrary(const std::string& t_indexPath, const std::string& t_profilePath) : m_indexPath(t_indexPath), m_hashed(0), m_dirty(false){
+    loadIndex();
+    loadProfiles(t_profilePath);
+}
+
+void RomLibrary::loadIndex(){
+    std::ifstream indexStream(m_indexPath);
+    if(!indexStream.is_open()){
+        return;
+    }
+
+    std::string magic;
+    int version = 0;
+    indexStream >> magic >> version;
+    if(magic != CHIP8_ROM_INDEX_MAGIC || version != CHIP8_ROM_INDEX_VERSION){
+        // An index from another version is only a cache, start over
+        m_dirty = true;
+        return;
+    }
+
+    // <hash> <mtime ns> <size> <path>, the path runs to the end of the line
+    std::string line;
+    std::getline(indexStream, line);
+    while(std::getline(indexStream, line)){
+        std::istringstream lineStream(line);
+        IndexEntry entry;
+        std::string path;
+        if(!(lineStream >> std::hex >> entry.hash >> std::dec >> entry.mtime >> entry.size) || !std::getline(lineStream >> std::ws, path) || path.empty()){
+            m_dirty = true;
+            continue;
+        }
+        m_index[path] = entry;
+    }
+}
+
+void RomLibrary::loadProfiles(const std::string& t_profilePath){
+    if(Util::fileExists(t_profilePath.c_str()) != Util::regFile){
+        return;
+    }
+
+    IniReader profiles(t_profilePath);
+    for(const std::string& header : profiles.getHeaders()){
+        char* end;
+        uint64_t romHash = std::strtoull(header.c_str(), &end, 16);
+        if(header.size() != 16 || *end){
+            throw std::string("RomLibrary: profile section '" + header + "' of " + t_profilePath + " is not a 16 digit rom hash");
+        }
+
+        RomProfile& profile = m_profiles[romHash];
+        profile.name = profiles.getString(header, "name", "");
+        // 0 or no entry keeps the default speed, the timer period caps the rest
+        long instructionsPerFrame = profiles.getInt(header, "ipf", 0);
+        if(instructionsPerFrame < 0 || instructionsPerFrame > CHIP8_MAX_TIMER_PERIOD){
+            throw std::string("RomLibrary: ipf of profile '" + header + "' in " + t_profilePath + " is not a number from 1 to " + std::to_string(CHIP8_MAX_TIMER_PERIOD));
+        }
+        profile.instructionsPerFrame = instructionsPerFrame;
+        profile.quirks = profiles.getString(header, "quirks", "");
+        profile.hasFgColor = !profiles.getString(header, "fg_color", "").empty();
+        profile.hasBgColor = !profiles.getString(header, "bg_color", "").empty();
+        profile.fgColor = profiles.getInt(header, "fg_color", 0);
+        profile.bgColor = profiles.getInt(header, "bg_color", 0);
+        for(const std::pair<std::string, std::string>& value : profiles.getHeaderValues(header)){
+            if(!value.first.compare(0, 4, "key_")){
+                profile.keyBinds.push_back(value);
+            }
+        }
+    }
+}
+
+uint64_t RomLibrary::hash(const std::string& t_romPath){
+    std::string path = canonicalPath(t_romPath);
+    struct stat romStat;
+    if(stat(path.c_str(), &romStat)){
+        throw std::string("RomLibrary: could not stat '" + t_romPath + "': " + std::strerror(errno));
+    }
+    int64_t mtime = static_cast<int64_t>(romStat.st_mtim.tv_sec) * 1000000000 + romStat.st_mtim.tv_nsec;
+
+    auto indexed = m_index.find(path);
+    if(indexed != m_index.end() && indexed->second.mtime == mtime && indexed->second.size == static_cast<uint64_t>(romStat.st_size)){
+        return indexed->second.hash;
+    }
+
+    std::ifstream romStream(path, std::ios::binary);
+    if(!romStream.is_open()){
+        throw std::string("RomLibrary: could not open rom '" + t_romPath + "'");
+    }
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(romStream)), std::istreambuf_iterator<char>());
+
+    IndexEntry entry = {mtime, static_cast<uint64_t>(romStat.st_size), hashContents(rom.data(), rom.size())};
+    m_index[path] = entry;
+    m_dirty = true;
+    ++m_hashed;
+    return entry.hash;
+}
+
+void RomLibrary::scanDirectory(const std::string& t_dirPath, std::vector<std::string>& t_romPaths){
+    DIR* dir = opendir(t_dirPath.c_str());
+    if(!dir){
+        throw std::string("RomLibrary: could not open directory '" + t_dirPath + "': " + std::strerror(errno));
+    }
+    while(dirent* entry = readdir(dir)){
+        std::string name = entry->d_name;
+        if(name == "." || name == ".."){
+            continue;
+        }
+        std::string path = t_dirPath + '/' + name;
+        const char* type = Util::fileExists(path.c_str());
+        if(type == Util::regFile){
+            t_romPaths.push_back(path);
+        }
+        else if(type){
+            scanDirectory(path, t_romPaths);
+        }
+    }
+    closedir(dir);
+}
+
+std::vector<std::string> RomLibrary::scan(const std::string& t_dirPath){
+    std::string dirPath = canonicalPath(t_dirPath);
+    std::vector<std::string> romPaths;
+    scanDirectory(dirPath, romPaths);
+
+    std::unordered_set<std::string> found;
+    for(const std::string& romPath : romPaths){
+        hash(romPath);
+        found.insert(romPath);
+    }
+
+    // Forget roms that were under this directory and are gone
+    std::string prefix = dirPath + '/';
+    for(auto entry = m_index.begin(); entry != m_index.end();){
+        if(!entry->first.compare(0, prefix.size(), prefix) && !found.count(entry->first)){
+            entry = m_index.erase(entry);
+            m_dirty = true;
+        }
+        else{
+            ++entry;
+        }
+    }
+    return romPaths;
+}
+
+void RomLibrary::save(){
+    if(!m_dirty){
+        return;
+    }
+
+    // Written aside then renamed over, a crash never leaves a torn index
+    std::string tempPath = m_indexPath + ".tmp";
+    {
+        std::ofstream indexStream(tempPath, std::ios::trunc);
+        if(!indexStream.is_open()){
+            throw std::string("RomLibrary: could not create '" + tempPath + "'");
+        }
+        indexStream << CHIP8_ROM_INDEX_MAGIC << ' ' << CHIP8_ROM_INDEX_VERSION << '\n';
+        for(const auto& entry : m_index){
+            indexStream << std::hex << entry.second.hash << std::dec << ' ' << entry.second.mtime << ' ' << entry.second.size << ' ' << entry.first << '\n';
+        }
+        if(!indexStream){
+            throw std::string("RomLibrary: failed writing '" + tempPath + "'");
+        }
+    }
+    if(std::rename(tempPath.c_str(), m_indexPath.c_str())){
+        throw std::string("RomLibrary: could not replace '" + m_indexPath + "': " + std::strerror(errno));
+    }
+    m_dirty = false;
+}
+
+const RomProfile* RomLibrary::profile(uint64_t t_hash) const{
+    auto found = m_profiles.find(t_hash);
+    return (found != m_profiles.end())? &found->second : nullptr;
+}
+
+uint64_t RomLibrary::hashContents(const uint8_t* t_data, std::size_t t_size){
+    return Util::xxh64(t_data, t_size);
+}
+
+} // namespace Chip8
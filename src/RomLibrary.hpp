@@ -0,0 +1,98 @@
+#ifndef CHIP8_ROM_LIBRARY_HPP
+#define CHIP8_ROM_LIBRARY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Chip8.hpp"
+
+#define CHIP8_ROM_INDEX_MAGIC     "chip8-rom-index"
+#define CHIP8_ROM_INDEX_VERSION   1
+#define CHIP8_FRAME_RATE          60
+
+namespace Chip8{
+
+// Per rom settings, read from a profile ini with one section per rom content hash:
+//
+//     [<16 hex digit hash>]
+//     name = Pong
+//     ipf = 12
+//     quirks = vip
+//     fg_color = 0xFFFFFF
+//     bg_color = 0x000000
+//     key_ch8_1 = 1
+//
+// Every key_* entry uses the [Keys] binding syntax of the emulator config and replaces that action's binding.
+struct RomProfile{
+    std::string name;
+    // Instructions per 60Hz frame, 0 keeps CHIP8_TICK_PERIOD_USEC. Loading rejects anything above
+    // CHIP8_MAX_TIMER_PERIOD, see BasicChip8::setTimerPeriod.
+    unsigned instructionsPerFrame = 0;
+    std::string quirks;
+    // Each colour the profile sets replaces the config's own, the other one stays as configured
+    bool hasFgColor = false;
+    bool hasBgColor = false;
+    uint32_t fgColor = 0;
+    uint32_t bgColor = 0;
+    std::vector<std::pair<std::string, std::string>> keyBinds;
+
+    long tickPeriodUsec() const{
+        return (instructionsPerFrame)? std::max(1L, 1000000 / (CHIP8_FRAME_RATE * static_cast<long>(instructionsPerFrame))) : CHIP8_TICK_PERIOD_USEC;
+    }
+
+    // Quirks for makeMachine, with the instructions per frame so the timers keep to 60Hz at that speed
+    std::string machineQuirks() const{
+        return (instructionsPerFrame)? quirks + ':' + std::to_string(instructionsPerFrame) : quirks;
+    }
+};
+
+// Content hashes of a rom library plus the profiles keyed by them. Hashes are cached in an index file
+// keyed by path, size and modification time, so a rescan only reads roms that changed since the last one.
+class RomLibrary{
+
+private:
+    struct IndexEntry{
+        int64_t mtime;
+        uint64_t size;
+        uint64_t hash;
+    };
+
+    std::string m_indexPath;
+    std::unordered_map<std::string, IndexEntry> m_index;
+    std::unordered_map<uint64_t, RomProfile> m_profiles;
+    std::size_t m_hashed;
+    bool m_dirty;
+
+    void loadIndex();
+    void loadProfiles(const std::string& t_profilePath);
+    void scanDirectory(const std::string& t_dirPath, std::vector<std::string>& t_romPaths);
+
+public:
+    // A missing index or profile file is an empty one, the index is created on save()
+    RomLibrary(const std::string& t_indexPath, const std::string& t_profilePath);
+
+    // Content hash of the rom at t_romPath, read from the index when the file has not changed
+    uint64_t hash(const std::string& t_romPath);
+    // Hashes every file below t_dirPath, drops index entries of files that no longer exist. Returns the paths found.
+    std::vector<std::string> scan(const std::string& t_dirPath);
+    // Writes the index if anything changed since it was loaded
+    void save();
+
+    const RomProfile* profile(uint64_t t_hash) const;
+
+    // Number of roms actually read and hashed so far, as opposed to served from the index
+    std::size_t hashed() const{
+        return m_hashed;
+    }
+
+    static uint64_t hashContents(const uint8_t* t_data, std::size_t t_size);
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_ROM_LIBRARY_HPP
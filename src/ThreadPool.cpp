@@ -0,0 +1,121 @@
+#include "ThreadPool.hpp"
+#include "LoggerImpl.hpp"
+
+namespace Chip8{
+    namespace Util{
+
+        // Index of the queue owned by the calling thread, -1 outside of any pool
+        static thread_local long currentWorkerIndex = -1;
+        static thread_local const ThreadPool* currentWorkerPool = nullptr;
+
+        ThreadPool::ThreadPool(std::size_t t_numThreads) : m_queued(0), m_pending(0), m_nextQueue(0), m_stop(false){
+            if(!t_numThreads){
+                t_numThreads = 1;
+            }
+            for(std::size_t i = 0; i < t_numThreads; ++i){
+                m_queues.emplace_back(new WorkQueue());
+            }
+            for(std::size_t i = 0; i < t_numThreads; ++i){
+                m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+            }
+        }
+
+        std::size_t ThreadPool::size() const{
+            return m_workers.size();
+        }
+
+        void ThreadPool::submit(std::function<void()> t_task){
+            std::size_t index;
+            if(currentWorkerPool == this){
+                index = static_cast<std::size_t>(currentWorkerIndex);
+            }
+            else{
+                index = m_nextQueue++ % m_queues.size();
+            }
+
+            ++m_pending;
+            {
+                std::lock_guard<std::mutex> queueLock(m_queues[index]->lock);
+                m_queues[index]->tasks.push_back(std::move(t_task));
+                ++m_queued;
+            }
+            std::lock_guard<std::mutex> idleLock(m_idleLock);
+            m_idleCond.notify_one();
+        }
+
+        bool ThreadPool::popTask(std::size_t t_index, std::function<void()>& t_task){
+            {
+                std::lock_guard<std::mutex> queueLock(m_queues[t_index]->lock);
+                if(!m_queues[t_index]->tasks.empty()){
+                    t_task = std::move(m_queues[t_index]->tasks.back());
+                    m_queues[t_index]->tasks.pop_back();
+                    --m_queued;
+                    return true;
+                }
+            }
+            for(std::size_t offset = 1; offset < m_queues.size(); ++offset){
+                WorkQueue& victim = *m_queues[(t_index + offset) % m_queues.size()];
+                std::lock_guard<std::mutex> queueLock(victim.lock);
+                if(!victim.tasks.empty()){
+                    t_task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    --m_queued;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void ThreadPool::workerLoop(std::size_t t_index){
+            currentWorkerIndex = static_cast<long>(t_index);
+            currentWorkerPool = this;
+
+            std::function<void()> task;
+            while(true){
+                if(popTask(t_index, task)){
+                    try{
+                        task();
+                    }
+                    catch(const std::string& error){
+                        chip8Logger.log<Logger::LogError>("ThreadPool: task failed: ", error, Logger::endl);
+                    }
+                    catch(const std::exception& except){
+                        chip8Logger.log<Logger::LogError>("ThreadPool: task failed: ", except.what(), Logger::endl);
+                    }
+                    catch(...){
+                        chip8Logger.log<Logger::LogError>("ThreadPool: task failed: unknown error", Logger::endl);
+                    }
+                    task = nullptr;
+                    if(--m_pending == 0){
+                        std::lock_guard<std::mutex> idleLock(m_idleLock);
+                        m_doneCond.notify_all();
+                    }
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> idleLock(m_idleLock);
+                m_idleCond.wait(idleLock, [this]{ return m_stop || m_queued.load() > 0; });
+                if(m_stop && m_queued.load() == 0){
+                    return;
+                }
+            }
+        }
+
+        void ThreadPool::wait(){
+            std::unique_lock<std::mutex> idleLock(m_idleLock);
+            m_doneCond.wait(idleLock, [this]{ return m_pending.load() == 0; });
+        }
+
+        ThreadPool::~ThreadPool(){
+            {
+                std::lock_guard<std::mutex> idleLock(m_idleLock);
+                m_stop = true;
+                m_idleCond.notify_all();
+            }
+            for(auto& worker : m_workers){
+                worker.join();
+            }
+        }
+
+    } // namespace Util
+} // namespace Chip8
@@ -0,0 +1,58 @@
+#ifndef CHIP8_THREAD_POOL_HPP
+#define CHIP8_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Chip8{
+    namespace Util{
+
+        // Work stealing thread pool. Every worker owns a deque, tasks submitted from a worker
+        // go to the back of its own deque and are popped LIFO, idle workers steal FIFO from the
+        // front of the other deques.
+        class ThreadPool{
+
+        private:
+            struct WorkQueue{
+                std::mutex lock;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<WorkQueue>> m_queues;
+            std::vector<std::thread> m_workers;
+
+            std::mutex m_idleLock;
+            std::condition_variable m_idleCond;
+            std::condition_variable m_doneCond;
+
+            std::atomic<std::size_t> m_queued;
+            std::atomic<std::size_t> m_pending;
+            std::atomic<std::size_t> m_nextQueue;
+            bool m_stop;
+
+            bool popTask(std::size_t t_index, std::function<void()>& t_task);
+            void workerLoop(std::size_t t_index);
+
+        public:
+            ThreadPool(std::size_t t_numThreads = std::thread::hardware_concurrency());
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            void submit(std::function<void()> t_task);
+            void wait();
+            std::size_t size() const;
+
+            ~ThreadPool();
+        };
+
+    } // namespace Util
+} // namespace Chip8
+
+#endif // CHIP8_THREAD_POOL_HPP
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+#include "Trigger.hpp"
+
+namespace Chip8{
+
+namespace{
+
+// Recursive descent over the C precedence levels, emitting straight into the program. Constant operands
+// are folded or become the immediate of the instruction using them, so 'mem[0x3a0] == 3' is two instructions.
+class Compiler{
+
+private:
+    typedef TriggerProgram::Instruction Instruction;
+
+    const std::string& m_name;
+    const std::string& m_expression;
+    std::vector<Instruction>& m_code;
+    std::size_t m_pos;
+    std::size_t m_depth;
+
+    [[noreturn]] void error(const std::string& t_what) const{
+        throw std::string("Trigger '" + m_name + "': " + t_what + " at column " + std::to_string(m_pos + 1) + " of '" + m_expression + "'");
+    }
+
+    void skipSpace(){
+        while(m_pos < m_expression.size() && std::isspace(static_cast<unsigned char>(m_expression[m_pos]))){
+            ++m_pos;
+        }
+    }
+
+    bool accept(const char* t_token){
+        skipSpace();
+        std::size_t length = std::char_traits<char>::length(t_token);
+        if(m_expression.compare(m_pos, length, t_token)){
+            return false;
+        }
+        // '<' must not take the start of '<<' or '<=', '&' that of '&&' and so on
+        if(length == 1 && m_pos + 1 < m_expression.size() && std::string("<>&|=!").find(t_token[0]) != std::string::npos
+           && std::string("<>&|=").find(m_expression[m_pos + 1]) != std::string::npos
+           && (t_token[0] != '!' || m_expression[m_pos + 1] == '=')){
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    void expect(const char* t_token){
+        if(!accept(t_token)){
+            error(std::string("expected '") + t_token + "'");
+        }
+    }
+
+    bool lastIsConstant(std::size_t t_back = 1) const{
+        return m_code.size() >= t_back && m_code[m_code.size() - t_back].op == TriggerProgram::TRIGGER_PUSH;
+    }
+
+    void push(TriggerProgram::Opcode t_op, bool t_immediate, int32_t t_arg){
+        m_code.push_back(Instruction{t_op, t_immediate, t_arg});
+    }
+
+    void grow(){
+        if(++m_depth > CHIP8_TRIGGER_MAX_DEPTH){
+            error("expression needs more than " + std::to_string(CHIP8_TRIGGER_MAX_DEPTH) + " operands at once");
+        }
+    }
+
+    void emitLoad(TriggerProgram::Opcode t_op, int32_t t_arg = 0){
+        grow();
+        push(t_op, false, t_arg);
+    }
+
+    void emitMemory(TriggerProgram::Opcode t_op){
+        if(lastIsConstant()){
+            m_code.back() = Instruction{t_op, true, m_code.back().arg};
+        }
+        else{
+            push(t_op, false, 0);
+        }
+    }
+
+    void emitUnary(TriggerProgram::Opcode t_op){
+        if(lastIsConstant()){
+            int32_t& value = m_code.back().arg;
+            value = (t_op == TriggerProgram::TRIGGER_NEG)? TriggerProgram::binary(TriggerProgram::TRIGGER_SUB, 0, value)
+                                                         : (t_op == TriggerProgram::TRIGGER_NOT)? !value : ~value;
+        }
+        else{
+            push(t_op, false, 0);
+        }
+    }
+
+    void emitBinary(TriggerProgram::Opcode t_op){
+        --m_depth;
+        if(lastIsConstant() && lastIsConstant(2)){
+            int32_t rhs = m_code.back().arg;
+            m_code.pop_back();
+            m_code.back().arg = TriggerProgram::binary(t_op, m_code.back().arg, rhs);
+        }
+        else if(lastIsConstant()){
+            m_code.back() = Instruction{t_op, true, m_code.back().arg};
+        }
+        else{
+            push(t_op, false, 0);
+        }
+    }
+
+    void primary(){
+        skipSpace();
+        if(m_pos >= m_expression.size()){
+            error("expected an operand");
+        }
+        char first = m_expression[m_pos];
+        if(accept("(")){
+            expression();
+            expect(")");
+        }
+        else if(std::isdigit(static_cast<unsigned char>(first))){
+            bool hex = !m_expression.compare(m_pos, 2, "0x") || !m_expression.compare(m_pos, 2, "0X");
+            const char* start = m_expression.c_str() + m_pos;
+            char* end = nullptr;
+            unsigned long long value = std::strtoull(start, &end, (hex)? 16 : 10);
+            if(value > UINT32_MAX || (hex && end == start + 2) || std::isalnum(static_cast<unsigned char>(*end)) || *end == '_'){
+                error("malformed number");
+            }
+            m_pos += end - start;
+            grow();
+            push(TriggerProgram::TRIGGER_PUSH, false, static_cast<int32_t>(static_cast<uint32_t>(value)));
+        }
+        else if(std::isalpha(static_cast<unsigned char>(first)) || first == '_'){
+            std::size_t start = m_pos;
+            while(m_pos < m_expression.size() && (std::isalnum(static_cast<unsigned char>(m_expression[m_pos])) || m_expression[m_pos] == '_')){
+                ++m_pos;
+            }
+            std::string word = m_expression.substr(start, m_pos - start);
+            std::transform(word.begin(), word.end(), word.begin(), [](char t_char){ return std::tolower(static_cast<unsigned char>(t_char)); });
+            if(word.size() == 2 && word[0] == 'v' && std::isxdigit(static_cast<unsigned char>(word[1]))){
+                emitLoad(TriggerProgram::TRIGGER_LOAD_V, std::strtol(word.c_str() + 1, nullptr, 16));
+            }
+            else if(word == "i"){
+                emitLoad(TriggerProgram::TRIGGER_LOAD_I);
+            }
+            else if(word == "pc"){
+                emitLoad(TriggerProgram::TRIGGER_LOAD_PC);
+            }
+            else if(word == "dt"){
+                emitLoad(TriggerProgram::TRIGGER_LOAD_DT);
+            }
+            else if(word == "st"){
+                emitLoad(TriggerProgram::TRIGGER_LOAD_ST);
+            }
+            else if(word == "mem" || word == "mem16"){
+                expect("[");
+                expression();
+                expect("]");
+                emitMemory((word == "mem")? TriggerProgram::TRIGGER_LOAD_MEM : TriggerProgram::TRIGGER_LOAD_MEM16);
+            }
+            else{
+                m_pos = start;
+                error("unknown operand '" + m_expression.substr(start, word.size()) + "'");
+            }
+        }
+        else{
+            error(std::string("unexpected '") + first + "'");
+        }
+    }
+
+    void unary(){
+        if(accept("!")){
+            unary();
+            emitUnary(TriggerProgram::TRIGGER_NOT);
+        }
+        else if(accept("~")){
+            unary();
+            emitUnary(TriggerProgram::TRIGGER_BIT_NOT);
+        }
+        else if(accept("-")){
+            unary();
+            emitUnary(TriggerProgram::TRIGGER_NEG);
+        }
+        else{
+            primary();
+        }
+    }
+
+    // Binary levels from the tightest binding, each operator with its opcode
+    struct Operator{
+        const char* token;
+        TriggerProgram::Opcode op;
+    };
+
+    void level(int t_level){
+        static const std::vector<std::vector<Operator>> levels = {
+            {{"*", TriggerProgram::TRIGGER_MUL}, {"/", TriggerProgram::TRIGGER_DIV}, {"%", TriggerProgram::TRIGGER_MOD}},
+            {{"+", TriggerProgram::TRIGGER_ADD}, {"-", TriggerProgram::TRIGGER_SUB}},
+            {{"<<", TriggerProgram::TRIGGER_SHL}, {">>", TriggerProgram::TRIGGER_SHR}},
+            {{"<=", TriggerProgram::TRIGGER_LE}, {">=", TriggerProgram::TRIGGER_GE}, {"<", TriggerProgram::TRIGGER_LT}, {">", TriggerProgram::TRIGGER_GT}},
+            {{"==", TriggerProgram::TRIGGER_EQ}, {"!=", TriggerProgram::TRIGGER_NE}},
+            {{"&", TriggerProgram::TRIGGER_BIT_AND}},
+            {{"^", TriggerProgram::TRIGGER_BIT_XOR}},
+            {{"|", TriggerProgram::TRIGGER_BIT_OR}},
+            {{"&&", TriggerProgram::TRIGGER_AND}},
+            {{"||", TriggerProgram::TRIGGER_OR}}};
+
+        if(t_level < 0){
+            unary();
+            return;
+        }
+        level(t_level - 1);
+        for(bool matched = true; matched;){
+            matched = false;
+            for(const Operator& op : levels[t_level]){
+                if(accept(op.token)){
+                    level(t_level - 1);
+                    emitBinary(op.op);
+                    matched = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    void expression(){
+        level(9);
+    }
+
+public:
+    Compiler(const std::string& t_name, const std::string& t_expression, std::vector<Instruction>& t_code) : m_name(t_name),
+                                                                                                           m_expression(t_expression),
+                                                                                                           m_code(t_code),
+                                                                                                           m_pos(0),
+                                                                                                           m_depth(0){
+    }
+
+    void compile(std::size_t t_trigger){
+        expression();
+        skipSpace();
+        if(m_pos != m_expression.size()){
+            error(std::string("unexpected '") + m_expression[m_pos] + "'");
+        }
+        push(TriggerProgram::TRIGGER_RESULT, false, static_cast<int32_t>(t_trigger));
+    }
+};
+
+std::string trim(const std::string& t_text){
+    std::size_t begin = t_text.find_first_not_of(" \t\r");
+    return (begin == std::string::npos)? "" : t_text.substr(begin, t_text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+} // namespace
+
+std::size_t TriggerProgram::add(const std::string& t_name, const std::string& t_expression){
+    if(t_name.empty() || std::find_if(t_name.begin(), t_name.end(), [](char t_char){ return !std::isalnum(static_cast<unsigned char>(t_char)) && t_char != '_'; })
+                         != t_name.end()){
+        throw std::string("Trigger: invalid name '" + t_name + "', expected letters, digits and '_'");
+    }
+    if(std::find(m_names.begin(), m_names.end(), t_name) != m_names.end()){
+        throw std::string("Trigger: '" + t_name + "' is defined twice");
+    }
+    if(m_names.size() == CHIP8_TRIGGER_MAX_TRIGGERS){
+        throw std::string("Trigger: more than " + std::to_string(CHIP8_TRIGGER_MAX_TRIGGERS) + " triggers");
+    }
+
+    // A failed compile leaves the program as it was
+    std::vector<Instruction> code(m_code);
+    Compiler(t_name, t_expression, code).compile(m_names.size());
+    m_code.swap(code);
+    m_names.push_back(t_name);
+    m_expressions.push_back(t_expression);
+    return m_names.size() - 1;
+}
+
+void TriggerProgram::parse(const std::string& t_triggers){
+    std::istringstream lines(t_triggers);
+    std::string line;
+    while(std::getline(lines, line)){
+        std::istringstream entries(line.substr(0, line.find('#')));
+        std::string entry;
+        while(std::getline(entries, entry, ';')){
+            if(trim(entry).empty()){
+                continue;
+            }
+            std::size_t separator = entry.find(':');
+            if(separator == std::string::npos){
+                throw std::string("Trigger: expected '<name>: <expression>', got '" + trim(entry) + "'");
+            }
+            add(trim(entry.substr(0, separator)), trim(entry.substr(separator + 1)));
+        }
+    }
+}
+
+TriggerCounters::TriggerCounters(std::size_t t_triggers) : m_counters(t_triggers, Counter{0, 0, 0}),
+                                                            m_last(0){
+}
+
+uint64_t TriggerCounters::update(uint64_t t_results, uint64_t t_frame){
+    uint64_t fired = t_results & ~m_last;
+    m_last = t_results;
+    for(uint64_t bits = t_results; bits; bits &= bits - 1){
+        ++m_counters[__builtin_ctzll(bits)].frames;
+    }
+    for(uint64_t bits = fired; bits; bits &= bits - 1){
+        Counter& counter = m_counters[__builtin_ctzll(bits)];
+        if(!counter.fired){
+            counter.firstFrame = t_frame;
+        }
+        ++counter.fired;
+        m_events.push_back(Event{t_frame, static_cast<std::size_t>(__builtin_ctzll(bits))});
+    }
+    return fired;
+}
+
+void TriggerCounters::clear(){
+    std::fill(m_counters.begin(), m_counters.end(), Counter{0, 0, 0});
+    m_events.clear();
+    m_last = 0;
+}
+
+std::string TriggerCounters::summary(const TriggerProgram& t_program) const{
+    std::ostringstream summary;
+    for(std::size_t trigger = 0; trigger < m_counters.size(); ++trigger){
+        summary << ((trigger)? ";" : "") << t_program.name(trigger) << '=' << m_counters[trigger].fired << '/' << m_counters[trigger].frames;
+    }
+    return summary.str();
+}
+
+} // namespace Chip8
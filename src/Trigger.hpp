@@ -0,0 +1,272 @@
+#ifndef CHIP8_TRIGGER_HPP
+#define CHIP8_TRIGGER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deepest operand stack an expression may need, and triggers per program (one result bit each)
+#define CHIP8_TRIGGER_MAX_DEPTH    16
+#define CHIP8_TRIGGER_MAX_TRIGGERS 64
+
+namespace Chip8{
+
+// Conditions on guest state compiled once into one flat bytecode program and evaluated against any number of
+// interpreters, e.g. once per frame. Expressions use C syntax and precedence over 32 bit signed integers:
+//
+//     mem[0x3a0] == 3 && V5 > 10
+//
+// Operands are decimal or 0x prefixed hex numbers, V0-VF, I, PC, DT, ST, mem[addr] (a byte) and mem16[addr]
+// (a big endian word), addresses wrap at the memory size. Operators are ( ) ! ~ unary -, * / %, + -, << >>,
+// < <= > >=, == !=, &, ^, |, && and ||. Reads have no side effects, so && and || evaluate both sides and the
+// program has no jumps; x / 0 and x % 0 are 0.
+//
+// Evaluation never touches run_tick, it reads the interpreter between ticks through getRegisters(),
+// getProgramCounter(), getIndexRegister(), getDelayTimer(), getSoundTimer() and readMemory(), so it takes
+// BasicChip8 and ExtendedChip8 directly, and Machine::evaluate() for run time variants.
+class TriggerProgram{
+
+public:
+    enum Opcode : uint8_t{
+        // Operand-less loads push, LOAD_MEM and LOAD_MEM16 replace the address on top unless immediate
+        TRIGGER_PUSH,
+        TRIGGER_LOAD_V,
+        TRIGGER_LOAD_I,
+        TRIGGER_LOAD_PC,
+        TRIGGER_LOAD_DT,
+        TRIGGER_LOAD_ST,
+        TRIGGER_LOAD_MEM,
+        TRIGGER_LOAD_MEM16,
+        TRIGGER_NEG,
+        TRIGGER_NOT,
+        TRIGGER_BIT_NOT,
+        // Pops the value of trigger arg into its result bit
+        TRIGGER_RESULT,
+        // Binary operators take the right operand from arg when immediate, from the stack otherwise
+        TRIGGER_MUL,
+        TRIGGER_DIV,
+        TRIGGER_MOD,
+        TRIGGER_ADD,
+        TRIGGER_SUB,
+        TRIGGER_SHL,
+        TRIGGER_SHR,
+        TRIGGER_LT,
+        TRIGGER_LE,
+        TRIGGER_GT,
+        TRIGGER_GE,
+        TRIGGER_EQ,
+        TRIGGER_NE,
+        TRIGGER_BIT_AND,
+        TRIGGER_BIT_XOR,
+        TRIGGER_BIT_OR,
+        TRIGGER_AND,
+        TRIGGER_OR
+    };
+
+    struct Instruction{
+        Opcode op;
+        bool immediate;
+        int32_t arg;
+    };
+
+private:
+    std::vector<std::string> m_names;
+    std::vector<std::string> m_expressions;
+    std::vector<Instruction> m_code;
+
+public:
+    // Value of a binary operator, the compiler folds constants with it
+    static int32_t binary(Opcode t_op, int32_t t_lhs, int32_t t_rhs){
+        // Unsigned arithmetic so overflow wraps instead of being undefined
+        uint32_t lhs = static_cast<uint32_t>(t_lhs);
+        uint32_t rhs = static_cast<uint32_t>(t_rhs);
+        switch(t_op){
+            case TRIGGER_MUL:       return static_cast<int32_t>(lhs * rhs);
+            case TRIGGER_DIV:       return (t_rhs && !(t_lhs == INT32_MIN && t_rhs == -1))? t_lhs / t_rhs : 0;
+            case TRIGGER_MOD:       return (t_rhs && t_rhs != -1)? t_lhs % t_rhs : 0;
+            case TRIGGER_ADD:       return static_cast<int32_t>(lhs + rhs);
+            case TRIGGER_SUB:       return static_cast<int32_t>(lhs - rhs);
+            case TRIGGER_SHL:       return static_cast<int32_t>(lhs << (rhs & 31));
+            case TRIGGER_SHR:       return t_lhs >> (rhs & 31);
+            case TRIGGER_LT:        return t_lhs < t_rhs;
+            case TRIGGER_LE:        return t_lhs <= t_rhs;
+            case TRIGGER_GT:        return t_lhs > t_rhs;
+            case TRIGGER_GE:        return t_lhs >= t_rhs;
+            case TRIGGER_EQ:        return t_lhs == t_rhs;
+            case TRIGGER_NE:        return t_lhs != t_rhs;
+            case TRIGGER_BIT_AND:   return t_lhs & t_rhs;
+            case TRIGGER_BIT_XOR:   return t_lhs ^ t_rhs;
+            case TRIGGER_BIT_OR:    return t_lhs | t_rhs;
+            case TRIGGER_AND:       return t_lhs && t_rhs;
+            case TRIGGER_OR:        return t_lhs || t_rhs;
+            default:                return 0;
+        }
+    }
+
+    // Compiles t_expression as trigger t_name, names are letters, digits and '_'. Throws std::string with
+    // the position of the error.
+    std::size_t add(const std::string& t_name, const std::string& t_expression);
+    // Adds triggers from a list of '<name>: <expression>' separated by ';' or new lines, '#' comments out
+    // the rest of a line
+    void parse(const std::string& t_triggers);
+
+    // Bit t set when trigger t holds in the current state of t_chip8
+    template<typename TChip8>
+    uint64_t evaluate(const TChip8& t_chip8) const{
+        int32_t stack[CHIP8_TRIGGER_MAX_DEPTH];
+        int32_t* top = stack;
+        int32_t rhs;
+        uint64_t results = 0;
+        for(const Instruction& instruction : m_code){
+            switch(instruction.op){
+                case TRIGGER_PUSH:
+                    *top++ = instruction.arg;
+                    break;
+                case TRIGGER_LOAD_V:
+                    *top++ = t_chip8.getRegisters()[instruction.arg];
+                    break;
+                case TRIGGER_LOAD_I:
+                    *top++ = t_chip8.getIndexRegister();
+                    break;
+                case TRIGGER_LOAD_PC:
+                    *top++ = t_chip8.getProgramCounter();
+                    break;
+                case TRIGGER_LOAD_DT:
+                    *top++ = t_chip8.getDelayTimer();
+                    break;
+                case TRIGGER_LOAD_ST:
+                    *top++ = t_chip8.getSoundTimer();
+                    break;
+                case TRIGGER_LOAD_MEM:
+                    if(instruction.immediate){
+                        *top++ = t_chip8.readMemory(instruction.arg);
+                    }
+                    else{
+                        top[-1] = t_chip8.readMemory(top[-1]);
+                    }
+                    break;
+                case TRIGGER_LOAD_MEM16:{
+                    uint32_t addr = (instruction.immediate)? instruction.arg : *--top;
+                    *top++ = (t_chip8.readMemory(addr) << 8) | t_chip8.readMemory(addr + 1);
+                    break;
+                }
+                case TRIGGER_NEG:
+                    top[-1] = static_cast<int32_t>(0u - static_cast<uint32_t>(top[-1]));
+                    break;
+                case TRIGGER_NOT:
+                    top[-1] = !top[-1];
+                    break;
+                case TRIGGER_BIT_NOT:
+                    top[-1] = ~top[-1];
+                    break;
+                case TRIGGER_RESULT:
+                    results |= static_cast<uint64_t>(*--top != 0) << instruction.arg;
+                    break;
+                case TRIGGER_EQ:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] == rhs;
+                    break;
+                case TRIGGER_NE:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] != rhs;
+                    break;
+                case TRIGGER_LT:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] < rhs;
+                    break;
+                case TRIGGER_LE:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] <= rhs;
+                    break;
+                case TRIGGER_GT:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] > rhs;
+                    break;
+                case TRIGGER_GE:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] >= rhs;
+                    break;
+                case TRIGGER_AND:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] && rhs;
+                    break;
+                case TRIGGER_OR:
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = top[-1] || rhs;
+                    break;
+                default:
+                    // Arithmetic is rarer in conditions than comparisons and logic, it shares one dispatch
+                    rhs = (instruction.immediate)? instruction.arg : *--top;
+                    top[-1] = binary(instruction.op, top[-1], rhs);
+                    break;
+            }
+        }
+        return results;
+    }
+
+    std::size_t size() const{
+        return m_names.size();
+    }
+
+    bool empty() const{
+        return m_names.empty();
+    }
+
+    const std::string& name(std::size_t t_trigger) const{
+        return m_names[t_trigger];
+    }
+
+    const std::string& expression(std::size_t t_trigger) const{
+        return m_expressions[t_trigger];
+    }
+
+    const std::vector<Instruction>& code() const{
+        return m_code;
+    }
+};
+
+// What the triggers of a program did over the frames of one interpreter, fed with the results of
+// TriggerProgram::evaluate. A trigger fires when it starts to hold, each firing is kept as an event.
+class TriggerCounters{
+
+public:
+    struct Counter{
+        // Firings, evaluations it held at, and the frame of its first firing
+        uint64_t fired;
+        uint64_t frames;
+        uint64_t firstFrame;
+    };
+
+    struct Event{
+        uint64_t frame;
+        std::size_t trigger;
+    };
+
+private:
+    std::vector<Counter> m_counters;
+    std::vector<Event> m_events;
+    uint64_t m_last;
+
+public:
+    explicit TriggerCounters(std::size_t t_triggers = 0);
+
+    // Records the results of one evaluation at t_frame, returns the triggers that fired
+    uint64_t update(uint64_t t_results, uint64_t t_frame);
+    void clear();
+
+    const std::vector<Counter>& counters() const{
+        return m_counters;
+    }
+
+    const std::vector<Event>& events() const{
+        return m_events;
+    }
+
+    // '<name>=<fired>/<frames>' per trigger separated by ';', for one CSV column
+    std::string summary(const TriggerProgram& t_program) const;
+};
+
+} // namespace Chip8
+
+#endif // CHIP8_TRIGGER_HPP
@@ -16,13 +16,23 @@
 #include <iomanip>
 #include <ctype.h>
 #include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include "Chip8.hpp"
 #include "Chip8Util.hpp"
 #include "IniReader.hpp"
 #include "KeyHandler.hpp"
 #include "Chip8Emulator.hpp"
+#include "Chip8TiledEmulator.hpp"
+#include "Replay.hpp"
 #include "LoggerImpl.hpp"
+#include "MemorySearch.hpp"
+#include "Profiler.hpp"
+#include "RomLibrary.hpp"
+#include "Trigger.hpp"
 
 #include <SDL2/SDL.h>
 
@@ -31,12 +41,35 @@ static const option long_opts[] =   {{"resolution",  required_argument,  0,  'r'
                                      {"log_level",   required_argument,  0,  0},
                                      {"log_file",    optional_argument,  0,  0},
                                      {"config",      required_argument,  0,  'c'},
+                                     {"scan",        required_argument,  0,  's'},
+                                     {"sessions",    required_argument,  0,  'n'},
                                      {"help",        no_argument,        0,  'h'},
+                                     {"record",      required_argument,  0,  0},
+                                     {"replay",      required_argument,  0,  0},
+                                     {"netplay",     required_argument,  0,  0},
+                                     {"gdb",         required_argument,  0,  0},
+                                     {"profile",     required_argument,  0,  0},
                                      {0,             0,                  0,  0}};
 
-static const char usage[] = "[ROM File] [Options]\n"
+static const char usage[] = "[ROM File]... [Options]\n"
                             "\t-r, --res=WxH           set the display resolution to WxH\n"
                             "\t-c, --config=FILE       set emulator ini file to read configuration from.\n" 
+                            "\t-s, --scan=DIR          hash every rom below DIR into the rom index, list hash, profile and path\n"
+                            "\t                        then exit; unchanged roms are not read again\n"
+                            "\t-n, --sessions=N        run N sessions of every rom, each with its own seed; more than one\n"
+                            "\t                        session in total opens a tiled window, TAB or a click moves the focus\n"
+                            "\t    --record=FILE       record the session's seed and key presses, by emulated cycle, into FILE\n"
+                            "\t                        when the window closes\n"
+                            "\t    --replay=FILE       run the rom through the session recorded in FILE without a window, as\n"
+                            "\t                        fast as it goes, and check it ends in the recorded state\n"
+                            "\t    --netplay=PORT:HOST:PEER_PORT\n"
+                            "\t                        play with the peer at HOST:PEER_PORT from local PORT over UDP; both\n"
+                            "\t                        sides run the same rom with seed 0, each player keeps to their own keys\n"
+                            "\t    --gdb=ADDR          wait for a gdb remote protocol client on ADDR, 'PORT', 'HOST:PORT' or\n"
+                            "\t                        'unix:PATH', and run the rom from reset under its control\n"
+                            "\t    --profile=FILE      count instructions per opcode class and time a sample of them, written\n"
+                            "\t                        to FILE on exit or key_emu_profile, JSON for a .json FILE, CSV otherwise;\n"
+                            "\t                        also profiles a --replay\n"
                             "\t    --log_level=LEVEL   set logger level, any message with level below LEVEL is ignored;\n"
                             "\t                        LEVEL can be 'all', 'fatal', 'error', 'warning', 'debug', 'trace'\n"
                             "\t                        'info'\n"
@@ -51,7 +84,7 @@ namespace arg = std::placeholders;
 int main(int argc, char** argv){
 
     std::pair<int, int> resolution = {0, 0};
-    std::pair<SDL_Color, SDL_Color> palette;
+    std::array<SDL_Color, CHIP8_NUM_COLORS> palette;
     std::unordered_map<Chip8::KeyHandler::KeyPair, Chip8::KeyHandler::KeyAction> bindMap;
 
     union{
@@ -64,12 +97,36 @@ int main(int argc, char** argv){
 
     int opt, longopt_ind = 0;
     std::string romPath;
+    std::vector<std::string> romPaths;
+    unsigned long sessions = 1;
+    std::string recordPath;
+    std::string replayPath;
+    std::string netplayPeer;
+    uint16_t netplayPort = 0, netplayPeerPort = 0;
+    long netplayLatencyMsec = 0;
+    int netplayLossPercent = 0;
+    std::regex netplayRegex("(\\d+):(.+):(\\d+)");
+    std::string gdbAddress;
+    std::string profilePath;
+    int profileSamplePeriod = CHIP8_PROFILE_DEFAULT_PERIOD;
     std::string logFile;
     std::string configFile = "res/config.ini";
+    std::string scanPath;
+    long tickPeriodUsec = CHIP8_TICK_PERIOD_USEC;
+    std::string quirks;
+    uint64_t romHash = 0;
+    bool bootSnapshot = true;
+    std::vector<Chip8::TileConfig> tiles;
+    std::string bootDirectory;
+    int rewindSeconds = 0;
+    int rewindBufferKb = 0;
+    int runAheadFrames = 0;
+    Chip8::MemoryPins pins;
+    Chip8::TriggerProgram triggers;
     std::regex resolutionRegex("(\\d*)x(\\d*)");
     std::cmatch matchRes;
     opterr = 0;
-    while((opt = getopt_long(argc, argv, "r:c:h", long_opts, &longopt_ind)) != -1){
+    while((opt = getopt_long(argc, argv, "r:c:s:n:h", long_opts, &longopt_ind)) != -1){
         switch(opt){
             case 'r':
                 if(std::regex_match(optarg, matchRes, resolutionRegex)){
@@ -83,6 +140,17 @@ int main(int argc, char** argv){
                 break;
             case 'c':
                 configFile = std::string(optarg);
+                break;
+            case 's':
+                scanPath = std::string(optarg);
+                break;
+            case 'n':
+                sessions = std::strtoul(optarg, nullptr, 10);
+                if(sessions == 0){
+                    std::cerr << argv[0] << ": Error option '-n | --sessions' argument '" << optarg << "' is not recognized\nTry '" << argv[0] << " --help for more information" << std::endl;
+                    exit(-1);
+                }
+                break;
             case 'h':
                 std::cout << "Usage: " << argv[0] << usage << std::endl;
                 exit(0);
@@ -129,6 +197,34 @@ int main(int argc, char** argv){
                         flags.logFile = 1;
                         logFile = std::string(optarg);
                         break;
+                    case 8:
+                        // record
+                        recordPath = std::string(optarg);
+                        break;
+                    case 9:
+                        // replay
+                        replayPath = std::string(optarg);
+                        break;
+                    case 10:
+                        // netplay
+                        if(std::regex_match(optarg, matchRes, netplayRegex)){
+                            netplayPort = std::strtoul(matchRes[1].str().c_str(), nullptr, 10);
+                            netplayPeer = matchRes[2].str();
+                            netplayPeerPort = std::strtoul(matchRes[3].str().c_str(), nullptr, 10);
+                        }
+                        else{
+                            std::cerr << argv[0] << ": Error option '--netplay' argument '" << optarg << "' is not recognized\nTry '" << argv[0] << " --help for more information" << std::endl;
+                            exit(-1);
+                        }
+                        break;
+                    case 11:
+                        // gdb
+                        gdbAddress = std::string(optarg);
+                        break;
+                    case 12:
+                        // profile
+                        profilePath = std::string(optarg);
+                        break;
                 }
                 break;
             case 'l':
@@ -157,10 +253,13 @@ int main(int argc, char** argv){
             std::cerr << argv[0] << ": Error file '" << argv[optind] <<  "' not found" << std::endl;
             exit(-1);
         }
-     romPath = argv[optind];
+        romPaths.push_back(argv[optind]);
         optind++;
     }
-    if(romPath.empty()){
+    if(!romPaths.empty()){
+        romPath = romPaths.front();
+    }
+    if(romPath.empty() && scanPath.empty()){
         std::cerr << "Error: No input file path to chip8 rom." << std::endl;
         exit(-1);
     }
@@ -181,23 +280,98 @@ int main(int argc, char** argv){
     try{
         IniReader config(configFile);
 
-        resolution.first = config.getInt("Display", "disp_width", 640);
-        resolution.second = config.getInt("Display", "disp_height", 480);
+        Chip8::RomLibrary library(config.getString("Library", "index_file", "res/rom_index"), config.getString("Library", "profile_file", "res/profiles.ini"));
+        if(!scanPath.empty()){
+            for(const std::string& scannedPath : library.scan(scanPath)){
+                uint64_t romHash = library.hash(scannedPath);
+                const Chip8::RomProfile* romProfile = library.profile(romHash);
+                std::cout << std::hex << std::setw(16) << std::setfill('0') << romHash << std::dec << ' ' << ((romProfile)? romProfile->name : "-") << ' ' << scannedPath << '\n';
+            }
+            std::cerr << "Hashed " << library.hashed() << " new or changed roms" << std::endl;
+            library.save();
+            exit(0);
+        }
+
+        // Per rom settings override the config, launching looks the rom up by content so renamed copies keep their profile
+        romHash = library.hash(romPath);
+        const Chip8::RomProfile* romProfile = library.profile(romHash);
+        library.save();
+        chip8Logger.log<Logger::LogTrace>("Rom hash: ", std::hex, std::setw(16), std::setfill('0'), romHash, " profile: ", (romProfile)? romProfile->name : "none", Logger::endl);
+        if(romProfile){
+            tickPeriodUsec = romProfile->tickPeriodUsec();
+            quirks = romProfile->machineQuirks();
+            chip8Logger.log<Logger::LogTrace>("Profile: ipf=", std::dec, romProfile->instructionsPerFrame, " quirks=", romProfile->quirks, Logger::endl);
+        }
+
+        // Resets and relaunches start from the rom's state at its first input wait, kept in boot_dir when set
+        bootSnapshot = config.getBool("Library", "boot_snapshot", true);
+        bootDirectory = config.getString("Library", "boot_dir", "");
 
-        int fg_raw = config.getInt("Display", "disp_fg_color", 0x000000);
-        int bg_raw = config.getInt("Display", "disp_bg_color", 0xFFFFFF);
+        // Rewind history, a minute of CHIP-8 frames is typically well under the default 512 KiB
+        rewindSeconds = config.getInt("Rewind", "rewind_seconds", 60);
+        rewindBufferKb = config.getInt("Rewind", "rewind_buffer_kb", 512);
 
-        palette.second.r = (bg_raw >> 16) & 0xFF;
-        palette.second.g = (bg_raw >> 8) & 0xFF;
-        palette.second.b = bg_raw & 0xFF;
-        palette.second.a = 0xFF;
+        // Frames of the rom's own input lag to hide, each costs a frame of emulation per frame
+        runAheadFrames = config.getInt("RunAhead", "run_ahead_frames", 0);
 
-        palette.first.r = (fg_raw >> 16) & 0xFF;
-        palette.first.g = (fg_raw >> 8) & 0xFF;
-        palette.first.b = fg_raw & 0xFF;
-        palette.first.a = 0xFF;
+        // Addresses forced every frame, found with a MemorySearch
+        pins.parse(config.getString("Cheats", "pins", ""));
+        triggers.parse(config.getString("Triggers", "triggers", ""));
 
-        auto chip8IniBinds = config.getHeaderValues("Keys");
+        // Instructions per timed one on average with --profile
+        profileSamplePeriod = config.getInt("Profile", "sample_period", CHIP8_PROFILE_DEFAULT_PERIOD);
+
+        // Delay and loss added to every datagram sent, to try netplay on one machine
+        netplayLatencyMsec = config.getInt("Netplay", "inject_latency_ms", 0);
+        netplayLossPercent = config.getInt("Netplay", "inject_loss_percent", 0);
+
+        resolution.first = config.getInt("Display", "disp_width", 640);
+        resolution.second = config.getInt("Display", "disp_height", 480);
+
+        auto profilePalette = [&config](const Chip8::RomProfile* t_profile){
+            int fg_raw = (t_profile && t_profile->hasFgColor)? t_profile->fgColor : config.getInt("Display", "disp_fg_color", 0x000000);
+            int bg_raw = (t_profile && t_profile->hasBgColor)? t_profile->bgColor : config.getInt("Display", "disp_bg_color", 0xFFFFFF);
+
+            // XO-CHIP programs light pixels in a second plane and in both planes, shown in two more colours
+            int color2_raw = config.getInt("Display", "disp_color2", 0xFF0000);
+            int color3_raw = config.getInt("Display", "disp_color3", 0x000080);
+
+            const int palette_raw[] = {bg_raw, fg_raw, color2_raw, color3_raw};
+            std::array<SDL_Color, CHIP8_NUM_COLORS> profileColors;
+            for(std::size_t color = 0; color < profileColors.size(); ++color){
+                profileColors[color].r = (palette_raw[color] >> 16) & 0xFF;
+                profileColors[color].g = (palette_raw[color] >> 8) & 0xFF;
+                profileColors[color].b = palette_raw[color] & 0xFF;
+                profileColors[color].a = 0xFF;
+            }
+            return profileColors;
+        };
+        palette = profilePalette(romProfile);
+
+        // Several roms or sessions share one tiled window, each tile keeps its own rom's profile
+        if(romPaths.size() > 1 || sessions > 1){
+            uint64_t seed = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            for(const std::string& tilePath : romPaths){
+                uint64_t tileHash = library.hash(tilePath);
+                const Chip8::RomProfile* tileProfile = library.profile(tileHash);
+                for(unsigned long session = 0; session < sessions; ++session){
+                    tiles.push_back({tilePath, tileHash, (tileProfile)? tileProfile->machineQuirks() : "", (tileProfile)? tileProfile->tickPeriodUsec() : CHIP8_TICK_PERIOD_USEC,
+                                     seed++, profilePalette(tileProfile)});
+                }
+            }
+            library.save();
+        }
+
+        std::map<std::string, std::string> chip8IniBinds;
+        for(const auto& iniBind : config.getHeaderValues("Keys")){
+            chip8IniBinds[iniBind.first] = iniBind.second;
+        }
+        // Profile key binds would apply to every tile, so only a single session takes them
+        if(romProfile && romPaths.size() == 1 && sessions == 1){
+            for(const auto& profileBind : romProfile->keyBinds){
+                chip8IniBinds[profileBind.first] = profileBind.second;
+            }
+        }
 
         for(auto iniBindsIt = chip8IniBinds.begin(); iniBindsIt != chip8IniBinds.end(); ++iniBindsIt){
             Chip8::KeyHandler::KeyAction bindAction = Chip8::KeyHandler::getActionFromName(iniBindsIt->first);
@@ -251,6 +425,44 @@ int main(int argc, char** argv){
         exit(-1);
     }
 
+    // A replay needs no window, it runs as fast as the interpreter goes and reports whether the session came out the same
+    if(!replayPath.empty()){
+        try{
+            Chip8::Replay replay(replayPath);
+            if(replay.romHash() != romHash){
+                std::cerr << argv[0] << ": Error '" << replayPath << "' was recorded with another rom than '" << romPath << "'" << std::endl;
+                exit(-1);
+            }
+            std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine(replay.quirks(), replay.seed());
+            machine->load(romPath);
+            // A profile covers every instruction from reset, so it runs the boot too
+            if(bootSnapshot && profilePath.empty()){
+                machine->boot(romHash, bootDirectory);
+            }
+
+            std::unique_ptr<Chip8::Profiler> profiler((profilePath.empty())? nullptr : new Chip8::Profiler(std::max(0, profileSamplePeriod)));
+            auto start = std::chrono::steady_clock::now();
+            std::string fault = replay.play(*machine, machine->bootTicks(), profiler.get());
+            auto usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if(profiler){
+                profiler->save(profilePath, machine->counters());
+            }
+
+            uint64_t stateHash = machine->stateHash();
+            std::cout << "Replayed " << replay.cycles() << " cycles, " << replay.events().size() << " key changes in " << usec << " usec" << std::endl;
+            if(!fault.empty()){
+                std::cout << "Session ended in fault: " << fault << std::endl;
+            }
+            std::cout << "State hash 0x" << std::hex << std::setw(16) << std::setfill('0') << stateHash
+                      << ", recorded 0x" << std::setw(16) << replay.finalHash() << std::dec << ((stateHash == replay.finalHash())? " (match)" : " (MISMATCH)") << std::endl;
+            exit((stateHash == replay.finalHash())? 0 : 1);
+        }
+        catch(const std::string& error){
+            std::cerr << argv[0] << ": Error " << error << std::endl;
+            exit(-1);
+        }
+    }
+
     if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) == -1){
         std::cerr << "SDL Error:" << SDL_GetError() << std::endl;
     }
@@ -261,19 +473,80 @@ int main(int argc, char** argv){
 
     chip8Logger.log<Logger::LogTrace>("Resolution: ", resolution.first, "x", resolution.second, Logger::endl);
     chip8Logger.log<Logger::LogTrace>("Rom: ", romPath, Logger::endl);
-    chip8Logger.log<Logger::LogTrace>("Palette: fg=0x", std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.first.r),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.first.g),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.first.b),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.first.a),
-                                              " bg=0x", std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.second.r),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.second.g),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.second.b),
-                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette.second.a), Logger::endl);
+    chip8Logger.log<Logger::LogTrace>("Palette: fg=0x", std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[1].r),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[1].g),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[1].b),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[1].a),
+                                              " bg=0x", std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[0].r),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[0].g),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[0].b),
+                                                        std::hex, std::setw(2), std::setfill('0'), static_cast<int>(palette[0].a), Logger::endl);
 
 
-    Chip8::Emulator emulator(resolution, palette, romPath, bindMap, true);
+    try{
+        if(!tiles.empty()){
+            if(!recordPath.empty()){
+                std::cerr << argv[0] << ": Warning '--record' only records a single session, ignored" << std::endl;
+            }
+            if(!profilePath.empty()){
+                std::cerr << argv[0] << ": Warning '--profile' only profiles a single session, ignored" << std::endl;
+            }
+            Chip8::TiledEmulator tiledEmulator(resolution, tiles, bindMap, bootSnapshot, bootDirectory);
+            tiledEmulator.run();
+            SDL_Quit();
+            return(0);
+        }
+
+        // Netplay peers have to start from the same seed, and rewinding, running ahead or recording one peer alone would desync it
+        Chip8::Emulator emulator(resolution, palette, romPath, bindMap, netplayPeer.empty(), tickPeriodUsec, quirks);
+        if(!gdbAddress.empty()){
+            // The client takes over from the first instruction, rewinding or running ahead would move the machine under it
+            emulator.enableGdb(gdbAddress);
+            emulator.run();
+            SDL_Quit();
+            return(0);
+        }
+        if(bootSnapshot && profilePath.empty()){
+            emulator.boot(romHash, bootDirectory);
+        }
+        if(!netplayPeer.empty()){
+            emulator.enableNetplay(netplayPort, netplayPeer, netplayPeerPort, netplayLatencyMsec, std::max(0, netplayLossPercent));
+            emulator.run();
+            SDL_Quit();
+            return(0);
+        }
+        if(rewindSeconds > 0 && rewindBufferKb > 0){
+            emulator.enableRewind(rewindSeconds, static_cast<std::size_t>(rewindBufferKb) << 10);
+        }
+        if(!recordPath.empty()){
+            emulator.startRecording(recordPath, romHash);
+        }
+        if(runAheadFrames > 0){
+            emulator.enableRunAhead(runAheadFrames);
+        }
+        if(!pins.empty()){
+            // A replay runs without them and would not reproduce the session
+            if(!recordPath.empty()){
+                std::cerr << argv[0] << ": Warning '[Cheats] pins' are not recorded, ignored while recording" << std::endl;
+            }
+            else{
+                emulator.setPins(pins);
+            }
+        }
+        if(!triggers.empty()){
+            emulator.setTriggers(triggers);
+        }
+        if(!profilePath.empty()){
+            emulator.enableProfile(profilePath, std::max(0, profileSamplePeriod));
+        }
 
-    emulator.run();
+        emulator.run();
+    }
+    catch(const std::string& error){
+        std::cerr << argv[0] << ": Error " << error << std::endl;
+        SDL_Quit();
+        exit(-1);
+    }
 
     SDL_Quit();
 
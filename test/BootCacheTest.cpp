@@ -0,0 +1,98 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/BootCache.hpp"
+#include "../src/Chip8.hpp"
+#include "../src/Chip8Extended.hpp"
+
+// LD V0, 5; LD I, 0x300; LD B, V0; RND V1, 0xff; SKP V1; JP 0x20a
+static const std::vector<uint8_t> bootRom = {0x60, 0x05, 0xa3, 0x00, 0xf0, 0x33, 0xc1, 0xff, 0xe1, 0x9e, 0x12, 0x0a};
+
+template<typename TChip8>
+static std::unique_ptr<TChip8> loadedBootRom(uint64_t t_seed){
+    std::unique_ptr<TChip8> chip8(new TChip8(t_seed));
+    chip8->load(bootRom.data(), bootRom.size());
+    return chip8;
+}
+
+BOOST_AUTO_TEST_CASE(BootCacheTest_restore_matches_cold_run){
+    std::unique_ptr<Chip8::Chip8> boot = loadedBootRom<Chip8::Chip8>(0);
+    BOOST_CHECK_EQUAL(boot->runToInput(100), 3);
+    BOOST_CHECK_EQUAL(boot->getMemory().privatePages(), 0);
+    BOOST_CHECK_EQUAL(boot->getMemory()[0x302], 5);
+
+    // Keys pressed during the boot only take effect at the first instruction reading them
+    std::unique_ptr<Chip8::Chip8> cold = loadedBootRom<Chip8::Chip8>(42);
+    std::unique_ptr<Chip8::Chip8> warm(new Chip8::Chip8(7));
+    warm->restore(*boot, 42);
+    for(int tick = 0; tick < 3; ++tick){
+        if(tick == 1){
+            cold->updateKeystate(true, false, Chip8::KEY_3);
+        }
+        cold->run_tick();
+    }
+    warm->updateKeystate(true, false, Chip8::KEY_3);
+    for(int tick = 0; tick < 20; ++tick){
+        cold->run_tick();
+        warm->run_tick();
+    }
+    BOOST_CHECK_EQUAL(warm->fullStateHash(), cold->fullStateHash());
+    BOOST_CHECK_EQUAL(warm->stateHash(), cold->stateHash());
+
+    std::unique_ptr<Chip8::XoChip8> xoBoot = loadedBootRom<Chip8::XoChip8>(0);
+    BOOST_CHECK_EQUAL(xoBoot->runToInput(100), 3);
+    std::unique_ptr<Chip8::XoChip8> xoCold = loadedBootRom<Chip8::XoChip8>(42);
+    std::unique_ptr<Chip8::XoChip8> xoWarm(new Chip8::XoChip8(0));
+    xoWarm->restore(*xoBoot, 42);
+    for(int tick = 0; tick < 3; ++tick){
+        xoCold->run_tick();
+    }
+    for(int tick = 0; tick < 20; ++tick){
+        xoCold->run_tick();
+        xoWarm->run_tick();
+    }
+    BOOST_CHECK_EQUAL(xoWarm->stateHash(), xoCold->stateHash());
+}
+
+BOOST_AUTO_TEST_CASE(BootCacheTest_directory){
+    std::unique_ptr<Chip8::Chip8> loaded = loadedBootRom<Chip8::Chip8>(0);
+    uint64_t bootHash;
+    {
+        Chip8::BootCache<Chip8::Chip8> cache("legacy", "BootCacheTest_boot");
+        const Chip8::BootState<Chip8::Chip8>& boot = cache.boot(0x1234, *loaded);
+        BOOST_CHECK_EQUAL(boot.ticks, 3);
+        BOOST_CHECK_EQUAL(&cache.boot(0x1234, *loaded), &boot);
+        bootHash = boot.state->stateHash();
+    }
+    BOOST_CHECK(std::ifstream("BootCacheTest_boot/0000000000001234-legacy.boot").good());
+
+    // A new cache reads the state back instead of booting, even from an instance that has not loaded the rom
+    Chip8::Chip8 blank(0);
+    Chip8::BootCache<Chip8::Chip8> reread("legacy", "BootCacheTest_boot");
+    const Chip8::BootState<Chip8::Chip8>& boot = reread.boot(0x1234, blank);
+    BOOST_CHECK_EQUAL(boot.ticks, 3);
+    BOOST_CHECK_EQUAL(boot.state->stateHash(), bootHash);
+    // Boot files leave the generator out, every generator policy of a variant shares them
+    Chip8::Chip8Xorshift blankXorshift(0);
+    Chip8::BootCache<Chip8::Chip8Xorshift> xorshift("legacy", "BootCacheTest_boot");
+    BOOST_CHECK_EQUAL(xorshift.boot(0x1234, blankXorshift).ticks, 3);
+    BOOST_CHECK_EQUAL(xorshift.boot(0x1234, blankXorshift).state->stateHash(), bootHash);
+
+    std::remove("BootCacheTest_boot/0000000000001234-legacy.boot");
+    rmdir("BootCacheTest_boot");
+
+    // A rom that never waits for input keeps its loaded state
+    const uint8_t spin[] = {0x12, 0x00};
+    Chip8::Chip8 spinning(0);
+    spinning.load(spin, sizeof(spin));
+    Chip8::BootCache<Chip8::Chip8> limited("legacy", "", 100);
+    BOOST_CHECK_EQUAL(limited.boot(0x5678, spinning).ticks, 0);
+    BOOST_CHECK_EQUAL(limited.boot(0x5678, spinning).state->stateHash(), spinning.stateHash());
+}
@@ -0,0 +1,130 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "../src/Chip8Extended.hpp"
+#include "../src/Chip8Machine.hpp"
+
+template<typename TChip8>
+class ExtendedProbe : public TChip8{
+public:
+    ExtendedProbe(const std::vector<uint8_t>& t_rom, std::size_t t_ticks) : TChip8(0){
+        this->load(t_rom.data(), t_rom.size());
+        for(std::size_t i = 0; i < t_ticks; ++i){
+            this->run_tick();
+        }
+    }
+
+    using TChip8::m_vRegs;
+    using TChip8::m_iReg;
+    using TChip8::m_programCounter;
+    using TChip8::read;
+
+    uint8_t pixel(std::size_t t_x, std::size_t t_y) const{
+        return this->getDisplay().pixel(t_x, t_y);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(Chip8ExtendedTest_hires_scroll){
+    // HIGH; LD I, sprite; LD V0, 0; DRW V0, V0, 0; SCR; SCD 2
+    std::vector<uint8_t> rom = {0x00, 0xff, 0xa2, 0x0e, 0x60, 0x00, 0xd0, 0x00, 0x00, 0xfb, 0x00, 0xc2, 0x12, 0x0c};
+    rom.insert(rom.end(), 32, 0xff);
+
+    ExtendedProbe<Chip8::SuperChip8> drawn(rom, 4);
+    BOOST_CHECK(drawn.hiRes());
+    BOOST_CHECK_EQUAL(drawn.pixel(0, 0), 1);
+    BOOST_CHECK_EQUAL(drawn.pixel(15, 15), 1);
+    BOOST_CHECK_EQUAL(drawn.pixel(16, 0), 0);
+    BOOST_CHECK_EQUAL(drawn.pixel(0, 16), 0);
+    BOOST_CHECK_EQUAL(drawn.m_vRegs[0xf], 0);
+
+    ExtendedProbe<Chip8::SuperChip8> scrolled(rom, 6);
+    BOOST_CHECK_EQUAL(scrolled.pixel(3, 2), 0);
+    BOOST_CHECK_EQUAL(scrolled.pixel(4, 2), 1);
+    BOOST_CHECK_EQUAL(scrolled.pixel(19, 17), 1);
+    BOOST_CHECK_EQUAL(scrolled.pixel(20, 2), 0);
+    BOOST_CHECK_EQUAL(scrolled.pixel(4, 1), 0);
+    BOOST_CHECK_EQUAL(scrolled.pixel(4, 18), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8ExtendedTest_lores_clip_and_wrap){
+    // Font sprite 0 at low resolution (62, 30) crosses the right and bottom edges
+    const std::vector<uint8_t> rom = {0x60, 0x00, 0xf0, 0x29, 0x61, 0x3e, 0x62, 0x1e, 0xd1, 0x25};
+
+    ExtendedProbe<Chip8::SuperChip8> clipped(rom, 5);
+    BOOST_CHECK_EQUAL(clipped.pixel(124, 60), 1);
+    BOOST_CHECK_EQUAL(clipped.pixel(127, 61), 1);
+    BOOST_CHECK_EQUAL(clipped.pixel(0, 60), 0);
+    BOOST_CHECK_EQUAL(clipped.pixel(124, 0), 0);
+
+    ExtendedProbe<Chip8::XoChip8> wrapped(rom, 5);
+    BOOST_CHECK_EQUAL(wrapped.pixel(124, 60), 1);
+    BOOST_CHECK_EQUAL(wrapped.pixel(0, 60), 1);
+    BOOST_CHECK_EQUAL(wrapped.pixel(124, 0), 1);
+    BOOST_CHECK_EQUAL(wrapped.pixel(2, 0), 1);
+    BOOST_CHECK_EQUAL(wrapped.pixel(0, 0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8ExtendedTest_xochip){
+    // SE V0, 5 skips the whole F000 NNNN, then LD I, 0x8000 and a SAVE / LOAD round trip above 4 KiB
+    const std::vector<uint8_t> memory = {0x60, 0x05, 0x30, 0x05, 0xf0, 0x00, 0x12, 0x34, 0xf0, 0x00, 0x80, 0x00,
+                                         0x61, 0x07, 0x50, 0x12, 0x60, 0x00, 0x61, 0x00, 0x50, 0x13};
+    ExtendedProbe<Chip8::XoChip8> skipped(memory, 2);
+    BOOST_CHECK_EQUAL(skipped.m_programCounter, 0x208);
+
+    ExtendedProbe<Chip8::XoChip8> loaded(memory, 8);
+    BOOST_CHECK_EQUAL(loaded.m_iReg, 0x8000);
+    BOOST_CHECK_EQUAL(loaded.read(0x8000), 5);
+    BOOST_CHECK_EQUAL(loaded.read(0x8001), 7);
+    BOOST_CHECK_EQUAL(loaded.m_vRegs[0], 5);
+    BOOST_CHECK_EQUAL(loaded.m_vRegs[1], 7);
+
+    // PLANE 2 draws palette index 2, PLANE 3 draws both planes from consecutive sprite data
+    const std::vector<uint8_t> planes = {0xf2, 0x01, 0xa2, 0x0c, 0x60, 0x00, 0xd0, 0x01, 0xf3, 0x01, 0xd0, 0x01, 0x80, 0xc0};
+    ExtendedProbe<Chip8::XoChip8> onePlane(planes, 4);
+    BOOST_CHECK_EQUAL(onePlane.pixel(0, 0), 2);
+    BOOST_CHECK_EQUAL(onePlane.pixel(1, 1), 2);
+    ExtendedProbe<Chip8::XoChip8> bothPlanes(planes, 6);
+    BOOST_CHECK_EQUAL(bothPlanes.pixel(0, 0), 1);
+    BOOST_CHECK_EQUAL(bothPlanes.pixel(2, 0), 2);
+    BOOST_CHECK_EQUAL(bothPlanes.m_vRegs[0xf], 1);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8ExtendedTest_flags_font_exit){
+    // LD V0, 0x42; LD R, V0; LD V0, 0; LD V0, R; LD V1, 8; LD I, BigSprt(V1); EXIT
+    const std::vector<uint8_t> rom = {0x60, 0x42, 0xf0, 0x75, 0x60, 0x00, 0xf0, 0x85, 0x61, 0x08, 0xf1, 0x30, 0x00, 0xfd};
+    ExtendedProbe<Chip8::SuperChip8> probe(rom, 10);
+    BOOST_CHECK_EQUAL(probe.m_vRegs[0], 0x42);
+    BOOST_CHECK_EQUAL(probe.m_iReg, CHIP8_BIG_SPRITE_OFFSET + 8 * CHIP8_BIG_SPRITE_SIZE);
+    BOOST_CHECK(probe.halted());
+    BOOST_CHECK_EQUAL(probe.m_programCounter, 0x20c);
+
+    std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine("xochip", 0);
+    BOOST_CHECK_EQUAL(machine->displayWidth(), CHIP8_HIRES_X);
+    BOOST_CHECK_EQUAL(machine->displayHeight(), CHIP8_HIRES_Y);
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("", 0)->displayWidth(), CHIP8_DISP_X);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8ExtendedTest_stack_overflow_state){
+    // CALL 0x200, recursing past the 16 stack entries; the state must not change across saveState and loadState
+    std::vector<uint8_t> rom = {0x22, 0x00};
+    std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine("schip", 0);
+    machine->load(rom.data(), rom.size());
+    for(int tick = 0; tick < 20; ++tick){
+        machine->run_tick();
+    }
+    BOOST_CHECK_EQUAL(machine->programCounter(), 0x200);
+    BOOST_CHECK_EQUAL(machine->readMemory(0x10000 + 0x201), 0x00);
+
+    std::vector<uint8_t> state(machine->stateSize());
+    machine->saveState(state.data(), state.size());
+    std::unique_ptr<Chip8::Machine> restored = Chip8::makeMachine("schip", 0);
+    restored->loadState(state.data(), state.size());
+    BOOST_CHECK_EQUAL(restored->stateHash(), machine->stateHash());
+
+    // In memory roms come back on restart
+    machine->restart();
+    BOOST_CHECK_EQUAL(machine->readMemory(0x200), 0x22);
+}
@@ -0,0 +1,182 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/Chip8.hpp"
+#include "../src/Chip8Differential.hpp"
+#include "../src/Chip8Lockstep.hpp"
+#include "../src/InputScript.hpp"
+
+#define LOCKSTEP_TEST_LANES  40
+#define LOCKSTEP_TEST_BUDGET 6000
+
+// Random branches, a self modifying subroutine, timers, key waits and a rare unknown opcode
+static const uint8_t lockstepRom[] = {
+    0x6e, 0x00, 0xc0, 0xff, 0xc1, 0x3f, 0xc2, 0x1f, 0xf0, 0x29, 0xd1, 0x25, 0x80, 0x14, 0x81, 0x25,     // 0x200
+    0x82, 0x06, 0x83, 0x07, 0x84, 0x0e, 0x85, 0x31, 0x86, 0x12, 0x87, 0x23, 0x88, 0x00, 0xa3, 0x00,     // 0x210
+    0xf0, 0x33, 0xf2, 0x65, 0xf7, 0x1e, 0xf3, 0x55, 0xc9, 0x03, 0x39, 0x00, 0x12, 0x32, 0x24, 0x00,     // 0x220
+    0x6a, 0x00, 0x8a, 0xe4, 0xfb, 0x07, 0x3b, 0x00, 0x12, 0x40, 0xc5, 0x3f, 0xf5, 0x15, 0xf5, 0x18,     // 0x230
+    0xcc, 0x0f, 0xec, 0xa1, 0x12, 0x48, 0xfd, 0x0a, 0x7e, 0x01, 0xc9, 0xff, 0x49, 0x00, 0xe0, 0x00,     // 0x240
+    0x3e, 0x00, 0x12, 0x02, 0x00, 0xe0, 0x60, 0x00, 0xb2, 0x00                                          // 0x250
+};
+
+static const uint8_t lockstepSubroutine[] = {
+    0xa2, 0x31, 0xf0, 0x55, 0x00, 0xee                                                                  // 0x400
+};
+
+static std::vector<uint8_t> lockstepImage(){
+    std::vector<uint8_t> image(0x400 - CHIP8_PROG_START_OFFSET + sizeof(lockstepSubroutine), 0);
+    std::copy(std::begin(lockstepRom), std::end(lockstepRom), image.begin());
+    std::copy(std::begin(lockstepSubroutine), std::end(lockstepSubroutine), image.begin() + 0x400 - CHIP8_PROG_START_OFFSET);
+    return image;
+}
+
+static Chip8::InputScript lockstepScript(std::size_t t_lane){
+    Chip8::InputScript script;
+    std::mt19937 generator(t_lane);
+    for(uint64_t cycle = 0; cycle < LOCKSTEP_TEST_BUDGET; cycle += 1 + generator() % 400){
+        script.addEvent(cycle, static_cast<Chip8::Chip8Key>(generator() % 16), generator() & 1);
+    }
+    return script;
+}
+
+BOOST_AUTO_TEST_CASE(Chip8LockstepTest_matches_interpreter){
+    std::vector<uint8_t> image = lockstepImage();
+    std::vector<Chip8::InputScript> scripts;
+    for(std::size_t lane = 0; lane < LOCKSTEP_TEST_LANES; ++lane){
+        scripts.push_back(lockstepScript(lane));
+    }
+
+    Chip8::Lockstep lockstep(LOCKSTEP_TEST_LANES, image.data(), image.size());
+    for(std::size_t lane = 0; lane < LOCKSTEP_TEST_LANES; ++lane){
+        lockstep.reset(lane, lane * 7 + 1);
+        if(lane % 3){
+            lockstep.setInputScript(lane, &scripts[lane]);
+        }
+    }
+    lockstep.run(LOCKSTEP_TEST_BUDGET);
+
+    std::size_t faults = 0;
+    for(std::size_t lane = 0; lane < LOCKSTEP_TEST_LANES; ++lane){
+        Chip8::Chip8 chip8(lane * 7 + 1);
+        chip8.load(image.data(), image.size());
+        std::size_t scriptPosition = 0;
+        std::string fault;
+        uint32_t cycle = 0;
+        try{
+            for(; cycle < LOCKSTEP_TEST_BUDGET; ++cycle){
+                if(lane % 3){
+                    scriptPosition = scripts[lane].apply(chip8, cycle, scriptPosition);
+                }
+                chip8.run_tick();
+            }
+        }
+        catch(const std::string& error){
+            fault = error;
+            ++faults;
+        }
+
+        BOOST_TEST_CONTEXT("lane " << lane){
+            BOOST_CHECK_EQUAL(lockstep.instructions(lane), cycle);
+            BOOST_CHECK_EQUAL(lockstep.faulted(lane), !fault.empty());
+            BOOST_CHECK_EQUAL(lockstep.faultMessage(lane), fault);
+            BOOST_CHECK_EQUAL(lockstep.stateHash(lane), chip8.stateHash());
+        }
+    }
+
+    // Both outcomes have to be exercised for the comparison to mean anything
+    BOOST_CHECK(faults > 0 && faults < LOCKSTEP_TEST_LANES);
+}
+
+// Interpreter engine that adds one to V3 whenever it retires the instruction at t_pc from instruction t_from on
+class FaultyEngine : public Chip8::DifferentialEngine{
+
+private:
+    std::vector<uint8_t> m_image;
+    uint16_t m_pc;
+    uint64_t m_from;
+    Chip8::Chip8 m_chip8;
+    const Chip8::InputScript* m_script;
+    std::size_t m_scriptPosition;
+    uint64_t m_instructions;
+    std::string m_fault;
+
+public:
+    FaultyEngine(const std::vector<uint8_t>& t_image, uint16_t t_pc, uint64_t t_from) : m_image(t_image), m_pc(t_pc), m_from(t_from), m_chip8(0), m_script(nullptr), m_scriptPosition(0), m_instructions(0){
+    }
+
+    std::size_t lanes() const override{
+        return 1;
+    }
+
+    void reset(std::size_t t_lane, uint64_t t_seed, const Chip8::InputScript* t_script) override{
+        m_chip8 = Chip8::Chip8(t_seed);
+        m_chip8.load(m_image.data(), m_image.size());
+        m_script = t_script;
+        m_scriptPosition = 0;
+        m_instructions = 0;
+        m_fault.clear();
+    }
+
+    void runTo(uint64_t t_instructions) override{
+        std::vector<uint8_t> state(Chip8::Chip8::stateSize);
+        try{
+            for(; m_fault.empty() && m_instructions < t_instructions; ++m_instructions){
+                if(m_script){
+                    m_scriptPosition = m_script->apply(m_chip8, m_instructions, m_scriptPosition);
+                }
+                m_chip8.saveState(state.data(), state.size());
+                bool corrupt = m_instructions >= m_from && state[32] == (m_pc & 0xff) && state[33] == (m_pc >> 8);
+                m_chip8.run_tick();
+                if(corrupt){
+                    m_chip8.saveState(state.data(), state.size());
+                    ++state[16 + 3];
+                    m_chip8.loadState(state.data(), state.size());
+                }
+            }
+        }
+        catch(const std::string& error){
+            m_fault = error;
+        }
+    }
+
+    void saveState(std::size_t t_lane, uint8_t* t_buffer, std::size_t t_size) const override{
+        m_chip8.saveState(t_buffer, t_size);
+    }
+
+    std::string fault(std::size_t t_lane) const override{
+        return m_fault;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(Chip8LockstepTest_differential){
+    std::vector<uint8_t> image = lockstepImage();
+    std::vector<Chip8::InputScript> scripts;
+    for(std::size_t lane = 0; lane < LOCKSTEP_TEST_LANES; ++lane){
+        scripts.push_back(lockstepScript(lane));
+    }
+
+    Chip8::LockstepEngine lockstep(LOCKSTEP_TEST_LANES, image.data(), image.size());
+    Chip8::Differential differential(lockstep, image.data(), image.size(), 250);
+    for(std::size_t lane = 0; lane < LOCKSTEP_TEST_LANES; ++lane){
+        differential.reset(lane, lane * 7 + 1, (lane % 3)? &scripts[lane] : nullptr);
+    }
+    Chip8::Differential::Divergence divergence = differential.run(LOCKSTEP_TEST_BUDGET);
+    BOOST_CHECK_MESSAGE(!divergence.found, Chip8::Differential::report(divergence));
+
+    // ADD V0, V1 at 0x20c, after the first 1000 instructions
+    FaultyEngine faulty(image, 0x20c, 1000);
+    Chip8::Differential faultyDifferential(faulty, image.data(), image.size(), 500);
+    faultyDifferential.reset(0, 8, &scripts[1]);
+    divergence = faultyDifferential.run(LOCKSTEP_TEST_BUDGET);
+    BOOST_TEST_MESSAGE(Chip8::Differential::report(divergence));
+    BOOST_REQUIRE(divergence.found);
+    BOOST_CHECK(divergence.pinpointed);
+    BOOST_CHECK_GT(divergence.instructions, 1000);
+    BOOST_CHECK_EQUAL(divergence.pc, 0x20c);
+    BOOST_CHECK_EQUAL(divergence.opcode, 0x8014);
+    BOOST_CHECK_EQUAL(divergence.diff.compare(0, 4, "V3: "), 0);
+}
@@ -12,8 +12,12 @@
 #include <chrono>
 #include <climits>
 #include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "../src/Chip8.hpp"
+#include "../src/Chip8Machine.hpp"
 
 #define NUM_DATA_TESTS 1024
 
@@ -38,6 +42,7 @@ public:
     using Chip8::m_stackPointer;
     using Chip8::m_programCounter;
     using Chip8::m_tCounter;
+    using Chip8::m_timerPeriod;
     using Chip8::m_keystates;
 
     // Expose protected member functions
@@ -170,6 +175,28 @@ BOOST_AUTO_TEST_CASE(Chip8Test_init){
     BOOST_REQUIRE_MESSAGE(std::equal(std::begin(testLoad), std::end(testLoad), chip8TestInst.m_memory.begin() + CHIP8_PROG_START_OFFSET), "Test Failed, memory does contain loaded program.");
 }
 
+BOOST_AUTO_TEST_CASE(Chip8Test_layout){
+    std::unique_ptr<Chip8Test> chip8TestInst(new Chip8Test(0));
+    uintptr_t base = reinterpret_cast<uintptr_t>(chip8TestInst.get());
+
+    BOOST_REQUIRE_MESSAGE(base % CHIP8_CACHE_LINE_SIZE == 0, "Error: instance at 0x" << std::hex << base << " is not cache line aligned");
+
+    // Every hot register has to end inside the first cache line
+    const std::pair<const void*, std::size_t> hot[] = {{&chip8TestInst->m_vRegs, sizeof(chip8TestInst->m_vRegs)},
+                                                       {&chip8TestInst->m_programCounter, sizeof(chip8TestInst->m_programCounter)},
+                                                       {&chip8TestInst->m_iReg, sizeof(chip8TestInst->m_iReg)},
+                                                       {&chip8TestInst->m_keystates, sizeof(chip8TestInst->m_keystates)},
+                                                       {&chip8TestInst->m_dtReg, sizeof(chip8TestInst->m_dtReg)},
+                                                       {&chip8TestInst->m_stReg, sizeof(chip8TestInst->m_stReg)},
+                                                       {&chip8TestInst->m_tCounter, sizeof(chip8TestInst->m_tCounter)},
+                                                       {&chip8TestInst->m_timerPeriod, sizeof(chip8TestInst->m_timerPeriod)},
+                                                       {&chip8TestInst->m_stack, sizeof(chip8TestInst->m_stack)}};
+    for(const auto& member : hot){
+        uintptr_t end = reinterpret_cast<uintptr_t>(member.first) + member.second - base;
+        BOOST_CHECK_MESSAGE(end <= CHIP8_CACHE_LINE_SIZE, "Error: hot member ends at offset " << end);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(Chip8Test_CLS, RandGeneratorFixture){
 
     constexpr uint16_t dispSize = (CHIP8_DISP_X >> 3) * CHIP8_DISP_Y;
@@ -347,7 +374,7 @@ BOOST_DATA_TEST_CASE(Chip8Test_SUB_REG, BoostData::xrange(0, NUM_DATA_TESTS) ^ B
 BOOST_DATA_TEST_CASE(Chip8Test_SHR, BoostData::xrange(0, NUM_DATA_TESTS) ^ BoostData::random(0, 0xe) ^ BoostData::random(0, 0xff), testNumber, registerIndex, immediateValue){
     Chip8Test chip8TestInst(std::mt19937::default_seed);
     chip8TestInst.LD_IMM(registerIndex, immediateValue);
-    chip8TestInst.SHR(registerIndex);
+    chip8TestInst.SHR(registerIndex, 0xe - registerIndex);
 
     BOOST_REQUIRE_MESSAGE(chip8TestInst.m_vRegs[registerIndex] == (immediateValue >> 1), "Test #" << testNumber << " failed, incorrect shift right result, expected: '" << AS_HEX(2, (immediateValue >> 1)) << "'; actual: '" << AS_HEX(2, chip8TestInst.m_vRegs[registerIndex]) << "'");
     BOOST_REQUIRE_MESSAGE(chip8TestInst.m_vRegs[0xf] == static_cast<uint8_t>(immediateValue & 0x01), "Test #" << testNumber << " failed, lsb flag result, expected: '" << AS_HEX(2, static_cast<uint8_t>(immediateValue & 0x01)) << "'; actual: '" << AS_HEX(2, chip8TestInst.m_vRegs[0xf]) << "'");
@@ -371,7 +398,7 @@ BOOST_DATA_TEST_CASE(Chip8Test_SUBN, BoostData::xrange(0, NUM_DATA_TESTS) ^ Boos
 BOOST_DATA_TEST_CASE(Chip8Test_SHL, BoostData::xrange(0, NUM_DATA_TESTS) ^ BoostData::random(0, 0xe) ^ BoostData::random(0, 0xff), testNumber, registerIndex, immediateValue){
     Chip8Test chip8TestInst(std::mt19937::default_seed);
     chip8TestInst.LD_IMM(registerIndex, immediateValue);
-    chip8TestInst.SHL(registerIndex);
+    chip8TestInst.SHL(registerIndex, 0xe - registerIndex);
 
     BOOST_REQUIRE_MESSAGE(chip8TestInst.m_vRegs[registerIndex] == static_cast<uint8_t>(immediateValue << 1), "Test #" << testNumber << " failed, incorrect shift left result, expected: '" << AS_HEX(2, static_cast<uint8_t>(immediateValue << 1)) << "'; actual: '" << AS_HEX(2, chip8TestInst.m_vRegs[registerIndex]) << "'");
     BOOST_REQUIRE_MESSAGE(chip8TestInst.m_vRegs[0xf] == static_cast<uint8_t>(!!(immediateValue & 0x80)), "Test #" << testNumber << " failed, msb flag result, expected: '" << AS_HEX(2, static_cast<uint8_t>(!!(immediateValue & 0x80))) << "'; actual: '" << AS_HEX(2, chip8TestInst.m_vRegs[0xf]) << "'");
@@ -417,6 +444,108 @@ BOOST_DATA_TEST_CASE(Chip8Test_RND, BoostData::xrange(0, NUM_DATA_TESTS) ^ Boost
     }
 }
 
+template<typename TRng>
+static void checkRngSplit(uint64_t t_seed){
+    TRng stream0 = TRng::split(t_seed, 0), stream0Again = TRng::split(t_seed, 0), stream1 = TRng::split(t_seed, 1);
+    int differences = 0;
+    for(int i = 0; i < NUM_DATA_TESTS; ++i){
+        uint8_t value = stream0.next();
+        BOOST_REQUIRE_EQUAL(value, stream0Again.next());
+        differences += (value != stream1.next());
+    }
+    // Independent streams agree on roughly 1 in 256 bytes
+    BOOST_CHECK_MESSAGE(differences > NUM_DATA_TESTS * 9 / 10, "streams 0 and 1 of seed " << t_seed << " differ in only " << differences << " bytes");
+}
+
+BOOST_DATA_TEST_CASE(Chip8Test_RNG_SPLIT, BoostData::xrange(0, 16) ^ BoostData::random(0, INT_MAX), testNumber, seed){
+    checkRngSplit<Chip8::Rng::Mt19937>(seed);
+    checkRngSplit<Chip8::Rng::Xorshift>(seed);
+    checkRngSplit<Chip8::Rng::Pcg32>(seed);
+
+    // reset(seed, stream) replays the same sequence
+    Chip8::Chip8Pcg32 chip8Inst(seed);
+    const uint8_t rom[] = {0xc0, 0xff, 0xc1, 0xff, 0xc2, 0xff, 0xc3, 0xff};
+    uint64_t hashes[2];
+    for(uint64_t& hash : hashes){
+        chip8Inst.reset(seed, testNumber);
+        chip8Inst.load(rom, sizeof(rom));
+        for(std::size_t i = 0; i < sizeof(rom) / 2; ++i){
+            chip8Inst.run_tick();
+        }
+        hash = chip8Inst.stateHash();
+    }
+    BOOST_CHECK_EQUAL(hashes[0], hashes[1]);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8Test_fullStateHash){
+    const uint8_t rom[] = {0xc0, 0xff, 0x12, 0x00};
+    Chip8::Chip8 first(7), second(7), reseeded(8);
+    for(Chip8::Chip8* chip8Inst : {&first, &second, &reseeded}){
+        chip8Inst->load(rom, sizeof(rom));
+    }
+    BOOST_CHECK_EQUAL(first.fullStateHash(), second.fullStateHash());
+
+    first.run_tick();
+    second = first;
+    BOOST_CHECK_EQUAL(first.fullStateHash(), second.fullStateHash());
+
+    // Equal architectural state, different generator state
+    first.reset(7);
+    first.load(rom, sizeof(rom));
+    BOOST_CHECK_EQUAL(first.stateHash(), reseeded.stateHash());
+    BOOST_CHECK_NE(first.fullStateHash(), reseeded.fullStateHash());
+}
+
+BOOST_DATA_TEST_CASE(Chip8Test_RNG_MT_ENGINE, BoostData::xrange(0, 16) ^ BoostData::random(0, INT_MAX), testNumber, seed){
+    std::uniform_int_distribution<> testDist(0, 0xff);
+    std::mt19937 reference(seed);
+    Chip8::Rng::Mt19937Engine engine(seed);
+    for(int i = 0; i < NUM_DATA_TESTS; ++i){
+        BOOST_REQUIRE_EQUAL(testDist(reference), testDist(engine));
+    }
+}
+
+BOOST_DATA_TEST_CASE(Chip8Test_saveState, BoostData::xrange(0, 16) ^ BoostData::random(0, INT_MAX), testNumber, seed){
+    // RND, BCD of the result into memory, draw it, count V1 into the delay timer, repeat
+    const uint8_t rom[] = {0xc0, 0xff, 0xa3, 0x00, 0xf0, 0x33, 0xd0, 0x05, 0x71, 0x01, 0xf1, 0x15, 0x12, 0x00};
+    Chip8::Chip8 source(seed), target(seed + 1);
+    source.load(rom, sizeof(rom));
+    source.updateKeystate(true, false, Chip8::KEY_5);
+    for(int i = 0; i < 100 + testNumber; ++i){
+        source.run_tick();
+    }
+
+    std::vector<uint8_t> state(Chip8::Chip8::stateSize);
+    BOOST_REQUIRE_EQUAL(source.saveState(state.data(), state.size()), Chip8::Chip8::stateSize);
+    BOOST_CHECK_THROW(source.saveState(state.data(), state.size() - 1), std::string);
+
+    target.loadState(state.data(), state.size());
+    BOOST_REQUIRE_EQUAL(source.fullStateHash(), target.fullStateHash());
+    for(int i = 0; i < 1000; ++i){
+        source.run_tick();
+        target.run_tick();
+        BOOST_REQUIRE_EQUAL(source.fullStateHash(), target.fullStateHash());
+    }
+
+    // Restoring into the instance that saved the state rewinds it
+    uint64_t saved = target.fullStateHash();
+    target.loadState(state.data(), state.size());
+    for(int i = 0; i < 1000; ++i){
+        target.run_tick();
+    }
+    BOOST_CHECK_EQUAL(saved, target.fullStateHash());
+
+    // Rejected states leave the machine as it was
+    BOOST_CHECK_THROW(target.loadState(state.data(), state.size() - 1), std::string);
+    state[4] ^= 0xff;
+    BOOST_CHECK_THROW(target.loadState(state.data(), state.size()), std::string);
+    BOOST_CHECK_EQUAL(saved, target.fullStateHash());
+
+    std::vector<uint8_t> xorshiftState(Chip8::Chip8::stateSize);
+    Chip8::Chip8Xorshift(seed).saveState(xorshiftState.data(), xorshiftState.size());
+    BOOST_CHECK_THROW(target.loadState(xorshiftState.data(), xorshiftState.size()), std::string);
+}
+
 BOOST_DATA_TEST_CASE(Chip8Test_DRW, BoostData::xrange(0, NUM_DATA_TESTS), testNumber){
     // TODO
 }
@@ -552,4 +681,86 @@ BOOST_DATA_TEST_CASE(Chip8Test_LD_REGS, BoostData::xrange(0, NUM_DATA_TESTS) ^ B
         return std::string("");
     };
     BOOST_REQUIRE_MESSAGE(std::equal(testValues.begin(), testValues.end(), std::begin(chip8TestInst.m_memory) + writeAddr), "Test #" << testNumber << "failed, incorrect loaded registers values from memory address <" << writeAddr <<">[" << 0 << "-" << testValues.size() << ") result, expected [" << collectionToString(testValues.cbegin(), testValues.cend() - 1) << "]; actual: [" << collectionToString(chip8TestInst.m_memory.cbegin() + writeAddr, chip8TestInst.m_memory.cbegin() + writeAddr + testValues.size() - 1) << "]");
-}
\ No newline at end of file
+}
+template<typename TChip8>
+class QuirksProbe : public TChip8{
+public:
+    QuirksProbe(const std::vector<uint8_t>& t_rom) : TChip8(0){
+        this->load(t_rom.data(), t_rom.size());
+        for(std::size_t i = 0; i < t_rom.size() / 2; ++i){
+            this->run_tick();
+        }
+    }
+
+    using TChip8::m_vRegs;
+    using TChip8::m_iReg;
+    using TChip8::m_programCounter;
+    using TChip8::m_disp;
+};
+
+template<typename TChip8>
+static void checkQuirks(uint8_t t_shifted, uint8_t t_shiftFlag, uint16_t t_indexAfterStore, uint16_t t_jumpTarget, bool t_wraps){
+    // LD V1, 5; LD V2, 6; SHR V1, V2
+    QuirksProbe<TChip8> shift({0x61, 0x05, 0x62, 0x06, 0x81, 0x26});
+    BOOST_CHECK_EQUAL(shift.m_vRegs[1], t_shifted);
+    BOOST_CHECK_EQUAL(shift.m_vRegs[0xf], t_shiftFlag);
+
+    // LD I, 0x300; LD [I], V2
+    QuirksProbe<TChip8> store({0xa3, 0x00, 0xf2, 0x55});
+    BOOST_CHECK_EQUAL(store.m_iReg, t_indexAfterStore);
+
+    // LD V0, 4; LD V3, 0x10; JP V0, 0x304
+    QuirksProbe<TChip8> jump({0x60, 0x04, 0x63, 0x10, 0xb3, 0x04});
+    BOOST_CHECK_EQUAL(jump.m_programCounter, t_jumpTarget);
+
+    // Font sprite 0 drawn at (62, 30) crosses the right and bottom edges
+    QuirksProbe<TChip8> draw({0x60, 0x00, 0xf0, 0x29, 0x64, 0x3e, 0x65, 0x1e, 0xd4, 0x55});
+    BOOST_CHECK_EQUAL(draw.m_disp[30 * (CHIP8_DISP_X >> 3) + 7], 0x03);
+    BOOST_CHECK_EQUAL(draw.m_disp[30 * (CHIP8_DISP_X >> 3)], (t_wraps)? 0xc0 : 0x00);
+    BOOST_CHECK_EQUAL(draw.m_disp[7], (t_wraps)? 0x02 : 0x00);
+}
+
+BOOST_AUTO_TEST_CASE(Chip8Test_QUIRKS){
+    checkQuirks<Chip8::Chip8>(2, 1, 0x300, 0x30a, true);
+    checkQuirks<Chip8::Chip8Vip>(3, 0, 0x303, 0x308, false);
+    checkQuirks<Chip8::Chip8Chip48>(2, 1, 0x302, 0x314, false);
+    checkQuirks<Chip8::Chip8SuperChip>(2, 1, 0x300, 0x314, false);
+
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("", 0)->quirks(), std::string("legacy"));
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("VIP", 0)->quirks(), std::string("vip"));
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("schip", 0)->quirks(), std::string("schip"));
+    BOOST_CHECK_THROW(Chip8::makeMachine("xo-chip", 0), std::string);
+
+    // Instructions per frame after the name set the timer period, the default one is left out of the name
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("VIP:12", 0)->quirks(), std::string("vip:12"));
+    BOOST_CHECK_EQUAL(Chip8::makeMachine(":30", 0)->quirks(), std::string("legacy:30"));
+    BOOST_CHECK_EQUAL(Chip8::makeMachine("schip:10", 0)->quirks(), std::string("schip"));
+    for(const char* quirks : {"legacy:", "legacy:0", "legacy:256", "legacy:-1", "legacy:12x"}){
+        BOOST_CHECK_THROW(Chip8::makeMachine(quirks, 0), std::string);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Chip8Test_timer_period){
+    // LD V0, 60; LD DT, V0; JP 0x204, the timer counts down once every period ticks from the second one on
+    const uint8_t rom[] = {0x60, 0x3c, 0xf0, 0x15, 0x12, 0x04};
+    for(const char* quirks : {"legacy", "legacy:30", "xochip", "xochip:30"}){
+        BOOST_TEST_CONTEXT(quirks){
+            std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine(quirks, 0);
+            machine->load(rom, sizeof(rom));
+            for(int tick = 0; tick < 302; ++tick){
+                machine->run_tick();
+            }
+            BOOST_CHECK_EQUAL(machine->readRegisters().dt, (std::string(quirks).find(':') == std::string::npos)? 30 : 50);
+
+            // The period survives a restart and loading a snapshot, it is not part of the state
+            std::vector<uint8_t> state(machine->stateSize());
+            machine->saveState(state.data(), state.size());
+            machine->restart();
+            machine->loadState(state.data(), state.size());
+            for(int tick = 0; tick < 300; ++tick){
+                machine->run_tick();
+            }
+            BOOST_CHECK_EQUAL(machine->readRegisters().dt, (std::string(quirks).find(':') == std::string::npos)? 0 : 40);
+        }
+    }
+}
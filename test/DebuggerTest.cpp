@@ -0,0 +1,213 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/Chip8Machine.hpp"
+#include "../src/Debugger.hpp"
+#include "../src/GdbStub.hpp"
+
+// Counter at 0x300 incremented once every 5 instructions: LD I, 0x300; LD V0, [I]; ADD V0, 1; LD [I], V0; JP 0x200
+static const uint8_t counterRom[] = {
+    0xa3, 0x00, 0xf0, 0x65, 0x70, 0x01, 0xf0, 0x55, 0x12, 0x00                                          // 0x200
+};
+
+BOOST_AUTO_TEST_CASE(DebuggerTest_breakpoints_and_watchpoints){
+    // Variants whose FX55/FX65 with X = 0 leave I on the counter
+    for(const char* quirks : {"legacy", "chip48", "schip"}){
+        BOOST_TEST_CONTEXT(quirks){
+            std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine(quirks, 0, true);
+            machine->load(counterRom, sizeof(counterRom));
+            Chip8::Debugger debugger(*machine);
+            Chip8::Breakpoints& breakpoints = debugger.breakpoints();
+
+            Chip8::Stop stop = debugger.step();
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_STEP);
+            BOOST_CHECK_EQUAL(stop.addr, 0x202u);
+
+            breakpoints.set(Chip8::BREAK_EXEC, 0x206);
+            stop = debugger.run(100);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_BREAKPOINT);
+            BOOST_CHECK_EQUAL(stop.addr, 0x206u);
+            BOOST_CHECK_EQUAL(stop.ticks, 2u);
+            // Resuming runs the instruction under the breakpoint and comes round to it again
+            stop = debugger.run(100);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_BREAKPOINT);
+            BOOST_CHECK_EQUAL(stop.ticks, 5u);
+            breakpoints.clear(Chip8::BREAK_EXEC, 0x206);
+
+            // Watchpoints stop after the access, fetches of the rom itself are no reads
+            breakpoints.set(Chip8::BREAK_WRITE, 0x300);
+            breakpoints.set(Chip8::BREAK_READ, 0x200, 10);
+            stop = debugger.run(100);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_WATCH);
+            BOOST_CHECK_EQUAL(stop.kind, Chip8::BREAK_WRITE);
+            BOOST_CHECK_EQUAL(stop.addr, 0x300u);
+            BOOST_CHECK_EQUAL(stop.ticks, 1u);
+            BOOST_CHECK_EQUAL(machine->programCounter(), 0x208u);
+            BOOST_CHECK_EQUAL(machine->readMemory(0x300), 2u);
+
+            breakpoints.clearAll();
+            breakpoints.set(Chip8::BREAK_ACCESS, 0x2ff, 2);
+            stop = debugger.run(100);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_WATCH);
+            BOOST_CHECK_EQUAL(stop.kind, Chip8::BREAK_READ);
+            BOOST_CHECK_EQUAL(stop.ticks, 3u);
+            breakpoints.clearAll();
+
+            stop = debugger.runTo(0x208, 100);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_STEP);
+            BOOST_CHECK_EQUAL(stop.addr, 0x208u);
+            BOOST_CHECK(!breakpoints.exec(0x208));
+            stop = debugger.run(12);
+            BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_BUDGET);
+            BOOST_CHECK_EQUAL(stop.ticks, 12u);
+        }
+    }
+
+    // Only debug builds report data accesses, execution breakpoints work on any machine
+    std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine("legacy", 0);
+    machine->load(counterRom, sizeof(counterRom));
+    BOOST_CHECK(!machine->debuggable());
+    Chip8::Breakpoints breakpoints(machine->memorySize());
+    BOOST_CHECK_THROW(machine->attach(&breakpoints), std::string);
+    Chip8::Debugger debugger(*machine);
+    debugger.breakpoints().set(Chip8::BREAK_ACCESS, 0x300);
+    debugger.breakpoints().set(Chip8::BREAK_EXEC, 0x204);
+    Chip8::Stop stop = debugger.run(100);
+    BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_BREAKPOINT);
+    BOOST_CHECK_EQUAL(stop.addr, 0x204u);
+}
+
+BOOST_AUTO_TEST_CASE(DebuggerTest_exits_and_faults){
+    static const uint8_t exitRom[] = {0x60, 0x01, 0x00, 0xfd};
+    std::unique_ptr<Chip8::Machine> exitMachine = Chip8::makeMachine("schip", 0, true);
+    exitMachine->load(exitRom, sizeof(exitRom));
+    Chip8::Debugger exitDebugger(*exitMachine);
+    Chip8::Stop stop = exitDebugger.run(100);
+    BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_HALTED);
+    BOOST_CHECK_EQUAL(stop.ticks, 2u);
+
+    static const uint8_t faultRom[] = {0x60, 0x01, 0xff, 0xff};
+    std::unique_ptr<Chip8::Machine> faultMachine = Chip8::makeMachine("legacy", 0, true);
+    faultMachine->load(faultRom, sizeof(faultRom));
+    Chip8::Debugger faultDebugger(*faultMachine);
+    stop = faultDebugger.run(100);
+    BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_FAULT);
+    BOOST_CHECK(stop.fault.find("Unknown opcode") != std::string::npos);
+
+    // An interrupt requested before a run stops it at its first tick
+    faultDebugger.interrupt();
+    stop = faultDebugger.run(100);
+    BOOST_CHECK_EQUAL(stop.reason, Chip8::STOP_INTERRUPT);
+    BOOST_CHECK_EQUAL(stop.ticks, 0u);
+}
+
+// What the stub sent since the last call, acknowledgements dropped and the packet framing taken off
+static std::string receive(int t_socket){
+    std::string bytes;
+    char buffer[4096];
+    ssize_t received;
+    while((received = ::recv(t_socket, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0){
+        bytes.append(buffer, received);
+    }
+    std::size_t start = bytes.find('$'), end = bytes.rfind('#');
+    return (start == std::string::npos || end == std::string::npos)? std::string() : bytes.substr(start + 1, end - start - 1);
+}
+
+static void transmit(int t_socket, const std::string& t_payload){
+    uint8_t checksum = 0;
+    for(char c : t_payload){
+        checksum += static_cast<uint8_t>(c);
+    }
+    char trailer[4];
+    std::snprintf(trailer, sizeof(trailer), "#%02x", checksum);
+    std::string packet = "$" + t_payload + trailer;
+    BOOST_REQUIRE_EQUAL(::send(t_socket, packet.data(), packet.size(), 0), static_cast<ssize_t>(packet.size()));
+}
+
+static std::string exchange(int t_socket, Chip8::GdbStub& t_stub, const std::string& t_payload){
+    transmit(t_socket, t_payload);
+    t_stub.poll();
+    return receive(t_socket);
+}
+
+BOOST_AUTO_TEST_CASE(DebuggerTest_gdb_stub){
+    std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine("legacy", 0, true);
+    machine->load(counterRom, sizeof(counterRom));
+    Chip8::Debugger debugger(*machine);
+    int sockets[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+    Chip8::GdbStub stub(debugger, sockets[1]);
+    int client = sockets[0];
+
+    BOOST_CHECK(exchange(client, stub, "qSupported:multiprocess+;xmlRegisters=i386").find("qXfer:features:read+") != std::string::npos);
+    BOOST_CHECK_EQUAL(exchange(client, stub, "QStartNoAckMode"), "OK");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "?"), "S05");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "qXfer:features:read:target.xml:0,ffff").compare(0, 6, "l<?xml"), 0);
+    BOOST_CHECK_EQUAL(exchange(client, stub, "vMustReplyEmpty"), "");
+
+    // V0-VF, I and PC little endian, SP, DT, ST; the stack pointer starts on the last slot
+    BOOST_CHECK_EQUAL(exchange(client, stub, "g"), std::string(32, '0') + "0000" + "0002" + "0f0000");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "m200,4"), "a300f065");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "M300,2:2a2b"), "OK");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "m300,2"), "2a2b");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "P5=7f"), "OK");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "p5"), "7f");
+    BOOST_CHECK_EQUAL(machine->readRegisters().v[5], 0x7f);
+    BOOST_CHECK_EQUAL(exchange(client, stub, "p15"), "E01");
+
+    BOOST_CHECK_EQUAL(exchange(client, stub, "Z0,206,2"), "OK");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "c"), "");
+    BOOST_CHECK(stub.resumed());
+    stub.advance(1000);
+    BOOST_CHECK_EQUAL(receive(client), "S05");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "p11"), "0602");
+    BOOST_CHECK_EQUAL(machine->readRegisters().v[0], 0x2b);
+
+    BOOST_CHECK_EQUAL(exchange(client, stub, "z0,206,2"), "OK");
+    BOOST_CHECK_EQUAL(exchange(client, stub, "Z2,300,1"), "OK");
+    exchange(client, stub, "c");
+    stub.advance(1000);
+    BOOST_CHECK_EQUAL(receive(client), "T05watch:300;");
+    BOOST_CHECK_EQUAL(machine->readMemory(0x300), 0x2b);
+    BOOST_CHECK_EQUAL(exchange(client, stub, "z2,300,1"), "OK");
+
+    exchange(client, stub, "s");
+    stub.advance(1000);
+    BOOST_CHECK_EQUAL(receive(client), "S05");
+    BOOST_CHECK_EQUAL(machine->programCounter(), 0x200u);
+
+    // Continuing from an address, then the interrupt character
+    exchange(client, stub, "c204");
+    BOOST_CHECK_EQUAL(::send(client, "\x03", 1, 0), 1);
+    stub.poll();
+    stub.advance(1000);
+    BOOST_CHECK_EQUAL(receive(client), "S02");
+    BOOST_CHECK_EQUAL(machine->programCounter(), 0x204u);
+
+    // The emulator advances the stub one tick at a time, breakpoints still stop it and only the first tick
+    // after resuming runs over one
+    BOOST_CHECK_EQUAL(exchange(client, stub, "Z0,206,2"), "OK");
+    for(uint64_t expected : {1u, 5u, 5u}){
+        exchange(client, stub, "c");
+        uint64_t ticks = 0;
+        for(int slice = 0; slice < 100 && stub.resumed(); ++slice){
+            ticks += stub.advance(1);
+        }
+        BOOST_CHECK(!stub.resumed());
+        BOOST_CHECK_EQUAL(receive(client), "S05");
+        BOOST_CHECK_EQUAL(ticks, expected);
+        BOOST_CHECK_EQUAL(machine->programCounter(), 0x206u);
+    }
+    BOOST_CHECK_EQUAL(exchange(client, stub, "z0,206,2"), "OK");
+
+    BOOST_CHECK_EQUAL(exchange(client, stub, "D"), "OK");
+    BOOST_CHECK(!stub.connected());
+    BOOST_CHECK(!stub.poll());
+    ::close(client);
+}
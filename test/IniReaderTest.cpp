@@ -0,0 +1,40 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "../src/IniReader.hpp"
+
+static void writeIniFile(const std::string& t_path, const std::string& t_contents){
+    std::ofstream fileStream(t_path, std::ios::binary | std::ios::trunc);
+    fileStream << t_contents;
+}
+
+BOOST_AUTO_TEST_CASE(IniReaderTest_bools){
+    writeIniFile("IniReaderTest.ini", "[Library]\non = true\nupper = YES\none = 1\noff = false\nzero = 0\nother = maybe\n");
+    IniReader config("IniReaderTest.ini");
+    BOOST_CHECK(config.getBool("Library", "on", false));
+    BOOST_CHECK(config.getBool("Library", "upper", false));
+    BOOST_CHECK(config.getBool("Library", "one", false));
+    BOOST_CHECK(!config.getBool("Library", "off", true));
+    BOOST_CHECK(!config.getBool("Library", "zero", true));
+    BOOST_CHECK(!config.getBool("Library", "other", true));
+    BOOST_CHECK(config.getBool("Library", "missing", true));
+    BOOST_CHECK(!config.getBool("Missing", "on", false));
+    std::remove("IniReaderTest.ini");
+}
+
+BOOST_AUTO_TEST_CASE(IniReaderTest_long_lines){
+    std::string triggers;
+    for(int trigger = 0; trigger < 20; ++trigger){
+        triggers += "trigger_" + std::to_string(trigger) + ": mem[0x3a0] == " + std::to_string(trigger) + " && V5 > 10; ";
+    }
+    BOOST_REQUIRE_GT(triggers.size(), 512u);
+    writeIniFile("IniReaderTest.ini", "[Triggers]\ntriggers = " + triggers + "\n[Keys]\nkey_ch8_1 = 1");
+    IniReader config("IniReaderTest.ini");
+    BOOST_CHECK_EQUAL(config.getString("Triggers", "triggers", ""), triggers.substr(0, triggers.size() - 1));
+    BOOST_CHECK_EQUAL(config.getString("Keys", "key_ch8_1", ""), "1");
+    std::remove("IniReaderTest.ini");
+}
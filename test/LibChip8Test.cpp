@@ -0,0 +1,100 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "../lib/chip8.h"
+#include "../src/Chip8.hpp"
+
+#define LIB_TEST_MACHINES 9
+#define LIB_TEST_FRAMES   7
+
+// RND V0, 0xff; LD I, 0x800; LD [I], V0; LD F, V0; DRW V1, V1, 5; JP 0x200
+static const uint8_t libTestRom[] = {0xc0, 0xff, 0xa8, 0x00, 0xf0, 0x55, 0xf0, 0x29, 0xd1, 0x15, 0x12, 0x00};
+
+static float libTestReward(const chip8_batch* t_batch, size_t t_index, void* t_user){
+    uint8_t value = 0;
+    chip8_peek(t_batch, t_index, 0x800, &value);
+    return value + *static_cast<float*>(t_user);
+}
+
+BOOST_AUTO_TEST_CASE(LibChip8Test_batch_matches_core){
+    BOOST_REQUIRE_EQUAL(chip8_abi_version(), static_cast<uint32_t>(CHIP8_ABI_VERSION));
+
+    chip8_batch_config config = {LIB_TEST_MACHINES, 1234, CHIP8_RNG_MT19937, 0, 3};
+    chip8_batch* batch = chip8_batch_create(&config, libTestRom, sizeof(libTestRom));
+    BOOST_REQUIRE(batch);
+    BOOST_CHECK_EQUAL(chip8_batch_size(batch), static_cast<size_t>(LIB_TEST_MACHINES));
+
+    const uint16_t watchAddrs[] = {0x800, 0x200};
+    const uint8_t* watched = chip8_batch_watch(batch, watchAddrs, 2);
+    const uint8_t* bytes = chip8_batch_framebuffers(batch, CHIP8_FB_BYTES);
+    float offset = 0.5f;
+    BOOST_REQUIRE_EQUAL(chip8_batch_set_reward(batch, libTestReward, &offset), 0);
+
+    std::vector<uint16_t> keys(LIB_TEST_MACHINES, 0x0001);
+    BOOST_CHECK_EQUAL(chip8_batch_step(batch, keys.data(), LIB_TEST_FRAMES), LIB_TEST_MACHINES);
+
+    for(std::size_t i = 0; i < LIB_TEST_MACHINES; ++i){
+        Chip8::Chip8 oracle(0);
+        oracle.reset(1234, i);
+        oracle.load(libTestRom, sizeof(libTestRom));
+        for(int tick = 0; tick < LIB_TEST_FRAMES * CHIP8_DEFAULT_FRAME_INSTRUCTIONS; ++tick){
+            oracle.run_tick();
+        }
+
+        uint8_t registers[CHIP8_NUM_V_REG];
+        BOOST_REQUIRE_EQUAL(chip8_peek_registers(batch, i, registers), 0);
+        BOOST_CHECK(std::equal(oracle.getRegisters().begin(), oracle.getRegisters().end(), registers));
+        BOOST_CHECK_EQUAL(watched[i * 2], oracle.getMemory().read(0x800));
+        BOOST_CHECK_EQUAL(watched[i * 2 + 1], 0xc0);
+        BOOST_CHECK_EQUAL(chip8_batch_rewards(batch)[i], oracle.getMemory().read(0x800) + 0.5f);
+        BOOST_CHECK_EQUAL(chip8_batch_instructions(batch)[i], static_cast<uint64_t>(LIB_TEST_FRAMES * CHIP8_DEFAULT_FRAME_INSTRUCTIONS));
+
+        const uint8_t* packed = chip8_framebuffer(batch, i);
+        BOOST_CHECK(std::equal(packed, packed + CHIP8_FB_PACKED_SIZE, oracle.getDisplayData()));
+        for(std::size_t pixel = 0; pixel < CHIP8_FB_BYTES_SIZE; ++pixel){
+            BOOST_REQUIRE_EQUAL(bytes[i * CHIP8_FB_BYTES_SIZE + pixel], (packed[pixel / 8] >> (7 - pixel % 8)) & 0x01);
+        }
+    }
+
+    // Errors are reported through the return value and chip8_last_error
+    uint8_t value;
+    BOOST_CHECK_EQUAL(chip8_peek(batch, LIB_TEST_MACHINES, 0x200, &value), -1);
+    BOOST_CHECK(std::string(chip8_last_error()).find("out of range") != std::string::npos);
+    BOOST_CHECK_EQUAL(chip8_peek(batch, 0, 0x200, nullptr), -1);
+    BOOST_CHECK(std::string(chip8_last_error()).find("null peek value") != std::string::npos);
+    BOOST_CHECK_EQUAL(chip8_peek_registers(batch, 0, nullptr), -1);
+    BOOST_CHECK(std::string(chip8_last_error()).find("null register array") != std::string::npos);
+
+    chip8_batch_destroy(batch);
+}
+
+BOOST_AUTO_TEST_CASE(LibChip8Test_faults){
+    // JP 0x204; unknown opcode 0x0000
+    const uint8_t rom[] = {0x12, 0x04};
+    chip8_batch_config config = {4, 1, CHIP8_RNG_PCG32, 2, 0};
+    chip8_batch* batch = chip8_batch_create(&config, rom, sizeof(rom));
+    BOOST_REQUIRE(batch);
+
+    BOOST_CHECK_EQUAL(chip8_batch_step(batch, nullptr, 1), 0);
+    for(std::size_t i = 0; i < 4; ++i){
+        BOOST_CHECK(chip8_batch_faults(batch)[i]);
+        BOOST_CHECK(std::string(chip8_fault_message(batch, i)).find("Unknown opcode") != std::string::npos);
+        BOOST_CHECK_EQUAL(chip8_batch_instructions(batch)[i], 1u);
+    }
+
+    // Faulted machines stay stopped until reset
+    BOOST_CHECK_EQUAL(chip8_batch_step(batch, nullptr, 1), 0);
+    BOOST_CHECK_EQUAL(chip8_batch_instructions(batch)[0], 1u);
+    BOOST_REQUIRE_EQUAL(chip8_batch_reset(batch, 2), 0);
+    BOOST_CHECK(!chip8_batch_faults(batch)[2]);
+    BOOST_CHECK_EQUAL(chip8_batch_instructions(batch)[2], 0u);
+    BOOST_CHECK_EQUAL(chip8_batch_step(batch, nullptr, 0), 1);
+
+    chip8_batch_destroy(batch);
+
+    config.rng = static_cast<chip8_rng>(7);
+    BOOST_CHECK(!chip8_batch_create(&config, rom, sizeof(rom)));
+    BOOST_CHECK(std::string(chip8_last_error()).find("unknown rng") != std::string::npos);
+}
@@ -0,0 +1,156 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/MemorySearch.hpp"
+
+#define MEMORY_SEARCH_TEST_SIZE      4096
+#define MEMORY_SEARCH_TEST_INSTANCES 3
+
+// Counter at 0x300 incremented once every 5 instructions
+static const uint8_t counterRom[] = {
+    0xa3, 0x00, 0xf0, 0x65, 0x70, 0x01, 0xf0, 0x55, 0x12, 0x00                                          // 0x200
+};
+
+static bool referencePredicate(uint8_t t_old, uint8_t t_new, Chip8::SearchPredicate t_predicate, uint8_t t_value){
+    switch(t_predicate){
+        case Chip8::SEARCH_EQUAL:           return t_new == t_value;
+        case Chip8::SEARCH_NOT_EQUAL:       return t_new != t_value;
+        case Chip8::SEARCH_CHANGED:         return t_new != t_old;
+        case Chip8::SEARCH_UNCHANGED:       return t_new == t_old;
+        case Chip8::SEARCH_INCREASED:       return t_new > t_old;
+        case Chip8::SEARCH_DECREASED:       return t_new < t_old;
+        case Chip8::SEARCH_INCREASED_BY:    return t_new == static_cast<uint8_t>(t_old + t_value);
+        case Chip8::SEARCH_DECREASED_BY:    return t_new == static_cast<uint8_t>(t_old - t_value);
+    }
+    return false;
+}
+
+BOOST_AUTO_TEST_CASE(MemorySearchTest_matches_scalar){
+    const std::vector<std::string> names = {"equal", "not-equal", "changed", "unchanged", "increased", "decreased", "increased-by", "decreased-by"};
+    Chip8::MemorySearch search(MEMORY_SEARCH_TEST_INSTANCES, MEMORY_SEARCH_TEST_SIZE);
+    std::mt19937 generator(7);
+    std::vector<std::vector<uint8_t>> memory(MEMORY_SEARCH_TEST_INSTANCES, std::vector<uint8_t>(MEMORY_SEARCH_TEST_SIZE));
+    std::vector<std::vector<bool>> expected(MEMORY_SEARCH_TEST_INSTANCES, std::vector<bool>(MEMORY_SEARCH_TEST_SIZE, true));
+
+    for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+        for(uint8_t& byte : memory[instance]){
+            byte = generator() % 4;
+        }
+        search.start(instance, memory[instance].data());
+        BOOST_CHECK_EQUAL(search.candidates(instance), MEMORY_SEARCH_TEST_SIZE);
+    }
+
+    // Small deltas keep most predicates passing for some addresses over several steps
+    for(int step = 0; step < 24; ++step){
+        Chip8::SearchPredicate predicate = Chip8::getSearchPredicateFromName(names[step % names.size()]);
+        uint8_t value = generator() % 3;
+        for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+            std::vector<uint8_t> next = memory[instance];
+            std::size_t left = 0;
+            for(std::size_t addr = 0; addr < MEMORY_SEARCH_TEST_SIZE; ++addr){
+                next[addr] += (generator() % 4 == 0)? generator() % 3 - 1 : 0;
+                expected[instance][addr] = expected[instance][addr] && referencePredicate(memory[instance][addr], next[addr], predicate, value);
+                left += expected[instance][addr];
+            }
+            BOOST_CHECK_EQUAL(search.narrow(instance, next.data(), predicate, value), left);
+            memory[instance] = next;
+        }
+        // Sends the candidates back to every address so later steps still test something
+        if(step % names.size() == names.size() - 1){
+            for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+                search.start(instance, memory[instance].data());
+                expected[instance].assign(MEMORY_SEARCH_TEST_SIZE, true);
+            }
+        }
+        else if(step % names.size() == 3){
+            for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+                for(std::size_t addr = 0; addr < MEMORY_SEARCH_TEST_SIZE; ++addr){
+                    BOOST_REQUIRE_EQUAL(search.isCandidate(instance, addr), expected[instance][addr]);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> common;
+    for(std::size_t addr = 0; addr < MEMORY_SEARCH_TEST_SIZE; ++addr){
+        bool everywhere = true;
+        for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+            everywhere = everywhere && expected[instance][addr];
+        }
+        if(everywhere){
+            common.push_back(addr);
+        }
+    }
+    std::vector<uint32_t> found = search.common();
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), common.begin(), common.end());
+    BOOST_CHECK_THROW(Chip8::getSearchPredicateFromName("bigger"), std::string);
+    BOOST_CHECK_THROW(Chip8::MemorySearch(1, 100), std::string);
+}
+
+BOOST_AUTO_TEST_CASE(MemorySearchTest_finds_counter){
+    std::vector<std::unique_ptr<Chip8::Machine>> machines;
+    for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+        machines.push_back(Chip8::makeMachine("legacy", instance));
+        machines.back()->load(counterRom, sizeof(counterRom));
+    }
+    Chip8::MemorySearch search(MEMORY_SEARCH_TEST_INSTANCES, machines.front()->memorySize());
+
+    // Each instance starts at a different point of the loop, they are only compared at its top
+    for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+        for(std::size_t tick = 0; tick < 5 * (instance + 1); ++tick){
+            machines[instance]->run_tick();
+        }
+        search.start(instance, *machines[instance]);
+    }
+    for(int step = 0; step < 4; ++step){
+        for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+            for(int tick = 0; tick < 5; ++tick){
+                machines[instance]->run_tick();
+            }
+            search.narrow(instance, *machines[instance], Chip8::SEARCH_INCREASED_BY, 1);
+            for(int tick = 0; tick < 5 * 3; ++tick){
+                machines[instance]->run_tick();
+            }
+            search.narrow(instance, *machines[instance], Chip8::SEARCH_INCREASED_BY, 3);
+        }
+    }
+    for(std::size_t instance = 0; instance < MEMORY_SEARCH_TEST_INSTANCES; ++instance){
+        BOOST_CHECK_EQUAL(search.candidates(instance), 1);
+        BOOST_CHECK_EQUAL(search.value(instance, 0x300), machines[instance]->readMemory(0x300));
+    }
+    BOOST_REQUIRE_EQUAL(search.common().size(), 1);
+    BOOST_CHECK_EQUAL(search.common().front(), 0x300);
+
+    // Pinning the counter holds it against the rom
+    Chip8::MemoryPins pins;
+    pins.parse("0x300=0x40, 0x301=7");
+    BOOST_CHECK_EQUAL(pins.pins().size(), 2);
+    pins.unpin(0x301);
+    for(int frame = 0; frame < 3; ++frame){
+        pins.apply(*machines.front());
+        BOOST_CHECK_EQUAL(machines.front()->readMemory(0x300), 0x40);
+        for(int tick = 0; tick < 10; ++tick){
+            machines.front()->run_tick();
+        }
+        BOOST_CHECK_EQUAL(machines.front()->readMemory(0x300), 0x42);
+    }
+    BOOST_CHECK_THROW(pins.parse("0x300"), std::string);
+    BOOST_CHECK_THROW(pins.parse("0x300=256"), std::string);
+    BOOST_CHECK_THROW(pins.parse("=1"), std::string);
+    BOOST_CHECK_THROW(pins.parse("0x300=1x"), std::string);
+    BOOST_CHECK_THROW(pins.parse("0x300=0x"), std::string);
+
+    // Leading zeros are decimal, not octal
+    Chip8::MemoryPins decimal;
+    decimal.parse("0X2f4=010 0768=09");
+    BOOST_REQUIRE_EQUAL(decimal.pins().size(), 2);
+    BOOST_CHECK_EQUAL(decimal.pins()[0].addr, 0x2f4u);
+    BOOST_CHECK_EQUAL(decimal.pins()[0].value, 10);
+    BOOST_CHECK_EQUAL(decimal.pins()[1].addr, 768u);
+    BOOST_CHECK_EQUAL(decimal.pins()[1].value, 9);
+}
@@ -0,0 +1,96 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/Chip8Machine.hpp"
+#include "../src/Netplay.hpp"
+
+#define NETPLAY_TICKS_PER_FRAME 8
+#define NETPLAY_FRAMES          300
+
+// RND V2; SKNP V0; ADD V3, V2; ADD V0, 1; LD V1, 0xf; AND V0, V1; LD I, 0x300; LD B, V3; JP 0x200
+static const std::vector<uint8_t> netplayRom = {0xc2, 0xff, 0xe0, 0xa1, 0x83, 0x24, 0x70, 0x01, 0x61, 0x0f, 0x80, 0x12, 0xa3, 0x00, 0xf3, 0x33, 0x12, 0x00};
+
+static uint16_t firstPlayerKeys(uint64_t t_frame){
+    return ((t_frame / 7) % 3)? 0 : 0x0003;
+}
+
+static uint16_t secondPlayerKeys(uint64_t t_frame){
+    return static_cast<uint16_t>(0x0100 << ((t_frame / 5) % 8));
+}
+
+static std::unique_ptr<Chip8::Machine> netplayMachine(const std::string& t_romPath){
+    std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine("legacy", 77);
+    machine->load(t_romPath);
+    return machine;
+}
+
+// Plays both peers over 127.0.0.1 until they agree on every frame and returns their state hashes
+static std::pair<uint64_t, uint64_t> playOverLoopback(const std::string& t_romPath, long t_latencyMsec, unsigned t_lossPercent, Chip8::NetplaySession::Stats& t_stats){
+    Chip8::UdpLink firstLink(0, "", 0, t_latencyMsec, t_lossPercent);
+    Chip8::UdpLink secondLink(0, "127.0.0.1", firstLink.localPort(), t_latencyMsec, t_lossPercent);
+    firstLink.connect("127.0.0.1", secondLink.localPort());
+
+    std::unique_ptr<Chip8::Machine> first = netplayMachine(t_romPath), second = netplayMachine(t_romPath);
+    Chip8::NetplaySession firstSession(*first, firstLink, NETPLAY_TICKS_PER_FRAME);
+    Chip8::NetplaySession secondSession(*second, secondLink, NETPLAY_TICKS_PER_FRAME);
+    // The second peer runs at half the rate at first, the first one gets ahead and has to correct its guesses
+    for(int step = 0; step < 20000 && (firstSession.confirmedFrames() < NETPLAY_FRAMES || secondSession.confirmedFrames() < NETPLAY_FRAMES); ++step){
+        if(firstSession.frame() < NETPLAY_FRAMES){
+            firstSession.advanceFrame(firstPlayerKeys(firstSession.frame()));
+        }
+        else{
+            firstSession.poll();
+        }
+        if(secondSession.frame() < NETPLAY_FRAMES && (step % 2 || step > 200)){
+            secondSession.advanceFrame(secondPlayerKeys(secondSession.frame()));
+        }
+        else{
+            secondSession.poll();
+        }
+        usleep(500);
+    }
+    BOOST_REQUIRE_EQUAL(firstSession.confirmedFrames(), NETPLAY_FRAMES);
+    BOOST_REQUIRE_EQUAL(secondSession.confirmedFrames(), NETPLAY_FRAMES);
+    t_stats = firstSession.stats();
+    BOOST_TEST_MESSAGE("latency " << t_latencyMsec << " ms, loss " << t_lossPercent << "%: " << t_stats.rollbacks << " rollbacks of "
+                       << t_stats.resimulatedFrames << " frames in " << t_stats.resimulationUsec << " usec, " << t_stats.stalls << " stalls");
+    return {first->stateHash(), second->stateHash()};
+}
+
+BOOST_AUTO_TEST_CASE(NetplayTest_peers_agree_with_local_play){
+    std::string romPath = "NetplayTest.ch8";
+    {
+        std::ofstream romStream(romPath, std::ios::binary);
+        romStream.write(reinterpret_cast<const char*>(netplayRom.data()), netplayRom.size());
+    }
+
+    // Both players on one machine
+    std::unique_ptr<Chip8::Machine> local = netplayMachine(romPath);
+    for(uint64_t frame = 0; frame < NETPLAY_FRAMES; ++frame){
+        local->setKeystates(firstPlayerKeys(frame) | secondPlayerKeys(frame));
+        for(int tick = 0; tick < NETPLAY_TICKS_PER_FRAME; ++tick){
+            local->run_tick();
+        }
+    }
+
+    Chip8::NetplaySession::Stats stats;
+    std::pair<uint64_t, uint64_t> hashes = playOverLoopback(romPath, 0, 0, stats);
+    BOOST_CHECK_EQUAL(hashes.first, local->stateHash());
+    BOOST_CHECK_EQUAL(hashes.second, local->stateHash());
+    BOOST_CHECK_GT(stats.rollbacks, 0);
+
+    hashes = playOverLoopback(romPath, 8, 30, stats);
+    BOOST_CHECK_EQUAL(hashes.first, local->stateHash());
+    BOOST_CHECK_EQUAL(hashes.second, local->stateHash());
+    BOOST_CHECK_GT(stats.rollbacks, 0);
+    BOOST_CHECK_LE(stats.resimulatedFrames, stats.rollbacks * CHIP8_NETPLAY_MAX_ROLLBACK);
+
+    std::remove(romPath.c_str());
+}
@@ -0,0 +1,75 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "../src/Chip8.hpp"
+#include "../src/PagedMemory.hpp"
+
+static std::vector<uint8_t> pagedMemoryRom(){
+    std::vector<uint8_t> rom(CHIP8_MAIN_MEM_SIZE - CHIP8_PROG_START_OFFSET);
+    for(std::size_t i = 0; i < rom.size(); ++i){
+        rom[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return rom;
+}
+
+BOOST_AUTO_TEST_CASE(PagedMemoryTest_copy_on_write){
+    std::vector<uint8_t> rom = pagedMemoryRom();
+    std::shared_ptr<const Chip8::MemoryImage> image = Chip8::PagedMemory::makeImage(rom.data(), rom.size());
+    Chip8::PagedMemory first(image), second(image);
+
+    BOOST_REQUIRE(std::equal(image->begin(), image->end(), first.cbegin()));
+    BOOST_CHECK_EQUAL(first.privatePages(), 0u);
+
+    first.write(0x345, 0xaa);
+    BOOST_CHECK_EQUAL(first.read(0x345), 0xaa);
+    BOOST_CHECK_EQUAL(second.read(0x345), (*image)[0x345]);
+    BOOST_CHECK_EQUAL((*image)[0x345], rom[0x345 - CHIP8_PROG_START_OFFSET]);
+    BOOST_CHECK_EQUAL(first.privatePages(), 1u);
+    BOOST_CHECK_EQUAL(second.privatePages(), 0u);
+
+    // The rest of the written page still reads the image contents
+    BOOST_CHECK(std::equal(image->begin() + 0x300, image->begin() + 0x345, first.cbegin() + 0x300));
+
+    // Copies share the image and duplicate only diverged pages
+    Chip8::PagedMemory copy(first);
+    first.write(0x345, 0x55);
+    BOOST_CHECK_EQUAL(copy.read(0x345), 0xaa);
+    BOOST_CHECK_EQUAL(copy.privatePages(), 1u);
+    BOOST_CHECK(copy.image() == image);
+
+    // Reset drops the diverged page but keeps its buffer for reuse
+    first.reset();
+    BOOST_CHECK_EQUAL(first.read(0x345), (*image)[0x345]);
+    BOOST_CHECK_EQUAL(first.privatePages(), 0u);
+    BOOST_CHECK_EQUAL(first.privateBytes(), static_cast<std::size_t>(CHIP8_PAGE_SIZE));
+
+    // Addresses wrap at the end of memory
+    first.write(CHIP8_MAIN_MEM_SIZE + 1, 0x12);
+    BOOST_CHECK_EQUAL(first.read(1), 0x12);
+}
+
+BOOST_AUTO_TEST_CASE(PagedMemoryTest_shared_load){
+    std::vector<uint8_t> rom = pagedMemoryRom();
+
+    // LD I, 0x800; LD V0, 0x42; LD [I], V0; JP 0x206
+    const uint8_t program[] = {0xa8, 0x00, 0x60, 0x42, 0xf0, 0x55, 0x12, 0x06};
+    std::copy(std::begin(program), std::end(program), rom.begin());
+    std::shared_ptr<const Chip8::MemoryImage> image = Chip8::PagedMemory::makeImage(rom.data(), rom.size());
+
+    Chip8::Chip8 copied(1), shared(1);
+    copied.load(rom.data(), rom.size());
+    shared.load(image);
+    BOOST_CHECK_EQUAL(copied.stateHash(), shared.stateHash());
+
+    for(int i = 0; i < 8; ++i){
+        copied.run_tick();
+        shared.run_tick();
+    }
+    BOOST_CHECK_EQUAL(copied.stateHash(), shared.stateHash());
+    BOOST_CHECK_EQUAL(shared.getMemory().read(0x800), 0x42);
+    BOOST_CHECK_EQUAL(shared.getMemory().privatePages(), 1u);
+    BOOST_CHECK_EQUAL((*image)[0x800], rom[0x800 - CHIP8_PROG_START_OFFSET]);
+}
@@ -0,0 +1,77 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/Chip8Machine.hpp"
+#include "../src/Profiler.hpp"
+
+// LD V0, 1; LD I, 0x20e; DRW V0, V0, 1 twice, the second erasing the first; SE V0, 1 skipping a word; LD V0, K
+static const uint8_t countersRom[] = {
+    0x60, 0x01, 0xa2, 0x0e, 0xd0, 0x01, 0xd0, 0x01, 0x30, 0x01, 0x00, 0x00, 0xf0, 0x0a,                 // 0x200
+    0xff                                                                                                // 0x20e
+};
+
+BOOST_AUTO_TEST_CASE(ProfilerTest_counters_and_export){
+    for(const char* quirks : {"legacy", "xochip"}){
+        BOOST_TEST_CONTEXT(quirks){
+            std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine(quirks, 0);
+            machine->load(countersRom, sizeof(countersRom));
+            Chip8::Profiler profiler(1);
+            for(int tick = 0; tick < 10; ++tick){
+                profiler.tick(*machine);
+            }
+
+            Chip8::ExecutionCounters counters = machine->counters();
+            BOOST_CHECK_EQUAL(counters.instructions, 10u);
+            BOOST_CHECK_EQUAL(counters.draws, 2u);
+            BOOST_CHECK_EQUAL(counters.spriteRows, 2u);
+            BOOST_CHECK_EQUAL(counters.collisions, 1u);
+            BOOST_CHECK_EQUAL(counters.skipsTaken, 1u);
+            BOOST_CHECK_EQUAL(counters.keyWaits, 5u);
+
+            BOOST_CHECK_EQUAL(profiler.count(Chip8::OP_LD_IMM), 1u);
+            BOOST_CHECK_EQUAL(profiler.count(Chip8::OP_DRW), 2u);
+            BOOST_CHECK_EQUAL(profiler.count(Chip8::OP_SE_IMM), 1u);
+            BOOST_CHECK_EQUAL(profiler.count(Chip8::OP_LD_KEY), 5u);
+            BOOST_CHECK_EQUAL(profiler.count(Chip8::OP_SYS), 0u);
+            // Every tick timed with a sample period of 1
+            const auto& histogram = profiler.histogram(Chip8::OP_LD_KEY);
+            BOOST_CHECK_EQUAL(profiler.samples(Chip8::OP_LD_KEY), 5u);
+            BOOST_CHECK_EQUAL(std::accumulate(histogram.begin(), histogram.end(), uint64_t(0)), 5u);
+
+            std::ostringstream csv, json;
+            profiler.writeCsv(csv, counters);
+            BOOST_CHECK_EQUAL(csv.str().compare(0, 45, "kind,name,count,samples,mean_cycles,histogram"), 0);
+            BOOST_CHECK(csv.str().find("\ncounter,collisions,1,,,\n") != std::string::npos);
+            BOOST_CHECK(csv.str().find("\nopcode,DRW,2,2,") != std::string::npos);
+            BOOST_CHECK(csv.str().find("opcode,SYS") == std::string::npos);
+            profiler.writeJson(json, counters);
+            BOOST_CHECK(json.str().find("\"key_waits\": 5") != std::string::npos);
+            BOOST_CHECK(json.str().find("{\"name\": \"LD_KEY\", \"count\": 5, \"samples\": 5") != std::string::npos);
+
+            // Snapshots leave the counters alone, run-ahead puts back the ones from before it
+            std::vector<uint8_t> state(machine->stateSize());
+            machine->saveState(state.data(), state.size());
+            machine->run_tick();
+            machine->loadState(state.data(), state.size());
+            BOOST_CHECK_EQUAL(machine->counters().instructions, 11u);
+            machine->setCounters(counters);
+            BOOST_CHECK_EQUAL(machine->counters().keyWaits, 5u);
+            BOOST_CHECK_EQUAL(machine->counters().instructions, 10u);
+
+            machine->reset();
+            BOOST_CHECK_EQUAL(machine->counters().instructions, 0u);
+        }
+    }
+
+    BOOST_CHECK_EQUAL(Chip8::opcodeClass(0x00fd), Chip8::OP_EXIT);
+    BOOST_CHECK_EQUAL(Chip8::opcodeClass(0x5123), Chip8::OP_LOAD_RANGE);
+    BOOST_CHECK_EQUAL(Chip8::opcodeClass(0xf375), Chip8::OP_SAVE_FLAGS);
+    BOOST_CHECK_EQUAL(Chip8::opcodeClass(0x8008), Chip8::OP_UNKNOWN);
+    BOOST_CHECK_EQUAL(std::string(Chip8::opcodeClassName(Chip8::OP_LD_I_LONG)), "LD_I_LONG");
+}
@@ -0,0 +1,104 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Chip8Machine.hpp"
+#include "../src/Replay.hpp"
+
+// LD V3, 7; LD I, 0x300; LD B, V3; LD V0, K; RND V2; ADD V2, V0; LD B, V2; DRW V2, V0, 5; SKP V0; JP 0x206; JP 0x206
+static const std::vector<uint8_t> replayRom = {0x63, 0x07, 0xa3, 0x00, 0xf3, 0x33, 0xf0, 0x0a, 0xc2, 0xff, 0x82, 0x04, 0xf2, 0x33, 0xd2, 0x05,
+                                               0xe0, 0x9e, 0x12, 0x06, 0x12, 0x06};
+
+static std::string writeReplayRom(const std::string& t_path){
+    std::ofstream romStream(t_path, std::ios::binary);
+    romStream.write(reinterpret_cast<const char*>(replayRom.data()), replayRom.size());
+    return t_path;
+}
+
+// Plays t_cycles cycles of presses the way the emulator records them, key state changes applied between ticks
+static void recordSession(Chip8::Machine& t_machine, Chip8::Replay& t_replay, uint64_t t_cycles){
+    for(uint64_t cycle = t_machine.bootTicks(); cycle < t_cycles; ++cycle){
+        if(cycle % 37 == 0){
+            uint16_t keys = static_cast<uint16_t>(1 << (cycle / 37 % 16));
+            t_machine.setKeystates(keys);
+            t_replay.addEvent(cycle, keys);
+        }
+        else if(cycle % 37 == 5){
+            t_machine.setKeystates(0);
+            t_replay.addEvent(cycle, 0);
+        }
+        t_machine.run_tick();
+    }
+    t_replay.finish(t_cycles, t_machine.stateHash());
+}
+
+BOOST_AUTO_TEST_CASE(ReplayTest_replay_reproduces_session){
+    std::string romPath = writeReplayRom("ReplayTest.ch8");
+    for(const std::string quirks : {"legacy", "xochip"}){
+        std::unique_ptr<Chip8::Machine> recorded = Chip8::makeMachine(quirks, 1234);
+        recorded->load(romPath);
+        recorded->boot(0x1234, "");
+        BOOST_REQUIRE_GT(recorded->bootTicks(), 0);
+
+        Chip8::Replay replay(0x1234, recorded->quirks(), recorded->seed());
+        recordSession(*recorded, replay, 5000);
+        replay.save("ReplayTest.c8r");
+
+        Chip8::Replay loaded("ReplayTest.c8r");
+        BOOST_CHECK_EQUAL(loaded.quirks(), quirks);
+        BOOST_CHECK_EQUAL(loaded.seed(), 1234);
+        BOOST_CHECK_EQUAL(loaded.cycles(), 5000);
+        BOOST_REQUIRE_EQUAL(loaded.events().size(), replay.events().size());
+
+        // From the boot state or from a cold load, events before the start only set the keys
+        std::unique_ptr<Chip8::Machine> warm = Chip8::makeMachine(loaded.quirks(), loaded.seed());
+        warm->load(romPath);
+        warm->boot(0x1234, "");
+        BOOST_CHECK_EQUAL(loaded.play(*warm, warm->bootTicks()), "");
+        BOOST_CHECK_EQUAL(warm->stateHash(), loaded.finalHash());
+
+        std::unique_ptr<Chip8::Machine> cold = Chip8::makeMachine(loaded.quirks(), loaded.seed());
+        cold->load(romPath);
+        loaded.play(*cold, 0);
+        BOOST_CHECK_EQUAL(cold->stateHash(), loaded.finalHash());
+
+        // Another seed takes another path through RND
+        std::unique_ptr<Chip8::Machine> reseeded = Chip8::makeMachine(loaded.quirks(), 99);
+        reseeded->load(romPath);
+        loaded.play(*reseeded, 0);
+        BOOST_CHECK_NE(reseeded->stateHash(), loaded.finalHash());
+    }
+    std::remove("ReplayTest.c8r");
+    std::remove(romPath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ReplayTest_truncate_and_malformed){
+    Chip8::Replay replay(1, "legacy", 2);
+    replay.addEvent(10, 0x1);
+    replay.addEvent(10, 0x3);
+    replay.addEvent(20, 0x0);
+    replay.addEvent(300, 0x8000);
+    BOOST_REQUIRE_EQUAL(replay.events().size(), 3);
+    BOOST_CHECK_EQUAL(replay.events()[0].keystates, 0x3);
+    replay.truncate(20);
+    BOOST_REQUIRE_EQUAL(replay.events().size(), 1);
+    replay.addEvent(25, 0x8000);
+    replay.save("ReplayTest.c8r");
+
+    std::ifstream inStream("ReplayTest.c8r", std::ios::binary);
+    std::string file((std::istreambuf_iterator<char>(inStream)), std::istreambuf_iterator<char>());
+    BOOST_CHECK_EQUAL(Chip8::Replay("ReplayTest.c8r").events()[1].cycle, 25);
+    {
+        std::ofstream outStream("ReplayTest.c8r", std::ios::binary | std::ios::trunc);
+        outStream.write(file.data(), file.size() - 1);
+    }
+    BOOST_CHECK_THROW(Chip8::Replay("ReplayTest.c8r"), std::string);
+    BOOST_CHECK_THROW(Chip8::Replay("ReplayTest.missing"), std::string);
+    std::remove("ReplayTest.c8r");
+}
@@ -0,0 +1,87 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "../src/Chip8.hpp"
+#include "../src/Chip8Extended.hpp"
+#include "../src/RewindBuffer.hpp"
+
+#define REWIND_TICKS_PER_FRAME 8
+
+// RND V0, BCD of it to 0x300, draw it, count V1 into the delay timer, repeat
+static const std::vector<uint8_t> rewindRom = {0xc0, 0xff, 0xa3, 0x00, 0xf0, 0x33, 0xd0, 0x05, 0x71, 0x01, 0xf1, 0x15, 0x12, 0x00};
+
+// Runs t_frames frames, pushing every frame into t_rewind and keeping a plain copy of each in t_history
+template<typename TChip8>
+static void record(TChip8& t_chip8, Chip8::RewindBuffer& t_rewind, std::vector<std::vector<uint8_t>>& t_history, std::size_t t_frames){
+    std::vector<uint8_t> state(TChip8::stateSize);
+    for(std::size_t frame = 0; frame < t_frames; ++frame){
+        for(int tick = 0; tick < REWIND_TICKS_PER_FRAME; ++tick){
+            t_chip8.run_tick();
+        }
+        t_chip8.saveState(state.data(), state.size());
+        t_rewind.push(state.data());
+        t_history.push_back(state);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RewindBufferTest_pop_replays_history){
+    std::unique_ptr<Chip8::Chip8> chip8(new Chip8::Chip8(3));
+    chip8->load(rewindRom.data(), rewindRom.size());
+    Chip8::RewindBuffer rewind(Chip8::Chip8::stateSize, 1000, 1 << 20, 16);
+    std::vector<std::vector<uint8_t>> history;
+    record(*chip8, rewind, history, 200);
+    BOOST_REQUIRE_EQUAL(rewind.frames(), 199);
+
+    std::vector<uint8_t> state(Chip8::Chip8::stateSize);
+    for(std::size_t frame = history.size() - 1; frame-- > 150;){
+        BOOST_REQUIRE(rewind.pop(state.data()));
+        BOOST_REQUIRE(state == history[frame]);
+    }
+
+    // Several frames at once, across keyframes
+    BOOST_REQUIRE(rewind.pop(state.data(), 37));
+    BOOST_REQUIRE(state == history[113]);
+
+    // Running on from a popped state records the new future over the old one
+    chip8->loadState(state.data(), state.size());
+    history.resize(114);
+    record(*chip8, rewind, history, 50);
+    for(std::size_t frame = history.size() - 1; frame-- > 0;){
+        BOOST_REQUIRE(rewind.pop(state.data()));
+        BOOST_REQUIRE(state == history[frame]);
+    }
+    BOOST_CHECK(!rewind.pop(state.data()));
+}
+
+BOOST_AUTO_TEST_CASE(RewindBufferTest_oldest_entries_give_way){
+    std::unique_ptr<Chip8::XoChip8> chip8(new Chip8::XoChip8(5));
+    chip8->load(rewindRom.data(), rewindRom.size());
+    // Room for a few keyframes only, the ring wraps many times
+    Chip8::RewindBuffer rewind(Chip8::XoChip8::stateSize, 500, 16 << 10, 60);
+    std::vector<std::vector<uint8_t>> history;
+    record(*chip8, rewind, history, 1000);
+    BOOST_REQUIRE_LE(rewind.usedBytes(), 16 << 10);
+    BOOST_REQUIRE_GT(rewind.frames(), 0);
+
+    std::vector<uint8_t> state(Chip8::XoChip8::stateSize);
+    std::size_t frames = rewind.frames();
+    for(std::size_t frame = history.size() - 1; frame-- > history.size() - 1 - frames;){
+        BOOST_REQUIRE(rewind.pop(state.data()));
+        BOOST_REQUIRE(state == history[frame]);
+    }
+    BOOST_CHECK(!rewind.pop(state.data()));
+}
+
+BOOST_AUTO_TEST_CASE(RewindBufferTest_minute_of_history){
+    std::unique_ptr<Chip8::Chip8> chip8(new Chip8::Chip8(9));
+    chip8->load(rewindRom.data(), rewindRom.size());
+    Chip8::RewindBuffer rewind(Chip8::Chip8::stateSize, 60 * 60, 512 << 10);
+    std::vector<std::vector<uint8_t>> history;
+    record(*chip8, rewind, history, 60 * 60 + 1);
+    BOOST_CHECK_EQUAL(rewind.frames(), 60 * 60);
+    BOOST_TEST_MESSAGE("a minute of frames takes " << rewind.usedBytes() << " bytes");
+    BOOST_CHECK_LT(rewind.usedBytes(), 512 << 10);
+}
@@ -0,0 +1,66 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/Chip8.hpp"
+#include "../src/RomCorpus.hpp"
+
+static std::string writeCorpusRom(const std::string& t_path, const std::vector<uint8_t>& t_rom){
+    std::ofstream romStream(t_path, std::ios::binary);
+    romStream.write(reinterpret_cast<const char*>(t_rom.data()), t_rom.size());
+    return t_path;
+}
+
+BOOST_AUTO_TEST_CASE(RomCorpusTest_pack_and_find){
+    const std::vector<std::vector<uint8_t>> roms = {{0x60, 0x01, 0x12, 0x00}, {0x61, 0x02}, {}, {0xa2, 0x00, 0xf0, 0x65, 0x12, 0x04}};
+    const std::vector<std::string> names = {"pong.ch8", "games/tetris.ch8", "empty", "b.ch8"};
+    std::vector<std::string> paths;
+    for(std::size_t i = 0; i < roms.size(); ++i){
+        paths.push_back(writeCorpusRom("RomCorpusTest_" + std::to_string(i) + ".ch8", roms[i]));
+    }
+    Chip8::RomCorpus::pack("RomCorpusTest.corpus", paths, names);
+
+    {
+        Chip8::RomCorpus corpus("RomCorpusTest.corpus");
+        BOOST_REQUIRE_EQUAL(corpus.size(), roms.size());
+
+        // Entries are in name order
+        for(std::size_t i = 1; i < corpus.size(); ++i){
+            Chip8::RomCorpus::Rom prev = corpus.rom(i - 1), rom = corpus.rom(i);
+            BOOST_CHECK(std::string(prev.name, prev.nameSize) < std::string(rom.name, rom.nameSize));
+        }
+
+        for(std::size_t i = 0; i < roms.size(); ++i){
+            long index = corpus.find(names[i]);
+            BOOST_REQUIRE(index >= 0);
+            Chip8::RomCorpus::Rom rom = corpus.rom(index);
+            BOOST_CHECK_EQUAL(std::string(rom.name, rom.nameSize), names[i]);
+            BOOST_CHECK(std::equal(roms[i].begin(), roms[i].end(), rom.data));
+            BOOST_CHECK_EQUAL(rom.size, roms[i].size());
+            BOOST_CHECK_EQUAL(rom.hash, Chip8::RomCorpus::hash(roms[i].data(), roms[i].size()));
+            BOOST_CHECK_EQUAL(corpus.find(rom.hash), index);
+
+            Chip8::Chip8 fromCorpus(0), fromBytes(0);
+            fromCorpus.load(corpus, index);
+            fromBytes.load(roms[i].data(), roms[i].size());
+            BOOST_CHECK_EQUAL(fromCorpus.stateHash(), fromBytes.stateHash());
+        }
+        BOOST_CHECK_EQUAL(corpus.find(std::string("pong")), -1);
+        BOOST_CHECK_EQUAL(corpus.find(std::string("zzz")), -1);
+        BOOST_CHECK_EQUAL(corpus.find(static_cast<uint64_t>(0)), -1);
+        BOOST_CHECK_THROW(corpus.rom(roms.size()), std::string);
+    }
+
+    // Anything else is rejected up front
+    BOOST_CHECK_THROW(Chip8::RomCorpus corpus(paths[0]), std::string);
+    BOOST_CHECK_THROW(Chip8::RomCorpus::pack("RomCorpusTest.corpus", {paths[0], paths[1]}, {"same", "same"}), std::string);
+
+    for(const std::string& path : paths){
+        std::remove(path.c_str());
+    }
+    std::remove("RomCorpusTest.corpus");
+}
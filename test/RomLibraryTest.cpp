@@ -0,0 +1,95 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "../src/Chip8Util.hpp"
+#include "../src/RomLibrary.hpp"
+
+static void writeLibraryFile(const std::string& t_path, const std::string& t_contents){
+    std::ofstream fileStream(t_path, std::ios::binary | std::ios::trunc);
+    fileStream << t_contents;
+}
+
+BOOST_AUTO_TEST_CASE(RomLibraryTest_xxh64){
+    const std::string text = "Nobody inspects the spammish repetition";
+    BOOST_CHECK_EQUAL(Chip8::Util::xxh64(nullptr, 0), 0xef46db3751d8e999);
+    BOOST_CHECK_EQUAL(Chip8::Util::xxh64(reinterpret_cast<const uint8_t*>("abc"), 3), 0x44bc2cf5ad770999);
+    BOOST_CHECK_EQUAL(Chip8::Util::xxh64(reinterpret_cast<const uint8_t*>(text.data()), text.size()), 0xfbcea83c8a378bf1);
+}
+
+BOOST_AUTO_TEST_CASE(RomLibraryTest_rescan_and_profiles){
+    mkdir("RomLibraryTest_roms", 0755);
+    mkdir("RomLibraryTest_roms/sub", 0755);
+    writeLibraryFile("RomLibraryTest_roms/a.ch8", std::string("\x60\x01\x12\x00", 4));
+    writeLibraryFile("RomLibraryTest_roms/b.ch8", "\x61\x02");
+    writeLibraryFile("RomLibraryTest_roms/sub/c.ch8", "\xa2\x00\xf0\x65");
+
+    uint64_t romHash = Chip8::RomLibrary::hashContents(reinterpret_cast<const uint8_t*>("\x61\x02"), 2);
+    char section[17];
+    std::snprintf(section, sizeof(section), "%016llx", static_cast<unsigned long long>(romHash));
+    writeLibraryFile("RomLibraryTest_profiles.ini", "[" + std::string(section) + "]\nname = B\nipf = 20\nquirks = vip\nbg_color = 0x102030\nkey_ch8_1 = Q\n");
+
+    {
+        Chip8::RomLibrary library("RomLibraryTest.index", "RomLibraryTest_profiles.ini");
+        BOOST_CHECK_EQUAL(library.scan("RomLibraryTest_roms").size(), 3);
+        BOOST_CHECK_EQUAL(library.hashed(), 3);
+        BOOST_CHECK_EQUAL(library.hash("RomLibraryTest_roms/../RomLibraryTest_roms/b.ch8"), romHash);
+        BOOST_CHECK_EQUAL(library.hashed(), 3);
+
+        const Chip8::RomProfile* profile = library.profile(romHash);
+        BOOST_REQUIRE(profile);
+        BOOST_CHECK_EQUAL(profile->name, "B");
+        BOOST_CHECK_EQUAL(profile->instructionsPerFrame, 20);
+        BOOST_CHECK_EQUAL(profile->tickPeriodUsec(), 1000000 / (CHIP8_FRAME_RATE * 20));
+        BOOST_CHECK_EQUAL(profile->quirks, "vip");
+        // Only the background is set, the foreground stays the config's
+        BOOST_CHECK(profile->hasBgColor);
+        BOOST_CHECK(!profile->hasFgColor);
+        BOOST_CHECK_EQUAL(profile->bgColor, 0x102030);
+        BOOST_REQUIRE_EQUAL(profile->keyBinds.size(), 1);
+        BOOST_CHECK_EQUAL(profile->keyBinds[0].second, "Q");
+        BOOST_CHECK(!library.profile(romHash + 1));
+        library.save();
+    }
+
+    // A fresh library only reads what changed since the index was written
+    writeLibraryFile("RomLibraryTest_roms/a.ch8", std::string("\x60\x02\x12\x00\x00\x00", 6));
+    std::remove("RomLibraryTest_roms/sub/c.ch8");
+    {
+        Chip8::RomLibrary library("RomLibraryTest.index", "RomLibraryTest_profiles.ini");
+        BOOST_CHECK_EQUAL(library.scan("RomLibraryTest_roms").size(), 2);
+        BOOST_CHECK_EQUAL(library.hashed(), 1);
+        library.save();
+    }
+    {
+        Chip8::RomLibrary library("RomLibraryTest.index", "missing_profiles.ini");
+        library.scan("RomLibraryTest_roms");
+        BOOST_CHECK_EQUAL(library.hashed(), 0);
+        BOOST_CHECK(!library.profile(romHash));
+    }
+
+    // Speeds the timer period cannot keep to 60Hz are turned down when the profiles are read
+    for(const char* ipf : {"256", "20000", "-1"}){
+        writeLibraryFile("RomLibraryTest_profiles.ini", "[" + std::string(section) + "]\nipf = " + ipf + "\n");
+        BOOST_CHECK_THROW(Chip8::RomLibrary("RomLibraryTest.index", "RomLibraryTest_profiles.ini"), std::string);
+    }
+    writeLibraryFile("RomLibraryTest_profiles.ini", "[" + std::string(section) + "]\nipf = 255\nquirks = schip\n");
+    {
+        Chip8::RomLibrary library("RomLibraryTest.index", "RomLibraryTest_profiles.ini");
+        BOOST_REQUIRE(library.profile(romHash));
+        BOOST_CHECK_GE(library.profile(romHash)->tickPeriodUsec(), 1);
+        BOOST_CHECK_EQUAL(library.profile(romHash)->machineQuirks(), "schip:255");
+    }
+
+    std::remove("RomLibraryTest_roms/a.ch8");
+    std::remove("RomLibraryTest_roms/b.ch8");
+    std::remove("RomLibraryTest_roms/sub");
+    std::remove("RomLibraryTest_roms");
+    std::remove("RomLibraryTest_profiles.ini");
+    std::remove("RomLibraryTest.index");
+}
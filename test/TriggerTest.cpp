@@ -0,0 +1,131 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Chip8.hpp"
+#include "../src/Chip8Machine.hpp"
+#include "../src/Trigger.hpp"
+
+// Sets V0-V3, I and DT, then spins at 0x20c
+static const uint8_t registerRom[] = {
+    0x60, 0x05, 0x61, 0x03, 0xa1, 0x23, 0x62, 0x30, 0xf2, 0x15, 0x63, 0xff, 0x12, 0x0c                  // 0x200
+};
+
+// Counter at 0x300 incremented once every 5 instructions
+static const uint8_t counterRom[] = {
+    0xa3, 0x00, 0xf0, 0x65, 0x70, 0x01, 0xf0, 0x55, 0x12, 0x00                                          // 0x200
+};
+
+static const std::vector<std::string> trueExpressions = {
+    "V0 * V1 == 15",
+    "V0 - V1 * 2 == -1",
+    "(V0 << V1) == 40 && V3 >> V1 == 31",
+    "-V0 / V1 == -1 && V0 % V1 == 2",
+    "~V0 == -6 && !V0 == 0 && !!v1",
+    "V0 < V1 || V1 <= 3",
+    "(V0 & V1) == 1 && (V0 ^ V1) == 6 && (V0 | V1) == 7",
+    "I == 0x123 && PC == 0x20c && DT > 0 && DT <= 0x30 && ST == 0",
+    "V0 != V1 && V0 >= 5 && V0 > 4",
+    "mem[PC] == 0x12 && mem16[PC] == 0x120c && mem16[0x20c] == 4620",
+    "mem[0x10000 + 0x200] == 0x60",
+    "V1 / 0 == 0 && V1 % 0 == 0",
+    "0x7fffffff + V1 == -2147483646",
+    "1 + 2 * 3 == 7 && (1 << 4 | 1) == 17 && -5 / 2 == -2 && ~0 == -1"
+};
+
+BOOST_AUTO_TEST_CASE(TriggerTest_expressions){
+    Chip8::Chip8 chip8(0);
+    chip8.load(registerRom, sizeof(registerRom));
+    for(int tick = 0; tick < 8; ++tick){
+        chip8.run_tick();
+    }
+
+    Chip8::TriggerProgram program;
+    for(std::size_t expression = 0; expression < trueExpressions.size(); ++expression){
+        program.add("t" + std::to_string(expression), trueExpressions[expression]);
+    }
+    std::size_t never = program.add("never", "V0 == 4 || mem[0x3a0]");
+    uint64_t all = (uint64_t(1) << trueExpressions.size()) - 1;
+    BOOST_CHECK_EQUAL(program.evaluate(chip8), all);
+
+    // Run time variants evaluate the same program on their concrete interpreter
+    for(const char* quirks : {"legacy", "schip", "xochip"}){
+        std::unique_ptr<Chip8::Machine> machine = Chip8::makeMachine(quirks, 0);
+        machine->load(registerRom, sizeof(registerRom));
+        for(int tick = 0; tick < 8; ++tick){
+            machine->run_tick();
+        }
+        BOOST_CHECK_EQUAL(machine->evaluate(program), all);
+    }
+    BOOST_CHECK(!(program.evaluate(chip8) >> never & 1));
+
+    // A constant compare of a constant address is the load, the compare and the result
+    Chip8::TriggerProgram single;
+    single.add("level", "mem[0x3a0] == 3");
+    BOOST_CHECK_EQUAL(single.code().size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(TriggerTest_counters){
+    Chip8::TriggerProgram program;
+    program.parse("# one per line or ';' separated\n"
+                  "odd: mem[0x300] % 2 == 1; above: mem[0x300] > 4\n"
+                  "never: V0 == 0xff   # comment\n");
+    BOOST_REQUIRE_EQUAL(program.size(), 3);
+    BOOST_CHECK_EQUAL(program.name(1), "above");
+
+    Chip8::Chip8 chip8(0);
+    chip8.load(counterRom, sizeof(counterRom));
+    Chip8::TriggerCounters counters(program.size());
+    // One evaluation per loop, the counter reads 1 to 10
+    for(uint64_t frame = 1; frame <= 10; ++frame){
+        for(int tick = 0; tick < 5; ++tick){
+            chip8.run_tick();
+        }
+        counters.update(program.evaluate(chip8), frame);
+    }
+    BOOST_CHECK_EQUAL(counters.counters()[0].fired, 5);
+    BOOST_CHECK_EQUAL(counters.counters()[0].frames, 5);
+    BOOST_CHECK_EQUAL(counters.counters()[0].firstFrame, 1);
+    BOOST_CHECK_EQUAL(counters.counters()[1].fired, 1);
+    BOOST_CHECK_EQUAL(counters.counters()[1].frames, 6);
+    BOOST_CHECK_EQUAL(counters.counters()[1].firstFrame, 5);
+    BOOST_CHECK_EQUAL(counters.counters()[2].fired, 0);
+    BOOST_CHECK_EQUAL(counters.events().size(), 6);
+    BOOST_CHECK_EQUAL(counters.events()[2].frame, 5);
+    BOOST_CHECK_EQUAL(counters.events()[2].trigger, 0);
+    BOOST_CHECK_EQUAL(counters.events()[3].trigger, 1);
+    BOOST_CHECK_EQUAL(counters.summary(program), "odd=5/5;above=1/6;never=0/0");
+
+    counters.clear();
+    BOOST_CHECK_EQUAL(counters.update(program.evaluate(chip8), 11), 2);
+}
+
+// V0 + (V0 + (...)), holding t_nesting + 1 operands at its deepest
+static std::string deepTrigger(std::size_t t_nesting){
+    std::string expression = "V0";
+    for(std::size_t level = 0; level < t_nesting; ++level){
+        expression = "V0 + (" + expression + ")";
+    }
+    return "x: " + expression;
+}
+
+BOOST_AUTO_TEST_CASE(TriggerTest_errors){
+    for(const std::string& triggers : std::vector<std::string>{"x: V5 >", "x: mem[1", "x: V5 > 10)", "x: VG == 1", "x: lives == 1", "x: 3a == 1", "x: 0x == 1",
+                                "x: 0x100000000", "x V5", "1-x: 1", "x: 1; x: 2", "x: V0 = 1", deepTrigger(CHIP8_TRIGGER_MAX_DEPTH)}){
+        Chip8::TriggerProgram program;
+        BOOST_CHECK_THROW(program.parse(triggers), std::string);
+    }
+
+    Chip8::TriggerProgram deep;
+    deep.parse(deepTrigger(CHIP8_TRIGGER_MAX_DEPTH - 1));
+
+    // A trigger that fails to compile leaves the program as it was
+    Chip8::TriggerProgram program;
+    program.add("ok", "V0 == 1");
+    BOOST_CHECK_THROW(program.add("bad", "V0 == "), std::string);
+    BOOST_CHECK_EQUAL(program.size(), 1);
+    BOOST_CHECK_EQUAL(program.code().size(), 3);
+}
@@ -0,0 +1,100 @@
+/*
+ * Chip8 corpus main, packs roms into a single memory mapped corpus file and lists corpora
+ */
+
+#include <cstdlib>
+#include <dirent.h>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../src/Chip8Util.hpp"
+#include "../../src/RomCorpus.hpp"
+
+static const option long_opts[] =   {{"output",      required_argument,  0,  'o'},
+                                     {"list",        required_argument,  0,  'l'},
+                                     {"help",        no_argument,        0,  'h'},
+                                     {0,             0,                  0,  0}};
+
+static const char usage[] = " -o CORPUS ROM|DIR... | -l CORPUS\n"
+                            "\t-o, --output=FILE       pack every ROM and every file below each DIR into FILE, roms are named\n"
+                            "\t                        by their path as given or as walked, so manifests keep working with -c\n"
+                            "\t-l, --list=FILE         print hash, size and name of every rom in FILE\n"
+                            "\t-h, --help              Prints this usage message then exits.";
+
+static void collectRoms(const std::string& t_path, std::vector<std::string>& t_romPaths){
+    const char* type = Chip8::Util::fileExists(t_path.c_str());
+    if(type == Chip8::Util::regFile){
+        t_romPaths.push_back(t_path);
+        return;
+    }
+    DIR* dir = (type)? opendir(t_path.c_str()) : nullptr;
+    if(!dir){
+        throw std::string("'" + t_path + "' is neither a rom nor a directory");
+    }
+    while(dirent* entry = readdir(dir)){
+        std::string name = entry->d_name;
+        if(name != "." && name != ".."){
+            collectRoms(t_path + '/' + name, t_romPaths);
+        }
+    }
+    closedir(dir);
+}
+
+int main(int argc, char** argv){
+
+    int opt, longopt_ind = 0;
+    std::string outputPath;
+    std::string listPath;
+    opterr = 0;
+    while((opt = getopt_long(argc, argv, "o:l:h", long_opts, &longopt_ind)) != -1){
+        switch(opt){
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'l':
+                listPath = optarg;
+                break;
+            case 'h':
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(0);
+            case '?':
+                std::cerr << argv[0] << ": Error unknown option '" << static_cast<char>(optopt) << "'" << std::endl;
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(-1);
+            default:
+                break;
+        }
+    }
+
+    try{
+        if(!listPath.empty()){
+            Chip8::RomCorpus corpus(listPath);
+            for(std::size_t i = 0; i < corpus.size(); ++i){
+                Chip8::RomCorpus::Rom rom = corpus.rom(i);
+                std::cout << std::hex << std::setw(16) << std::setfill('0') << rom.hash << std::dec << ' ' << rom.size << ' '
+                          << std::string(rom.name, rom.nameSize) << '\n';
+            }
+            return(0);
+        }
+
+        if(outputPath.empty() || optind == argc){
+            std::cerr << "Error: expected -o CORPUS and at least one rom or directory." << std::endl;
+            exit(-1);
+        }
+        std::vector<std::string> romPaths;
+        for(int arg = optind; arg < argc; ++arg){
+            collectRoms(argv[arg], romPaths);
+        }
+        Chip8::RomCorpus::pack(outputPath, romPaths, romPaths);
+        std::cerr << "Packed " << romPaths.size() << " roms into " << outputPath << std::endl;
+    }
+    catch(const std::string& error){
+        std::cerr << argv[0] << ": Error " << error << std::endl;
+        exit(-1);
+    }
+
+    return(0);
+}
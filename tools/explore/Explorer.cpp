@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Explorer.hpp"
+#include "../../src/Chip8.hpp"
+
+namespace Chip8{
+    namespace Explore{
+
+        Target parseTarget(const std::string& t_target){
+            std::size_t separator = t_target.find('=');
+            if(separator == std::string::npos || separator == 0 || separator + 1 == t_target.size()){
+                throw std::string("Explorer: malformed target '" + t_target + "', expected '<addr>=<value>' or 'v<x>=<value>'");
+            }
+
+            std::string lhs = t_target.substr(0, separator);
+            std::string rhs = t_target.substr(separator + 1);
+            Target target;
+            char* end;
+            target.reg = (lhs[0] == 'v' || lhs[0] == 'V');
+            unsigned long addr = std::strtoul(lhs.c_str() + target.reg, &end, 16);
+            if(*end || addr >= ((target.reg)? CHIP8_NUM_V_REG : CHIP8_MAIN_MEM_SIZE)){
+                throw std::string("Explorer: bad target location '" + lhs + "'");
+            }
+            unsigned long value = std::strtoul(rhs.c_str(), &end, 0);
+            if(*end || value > UINT8_MAX){
+                throw std::string("Explorer: bad target value '" + rhs + "'");
+            }
+            target.addr = addr;
+            target.value = value;
+            return target;
+        }
+
+        void writeInputScript(std::ostream& t_outStream, const std::vector<uint16_t>& t_path, uint64_t t_frameInstructions){
+            uint16_t held = 0;
+            for(std::size_t frame = 0; frame <= t_path.size(); ++frame){
+                // Release everything after the last frame
+                uint16_t keys = (frame < t_path.size())? t_path[frame] : 0;
+                for(uint8_t key = 0; key < 16; ++key){
+                    if(((held ^ keys) >> key) & 0x01){
+                        t_outStream << frame * t_frameInstructions << ' ' << std::hex << static_cast<unsigned>(key) << std::dec << ' '
+                                    << (((keys >> key) & 0x01)? "down" : "up") << '\n';
+                    }
+                }
+                held = keys;
+            }
+        }
+
+        template<typename TChip8>
+        Explorer<TChip8>::Explorer(const std::vector<uint8_t>& t_rom, const Options& t_options) : m_options(t_options),
+                                                                                                 m_image(PagedMemory::makeImage(t_rom.data(), t_rom.size())),
+                                                                                                 m_boot(new TChip8(t_options.seed)),
+                                                                                                 m_numFaulted(0),
+                                                                                                 m_pool(t_options.numThreads),
+                                                                                                 m_found(false){
+            if(m_options.actions.empty()){
+                m_options.actions.push_back(0);
+                for(uint8_t key = 0; key < 16; ++key){
+                    m_options.actions.push_back(0x01 << key);
+                }
+            }
+            if(!m_options.memoryNodes){
+                m_options.memoryNodes = 1;
+            }
+
+            // Same boot as a farm job with this seed, found paths replay there unchanged
+            m_boot->reset(m_options.seed);
+            m_boot->load(m_image);
+        }
+
+        template<typename TChip8>
+        bool Explorer<TChip8>::matches(const TChip8& t_machine) const{
+            if(m_options.targets.empty()){
+                return false;
+            }
+            for(const Target& target : m_options.targets){
+                uint8_t value = (target.reg)? t_machine.getRegisters()[target.addr] : t_machine.getMemory().read(target.addr);
+                if(value != target.value){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename TChip8>
+        bool Explorer<TChip8>::runFrame(TChip8& t_machine, uint16_t t_keys) const{
+            t_machine.setKeystates(t_keys);
+            try{
+                for(uint64_t i = 0; i < m_options.frameInstructions; ++i){
+                    t_machine.run_tick();
+                }
+            }
+            catch(const std::string&){
+                return false;
+            }
+            return true;
+        }
+
+        template<typename TChip8>
+        typename Explorer<TChip8>::Node Explorer<TChip8>::replay(const std::vector<uint16_t>& t_path) const{
+            // Spilled paths were expanded without faulting, replaying them is deterministic
+            Node node{std::unique_ptr<TChip8>(new TChip8(*m_boot)), t_path, 0};
+            for(uint16_t keys : t_path){
+                runFrame(*node.machine, keys);
+            }
+            return node;
+        }
+
+        template<typename TChip8>
+        std::size_t Explorer<TChip8>::chunkSize(std::size_t t_count) const{
+            std::size_t tasks = std::max<std::size_t>(1, std::min(t_count, m_pool.size() * CHIP8_EXPLORE_TASKS_PER_THREAD));
+            return std::max<std::size_t>(1, (t_count + tasks - 1) / tasks);
+        }
+
+        template<typename TChip8>
+        template<typename TFunc>
+        void Explorer<TChip8>::parallelFor(std::size_t t_count, TFunc t_func){
+            std::size_t chunk = chunkSize(t_count);
+            for(std::size_t begin = 0; begin < t_count; begin += chunk){
+                std::size_t end = std::min(t_count, begin + chunk);
+                m_pool.submit([&t_func, chunk, begin, end]{
+                    t_func(begin / chunk, begin, end);
+                });
+            }
+            m_pool.wait();
+        }
+
+        template<typename TChip8>
+        void Explorer<TChip8>::expand(std::vector<Node>& t_nodes, std::size_t t_begin, std::size_t t_end, std::vector<Node>& t_children){
+            // Drops states seen in earlier levels or earlier in this chunk, the merge catches the rest
+            std::unordered_set<uint64_t> seen;
+            for(std::size_t index = t_begin; index < t_end; ++index){
+                Node& node = t_nodes[index];
+                for(std::size_t action = 0; action < m_options.actions.size(); ++action){
+                    // The last action takes over the parent instead of copying it
+                    std::unique_ptr<TChip8> machine((action + 1 < m_options.actions.size())? new TChip8(*node.machine) : node.machine.release());
+                    uint16_t keys = m_options.actions[action];
+                    if(!runFrame(*machine, keys)){
+                        ++m_numFaulted;
+                        continue;
+                    }
+                    uint64_t hash = machine->fullStateHash();
+                    if(m_visited.count(hash) || !seen.insert(hash).second){
+                        continue;
+                    }
+
+                    t_children.push_back(Node{std::move(machine), node.path, hash});
+                    t_children.back().path.push_back(keys);
+                }
+                node.path = std::vector<uint16_t>();
+            }
+        }
+
+        template<typename TChip8>
+        void Explorer<TChip8>::expandAll(std::vector<Node>& t_nodes, Level& t_next){
+            std::vector<std::vector<Node>> children((t_nodes.size() + chunkSize(t_nodes.size()) - 1) / chunkSize(t_nodes.size()));
+            parallelFor(t_nodes.size(), [this, &t_nodes, &children](std::size_t t_chunk, std::size_t t_begin, std::size_t t_end){
+                expand(t_nodes, t_begin, t_end, children[t_chunk]);
+            });
+            t_nodes.clear();
+
+            // Merge in frontier order, the first input sequence reaching a state keeps it
+            for(std::vector<Node>& chunk : children){
+                for(Node& child : chunk){
+                    if(!m_visited.insert(child.hash).second){
+                        continue;
+                    }
+                    if(!m_found && matches(*child.machine)){
+                        m_found = true;
+                        m_foundPath = child.path;
+                    }
+                    store(child, t_next);
+                }
+                chunk.clear();
+            }
+        }
+
+        template<typename TChip8>
+        void Explorer<TChip8>::store(Node& t_child, Level& t_next){
+            if(t_next.nodes.size() < m_options.memoryNodes){
+                t_next.nodes.push_back(std::move(t_child));
+                return;
+            }
+
+            // Record is the path length followed by one key mask per frame
+            if(!t_next.spill.is_open()){
+                t_next.spill.open(t_next.spillPath, std::ios::binary | std::ios::trunc);
+                if(!t_next.spill.is_open()){
+                    throw std::string("Explorer: could not open spill file '" + t_next.spillPath + "'");
+                }
+            }
+            uint32_t length = t_child.path.size();
+            t_next.spill.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            t_next.spill.write(reinterpret_cast<const char*>(t_child.path.data()), length * sizeof(uint16_t));
+            ++t_next.spilled;
+        }
+
+        template<typename TChip8>
+        Result Explorer<TChip8>::run(std::ostream& t_progress){
+            auto start = std::chrono::steady_clock::now();
+            Result result;
+
+            std::vector<Node> frontier;
+            frontier.push_back(Node{std::unique_ptr<TChip8>(new TChip8(*m_boot)), std::vector<uint16_t>(), m_boot->fullStateHash()});
+            m_visited.insert(frontier.back().hash);
+            m_found = matches(*frontier.back().machine);
+
+            std::string spillIn;
+            std::size_t spilledIn = 0;
+            std::size_t depth = 0;
+            while(!m_found && depth < m_options.maxDepth && (!frontier.empty() || spilledIn)){
+                Level next;
+                next.spillPath = m_options.spillPath + '.' + std::to_string((depth + 1) % 2);
+                expandAll(frontier, next);
+
+                if(spilledIn){
+                    std::ifstream spill(spillIn, std::ios::binary);
+                    std::vector<std::vector<uint16_t>> paths;
+                    uint32_t length;
+                    while(spill.read(reinterpret_cast<char*>(&length), sizeof(length))){
+                        paths.emplace_back(length);
+                        spill.read(reinterpret_cast<char*>(paths.back().data()), length * sizeof(uint16_t));
+                        if(paths.size() == m_options.memoryNodes || spill.peek() == std::ifstream::traits_type::eof()){
+                            std::vector<Node> nodes(paths.size());
+                            parallelFor(paths.size(), [this, &paths, &nodes](std::size_t, std::size_t t_begin, std::size_t t_end){
+                                for(std::size_t index = t_begin; index < t_end; ++index){
+                                    nodes[index] = replay(paths[index]);
+                                }
+                            });
+                            paths.clear();
+                            expandAll(nodes, next);
+                        }
+                    }
+                    spill.close();
+                    std::remove(spillIn.c_str());
+                }
+
+                next.spill.close();
+                frontier = std::move(next.nodes);
+                spillIn = next.spillPath;
+                spilledIn = next.spilled;
+                ++depth;
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+                t_progress << "depth " << depth << ": frontier " << frontier.size() + spilledIn << " (" << spilledIn << " spilled), visited "
+                           << m_visited.size() << ", faulted " << m_numFaulted << ", " << elapsed << " ms" << std::endl;
+            }
+            if(spilledIn){
+                std::remove(spillIn.c_str());
+            }
+
+            result.found = m_found;
+            result.path = m_foundPath;
+            result.visited = m_visited.size();
+            result.faulted = m_numFaulted;
+            result.depth = depth;
+            return result;
+        }
+
+        template class Explorer<Chip8>;
+        template class Explorer<Chip8Xorshift>;
+        template class Explorer<Chip8Pcg32>;
+
+    } // namespace Explore
+} // namespace Chip8
@@ -0,0 +1,114 @@
+#ifndef CHIP8_EXPLORER_HPP
+#define CHIP8_EXPLORER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../../src/PagedMemory.hpp"
+#include "../../src/ThreadPool.hpp"
+
+#define CHIP8_EXPLORE_DEFAULT_FRAME_INSTRUCTIONS 10
+#define CHIP8_EXPLORE_DEFAULT_MAX_DEPTH          64
+#define CHIP8_EXPLORE_DEFAULT_MEMORY_NODES       (1 << 16)
+#define CHIP8_EXPLORE_TASKS_PER_THREAD           4
+
+namespace Chip8{
+    namespace Explore{
+
+        // Condition on the machine state, mem[addr] == value or V[addr] == value
+        struct Target{
+            bool reg;
+            uint16_t addr;
+            uint8_t value;
+        };
+
+        // Parses '<hex addr>=<value>' or 'v<x>=<value>', values are decimal or 0x prefixed hex
+        Target parseTarget(const std::string& t_target);
+
+        struct Options{
+            uint64_t seed = 0;
+            uint64_t frameInstructions = CHIP8_EXPLORE_DEFAULT_FRAME_INSTRUCTIONS;
+            std::size_t maxDepth = CHIP8_EXPLORE_DEFAULT_MAX_DEPTH;
+            // Frontier nodes kept as live machines, the rest of a level is spilled to disk
+            std::size_t memoryNodes = CHIP8_EXPLORE_DEFAULT_MEMORY_NODES;
+            std::string spillPath = "chip8_explore.spill";
+            std::size_t numThreads = 1;
+            // Key masks tried every frame, no key plus every single key by default
+            std::vector<uint16_t> actions;
+            std::vector<Target> targets;
+        };
+
+        struct Result{
+            bool found = false;
+            // Key mask held during each frame from boot to the target state
+            std::vector<uint16_t> path;
+            uint64_t visited = 0;
+            uint64_t faulted = 0;
+            std::size_t depth = 0;
+        };
+
+        // Breadth first search over the input space at frame granularity. Every level expands each
+        // frontier state by each action in parallel, states are deduplicated on fullStateHash() so
+        // a state reached by several input sequences is expanded once. Workers only read the set of
+        // states seen in earlier levels, children are merged in frontier order afterwards so results
+        // do not depend on the number of threads. Levels that outgrow memoryNodes live machines spill
+        // the excess to disk as key paths, a few bytes per frame, and spilled nodes are rebuilt by
+        // replaying their path from boot when their level is expanded.
+        template<typename TChip8>
+        class Explorer{
+
+        private:
+            struct Node{
+                std::unique_ptr<TChip8> machine;
+                std::vector<uint16_t> path;
+                uint64_t hash;
+            };
+
+            // Nodes of the level being built
+            struct Level{
+                std::vector<Node> nodes;
+                std::ofstream spill;
+                std::string spillPath;
+                std::size_t spilled = 0;
+            };
+
+            Options m_options;
+            std::shared_ptr<const MemoryImage> m_image;
+            std::unique_ptr<TChip8> m_boot;
+            std::unordered_set<uint64_t> m_visited;
+            std::atomic<uint64_t> m_numFaulted;
+            Util::ThreadPool m_pool;
+
+            bool m_found;
+            std::vector<uint16_t> m_foundPath;
+
+            bool matches(const TChip8& t_machine) const;
+            bool runFrame(TChip8& t_machine, uint16_t t_keys) const;
+            Node replay(const std::vector<uint16_t>& t_path) const;
+            void expand(std::vector<Node>& t_nodes, std::size_t t_begin, std::size_t t_end, std::vector<Node>& t_children);
+            void expandAll(std::vector<Node>& t_nodes, Level& t_next);
+            void store(Node& t_child, Level& t_next);
+            std::size_t chunkSize(std::size_t t_count) const;
+            // Runs t_func(chunk, begin, end) over [0, t_count) in chunks of chunkSize(t_count) on the pool
+            template<typename TFunc>
+            void parallelFor(std::size_t t_count, TFunc t_func);
+
+        public:
+            Explorer(const std::vector<uint8_t>& t_rom, const Options& t_options);
+
+            Result run(std::ostream& t_progress);
+        };
+
+        // Converts a search result into an InputScript that replays it, cycles are counted from boot
+        void writeInputScript(std::ostream& t_outStream, const std::vector<uint16_t>& t_path, uint64_t t_frameInstructions);
+
+    } // namespace Explore
+} // namespace Chip8
+
+#endif // CHIP8_EXPLORER_HPP
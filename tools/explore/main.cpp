@@ -0,0 +1,166 @@
+/*
+ * Chip8 explorer main, searches the input space of a rom for a target state
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "Explorer.hpp"
+#include "../farm/Farm.hpp"
+#include "../../src/Chip8.hpp"
+
+static const option long_opts[] =   {{"target",      required_argument,  0,  't'},
+                                     {"keys",        required_argument,  0,  'k'},
+                                     {"seed",        required_argument,  0,  's'},
+                                     {"frame",       required_argument,  0,  'f'},
+                                     {"depth",       required_argument,  0,  'd'},
+                                     {"nodes",       required_argument,  0,  'n'},
+                                     {"spill",       required_argument,  0,  'S'},
+                                     {"jobs",        required_argument,  0,  'j'},
+                                     {"rng",         required_argument,  0,  'r'},
+                                     {"output",      required_argument,  0,  'o'},
+                                     {"help",        no_argument,        0,  'h'},
+                                     {0,             0,                  0,  0}};
+
+static const char usage[] = " [Options] ROM\n"
+                            "\t-t, --target=COND       state to reach, '<hex addr>=<value>' or 'v<x>=<value>'; repeat to require several,\n"
+                            "\t                        without a target the reachable state space is enumerated up to the depth limit\n"
+                            "\t-k, --keys=KEYS         hex digits of the keys tried each frame, default all 16; no key is always tried\n"
+                            "\t-s, --seed=N            RND seed, found paths replay as a chip8_farm job with the same seed\n"
+                            "\t-f, --frame=N           instructions per frame, the input granularity, default 10\n"
+                            "\t-d, --depth=N           maximum number of frames searched, default 64\n"
+                            "\t-n, --nodes=N           frontier states kept in memory, the rest is spilled to disk, default 65536\n"
+                            "\t-S, --spill=FILE        prefix of the frontier spill files, default ./chip8_explore.spill\n"
+                            "\t-j, --jobs=N            number of worker threads, defaults to the number of cores\n"
+                            "\t-r, --rng=NAME          generator behind RND; NAME can be 'mt19937' (default), 'xorshift', 'pcg32'\n"
+                            "\t-o, --output=FILE       write the input script reaching the target to FILE instead of stdout\n"
+                            "\t-h, --help              Prints this usage message then exits.";
+
+template<typename TChip8>
+static Chip8::Explore::Result explore(const std::vector<uint8_t>& t_rom, const Chip8::Explore::Options& t_options){
+    Chip8::Explore::Explorer<TChip8> explorer(t_rom, t_options);
+    return explorer.run(std::cerr);
+}
+
+int main(int argc, char** argv){
+
+    int opt, longopt_ind = 0;
+    Chip8::Explore::Options options;
+    options.numThreads = std::thread::hardware_concurrency();
+    std::string outputPath;
+    Chip8::Farm::RngPolicy rng = Chip8::Farm::RNG_MT19937;
+    opterr = 0;
+    try{
+        while((opt = getopt_long(argc, argv, "t:k:s:f:d:n:S:j:r:o:h", long_opts, &longopt_ind)) != -1){
+            switch(opt){
+                case 't':
+                    options.targets.push_back(Chip8::Explore::parseTarget(optarg));
+                    break;
+                case 'k':
+                    options.actions.assign(1, 0);
+                    for(const char* digit = optarg; *digit; ++digit){
+                        if(!std::isxdigit(*digit)){
+                            throw std::string("option '-k | --keys' argument '" + std::string(optarg) + "' is not a list of hex digits");
+                        }
+                        options.actions.push_back(0x01 << std::stoul(std::string(1, *digit), nullptr, 16));
+                    }
+                    break;
+                case 's':
+                    options.seed = std::strtoull(optarg, nullptr, 10);
+                    break;
+                case 'f':
+                    options.frameInstructions = std::strtoull(optarg, nullptr, 10);
+                    break;
+                case 'd':
+                    options.maxDepth = std::strtoul(optarg, nullptr, 10);
+                    break;
+                case 'n':
+                    options.memoryNodes = std::strtoul(optarg, nullptr, 10);
+                    break;
+                case 'S':
+                    options.spillPath = optarg;
+                    break;
+                case 'j':
+                    options.numThreads = std::strtoul(optarg, nullptr, 10);
+                    break;
+                case 'r':
+                    rng = Chip8::Farm::getRngPolicyFromName(optarg);
+                    break;
+                case 'o':
+                    outputPath = optarg;
+                    break;
+                case 'h':
+                    std::cout << "Usage: " << argv[0] << usage << std::endl;
+                    exit(0);
+                case '?':
+                    std::cerr << argv[0] << ": Error unknown option '" << static_cast<char>(optopt) << "'" << std::endl;
+                    std::cout << "Usage: " << argv[0] << usage << std::endl;
+                    exit(-1);
+                default:
+                    break;
+            }
+        }
+    }
+    catch(const std::string& error){
+        std::cerr << argv[0] << ": Error " << error << "\nTry '" << argv[0] << " --help for more information" << std::endl;
+        exit(-1);
+    }
+
+    if(optind + 1 != argc){
+        std::cerr << "Error: expected exactly one rom." << std::endl;
+        exit(-1);
+    }
+    std::string romPath = argv[optind];
+    std::ifstream romStream(romPath, std::ios::binary);
+    if(!romStream.is_open()){
+        std::cerr << "Error: could not open rom '" << romPath << "'" << std::endl;
+        exit(-1);
+    }
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(romStream)), std::istreambuf_iterator<char>());
+
+    try{
+        Chip8::Explore::Result result;
+        if(rng == Chip8::Farm::RNG_XORSHIFT){
+            result = explore<Chip8::Chip8Xorshift>(rom, options);
+        }
+        else if(rng == Chip8::Farm::RNG_PCG32){
+            result = explore<Chip8::Chip8Pcg32>(rom, options);
+        }
+        else{
+            result = explore<Chip8::Chip8>(rom, options);
+        }
+
+        std::cerr << result.visited << " distinct states, " << result.faulted << " faulted branches, " << result.depth << " frames deep" << std::endl;
+        if(options.targets.empty()){
+            return(0);
+        }
+        if(!result.found){
+            std::cerr << "Target not reached." << std::endl;
+            return(1);
+        }
+
+        std::ofstream outputFile;
+        if(!outputPath.empty()){
+            outputFile.open(outputPath);
+            if(!outputFile.is_open()){
+                std::cerr << "Error: could not open output file '" << outputPath << "'" << std::endl;
+                exit(-1);
+            }
+        }
+        std::ostream& output = (outputFile.is_open())? outputFile : std::cout;
+        output << "# " << romPath << " seed " << options.seed << ", target reached after " << result.path.size() * options.frameInstructions << " cycles\n";
+        Chip8::Explore::writeInputScript(output, result.path, options.frameInstructions);
+    }
+    catch(const std::string& error){
+        std::cerr << error << std::endl;
+        exit(-1);
+    }
+
+    return(0);
+}
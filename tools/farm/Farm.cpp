@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+
+#include "Farm.hpp"
+#include "../../src/Chip8Differential.hpp"
+#include "../../src/Chip8Lockstep.hpp"
+#include "../../src/Chip8Util.hpp"
+#include "../../src/ThreadPool.hpp"
+
+namespace Chip8{
+    namespace Farm{
+
+        Farm::Farm(const std::string& t_manifestPath, const RomCorpus* t_corpus) : m_corpus(t_corpus),
+                                                                                   m_triggers(nullptr), m_profilePeriod(CHIP8_PROFILE_DEFAULT_PERIOD),
+                                                                                   m_searchSteps(nullptr){
+            std::ifstream manifest(t_manifestPath);
+            if(!manifest.is_open()){
+                throw std::string("Farm: could not open manifest '" + t_manifestPath + "'");
+            }
+
+            std::string line;
+            std::size_t lineNumber = 0;
+            while(std::getline(manifest, line)){
+                ++lineNumber;
+                line = line.substr(0, line.find('#'));
+                if(line.find_first_not_of(" \t\r") == std::string::npos){
+                    continue;
+                }
+
+                std::istringstream lineStream(line);
+                std::string romPath, scriptPath;
+                Job job;
+                if(!(lineStream >> romPath >> job.seed >> job.cycles)){
+                    throw std::string("Farm: malformed job '" + line + "' on line " + std::to_string(lineNumber) + " of " + t_manifestPath);
+                }
+                lineStream >> scriptPath;
+
+                job.id = m_jobs.size();
+                job.rom = addRom(romPath);
+                job.script = (scriptPath.empty())? -1 : addScript(scriptPath);
+                m_jobs.push_back(job);
+            }
+        }
+
+        std::size_t Farm::addRom(const std::string& t_romPath){
+            auto known = m_romIndices.find(t_romPath);
+            if(known != m_romIndices.end()){
+                return known->second;
+            }
+
+            if(m_corpus){
+                long index = (t_romPath.compare(0, 5, "hash:"))? m_corpus->find(t_romPath) : m_corpus->find(std::strtoull(t_romPath.c_str() + 5, nullptr, 16));
+                if(index < 0){
+                    throw std::string("Farm: rom '" + t_romPath + "' is not in the corpus");
+                }
+                RomCorpus::Rom rom = m_corpus->rom(index);
+                m_roms.emplace_back(rom.data, rom.data + rom.size);
+            }
+            else{
+                std::ifstream romStream(t_romPath, std::ios::binary);
+                if(!romStream.is_open()){
+                    throw std::string("Farm: could not open rom '" + t_romPath + "'");
+                }
+                m_roms.emplace_back(std::istreambuf_iterator<char>(romStream), std::istreambuf_iterator<char>());
+            }
+            m_images.push_back(PagedMemory::makeImage(m_roms.back().data(), m_roms.back().size()));
+            m_romHashes.push_back(Util::xxh64(m_roms.back().data(), m_roms.back().size()));
+            m_romPaths.push_back(t_romPath);
+            m_romIndices.emplace(t_romPath, m_roms.size() - 1);
+            return m_roms.size() - 1;
+        }
+
+        long Farm::addScript(const std::string& t_scriptPath){
+            auto known = std::find(m_scriptPaths.begin(), m_scriptPaths.end(), t_scriptPath);
+            if(known != m_scriptPaths.end()){
+                return std::distance(m_scriptPaths.begin(), known);
+            }
+            m_scripts.emplace_back(t_scriptPath);
+            m_scriptPaths.push_back(t_scriptPath);
+            return m_scripts.size() - 1;
+        }
+
+        std::vector<SearchStep> parseSearchSteps(std::istream& t_steps){
+            std::vector<SearchStep> steps;
+            std::string line;
+            std::size_t lineNumber = 0;
+            while(std::getline(t_steps, line)){
+                ++lineNumber;
+                line = line.substr(0, line.find('#'));
+                if(line.find_first_not_of(" \t\r") == std::string::npos){
+                    continue;
+                }
+
+                std::istringstream lineStream(line);
+                std::string predicate, rest;
+                unsigned value = 0;
+                SearchStep step;
+                if(!(lineStream >> step.cycle >> predicate) || (!(lineStream >> value) && !lineStream.eof()) || value > 0xff || (lineStream >> rest)
+                   || (!steps.empty() && step.cycle < steps.back().cycle)){
+                    throw std::string("Farm: malformed search step '" + line + "' on line " + std::to_string(lineNumber)
+                                      + ", expected '<cycle> <predicate> [N]' in ascending cycle order");
+                }
+                try{
+                    step.predicate = getSearchPredicateFromName(predicate);
+                }
+                catch(const std::string& error){
+                    throw std::string("Farm: " + error + " on line " + std::to_string(lineNumber));
+                }
+                step.value = static_cast<uint8_t>(value);
+                steps.push_back(step);
+            }
+            return steps;
+        }
+
+        // Guest memory in one piece, pages still reading through to the rom image are copied from there
+        template<typename TChip8>
+        static void copyMemory(const TChip8& t_chip8, uint8_t* t_buffer){
+            for(std::size_t page = 0; page < CHIP8_NUM_PAGES; ++page){
+                std::copy(t_chip8.getMemory().page(page), t_chip8.getMemory().page(page) + CHIP8_PAGE_SIZE, t_buffer + page * CHIP8_PAGE_SIZE);
+            }
+        }
+
+        // Narrows t_instance at every step from t_step due at t_cycle, returns the first step still ahead. Each job
+        // narrows through its own t_memory so batches on other threads never share a buffer.
+        template<typename TChip8>
+        static std::size_t narrowSearch(const TChip8& t_chip8, std::size_t t_instance, const JobSearch& t_search, uint8_t* t_memory, uint64_t t_cycle,
+                                        std::size_t t_step){
+            for(; t_step < t_search.steps->size() && (*t_search.steps)[t_step].cycle == t_cycle; ++t_step){
+                copyMemory(t_chip8, t_memory);
+                t_search.search->narrow(t_instance, t_memory, (*t_search.steps)[t_step].predicate, (*t_search.steps)[t_step].value);
+            }
+            return t_step;
+        }
+
+        RngPolicy getRngPolicyFromName(const std::string& t_name){
+            if(t_name == "mt19937"){
+                return RNG_MT19937;
+            }
+            else if(t_name == "xorshift"){
+                return RNG_XORSHIFT;
+            }
+            else if(t_name == "pcg32"){
+                return RNG_PCG32;
+            }
+            throw std::string("'" + t_name + "' does not name a random generator, expected 'mt19937', 'xorshift' or 'pcg32'");
+        }
+
+        template<typename TChip8>
+        std::string runJob(TChip8& t_chip8, const std::shared_ptr<const MemoryImage>& t_image, const std::string& t_romPath, const Job& t_job,
+                           const InputScript* t_script, const BootState<TChip8>* t_boot, const TriggerProgram* t_triggers, Profiler* t_profiler,
+                           const JobSearch* t_search){
+            auto start = std::chrono::steady_clock::now();
+            std::size_t scriptPosition = 0;
+            std::string fault;
+            uint64_t cycle = 0;
+            TriggerCounters triggerCounters((t_triggers)? t_triggers->size() : 0);
+            std::vector<uint8_t> memory((t_search)? CHIP8_MAIN_MEM_SIZE : 0);
+            // Cycle of the next search step, the loop only compares against it
+            std::size_t step = 0;
+            uint64_t nextStep = UINT64_MAX;
+
+            if(t_boot && t_boot->ticks <= t_job.cycles){
+                // Script events before the boot ticks only set keys, the first apply() below catches up on them
+                t_chip8.restore(*t_boot->state, t_job.seed);
+                cycle = t_boot->ticks;
+            }
+            else{
+                t_chip8.reset(t_job.seed);
+                t_chip8.load(t_image);
+            }
+            if(t_search){
+                copyMemory(t_chip8, memory.data());
+                t_search->search->start(t_job.id, memory.data());
+                step = narrowSearch(t_chip8, t_job.id, *t_search, memory.data(), cycle, step);
+                nextStep = (step < t_search->steps->size())? (*t_search->steps)[step].cycle : UINT64_MAX;
+            }
+            try{
+                for(; cycle < t_job.cycles; ++cycle){
+                    if(t_script){
+                        scriptPosition = t_script->apply(t_chip8, cycle, scriptPosition);
+                    }
+                    if(t_profiler){
+                        t_profiler->tick(t_chip8);
+                    }
+                    else{
+                        t_chip8.run_tick();
+                    }
+                    if(t_triggers && !((cycle + 1) % CHIP8_FARM_TRIGGER_PERIOD)){
+                        triggerCounters.update(t_triggers->evaluate(t_chip8), (cycle + 1) / CHIP8_FARM_TRIGGER_PERIOD);
+                    }
+                    if(cycle + 1 == nextStep){
+                        step = narrowSearch(t_chip8, t_job.id, *t_search, memory.data(), cycle + 1, step);
+                        nextStep = (step < t_search->steps->size())? (*t_search->steps)[step].cycle : UINT64_MAX;
+                    }
+                }
+            }
+            catch(const std::string& error){
+                fault = error;
+            }
+
+            auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            std::replace(fault.begin(), fault.end(), ',', ';');
+            std::ostringstream result;
+            result << t_job.id << ',' << t_romPath << ',' << t_job.seed << ',' << cycle << ','
+                   << ((fault.empty())? 0 : 1) << ',' << fault << ",0x" << std::hex << std::setw(16) << std::setfill('0') << t_chip8.stateHash()
+                   << std::dec << ',' << wallTime;
+            if(t_profiler){
+                const ExecutionCounters& counters = t_chip8.getCounters();
+                result << ',' << counters.draws << ',' << counters.spriteRows << ',' << counters.collisions << ',' << counters.skipsTaken << ',' << counters.keyWaits;
+            }
+            if(t_triggers){
+                result << ',' << triggerCounters.summary(*t_triggers);
+            }
+            if(t_search){
+                result << ',' << t_search->search->candidates(t_job.id);
+            }
+            result << '\n';
+            return result.str();
+        }
+
+        template std::string runJob<Chip8>(Chip8&, const std::shared_ptr<const MemoryImage>&, const std::string&, const Job&, const InputScript*,
+                                           const BootState<Chip8>*, const TriggerProgram*, Profiler*, const JobSearch*);
+        template std::string runJob<Chip8Xorshift>(Chip8Xorshift&, const std::shared_ptr<const MemoryImage>&, const std::string&, const Job&, const InputScript*,
+                                                   const BootState<Chip8Xorshift>*, const TriggerProgram*, Profiler*, const JobSearch*);
+        template std::string runJob<Chip8Pcg32>(Chip8Pcg32&, const std::shared_ptr<const MemoryImage>&, const std::string&, const Job&, const InputScript*,
+                                                const BootState<Chip8Pcg32>*, const TriggerProgram*, Profiler*, const JobSearch*);
+
+        template<typename TChip8>
+        std::string Farm::runBatch(std::vector<Job>::const_iterator t_begin, std::vector<Job>::const_iterator t_end, BootCache<TChip8>* t_bootCache,
+                                   Profiler* t_profiler, ExecutionCounters* t_counters, const JobSearch* t_search) const{
+            // One interpreter per batch, every job of a batch runs the same rom
+            TChip8 chip8(0);
+            std::ostringstream results;
+
+            const BootState<TChip8>* boot = nullptr;
+            if(t_bootCache){
+                chip8.load(m_images[t_begin->rom]);
+                boot = &t_bootCache->boot(m_romHashes[t_begin->rom], chip8);
+            }
+
+            for(auto job = t_begin; job != t_end; ++job){
+                results << runJob(chip8, m_images[job->rom], m_romPaths[job->rom], *job, (job->script < 0)? nullptr : &m_scripts[job->script], boot, m_triggers,
+                                  t_profiler, t_search);
+                if(t_profiler){
+                    *t_counters += chip8.getCounters();
+                }
+            }
+            return results.str();
+        }
+
+        std::string Farm::runLockstepBatch(std::vector<Job>::const_iterator t_begin, std::vector<Job>::const_iterator t_end, uint64_t t_validate) const{
+            // Every job of a batch shares rom and cycle budget, wall time is the batch time split evenly across lanes
+            auto start = std::chrono::steady_clock::now();
+            std::size_t lanes = std::distance(t_begin, t_end);
+            LockstepEngine engine(lanes, m_roms[t_begin->rom].data(), m_roms[t_begin->rom].size());
+            const Lockstep& lockstep = engine.lockstep();
+            std::ostringstream results;
+
+            if(t_validate){
+                Differential differential(engine, m_roms[t_begin->rom].data(), m_roms[t_begin->rom].size(), t_validate);
+                for(std::size_t lane = 0; lane < lanes; ++lane){
+                    const Job& job = *(t_begin + lane);
+                    differential.reset(lane, job.seed, (job.script < 0)? nullptr : &m_scripts[job.script]);
+                }
+                Differential::Divergence divergence = differential.run(t_begin->cycles);
+                if(divergence.found){
+                    const Job& job = *(t_begin + divergence.lane);
+                    throw std::string("Farm: job " + std::to_string(job.id) + " (" + m_romPaths[job.rom] + ", seed " + std::to_string(job.seed)
+                                      + "), " + Differential::report(divergence));
+                }
+            }
+            else{
+                for(std::size_t lane = 0; lane < lanes; ++lane){
+                    const Job& job = *(t_begin + lane);
+                    engine.reset(lane, job.seed, (job.script < 0)? nullptr : &m_scripts[job.script]);
+                }
+                engine.runTo(t_begin->cycles);
+            }
+
+            auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / lanes;
+            for(std::size_t lane = 0; lane < lanes; ++lane){
+                const Job& job = *(t_begin + lane);
+                std::string fault = lockstep.faultMessage(lane);
+                std::replace(fault.begin(), fault.end(), ',', ';');
+                results << job.id << ',' << m_romPaths[job.rom] << ',' << job.seed << ',' << lockstep.instructions(lane) << ','
+                        << ((fault.empty())? 0 : 1) << ',' << fault << ",0x" << std::hex << std::setw(16) << std::setfill('0') << lockstep.stateHash(lane)
+                        << std::dec << ',' << wallTime << '\n';
+            }
+            return results.str();
+        }
+
+        void Farm::run(std::ostream& t_results, std::size_t t_numThreads, std::size_t t_batchSize, bool t_lockstep, RngPolicy t_rng, bool t_boot,
+                       const std::string& t_bootDirectory, uint64_t t_validate){
+            if(t_lockstep && t_rng != RNG_MT19937){
+                throw std::string("Farm: lockstep runs only support the mt19937 generator");
+            }
+            if(t_lockstep && m_triggers){
+                throw std::string("Farm: triggers need the interpreter, lockstep lanes do not expose their state");
+            }
+            if(t_lockstep && !m_profilePath.empty()){
+                throw std::string("Farm: profiling needs the interpreter, lockstep lanes do not run its handlers");
+            }
+            if(t_lockstep && m_searchSteps){
+                throw std::string("Farm: searches need the interpreter, lockstep lanes do not expose their memory");
+            }
+            // A boot state skips the frames its boot would have evaluated triggers at, the instructions a profile would
+            // count and the search steps before it
+            t_boot = t_boot && !m_triggers && m_profilePath.empty() && !m_searchSteps;
+            // Job ids number the manifest lines, one search instance each
+            m_search.reset((m_searchSteps)? new MemorySearch(m_jobs.size(), CHIP8_MAIN_MEM_SIZE) : nullptr);
+            JobSearch search = {m_search.get(), m_searchSteps};
+
+            if(!t_batchSize){
+                t_batchSize = 1;
+            }
+
+            // Group jobs by rom so a batch keeps one rom image and interpreter hot in cache
+            std::vector<Job> jobs(m_jobs);
+            std::stable_sort(jobs.begin(), jobs.end(), [t_lockstep](const Job& t_lhs, const Job& t_rhs){
+                return t_lhs.rom < t_rhs.rom || (t_lockstep && t_lhs.rom == t_rhs.rom && t_lhs.cycles < t_rhs.cycles);
+            });
+
+            // Boot states only depend on the rom, one cache per interpreter type serves every batch
+            BootCache<Chip8> bootCache("legacy", t_bootDirectory);
+            BootCache<Chip8Xorshift> bootCacheXorshift("legacy", t_bootDirectory);
+            BootCache<Chip8Pcg32> bootCachePcg32("legacy", t_bootDirectory);
+
+            std::mutex resultsLock;
+            std::string header = CHIP8_FARM_RESULTS_HEADER;
+            if(!m_profilePath.empty()){
+                header.insert(header.size() - 1, CHIP8_FARM_PROFILE_COLUMNS);
+            }
+            if(m_triggers){
+                header.insert(header.size() - 1, ",triggers");
+            }
+            if(m_searchSteps){
+                header.insert(header.size() - 1, ",candidates");
+            }
+            t_results << header;
+            // Profile of every job, batches merge theirs in under resultsLock
+            Profiler profile(m_profilePeriod);
+            ExecutionCounters counters = ExecutionCounters();
+            // First divergence found by validation, lockstep batches not started yet are skipped after it
+            std::atomic<bool> diverged(false);
+            std::string divergence;
+
+            Util::ThreadPool pool(t_numThreads);
+            auto batchBegin = jobs.cbegin();
+            while(batchBegin != jobs.cend()){
+                auto batchEnd = batchBegin;
+                std::size_t batchCount = 0;
+                while(batchEnd != jobs.cend() && batchEnd->rom == batchBegin->rom && batchCount < t_batchSize
+                      && (!t_lockstep || batchEnd->cycles == batchBegin->cycles)){
+                    ++batchEnd;
+                    ++batchCount;
+                }
+
+                // Lockstep lanes count instructions in 32 bits, longer jobs stay on the interpreter
+                bool lockstep = t_lockstep && batchBegin->cycles <= UINT32_MAX;
+                pool.submit([this, batchBegin, batchEnd, lockstep, t_rng, t_boot, t_validate, &bootCache, &bootCacheXorshift, &bootCachePcg32, &t_results,
+                             &resultsLock, &diverged, &divergence, &profile, &counters, &search]{
+                    const JobSearch* batchSearch = (search.search)? &search : nullptr;
+                    std::string batchResults;
+                    std::unique_ptr<Profiler> batchProfile((m_profilePath.empty())? nullptr : new Profiler(m_profilePeriod));
+                    ExecutionCounters batchCounters = ExecutionCounters();
+                    if(lockstep){
+                        if(diverged){
+                            return;
+                        }
+                        try{
+                            batchResults = runLockstepBatch(batchBegin, batchEnd, t_validate);
+                        }
+                        catch(const std::string& error){
+                            std::lock_guard<std::mutex> lock(resultsLock);
+                            if(!diverged.exchange(true)){
+                                divergence = error;
+                            }
+                            return;
+                        }
+                    }
+                    else if(t_rng == RNG_XORSHIFT){
+                        batchResults = runBatch<Chip8Xorshift>(batchBegin, batchEnd, (t_boot)? &bootCacheXorshift : nullptr, batchProfile.get(), &batchCounters, batchSearch);
+                    }
+                    else if(t_rng == RNG_PCG32){
+                        batchResults = runBatch<Chip8Pcg32>(batchBegin, batchEnd, (t_boot)? &bootCachePcg32 : nullptr, batchProfile.get(), &batchCounters, batchSearch);
+                    }
+                    else{
+                        batchResults = runBatch<Chip8>(batchBegin, batchEnd, (t_boot)? &bootCache : nullptr, batchProfile.get(), &batchCounters, batchSearch);
+                    }
+                    std::lock_guard<std::mutex> lock(resultsLock);
+                    t_results << batchResults << std::flush;
+                    if(batchProfile){
+                        profile.merge(*batchProfile);
+                        counters += batchCounters;
+                    }
+                });
+                batchBegin = batchEnd;
+            }
+            pool.wait();
+            if(diverged){
+                throw divergence;
+            }
+            if(!m_profilePath.empty()){
+                profile.save(m_profilePath, counters);
+            }
+        }
+
+    } // namespace Farm
+} // namespace Chip8
@@ -0,0 +1,154 @@
+#ifndef CHIP8_FARM_HPP
+#define CHIP8_FARM_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/BootCache.hpp"
+#include "../../src/InputScript.hpp"
+#include "../../src/MemorySearch.hpp"
+#include "../../src/PagedMemory.hpp"
+#include "../../src/Profiler.hpp"
+#include "../../src/RomCorpus.hpp"
+#include "../../src/Trigger.hpp"
+
+#define CHIP8_FARM_DEFAULT_BATCH_SIZE 64
+#define CHIP8_FARM_RESULTS_HEADER     "job,rom,seed,instructions,faulted,fault,state_hash,wall_usec\n"
+// Per job ExecutionCounters columns added when profiling
+#define CHIP8_FARM_PROFILE_COLUMNS    ",draws,sprite_rows,collisions,skips_taken,key_waits"
+// Instructions between trigger evaluations, one frame at the default speed
+#define CHIP8_FARM_TRIGGER_PERIOD     8
+
+namespace Chip8{
+    namespace Farm{
+
+        // Generator policy used for RND, see Chip8Rng.hpp
+        enum RngPolicy{
+            RNG_MT19937,
+            RNG_XORSHIFT,
+            RNG_PCG32
+        };
+
+        RngPolicy getRngPolicyFromName(const std::string& t_name);
+
+        struct Job{
+            std::size_t id;
+            std::size_t rom;
+            uint64_t seed;
+            uint64_t cycles;
+            long script;
+        };
+
+        // One narrowing of a memory search, taken once a job ran cycle instructions
+        struct SearchStep{
+            uint64_t cycle;
+            SearchPredicate predicate;
+            uint8_t value;
+        };
+
+        // Steps of a search file, one '<cycle> <predicate> [N]' per line in ascending cycle order, predicates as
+        // named by getSearchPredicateFromName and '#' starting a comment. Throws std::string on anything else.
+        std::vector<SearchStep> parseSearchSteps(std::istream& t_steps);
+
+        // The memory search of a farm run, every job its own instance of t_search
+        struct JobSearch{
+            MemorySearch* search;
+            const std::vector<SearchStep>* steps;
+        };
+
+        // Boots t_chip8 from t_image, runs t_job and returns its CSV result line. With t_boot, the boot state of
+        // the rom, jobs long enough to reach it start from a copy of it instead. With t_triggers, they are evaluated
+        // every CHIP8_FARM_TRIGGER_PERIOD instructions and the line ends in their counts, see TriggerCounters::summary.
+        // With t_profiler, every tick goes through it and the job's ExecutionCounters follow the wall time. With
+        // t_search, the job's memory is snapshot where it starts and narrowed at every step its budget reaches, the
+        // line then ends in the candidates it has left.
+        template<typename TChip8>
+        std::string runJob(TChip8& t_chip8, const std::shared_ptr<const MemoryImage>& t_image, const std::string& t_romPath, const Job& t_job,
+                           const InputScript* t_script, const BootState<TChip8>* t_boot = nullptr, const TriggerProgram* t_triggers = nullptr,
+                           Profiler* t_profiler = nullptr, const JobSearch* t_search = nullptr);
+
+        // Runs every job of a manifest on a work stealing pool. Manifest format, one job per line:
+        //
+        //     <rom file> <seed> <cycle budget> [input script]
+        //
+        // ROMs and input scripts are read once up front and shared read only by all workers, every
+        // interpreter maps the boot image of its rom copy on write. With a corpus, <rom file> names a
+        // rom of the corpus, or 'hash:<hex>' its content hash, and no rom file is opened. In lockstep mode
+        // jobs sharing a rom and cycle budget run as the lanes of one Lockstep engine per batch, lockstep lanes
+        // always use the mt19937 policy. Unless disabled, jobs skip the input independent boot of their rom, see
+        // BootCache; results are the same either way.
+        class Farm{
+
+        private:
+            const RomCorpus* m_corpus;
+            std::vector<std::string> m_romPaths;
+            std::unordered_map<std::string, std::size_t> m_romIndices;
+            std::vector<std::vector<uint8_t>> m_roms;
+            std::vector<std::shared_ptr<const MemoryImage>> m_images;
+            std::vector<uint64_t> m_romHashes;
+            std::vector<std::string> m_scriptPaths;
+            std::vector<InputScript> m_scripts;
+            std::vector<Job> m_jobs;
+            const TriggerProgram* m_triggers;
+            std::string m_profilePath;
+            uint64_t m_profilePeriod;
+            const std::vector<SearchStep>* m_searchSteps;
+            std::unique_ptr<MemorySearch> m_search;
+
+            std::size_t addRom(const std::string& t_romPath);
+            long addScript(const std::string& t_scriptPath);
+            // With t_profiler, profiles every job and adds their ExecutionCounters to t_counters
+            template<typename TChip8>
+            std::string runBatch(std::vector<Job>::const_iterator t_begin, std::vector<Job>::const_iterator t_end, BootCache<TChip8>* t_bootCache,
+                                 Profiler* t_profiler = nullptr, ExecutionCounters* t_counters = nullptr, const JobSearch* t_search = nullptr) const;
+            // With t_validate, checks the lanes against the interpreter every t_validate instructions and throws at a divergence
+            std::string runLockstepBatch(std::vector<Job>::const_iterator t_begin, std::vector<Job>::const_iterator t_end, uint64_t t_validate) const;
+
+        public:
+            Farm(const std::string& t_manifestPath, const RomCorpus* t_corpus = nullptr);
+
+            std::size_t size() const{
+                return m_jobs.size();
+            }
+
+            // Adds a 'triggers' column counting the firings of every trigger of t_triggers, interpreter runs only
+            void setTriggers(const TriggerProgram* t_triggers){
+                m_triggers = t_triggers;
+            }
+
+            // Profiles every job, see Profiler, and adds CHIP8_FARM_PROFILE_COLUMNS to the results. run() writes the
+            // profile of all jobs and the sum of their counters to t_filePath once they are done, interpreter runs only.
+            void setProfile(const std::string& t_filePath, uint64_t t_samplePeriod = CHIP8_PROFILE_DEFAULT_PERIOD){
+                m_profilePath = t_filePath;
+                m_profilePeriod = t_samplePeriod;
+            }
+
+            // Searches the memory of every job for addresses passing t_steps, see MemorySearch, and adds a 'candidates'
+            // column with the addresses left in each job. Jobs run cold so every one starts its search at cycle 0,
+            // interpreter runs only.
+            void setSearch(const std::vector<SearchStep>* t_steps){
+                m_searchSteps = t_steps;
+            }
+
+            // The search of the last run(), one instance per job in manifest order, e.g. common() for the addresses
+            // that passed in every job. Null without setSearch().
+            const MemorySearch* search() const{
+                return m_search.get();
+            }
+
+            // t_bootDirectory keeps boot states on disk between runs, t_boot false runs every job from the loaded rom. A nonzero
+            // t_validate checks lockstep lanes against the interpreter every t_validate instructions, see Differential, and
+            // throws the report of the first lane that diverges once the running batches are done.
+            void run(std::ostream& t_results, std::size_t t_numThreads, std::size_t t_batchSize = CHIP8_FARM_DEFAULT_BATCH_SIZE, bool t_lockstep = false,
+                     RngPolicy t_rng = RNG_MT19937, bool t_boot = true, const std::string& t_bootDirectory = "", uint64_t t_validate = 0);
+        };
+
+    } // namespace Farm
+} // namespace Chip8
+
+#endif // CHIP8_FARM_HPP
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ForkServer.hpp"
+#include "../../src/Chip8Util.hpp"
+
+namespace Chip8{
+    namespace Farm{
+
+        namespace{
+
+        void writeAll(int t_fd, const std::string& t_data){
+            std::size_t written = 0;
+            while(written < t_data.size()){
+                ssize_t count = write(t_fd, t_data.data() + written, t_data.size() - written);
+                if(count < 0 && errno == EINTR){
+                    continue;
+                }
+                if(count <= 0){
+                    // The client went away, its remaining results are dropped
+                    return;
+                }
+                written += count;
+            }
+        }
+
+        // Reads up to the next newline, t_buffer carries bytes read past it to the next call
+        bool readLine(int t_fd, std::string& t_buffer, std::string& t_line){
+            std::size_t newline;
+            while((newline = t_buffer.find('\n')) == std::string::npos){
+                char chunk[4096];
+                ssize_t count = read(t_fd, chunk, sizeof(chunk));
+                if(count < 0 && errno == EINTR){
+                    continue;
+                }
+                if(count <= 0){
+                    t_line.swap(t_buffer);
+                    t_buffer.clear();
+                    return !t_line.empty();
+                }
+                t_buffer.append(chunk, count);
+            }
+            t_line = t_buffer.substr(0, newline);
+            t_buffer.erase(0, newline + 1);
+            return true;
+        }
+
+        std::string faultLine(const Job& t_job, const std::string& t_romPath, std::string t_fault, long t_wallTime){
+            std::replace(t_fault.begin(), t_fault.end(), ',', ';');
+            std::ostringstream result;
+            result << t_job.id << ',' << t_romPath << ',' << t_job.seed << ",0,1," << t_fault << ",0x0000000000000000," << t_wallTime << '\n';
+            return result.str();
+        }
+
+        } // namespace
+
+        template<typename TChip8>
+        ForkServer<TChip8>::ForkServer(const std::string& t_romPath, std::size_t t_maxChildren, bool t_boot, const std::string& t_bootDirectory) : m_romPath(t_romPath),
+                                                                                                 m_maxChildren(std::max<std::size_t>(1, t_maxChildren)),
+                                                                                                 m_nextId(0),
+                                                                                                 m_chip8(0),
+                                                                                                 m_bootCache("legacy", t_bootDirectory),
+                                                                                                 m_boot(nullptr){
+            std::ifstream romStream(t_romPath, std::ios::binary);
+            if(!romStream.is_open()){
+                throw std::string("ForkServer: could not open rom '" + t_romPath + "'");
+            }
+            std::vector<uint8_t> rom((std::istreambuf_iterator<char>(romStream)), std::istreambuf_iterator<char>());
+            m_image = PagedMemory::makeImage(rom.data(), rom.size());
+            m_chip8.load(m_image);
+            if(t_boot){
+                m_boot = &m_bootCache.boot(Util::xxh64(rom.data(), rom.size()), m_chip8);
+            }
+        }
+
+        template<typename TChip8>
+        const InputScript* ForkServer<TChip8>::script(const std::string& t_scriptPath){
+            if(t_scriptPath.empty()){
+                return nullptr;
+            }
+            // Parsed once in the server, every later job using the script inherits it
+            auto known = m_scripts.find(t_scriptPath);
+            if(known == m_scripts.end()){
+                known = m_scripts.emplace(t_scriptPath, InputScript(t_scriptPath)).first;
+            }
+            return &known->second;
+        }
+
+        template<typename TChip8>
+        void ForkServer<TChip8>::spawn(const Job& t_job, const InputScript* t_script, int t_outFd){
+            int fds[2];
+            if(pipe(fds)){
+                throw std::string("ForkServer: pipe failed: ") + std::strerror(errno);
+            }
+
+            Child child{-1, fds[0], t_outFd, t_job, std::chrono::steady_clock::now()};
+            child.pid = fork();
+            if(child.pid < 0){
+                close(fds[0]);
+                close(fds[1]);
+                throw std::string("ForkServer: fork failed: ") + std::strerror(errno);
+            }
+            if(!child.pid){
+                close(fds[0]);
+                writeAll(fds[1], runJob(m_chip8, m_image, m_romPath, t_job, t_script, m_boot));
+                // Skip destructors and atexit handlers, they belong to the server
+                _exit(0);
+            }
+            close(fds[1]);
+            m_children.push_back(child);
+        }
+
+        template<typename TChip8>
+        void ForkServer<TChip8>::reap(bool t_block){
+            int status;
+            pid_t pid;
+            while((pid = waitpid(-1, &status, (t_block)? 0 : WNOHANG)) < 0 && errno == EINTR){}
+            if(pid <= 0){
+                return;
+            }
+
+            auto child = std::find_if(m_children.begin(), m_children.end(), [pid](const Child& t_child){
+                return t_child.pid == pid;
+            });
+            if(child == m_children.end()){
+                return;
+            }
+
+            // Result lines are far below the pipe capacity, the child never blocks on its write
+            std::string buffer, line;
+            bool reported = false;
+            while(readLine(child->resultFd, buffer, line)){
+                writeAll(child->outFd, line + '\n');
+                reported = true;
+            }
+            if(!reported){
+                auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - child->start).count();
+                std::string fault = (WIFSIGNALED(status))? "killed by signal " + std::to_string(WTERMSIG(status))
+                                                         : "exited with status " + std::to_string(WEXITSTATUS(status));
+                writeAll(child->outFd, faultLine(child->job, m_romPath, fault, wallTime));
+            }
+            close(child->resultFd);
+            m_children.erase(child);
+        }
+
+        template<typename TChip8>
+        void ForkServer<TChip8>::serveStream(int t_inFd, int t_outFd){
+            std::string buffer, line;
+            writeAll(t_outFd, CHIP8_FARM_RESULTS_HEADER);
+            while(readLine(t_inFd, buffer, line)){
+                line = line.substr(0, line.find('#'));
+                if(line.find_first_not_of(" \t\r") == std::string::npos){
+                    continue;
+                }
+
+                Job job;
+                std::string scriptPath;
+                std::istringstream lineStream(line);
+                job.id = m_nextId++;
+                job.rom = 0;
+                job.script = -1;
+                if(!(lineStream >> job.seed >> job.cycles)){
+                    job.seed = 0;
+                    writeAll(t_outFd, faultLine(job, m_romPath, "ForkServer: malformed job '" + line + "'", 0));
+                    continue;
+                }
+                lineStream >> scriptPath;
+
+                const InputScript* jobScript;
+                try{
+                    jobScript = script(scriptPath);
+                }
+                catch(const std::string& error){
+                    writeAll(t_outFd, faultLine(job, m_romPath, error, 0));
+                    continue;
+                }
+
+                while(m_children.size() >= m_maxChildren){
+                    reap(true);
+                }
+                spawn(job, jobScript, t_outFd);
+                reap(false);
+            }
+            while(!m_children.empty()){
+                reap(true);
+            }
+        }
+
+        template<typename TChip8>
+        void ForkServer<TChip8>::serve(int t_inFd, int t_outFd){
+            serveStream(t_inFd, t_outFd);
+        }
+
+        template<typename TChip8>
+        void ForkServer<TChip8>::listen(const std::string& t_socketPath){
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if(t_socketPath.size() >= sizeof(address.sun_path)){
+                throw std::string("ForkServer: socket path '" + t_socketPath + "' is too long");
+            }
+            std::strcpy(address.sun_path, t_socketPath.c_str());
+
+            int server = socket(AF_UNIX, SOCK_STREAM, 0);
+            if(server < 0){
+                throw std::string("ForkServer: socket failed: ") + std::strerror(errno);
+            }
+            unlink(t_socketPath.c_str());
+            if(bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) || ::listen(server, SOMAXCONN)){
+                std::string error = std::strerror(errno);
+                close(server);
+                throw std::string("ForkServer: could not listen on '" + t_socketPath + "': " + error);
+            }
+
+            // A client closing early must not kill the server
+            std::signal(SIGPIPE, SIG_IGN);
+            while(true){
+                int client = accept(server, nullptr, nullptr);
+                if(client < 0){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    std::string error = std::strerror(errno);
+                    close(server);
+                    throw std::string("ForkServer: accept failed: " + error);
+                }
+                serveStream(client, client);
+                close(client);
+            }
+        }
+
+        template class ForkServer<Chip8>;
+        template class ForkServer<Chip8Xorshift>;
+        template class ForkServer<Chip8Pcg32>;
+
+    } // namespace Farm
+} // namespace Chip8
@@ -0,0 +1,64 @@
+#ifndef CHIP8_FORK_SERVER_HPP
+#define CHIP8_FORK_SERVER_HPP
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "Farm.hpp"
+
+namespace Chip8{
+    namespace Farm{
+
+        // Serves jobs for one rom from a process that has already loaded it. Jobs arrive one per line:
+        //
+        //     <seed> <cycle budget> [input script]
+        //
+        // and every job runs in a fork() of the server, so the child starts from the warm, copy on write
+        // image of the booted interpreter and parsed input scripts, and a crashing job only takes its own
+        // process down. Each child writes its CSV result line (see Farm) back over a private pipe; the
+        // server forwards it, or a fault line when the child died, to the client that sent the job.
+        template<typename TChip8>
+        class ForkServer{
+
+        private:
+            struct Child{
+                pid_t pid;
+                int resultFd;
+                int outFd;
+                Job job;
+                std::chrono::steady_clock::time_point start;
+            };
+
+            std::string m_romPath;
+            std::shared_ptr<const MemoryImage> m_image;
+            std::map<std::string, InputScript> m_scripts;
+            std::size_t m_maxChildren;
+            std::size_t m_nextId;
+            std::vector<Child> m_children;
+            TChip8 m_chip8;
+            BootCache<TChip8> m_bootCache;
+            const BootState<TChip8>* m_boot;
+
+            const InputScript* script(const std::string& t_scriptPath);
+            void spawn(const Job& t_job, const InputScript* t_script, int t_outFd);
+            void reap(bool t_block);
+            void serveStream(int t_inFd, int t_outFd);
+
+        public:
+            // With t_boot the server also runs the rom to its boot state, or reads it from t_bootDirectory, so children skip the boot
+            ForkServer(const std::string& t_romPath, std::size_t t_maxChildren, bool t_boot = true, const std::string& t_bootDirectory = "");
+
+            // Serves jobs read from t_inFd until end of file, results go to t_outFd
+            void serve(int t_inFd, int t_outFd);
+            // Serves every client connecting to a Unix socket at t_socketPath, results go back over the connection
+            void listen(const std::string& t_socketPath);
+        };
+
+    } // namespace Farm
+} // namespace Chip8
+
+#endif // CHIP8_FORK_SERVER_HPP
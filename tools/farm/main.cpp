@@ -0,0 +1,256 @@
+/*
+ * Chip8 farm main, runs a manifest of headless jobs across all cores
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "Farm.hpp"
+#include "ForkServer.hpp"
+#include "../../src/LoggerImpl.hpp"
+
+static const option long_opts[] =   {{"manifest",    required_argument,  0,  'm'},
+                                     {"output",      required_argument,  0,  'o'},
+                                     {"jobs",        required_argument,  0,  'j'},
+                                     {"batch",       required_argument,  0,  'b'},
+                                     {"lockstep",    no_argument,        0,  'l'},
+                                     {"rng",         required_argument,  0,  'r'},
+                                     {"layout",      no_argument,        0,  'L'},
+                                     {"corpus",      required_argument,  0,  'c'},
+                                     {"fork-server", required_argument,  0,  'F'},
+                                     {"socket",      required_argument,  0,  'U'},
+                                     {"boot-dir",    required_argument,  0,  'B'},
+                                     {"cold",        no_argument,        0,  'C'},
+                                     {"validate",    required_argument,  0,  'V'},
+                                     {"triggers",    required_argument,  0,  'T'},
+                                     {"profile",     required_argument,  0,  'P'},
+                                     {"search",      required_argument,  0,  'S'},
+                                     {"help",        no_argument,        0,  'h'},
+                                     {0,             0,                  0,  0}};
+
+static const char usage[] = " -m MANIFEST [Options] | -F ROM [Options]\n"
+                            "\t-m, --manifest=FILE     job manifest, one '<rom> <seed> <cycles> [input script]' per line\n"
+                            "\t-o, --output=FILE       write per job results to FILE instead of stdout\n"
+                            "\t-j, --jobs=N            number of worker threads, defaults to the number of cores\n"
+                            "\t-b, --batch=N           number of jobs run back to back per task, default 64\n"
+                            "\t-l, --lockstep          run jobs sharing a rom and cycle budget as lanes of one SIMD lockstep engine\n"
+                            "\t-r, --rng=NAME          generator behind RND; NAME can be 'mt19937' (default), 'xorshift', 'pcg32'\n"
+                            "\t-L, --layout            print the memory layout of each interpreter instantiation then exits\n"
+                            "\t-c, --corpus=FILE       take the manifest roms from a packed corpus (see chip8_corpus), by name or 'hash:<hex>'\n"
+                            "\t-F, --fork-server=ROM   load ROM once then run jobs '<seed> <cycles> [input script]' read from stdin,\n"
+                            "\t                        each in a fork of the warm server; -j bounds the jobs running at once\n"
+                            "\t-U, --socket=PATH       with -F, accept jobs from clients of a Unix socket at PATH instead of stdin\n"
+                            "\t-B, --boot-dir=DIR      keep the boot state of every rom in DIR, later runs skip its boot without running it\n"
+                            "\t-C, --cold              run every job from the loaded rom instead of from the rom's boot state\n"
+                            "\t-V, --validate=N        implies -l, checks every lane against the interpreter every N instructions and\n"
+                            "\t                        exits with the first instruction and state fields that differ\n"
+                            "\t-T, --triggers=FILE     evaluate the '<name>: <expression>' lines of FILE every 8 instructions and add a\n"
+                            "\t                        'triggers' column with '<name>=<fired>/<held>' per trigger; not with -l\n"
+                            "\t-P, --profile=FILE      count every job's instructions per opcode class and time about one in 64, add the\n"
+                            "\t                        job's counter columns and write the profile of all jobs to FILE, JSON for a .json\n"
+                            "\t                        FILE and CSV otherwise; runs jobs cold, not with -l\n"
+                            "\t-S, --search=FILE       narrow every job's memory at the '<cycle> <predicate> [N]' steps of FILE, add a\n"
+                            "\t                        'candidates' column and print the addresses left in every job as a '[Cheats]\n"
+                            "\t                        pins' line on stderr; runs jobs cold, not with -l\n"
+                            "\t-h, --help              Prints this usage message then exits.";
+
+template<typename TChip8>
+static void serveForks(const std::string& t_romPath, const std::string& t_socketPath, std::size_t t_maxChildren, bool t_boot, const std::string& t_bootDirectory){
+    Chip8::Farm::ForkServer<TChip8> server(t_romPath, t_maxChildren, t_boot, t_bootDirectory);
+    if(t_socketPath.empty()){
+        server.serve(STDIN_FILENO, STDOUT_FILENO);
+    }
+    else{
+        server.listen(t_socketPath);
+    }
+}
+
+int main(int argc, char** argv){
+
+    int opt, longopt_ind = 0;
+    std::string manifestPath;
+    std::string outputPath;
+    std::string corpusPath;
+    std::string forkServerRom;
+    std::string socketPath;
+    std::string bootDirectory;
+    std::string triggersPath;
+    std::string profilePath;
+    std::string searchPath;
+    bool boot = true;
+    std::size_t numThreads = std::thread::hardware_concurrency();
+    std::size_t batchSize = CHIP8_FARM_DEFAULT_BATCH_SIZE;
+    bool lockstep = false;
+    uint64_t validate = 0;
+    Chip8::Farm::RngPolicy rng = Chip8::Farm::RNG_MT19937;
+    opterr = 0;
+    while((opt = getopt_long(argc, argv, "m:o:j:b:lr:Lc:F:U:B:CV:T:P:S:h", long_opts, &longopt_ind)) != -1){
+        switch(opt){
+            case 'm':
+                manifestPath = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'j':
+                numThreads = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'b':
+                batchSize = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'l':
+                lockstep = true;
+                break;
+            case 'r':
+                try{
+                    rng = Chip8::Farm::getRngPolicyFromName(optarg);
+                }
+                catch(const std::string& error){
+                    std::cerr << argv[0] << ": Error option '-r | --rng' argument " << error << "\nTry '" << argv[0] << " --help for more information" << std::endl;
+                    exit(-1);
+                }
+                break;
+            case 'L':
+                std::cout << "Chip8 (mt19937): ";
+                Chip8::Chip8::layoutReport(std::cout);
+                std::cout << "Chip8Xorshift: ";
+                Chip8::Chip8Xorshift::layoutReport(std::cout);
+                std::cout << "Chip8Pcg32: ";
+                Chip8::Chip8Pcg32::layoutReport(std::cout);
+                exit(0);
+            case 'c':
+                corpusPath = optarg;
+                break;
+            case 'F':
+                forkServerRom = optarg;
+                break;
+            case 'U':
+                socketPath = optarg;
+                break;
+            case 'B':
+                bootDirectory = optarg;
+                break;
+            case 'C':
+                boot = false;
+                break;
+            case 'V':
+                validate = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'T':
+                triggersPath = optarg;
+                break;
+            case 'P':
+                profilePath = optarg;
+                break;
+            case 'S':
+                searchPath = optarg;
+                break;
+            case 'h':
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(0);
+            case '?':
+                std::cerr << argv[0] << ": Error unknown option '" << static_cast<char>(optopt) << "'" << std::endl;
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(-1);
+            default:
+                break;
+        }
+    }
+    // Validation samples the lockstep lanes, so it implies -l; -V 0 leaves an explicit -l alone
+    if(validate){
+        lockstep = true;
+    }
+
+    if(!forkServerRom.empty()){
+        try{
+            if(rng == Chip8::Farm::RNG_XORSHIFT){
+                serveForks<Chip8::Chip8Xorshift>(forkServerRom, socketPath, numThreads, boot, bootDirectory);
+            }
+            else if(rng == Chip8::Farm::RNG_PCG32){
+                serveForks<Chip8::Chip8Pcg32>(forkServerRom, socketPath, numThreads, boot, bootDirectory);
+            }
+            else{
+                serveForks<Chip8::Chip8>(forkServerRom, socketPath, numThreads, boot, bootDirectory);
+            }
+        }
+        catch(const std::string& error){
+            std::cerr << error << std::endl;
+            exit(-1);
+        }
+        return(0);
+    }
+
+    if(manifestPath.empty()){
+        std::cerr << "Error: No job manifest given." << std::endl;
+        exit(-1);
+    }
+
+    try{
+        std::unique_ptr<Chip8::RomCorpus> corpus;
+        if(!corpusPath.empty()){
+            corpus.reset(new Chip8::RomCorpus(corpusPath));
+        }
+        Chip8::Farm::Farm farm(manifestPath, corpus.get());
+
+        Chip8::TriggerProgram triggers;
+        if(!triggersPath.empty()){
+            std::ifstream triggersFile(triggersPath);
+            if(!triggersFile.is_open()){
+                std::cerr << "Error: could not open triggers file '" << triggersPath << "'" << std::endl;
+                exit(-1);
+            }
+            triggers.parse(std::string(std::istreambuf_iterator<char>(triggersFile), std::istreambuf_iterator<char>()));
+            farm.setTriggers(&triggers);
+        }
+        if(!profilePath.empty()){
+            farm.setProfile(profilePath);
+        }
+        std::vector<Chip8::Farm::SearchStep> searchSteps;
+        if(!searchPath.empty()){
+            std::ifstream searchFile(searchPath);
+            if(!searchFile.is_open()){
+                std::cerr << "Error: could not open search file '" << searchPath << "'" << std::endl;
+                exit(-1);
+            }
+            searchSteps = Chip8::Farm::parseSearchSteps(searchFile);
+            farm.setSearch(&searchSteps);
+        }
+
+        std::ofstream outputFile;
+        if(!outputPath.empty()){
+            outputFile.open(outputPath);
+            if(!outputFile.is_open()){
+                std::cerr << "Error: could not open output file '" << outputPath << "'" << std::endl;
+                exit(-1);
+            }
+        }
+
+        farm.run((outputFile.is_open())? outputFile : std::cout, numThreads, batchSize, lockstep, rng, boot, bootDirectory, validate);
+
+        if(farm.search()){
+            // Values as the first job last saw them, ready to paste into a profile or config
+            std::vector<uint32_t> common = farm.search()->common();
+            std::cerr << common.size() << " addresses left in every job" << std::endl;
+            std::cerr << "pins =";
+            for(std::size_t i = 0; i < common.size(); ++i){
+                std::cerr << ((i)? ", " : " ") << "0x" << std::hex << std::setw(3) << std::setfill('0') << common[i] << '=' << std::dec
+                          << static_cast<unsigned>(farm.search()->value(0, common[i]));
+            }
+            std::cerr << std::endl;
+        }
+    }
+    catch(const std::string& error){
+        std::cerr << error << std::endl;
+        exit(-1);
+    }
+
+    return(0);
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Fuzz.hpp"
+
+namespace Chip8{
+    namespace Fuzz{
+
+        static const char* const variants[CHIP8_FUZZ_NUM_VARIANTS] = {"legacy", "vip", "chip48", "schip", "xochip"};
+
+        // Shared by every harness, the hook has no way to tell them apart
+        static uint8_t hostEdges[CHIP8_FUZZ_MAP_SIZE];
+        static std::size_t hostEdgeCount = 0;
+        static uintptr_t lastHostBlock = 0;
+
+        void recordHostEdge(uintptr_t t_pc){
+            std::size_t index = ((lastHostBlock >> 1) ^ t_pc) & (CHIP8_FUZZ_MAP_SIZE - 1);
+            lastHostBlock = t_pc;
+            if(!hostEdges[index]){
+                hostEdges[index] = 1;
+                ++hostEdgeCount;
+            }
+        }
+
+        Input parseInput(const uint8_t* t_data, std::size_t t_size){
+            Input input{0, {}, t_data, 0};
+            if(t_size < 2){
+                return input;
+            }
+            input.variant = t_data[0] % CHIP8_FUZZ_NUM_VARIANTS;
+            std::size_t events = std::min<std::size_t>(t_data[1], (t_size - 2) / 4);
+            const uint8_t* in = t_data + 2;
+            uint64_t tick = 0;
+            for(std::size_t event = 0; event < events; ++event, in += 4){
+                tick += in[0] | (in[1] << 8);
+                input.events.emplace_back(tick, in[2] | (in[3] << 8));
+            }
+            input.rom = in;
+            input.romSize = t_data + t_size - in;
+            return input;
+        }
+
+        uint16_t opcodeClass(uint16_t t_op){
+            switch(t_op >> 12){
+                case 0x0:
+                    // 0NNN is one class, 00CN and 00DN scroll by N
+                    if(t_op & 0x0f00){
+                        return 0x0000;
+                    }
+                    return ((t_op & 0x00f0) == 0x00c0 || (t_op & 0x00f0) == 0x00d0)? t_op & 0xfff0 : t_op;
+                case 0x5:
+                case 0x8:
+                case 0x9:
+                    return t_op & 0xf00f;
+                case 0xe:
+                case 0xf:
+                    return t_op & 0xf0ff;
+                default:
+                    return t_op & 0xf000;
+            }
+        }
+
+        Harness::Harness(uint64_t t_budget) : m_budget(t_budget),
+                                              m_opcodes(CHIP8_FUZZ_MAP_SIZE),
+                                              m_guestEdges(CHIP8_FUZZ_MAP_SIZE),
+                                              m_coverage{0, 0, 0}{
+            std::size_t stateSize = 0;
+            for(const char* variant : variants){
+                m_machines.push_back(makeMachine(variant, CHIP8_FUZZ_SEED));
+                m_restored.push_back(makeMachine(variant, CHIP8_FUZZ_SEED));
+                stateSize = std::max(stateSize, m_machines.back()->stateSize());
+            }
+            m_state.resize(stateSize);
+        }
+
+        std::size_t Harness::mark(std::vector<uint8_t>& t_map, std::size_t t_index, std::size_t& t_count){
+            if(t_map[t_index]){
+                return 0;
+            }
+            t_map[t_index] = 1;
+            ++t_count;
+            return 1;
+        }
+
+        void Harness::checkState(std::size_t t_variant, const std::string& t_fault){
+            Machine& machine = *m_machines[t_variant];
+            Machine& restored = *m_restored[t_variant];
+            std::size_t size = machine.saveState(m_state.data(), m_state.size());
+            restored.loadState(m_state.data(), size);
+            if(restored.stateHash() != machine.stateHash() || restored.programCounter() != machine.programCounter()){
+                std::fprintf(stderr, "Fuzz: %s state changed across saveState and loadState%s%s\n", variants[t_variant],
+                             (t_fault.empty())? "" : " after fault: ", t_fault.c_str());
+                std::abort();
+            }
+        }
+
+        Result Harness::run(const uint8_t* t_data, std::size_t t_size){
+            Input input = parseInput(t_data, std::min<std::size_t>(t_size, CHIP8_FUZZ_MAX_INPUT));
+            Machine& machine = *m_machines[input.variant];
+            machine.reset();
+            machine.load(input.rom, input.romSize);
+            machine.setKeystates(0);
+
+            Result result{0, "", 0};
+            std::size_t hostEdgesBefore = hostEdgeCount;
+            std::size_t event = 0;
+            uint16_t prevPc = 0;
+            try{
+                for(; result.ticks < m_budget; ++result.ticks){
+                    while(event < input.events.size() && input.events[event].first <= result.ticks){
+                        machine.setKeystates(input.events[event++].second);
+                    }
+                    uint16_t pc = machine.programCounter();
+                    uint16_t op = (machine.readMemory(pc) << 8) | machine.readMemory(pc + 1);
+                    result.newCoverage += mark(m_guestEdges, ((prevPc >> 1) ^ pc) & (CHIP8_FUZZ_MAP_SIZE - 1), m_coverage.guestEdges);
+                    prevPc = pc;
+                    machine.run_tick();
+                    // Only opcodes that ran count, an unknown one faults and would make every 16 bit pattern a class
+                    result.newCoverage += mark(m_opcodes, opcodeClass(op), m_coverage.opcodes);
+                }
+            }
+            catch(const std::string& error){
+                result.fault = error;
+            }
+            checkState(input.variant, result.fault);
+            result.newCoverage += hostEdgeCount - hostEdgesBefore;
+            return result;
+        }
+
+        Coverage Harness::coverage() const{
+            Coverage coverage = m_coverage;
+            coverage.hostEdges = hostEdgeCount;
+            return coverage;
+        }
+
+    } // namespace Fuzz
+} // namespace Chip8
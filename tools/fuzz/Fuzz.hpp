@@ -0,0 +1,89 @@
+#ifndef CHIP8_FUZZ_HPP
+#define CHIP8_FUZZ_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../src/Chip8Machine.hpp"
+
+#define CHIP8_FUZZ_DEFAULT_BUDGET     10000
+#define CHIP8_FUZZ_SEED               0
+// Inputs are cut to this many bytes, roms longer than 4 KiB only slow the search down
+#define CHIP8_FUZZ_MAX_INPUT          4096
+#define CHIP8_FUZZ_MAP_SIZE           (1 << 16)
+#define CHIP8_FUZZ_NUM_VARIANTS       5
+
+namespace Chip8{
+    namespace Fuzz{
+
+        // A fuzz input, laid out as
+        //
+        //     variant u8, event count u8, events, rom bytes
+        //
+        // The variant byte picks legacy, vip, chip48, schip or xochip (modulo 5). Each event is a tick delta u16
+        // and the key state u16 held from there on, both little endian. Whatever follows the events is the rom.
+        // Any byte string is a valid input, short ones just have no events or an empty rom.
+        struct Input{
+            std::size_t variant;
+            std::vector<std::pair<uint64_t, uint16_t>> events;
+            const uint8_t* rom;
+            std::size_t romSize;
+        };
+
+        Input parseInput(const uint8_t* t_data, std::size_t t_size);
+
+        // Coverage class of an opcode: the opcode with its operand fields masked out, so 8XY4 for every X and Y
+        uint16_t opcodeClass(uint16_t t_op);
+
+        // Records the edge from the last host block to the one at t_pc, called by the -fsanitize-coverage=trace-pc
+        // hook of the standalone driver
+        void recordHostEdge(uintptr_t t_pc);
+
+        struct Coverage{
+            std::size_t opcodes;
+            std::size_t guestEdges;
+            // Zero unless the core was built with host coverage, see the fuzz target of the makefile
+            std::size_t hostEdges;
+        };
+
+        struct Result{
+            uint64_t ticks;
+            std::string fault;
+            // Coverage entries seen for the first time in this run
+            std::size_t newCoverage;
+        };
+
+        // Runs fuzz inputs on one machine per variant, in memory and without allocating per run beyond what a
+        // rom load costs. A fault of the guest (std::string thrown by run_tick) is an ordinary outcome of a
+        // malformed rom and ends the run, anything else thrown is left to the caller as a finding. After every
+        // run the harness also checks that the final state survives saveState and loadState and aborts if not.
+        class Harness{
+
+        private:
+            uint64_t m_budget;
+            std::vector<std::unique_ptr<Machine>> m_machines;
+            std::vector<std::unique_ptr<Machine>> m_restored;
+            std::vector<uint8_t> m_state;
+            std::vector<uint8_t> m_opcodes;
+            std::vector<uint8_t> m_guestEdges;
+            Coverage m_coverage;
+
+            std::size_t mark(std::vector<uint8_t>& t_map, std::size_t t_index, std::size_t& t_count);
+            void checkState(std::size_t t_variant, const std::string& t_fault);
+
+        public:
+            Harness(uint64_t t_budget = CHIP8_FUZZ_DEFAULT_BUDGET);
+
+            Result run(const uint8_t* t_data, std::size_t t_size);
+
+            // Everything covered by the runs so far
+            Coverage coverage() const;
+        };
+
+    } // namespace Fuzz
+} // namespace Chip8
+
+#endif // CHIP8_FUZZ_HPP
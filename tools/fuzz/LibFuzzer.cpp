@@ -0,0 +1,14 @@
+/*
+ * libFuzzer entry point, see the fuzz-libfuzzer target of the makefile
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Fuzz.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* t_data, std::size_t t_size){
+    static Chip8::Fuzz::Harness harness;
+    harness.run(t_data, t_size);
+    return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * Chip8 fuzz main, standalone coverage guided driver for the harness in Fuzz.hpp
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Fuzz.hpp"
+#include "../../src/Chip8Util.hpp"
+
+static const option long_opts[] =   {{"runs",        required_argument,  0,  'r'},
+                                     {"budget",      required_argument,  0,  'b'},
+                                     {"seed",        required_argument,  0,  's'},
+                                     {"output",      required_argument,  0,  'o'},
+                                     {"help",        no_argument,        0,  'h'},
+                                     {0,             0,                  0,  0}};
+
+static const char usage[] = " [Options] CORPUS_DIR|INPUT...\n"
+                            "\t-r, --runs=N            mutated inputs to run, default 100000; 0 only runs the given inputs and\n"
+                            "\t                        prints the outcome of each\n"
+                            "\t-b, --budget=N          instructions per input, default 10000\n"
+                            "\t-s, --seed=N            seed of the mutations, default 0\n"
+                            "\t-o, --output=DIR        write inputs reaching new coverage and crash inputs to DIR, defaults to\n"
+                            "\t                        the first CORPUS_DIR\n"
+                            "\t-h, --help              Prints this usage message then exits.";
+
+// Called by every block of code built with -fsanitize-coverage=trace-pc, which the fuzz target uses for the core
+extern "C" void __sanitizer_cov_trace_pc(){
+    Chip8::Fuzz::recordHostEdge(reinterpret_cast<uintptr_t>(__builtin_return_address(0)));
+}
+
+// Input being run and where to keep it should the run crash, written from the signal handler
+static std::vector<uint8_t> currentInput;
+static char crashPath[4096];
+
+static void saveCrash(int t_signal){
+    int fd = ::open(crashPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd >= 0){
+        ssize_t written = ::write(fd, currentInput.data(), currentInput.size());
+        ::close(fd);
+        static const char message[] = "chip8_fuzz: crashed, input written to ";
+        written = ::write(STDERR_FILENO, message, sizeof(message) - 1);
+        written = ::write(STDERR_FILENO, crashPath, std::strlen(crashPath));
+        written = ::write(STDERR_FILENO, "\n", 1);
+        (void)written;
+    }
+    std::signal(t_signal, SIG_DFL);
+    std::raise(t_signal);
+}
+
+static std::vector<uint8_t> readInput(const std::string& t_path){
+    std::ifstream inputStream(t_path, std::ios::binary);
+    if(!inputStream.is_open()){
+        throw std::string("could not open input '" + t_path + "'");
+    }
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(inputStream)), std::istreambuf_iterator<char>());
+}
+
+static void collectInputs(const std::string& t_path, std::vector<std::vector<uint8_t>>& t_inputs, std::vector<std::string>& t_directories){
+    const char* type = Chip8::Util::fileExists(t_path.c_str());
+    if(type == Chip8::Util::regFile){
+        t_inputs.push_back(readInput(t_path));
+        return;
+    }
+    DIR* dir = (type)? opendir(t_path.c_str()) : nullptr;
+    if(!dir){
+        throw std::string("'" + t_path + "' is neither an input nor a directory");
+    }
+    t_directories.push_back(t_path);
+    while(dirent* entry = readdir(dir)){
+        std::string name = entry->d_name;
+        if(name[0] != '.' && Chip8::Util::fileExists((t_path + '/' + name).c_str()) == Chip8::Util::regFile){
+            t_inputs.push_back(readInput(t_path + '/' + name));
+        }
+    }
+    closedir(dir);
+}
+
+static void writeInput(const std::string& t_directory, const std::string& t_prefix, const std::vector<uint8_t>& t_input){
+    std::ostringstream path;
+    path << t_directory << '/' << t_prefix << std::hex << std::setw(16) << std::setfill('0') << Chip8::Util::fnv1a(t_input.data(), t_input.size());
+    std::ofstream outputStream(path.str(), std::ios::binary);
+    outputStream.write(reinterpret_cast<const char*>(t_input.data()), t_input.size());
+}
+
+// One random edit, biased towards the rom part and towards whole opcodes
+static void mutate(std::vector<uint8_t>& t_input, const std::vector<std::vector<uint8_t>>& t_corpus, std::mt19937_64& t_generator){
+    if(t_input.size() < 2){
+        t_input.resize(2, 0);
+    }
+    std::size_t pos = t_generator() % t_input.size();
+    switch(t_generator() % 7){
+        case 0:
+            t_input[pos] ^= 1 << (t_generator() % 8);
+            break;
+        case 1:
+            t_input[pos] = static_cast<uint8_t>(t_generator());
+            break;
+        case 2:
+            // A random opcode, at an even offset of the rom so it lines up with the instructions around it
+            pos &= ~static_cast<std::size_t>(1);
+            t_input.insert(t_input.begin() + pos, {static_cast<uint8_t>(t_generator()), static_cast<uint8_t>(t_generator())});
+            break;
+        case 3:
+            t_input.erase(t_input.begin() + pos, t_input.begin() + std::min(t_input.size(), pos + 1 + t_generator() % 4));
+            break;
+        case 4:
+            t_input[0] = static_cast<uint8_t>(t_generator() % CHIP8_FUZZ_NUM_VARIANTS);
+            break;
+        case 5:{
+            // A key event, events sit between the header and the rom
+            std::size_t events = std::min<std::size_t>(t_input[1], (t_input.size() - 2) / 4);
+            if(events < 0xff){
+                uint64_t event = t_generator();
+                t_input.insert(t_input.begin() + 2 + 4 * events, {static_cast<uint8_t>(event), static_cast<uint8_t>(event >> 8 & 0x3),
+                                                                  static_cast<uint8_t>(event >> 16), static_cast<uint8_t>(event >> 24)});
+                t_input[1] = static_cast<uint8_t>(events + 1);
+            }
+            break;
+        }
+        default:{
+            // Splices the tail of another input in
+            const std::vector<uint8_t>& other = t_corpus[t_generator() % t_corpus.size()];
+            std::size_t from = (other.empty())? 0 : t_generator() % other.size();
+            t_input.resize(pos);
+            t_input.insert(t_input.end(), other.begin() + from, other.end());
+            break;
+        }
+    }
+    if(t_input.size() > CHIP8_FUZZ_MAX_INPUT){
+        t_input.resize(CHIP8_FUZZ_MAX_INPUT);
+    }
+}
+
+static void printStatus(uint64_t t_runs, const Chip8::Fuzz::Harness& t_harness, std::size_t t_corpusSize, uint64_t t_faults,
+                        std::chrono::steady_clock::time_point t_start){
+    Chip8::Fuzz::Coverage coverage = t_harness.coverage();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cerr << '#' << t_runs << "\topcodes: " << coverage.opcodes << " guest edges: " << coverage.guestEdges << " host edges: " << coverage.hostEdges
+              << " corpus: " << t_corpusSize << " faults: " << t_faults << " exec/s: " << static_cast<uint64_t>((seconds > 0)? t_runs / seconds : 0) << std::endl;
+}
+
+int main(int argc, char** argv){
+
+    int opt, longopt_ind = 0;
+    uint64_t runs = 100000;
+    uint64_t budget = CHIP8_FUZZ_DEFAULT_BUDGET;
+    uint64_t seed = 0;
+    std::string outputDirectory;
+    opterr = 0;
+    while((opt = getopt_long(argc, argv, "r:b:s:o:h", long_opts, &longopt_ind)) != -1){
+        switch(opt){
+            case 'r':
+                runs = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'b':
+                budget = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 's':
+                seed = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'o':
+                outputDirectory = optarg;
+                break;
+            case 'h':
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(0);
+            case '?':
+                std::cerr << argv[0] << ": Error unknown option '" << static_cast<char>(optopt) << "'" << std::endl;
+                std::cout << "Usage: " << argv[0] << usage << std::endl;
+                exit(-1);
+            default:
+                break;
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> corpus;
+    std::vector<std::string> directories;
+    try{
+        for(int arg = optind; arg < argc; ++arg){
+            collectInputs(argv[arg], corpus, directories);
+        }
+    }
+    catch(const std::string& error){
+        std::cerr << "Error: " << error << std::endl;
+        exit(-1);
+    }
+    if(outputDirectory.empty() && !directories.empty()){
+        outputDirectory = directories.front();
+    }
+    std::snprintf(crashPath, sizeof(crashPath), "%s%scrash-input", outputDirectory.c_str(), (outputDirectory.empty())? "" : "/");
+    for(int signal : {SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL}){
+        std::signal(signal, saveCrash);
+    }
+
+    Chip8::Fuzz::Harness harness(budget);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t faults = 0;
+    try{
+        // The given inputs first, this also replays a crash input
+        for(const std::vector<uint8_t>& input : corpus){
+            currentInput = input;
+            Chip8::Fuzz::Result result = harness.run(input.data(), input.size());
+            faults += !result.fault.empty();
+            if(!runs){
+                std::cout << input.size() << " bytes: " << result.ticks << " instructions, " << result.newCoverage << " new coverage"
+                          << ((result.fault.empty())? "" : ", fault: ") << result.fault << std::endl;
+            }
+        }
+        if(!runs){
+            printStatus(corpus.size(), harness, corpus.size(), faults, start);
+            return(0);
+        }
+        if(corpus.empty()){
+            corpus.push_back({0, 0});
+        }
+
+        std::mt19937_64 generator(seed);
+        for(uint64_t run = 1; run <= runs; ++run){
+            currentInput = corpus[generator() % corpus.size()];
+            for(uint64_t edits = 1 + generator() % 4; edits; --edits){
+                mutate(currentInput, corpus, generator);
+            }
+            Chip8::Fuzz::Result result = harness.run(currentInput.data(), currentInput.size());
+            faults += !result.fault.empty();
+            if(result.newCoverage){
+                corpus.push_back(currentInput);
+                if(!outputDirectory.empty()){
+                    writeInput(outputDirectory, "", currentInput);
+                }
+            }
+            if(!(run & (run - 1)) || run == runs){
+                printStatus(run, harness, corpus.size(), faults, start);
+            }
+        }
+    }
+    catch(const std::exception& except){
+        // A guest fault is a std::string and handled by the harness, anything else escaping it is a bug of the core
+        std::cerr << "chip8_fuzz: uncaught exception: " << except.what() << std::endl;
+        writeInput((outputDirectory.empty())? "." : outputDirectory, "crash-", currentInput);
+        exit(1);
+    }
+
+    return(0);
+}